@@ -93,6 +93,16 @@ vec3 sampleSphericalHarmonic(SphericalHarmonics sh, vec3 dir)
          + Y2_2 * sh.L2_2.xyz + Y2_1 * sh.L2_1.xyz + Y20 * sh.L20.xyz + Y21 * sh.L21.xyz + Y22 * sh.L22.xyz;
 }
 
+// Tangent space normal from a normal map texel. Only uses x & y and reconstructs z, so it works for both regular RGB
+// normal maps and two-channel (BC5) ones.
+vec3 unpackNormalMapNormal(vec2 packedNormal)
+{
+    vec3 normal;
+    normal.xy = packedNormal * 2.0 - 1.0;
+    normal.z = sqrt(max(0.0, 1.0 - dot(normal.xy, normal.xy)));
+    return normal;
+}
+
 // Source: http://lolengine.net/blog/2013/07/27/rgb-to-hsv-in-glsl
 vec3 hsv2rgb(vec3 c)
 {
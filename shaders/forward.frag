@@ -1,6 +1,7 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+#include "common.glsl"
 #include "shared/ForwardData.h"
 
 layout(location = 0) in vec2 vTexCoord;
@@ -25,8 +26,8 @@ void main()
 
     vec3 baseColor = texture(uSamplers[material.baseColor], vTexCoord).rgb;
 
-    vec3 packedNormal = texture(uSamplers[material.normalMap], vTexCoord).rgb;
-    vec3 mappedNormal = normalize(packedNormal * 2.0 - 1.0);
+    vec2 packedNormal = texture(uSamplers[material.normalMap], vTexCoord).rg;
+    vec3 mappedNormal = unpackNormalMapNormal(packedNormal);
     vec3 N = normalize(vTbnMatrix * mappedNormal); // TODO: Clean up TBN?
 
     oColor = vec4(baseColor, 1.0);
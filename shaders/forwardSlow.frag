@@ -130,8 +130,8 @@ void main()
     float metallic = metallicRoughness.b;
     float roughness = metallicRoughness.g;
 
-    vec3 packedNormal = texture(uNormalMap, vTexCoord).rgb;
-    vec3 mappedNormal = normalize(packedNormal * 2.0 - 1.0);
+    vec2 packedNormal = texture(uNormalMap, vTexCoord).rg;
+    vec3 mappedNormal = unpackNormalMapNormal(packedNormal);
     vec3 N = normalize(vTbnMatrix * mappedNormal);
 
     vec3 V = -normalize(vPosition);
@@ -2,11 +2,12 @@
 
 #include "shared/CameraState.h"
 #include "shared/ForwardData.h"
+#include "shared/SceneGeometryData.h"
+#include "octahedral.glsl"
 
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec2 aTexCoord;
-layout(location = 2) in vec3 aNormal;
-layout(location = 3) in vec4 aTangent;
+layout(location = 2) in vec4 aPackedNormalTangent;
 
 layout(set = 0, binding = 0) uniform CameraStateBlock
 {
@@ -18,6 +19,11 @@ layout(set = 1, binding = 0) uniform ObjectDataBlock
     PerForwardObject object;
 };
 
+layout(set = 0, binding = 1) buffer readonly SceneMeshBlock
+{
+    SceneMesh sceneMeshes[];
+};
+
 layout(location = 0) out vec2 vTexCoord;
 layout(location = 1) out vec3 vPosition;
 layout(location = 2) out vec3 vNormal;
@@ -28,14 +34,19 @@ void main()
     vec4 viewSpacePos = camera.viewFromWorld * object.worldFromLocal * vec4(aPosition, 1.0);
     vPosition = viewSpacePos.xyz;
 
+    vec3 normal;
+    vec4 tangent;
+    decodeTangentFrame(aPackedNormalTangent, normal, tangent);
+
     mat3 viewFromTangent = mat3(camera.viewFromWorld) * mat3(object.worldFromTangent);
-    vec3 viewSpaceNormal = normalize(viewFromTangent * aNormal);
-    vec3 viewSpaceTangent = normalize(viewFromTangent * aTangent.xyz);
-    vec3 viewSpaceBitangent = cross(viewSpaceNormal, viewSpaceTangent) * aTangent.w;
+    vec3 viewSpaceNormal = normalize(viewFromTangent * normal);
+    vec3 viewSpaceTangent = normalize(viewFromTangent * tangent.xyz);
+    vec3 viewSpaceBitangent = cross(viewSpaceNormal, viewSpaceTangent) * tangent.w;
     vTbnMatrix = mat3(viewSpaceTangent, viewSpaceBitangent, viewSpaceNormal);
     vNormal = viewSpaceNormal;
 
-    vTexCoord = aTexCoord;
+    vec4 texcoordScaleBias = sceneMeshes[object.meshIndex].texcoordScaleBias;
+    vTexCoord = aTexCoord * texcoordScaleBias.xy + texcoordScaleBias.zw;
 
     gl_Position = camera.projectionFromView * viewSpacePos;
 }
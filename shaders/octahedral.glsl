@@ -0,0 +1,25 @@
+#ifndef OCTAHEDRAL_GLSL
+#define OCTAHEDRAL_GLSL
+
+// See "A Survey of Efficient Representations for Independent Unit Vectors" (Cigolle et al. 2014)
+vec3 octahedralDecode(vec2 p)
+{
+    vec3 v = vec3(p.xy, 1.0 - abs(p.x) - abs(p.y));
+    if (v.z < 0.0) {
+        vec2 signNotZero = vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+        v.xy = (1.0 - abs(v.yx)) * signNotZero;
+    }
+    return normalize(v);
+}
+
+// Decodes the packed normal & tangent of CompactVertexFormat, where the bitangent sign is stored in the sign of .w
+void decodeTangentFrame(vec4 packedNormalTangent, out vec3 normal, out vec4 tangent)
+{
+    normal = octahedralDecode(packedNormalTangent.xy);
+
+    float tangentSign = packedNormalTangent.w < 0.0 ? -1.0 : 1.0;
+    float tangentY = abs(packedNormalTangent.w) * 2.0 - 1.0;
+    tangent = vec4(octahedralDecode(vec2(packedNormalTangent.z, tangentY)), tangentSign);
+}
+
+#endif // OCTAHEDRAL_GLSL
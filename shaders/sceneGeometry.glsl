@@ -0,0 +1,48 @@
+#ifndef SCENE_GEOMETRY_GLSL
+#define SCENE_GEOMETRY_GLSL
+
+// Vertex & index fetching from the shared scene geometry buffers, for use in e.g. ray tracing shaders.
+// The including shader must declare the buffers sceneVertexWords[] & sceneIndexWords[] (plain uint arrays).
+
+#include "shared/SceneGeometryData.h"
+#include "octahedral.glsl"
+
+uint sceneMeshIndex(SceneMesh mesh, uint i)
+{
+    if (mesh.indexType == SCENE_INDEX_TYPE_UINT16) {
+        uint word = sceneIndexWords[mesh.firstIndexWord + i / 2];
+        return (word >> (16 * (i % 2))) & 0xFFFF;
+    } else {
+        return sceneIndexWords[mesh.firstIndexWord + i];
+    }
+}
+
+uvec3 sceneMeshTriangle(SceneMesh mesh, uint primitiveId)
+{
+    return uvec3(sceneMeshIndex(mesh, 3 * primitiveId + 0),
+                 sceneMeshIndex(mesh, 3 * primitiveId + 1),
+                 sceneMeshIndex(mesh, 3 * primitiveId + 2));
+}
+
+vec2 sceneVertexTexCoord(SceneMesh mesh, uint index)
+{
+    uint base = (mesh.vertexOffset + index) * SCENE_VERTEX_STRIDE_WORDS;
+#if SCENE_TEXCOORD_ENCODING == SCENE_TEXCOORD_ENCODING_FLOAT32
+    vec2 texCoord = uintBitsToFloat(uvec2(sceneVertexWords[base + SCENE_VERTEX_TEXCOORD_WORD], sceneVertexWords[base + SCENE_VERTEX_TEXCOORD_WORD + 1]));
+#elif SCENE_TEXCOORD_ENCODING == SCENE_TEXCOORD_ENCODING_HALF
+    vec2 texCoord = unpackHalf2x16(sceneVertexWords[base + SCENE_VERTEX_TEXCOORD_WORD]);
+#else
+    vec2 texCoord = unpackUnorm2x16(sceneVertexWords[base + SCENE_VERTEX_TEXCOORD_WORD]);
+#endif
+    return texCoord * mesh.texcoordScaleBias.xy + mesh.texcoordScaleBias.zw;
+}
+
+// (note: in mesh space, i.e. apply mesh.localNormalMatrix to get it in model/object space)
+vec3 sceneVertexNormal(SceneMesh mesh, uint index)
+{
+    uint base = (mesh.vertexOffset + index) * SCENE_VERTEX_STRIDE_WORDS;
+    vec2 octNormal = unpackSnorm2x16(sceneVertexWords[base + SCENE_VERTEX_NORMAL_TANGENT_WORD]);
+    return octahedralDecode(octNormal);
+}
+
+#endif // SCENE_GEOMETRY_GLSL
@@ -15,7 +15,8 @@ struct PerForwardObject {
     mat4 worldFromLocal;
     mat4 worldFromTangent;
     int materialIndex;
-    int pad1, pad2, pad3;
+    int meshIndex; // (index into the scene geometry SceneMesh buffer)
+    int pad2, pad3;
 };
 
 #endif // FORWARD_DATA_H
@@ -29,11 +29,4 @@ struct RTVoxelContour {
     vec4 plane;
 };
 
-struct RTVertex {
-    // TODO: we could fit the tex coord data in .w of position & normal!
-    vec4 position;
-    vec4 normal;
-    vec4 texCoord;
-};
-
 #endif // RTDATA_H
@@ -0,0 +1,34 @@
+#ifndef SCENE_GEOMETRY_DATA_H
+#define SCENE_GEOMETRY_DATA_H
+
+#define SCENE_TEXCOORD_ENCODING_FLOAT32 0
+#define SCENE_TEXCOORD_ENCODING_HALF 1
+#define SCENE_TEXCOORD_ENCODING_UNORM16 2
+
+// The shared scene vertex layout, which SceneGeometryNode::vertexFormat() is derived from (and checked against):
+//  words 0-2: position (float32x3)
+//  next 1-2:  texcoord (SCENE_TEXCOORD_ENCODING, dequantize with SceneMesh::texcoordScaleBias)
+//  next 2:    octahedral normal & tangent (snorm16x4)
+#define SCENE_TEXCOORD_ENCODING SCENE_TEXCOORD_ENCODING_UNORM16
+
+#define SCENE_VERTEX_TEXCOORD_WORD 3
+#if SCENE_TEXCOORD_ENCODING == SCENE_TEXCOORD_ENCODING_FLOAT32
+#define SCENE_VERTEX_NORMAL_TANGENT_WORD 5
+#else
+#define SCENE_VERTEX_NORMAL_TANGENT_WORD 4
+#endif
+#define SCENE_VERTEX_STRIDE_WORDS (SCENE_VERTEX_NORMAL_TANGENT_WORD + 2)
+
+#define SCENE_INDEX_TYPE_UINT16 0
+#define SCENE_INDEX_TYPE_UINT32 1
+
+struct SceneMesh {
+    mat4 localNormalMatrix;
+    vec4 texcoordScaleBias;
+    int vertexOffset;
+    int firstIndexWord;
+    int indexType;
+    int pad0;
+};
+
+#endif // SCENE_GEOMETRY_DATA_H
@@ -1,7 +1,7 @@
 #ifndef SPHERICAL_HARMONICS_H
 #define SPHERICAL_HARMONICS_H
 
-// FIXME: This can probably be packed more efficiently, since we only care about the rgb's
+// Unpacked, as used for evaluating. (The fourth component of each coefficient is unused.)
 struct SphericalHarmonics {
     vec4 L00;
     vec4 L11;
@@ -14,4 +14,15 @@ struct SphericalHarmonics {
     vec4 L22;
 };
 
+// Packings of the sphere-set SH buffers, see SphereSetModel::packedSphericalHarmonics(). The buffers start with one word
+// for the packing, followed by the packed SHs of all spheres, with the rgb of each coefficient tightly packed in the
+// order L00, L1_1, L10, L11, L2_2, L2_1, L20, L21, L22 (and only the first four for the L1 packing).
+#define SH_PACKING_FLOAT 0 // 27 floats
+#define SH_PACKING_HALF 1 // 27 halfs (+ one half of padding)
+#define SH_PACKING_L1_HALF 2 // 12 halfs, only the constant & linear bands
+
+#define SH_PACKED_WORDS_FLOAT 27
+#define SH_PACKED_WORDS_HALF 14
+#define SH_PACKED_WORDS_L1_HALF 6
+
 #endif // SPHERICAL_HARMONICS_H
@@ -0,0 +1,64 @@
+#ifndef SPHERICAL_HARMONICS_GLSL
+#define SPHERICAL_HARMONICS_GLSL
+
+// Unpacking of the sphere-set SH buffers (see shared/SphericalHarmonics.h for the packings).
+// The including shader must declare the buffers as sphereSHSets[], each with the members packing & words[] (plain uint).
+
+#include "shared/SphericalHarmonics.h"
+
+uint sphericalHarmonicsPackedWords(uint packing)
+{
+    switch (packing) {
+    case SH_PACKING_HALF:
+        return SH_PACKED_WORDS_HALF;
+    case SH_PACKING_L1_HALF:
+        return SH_PACKED_WORDS_L1_HALF;
+    default:
+        return SH_PACKED_WORDS_FLOAT;
+    }
+}
+
+vec3 unpackSphericalHarmonicsCoefficient(uint setIndex, uint packing, uint firstWord, uint coefficient)
+{
+    if (packing == SH_PACKING_FLOAT) {
+        uint word = firstWord + 3 * coefficient;
+        return uintBitsToFloat(uvec3(sphereSHSets[setIndex].words[word + 0],
+                                     sphereSHSets[setIndex].words[word + 1],
+                                     sphereSHSets[setIndex].words[word + 2]));
+    }
+
+    // (two halfs per word, where the first half is in the low bits)
+    vec3 value;
+    for (uint i = 0; i < 3; ++i) {
+        uint halfIndex = 3 * coefficient + i;
+        vec2 halfs = unpackHalf2x16(sphereSHSets[setIndex].words[firstWord + halfIndex / 2]);
+        value[i] = (halfIndex % 2 == 0) ? halfs.x : halfs.y;
+    }
+    return value;
+}
+
+SphericalHarmonics loadSphericalHarmonics(uint setIndex, uint sphereIndex)
+{
+    uint packing = sphereSHSets[setIndex].packing;
+    uint firstWord = sphereIndex * sphericalHarmonicsPackedWords(packing);
+
+    SphericalHarmonics sh;
+    sh.L00 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 0), 0.0);
+    sh.L1_1 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 1), 0.0);
+    sh.L10 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 2), 0.0);
+    sh.L11 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 3), 0.0);
+
+    if (packing == SH_PACKING_L1_HALF) {
+        sh.L2_2 = sh.L2_1 = sh.L20 = sh.L21 = sh.L22 = vec4(0.0);
+    } else {
+        sh.L2_2 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 4), 0.0);
+        sh.L2_1 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 5), 0.0);
+        sh.L20 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 6), 0.0);
+        sh.L21 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 7), 0.0);
+        sh.L22 = vec4(unpackSphericalHarmonicsCoefficient(setIndex, packing, firstWord, 8), 0.0);
+    }
+
+    return sh;
+}
+
+#endif // SPHERICAL_HARMONICS_GLSL
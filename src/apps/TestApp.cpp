@@ -7,6 +7,8 @@
 #include "rendering/nodes/RTDiffuseGINode.h"
 #include "rendering/nodes/RTFirstHitNode.h"
 #include "rendering/nodes/RTReflectionsNode.h"
+#include "rendering/nodes/RTSceneDataNode.h"
+#include "rendering/nodes/SceneGeometryNode.h"
 #include "rendering/nodes/SceneUniformNode.h"
 #include "rendering/nodes/ShadowMapNode.h"
 #include "rendering/nodes/SlowForwardRenderNode.h"
@@ -20,15 +22,18 @@ void TestApp::setup(RenderGraph& graph)
 {
     m_scene = Scene::loadFromFile("assets/Scenes/eval/bunny_test.json");
     m_scene->camera().setMaxSpeed(5.0f);
+    graph.setTextureStreamingBudget(m_scene->textureStreamingBudget());
 
     bool rtxOn = true;
     bool firstHit = true;
 
     graph.addNode<SceneUniformNode>(*m_scene);
+    graph.addNode<SceneGeometryNode>(*m_scene);
     graph.addNode<ShadowMapNode>(*m_scene);
     graph.addNode<SlowForwardRenderNode>(*m_scene);
     if (rtxOn) {
         graph.addNode<RTAccelerationStructures>(*m_scene);
+        graph.addNode<RTSceneDataNode>(*m_scene);
         graph.addNode<RTAmbientOcclusion>(*m_scene);
         graph.addNode<RTDiffuseGINode>(*m_scene);
         if (firstHit) {
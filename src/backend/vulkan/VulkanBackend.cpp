@@ -608,6 +608,9 @@ void VulkanBackend::drawFrame(const AppState& appState, double elapsedTime, doub
 {
     ASSERT(m_renderGraph);
 
+    // (resolve the streaming requests made while recording the previous frame)
+    updateStreamedTextures();
+
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -683,6 +686,12 @@ void VulkanBackend::newBuffer(const Buffer& buffer)
     case Buffer::Usage::StorageBuffer:
         usageFlags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         break;
+    case Buffer::Usage::VertexStorage:
+        usageFlags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        break;
+    case Buffer::Usage::IndexStorage:
+        usageFlags |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        break;
     default:
         ASSERT_NOT_REACHED();
     }
@@ -782,8 +791,11 @@ VulkanBackend::BufferInfo& VulkanBackend::bufferInfo(const Buffer& buffer)
     return bufferInfo;
 }
 
-void VulkanBackend::newTexture(const Texture& texture)
+void VulkanBackend::newTexture(const Texture& texture, uint32_t baseMipLevel)
 {
+    ASSERT(baseMipLevel < texture.mipLevels());
+    uint32_t mipLevelCount = texture.mipLevels() - baseMipLevel;
+
     VkFormat format;
     switch (texture.format()) {
     case Texture::Format::RGBA8:
@@ -801,9 +813,33 @@ void VulkanBackend::newTexture(const Texture& texture)
     case Texture::Format::RGBA32F:
         format = VK_FORMAT_R32G32B32A32_SFLOAT;
         break;
+    case Texture::Format::RGB9E5:
+        format = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+        break;
     case Texture::Format::Depth32F:
         format = VK_FORMAT_D32_SFLOAT;
         break;
+    case Texture::Format::BC1:
+        format = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        break;
+    case Texture::Format::BC1sRGB:
+        format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        break;
+    case Texture::Format::BC3:
+        format = VK_FORMAT_BC3_UNORM_BLOCK;
+        break;
+    case Texture::Format::BC3sRGB:
+        format = VK_FORMAT_BC3_SRGB_BLOCK;
+        break;
+    case Texture::Format::BC5:
+        format = VK_FORMAT_BC5_UNORM_BLOCK;
+        break;
+    case Texture::Format::BC7:
+        format = VK_FORMAT_BC7_UNORM_BLOCK;
+        break;
+    case Texture::Format::BC7sRGB:
+        format = VK_FORMAT_BC7_SRGB_BLOCK;
+        break;
     case Texture::Format::Unknown:
         LogErrorAndExit("Trying to create new texture with format Unknown, which is not allowed!\n");
     default:
@@ -846,8 +882,10 @@ void VulkanBackend::newTexture(const Texture& texture)
 
     VkImageCreateInfo imageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
     imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageCreateInfo.extent = { .width = texture.extent().width(), .height = texture.extent().height(), .depth = 1 };
-    imageCreateInfo.mipLevels = texture.mipLevels();
+    imageCreateInfo.extent = { .width = std::max(1u, texture.extent().width() >> baseMipLevel),
+                               .height = std::max(1u, texture.extent().height() >> baseMipLevel),
+                               .depth = 1 };
+    imageCreateInfo.mipLevels = mipLevelCount;
     imageCreateInfo.arrayLayers = 1;
     imageCreateInfo.usage = usageFlags;
     imageCreateInfo.format = format;
@@ -882,7 +920,7 @@ void VulkanBackend::newTexture(const Texture& texture)
         VK_COMPONENT_SWIZZLE_IDENTITY
     };
     viewCreateInfo.subresourceRange.baseMipLevel = 0;
-    viewCreateInfo.subresourceRange.levelCount = texture.mipLevels();
+    viewCreateInfo.subresourceRange.levelCount = mipLevelCount;
     viewCreateInfo.subresourceRange.baseArrayLayer = 0;
     viewCreateInfo.subresourceRange.layerCount = 1;
 
@@ -970,7 +1008,7 @@ void VulkanBackend::newTexture(const Texture& texture)
         imageBarrier.image = image;
         imageBarrier.subresourceRange.aspectMask = texture.hasDepthFormat() ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
         imageBarrier.subresourceRange.baseMipLevel = 0;
-        imageBarrier.subresourceRange.levelCount = texture.mipLevels();
+        imageBarrier.subresourceRange.levelCount = mipLevelCount;
         imageBarrier.subresourceRange.baseArrayLayer = 0;
         imageBarrier.subresourceRange.layerCount = 1;
 
@@ -998,6 +1036,7 @@ void VulkanBackend::newTexture(const Texture& texture)
     textureInfo.view = imageView;
     textureInfo.sampler = sampler;
     textureInfo.currentLayout = layout;
+    textureInfo.baseMipLevel = baseMipLevel;
 
     size_t index = m_textureInfos.add(textureInfo);
     texture.registerBackend(backendBadge(), index);
@@ -1030,8 +1069,20 @@ void VulkanBackend::updateTexture(const TextureUpdate& update)
     case Texture::Format::sRGBA8:
     case Texture::Format::RGBA16F:
     case Texture::Format::RGBA32F:
+    case Texture::Format::BC1:
+    case Texture::Format::BC1sRGB:
+    case Texture::Format::BC3:
+    case Texture::Format::BC3sRGB:
+    case Texture::Format::BC7:
+    case Texture::Format::BC7sRGB:
         numChannels = 4;
         break;
+    case Texture::Format::RGB9E5:
+        numChannels = 3;
+        break;
+    case Texture::Format::BC5:
+        numChannels = 2;
+        break;
     case Texture::Format::Depth32F:
         numChannels = 1;
         break;
@@ -1042,47 +1093,65 @@ void VulkanBackend::updateTexture(const TextureUpdate& update)
 
     int width, height;
     VkDeviceSize pixelsSize;
+    const void* pixels { nullptr };
+    stbi_uc pixelValueData[4];
 
-    bool isHdr = false;
-    stbi_uc* pixels { nullptr };
-    float* hdrPixels { nullptr };
+    // If the image comes with all mip levels (i.e. generated on the CPU or read from the mipmap cache) we upload them all at once
+    const Image* mipmappedImage { nullptr };
 
     if (update.hasPath()) {
-        if (!FileIO::isFileReadable(update.path())) {
-            LogError("VulkanBackend::updateTexture(): there is no file that can be read at path '%s'.\n", update.path().c_str());
+        // NOTE: The image is decoded on a worker thread (started when the texture was loaded), so this might block
+        const Image& image = update.image();
+        if (!image.isValid()) {
+            LogError("VulkanBackend::updateTexture(): could not load the image at path '%s'.\n", update.path().c_str());
             return;
         }
 
-        isHdr = stbi_is_hdr(update.path().c_str());
+        width = image.info().width;
+        height = image.info().height;
+        pixels = image.pixels();
+        pixelsSize = image.pixelDataSize();
 
-        if (isHdr) {
-            hdrPixels = stbi_loadf(update.path().c_str(), &width, &height, nullptr, numChannels);
-            pixelsSize = width * height * numChannels * sizeof(float);
-        } else {
-            pixels = stbi_load(update.path().c_str(), &width, &height, nullptr, numChannels);
-            pixelsSize = width * height * numChannels * sizeof(stbi_uc);
-        }
-
-        if ((isHdr && !hdrPixels) || (!isHdr && !pixels)) {
-            LogError("VulkanBackend::updateTexture(): stb_image could not read the contents of '%s'.\n", update.path().c_str());
-            return;
+        if (image.componentCount() != numChannels || image.isBlockCompressed() != update.texture().hasBlockCompressedFormat()) {
+            LogErrorAndExit("VulkanBackend::updateTexture(): loaded texture does not match the texture format.\n");
         }
-
         if (Extent2D(width, height) != update.texture().extent()) {
             LogErrorAndExit("VulkanBackend::updateTexture(): loaded texture does not match specified extent.\n");
         }
 
+        if (image.mipLevels().size() > 1) {
+            if (update.texture().mipLevels() == 1) {
+                // (e.g. a cooked image loaded without mipmaps, so only upload the first level)
+                pixelsSize = image.mipLevels()[1].offset;
+            } else if (image.mipLevels().size() != update.texture().mipLevels()) {
+                LogErrorAndExit("VulkanBackend::updateTexture(): loaded texture mip levels does not match the texture.\n");
+            } else {
+                mipmappedImage = &image;
+            }
+        }
+
     } else {
+        ASSERT(!update.texture().hasBlockCompressedFormat());
         width = 1;
         height = 1;
 
         vec4 color = update.pixelValue();
-        pixelsSize = (width * height) * (4 * sizeof(stbi_uc));
-        pixels = (stbi_uc*)malloc(pixelsSize);
-        pixels[0] = (stbi_uc)(mathkit::clamp(color.r, 0.0f, 1.0f) * 255.99f);
-        pixels[1] = (stbi_uc)(mathkit::clamp(color.g, 0.0f, 1.0f) * 255.99f);
-        pixels[2] = (stbi_uc)(mathkit::clamp(color.b, 0.0f, 1.0f) * 255.99f);
-        pixels[3] = (stbi_uc)(mathkit::clamp(color.a, 0.0f, 1.0f) * 255.99f);
+        pixelValueData[0] = (stbi_uc)(mathkit::clamp(color.r, 0.0f, 1.0f) * 255.99f);
+        pixelValueData[1] = (stbi_uc)(mathkit::clamp(color.g, 0.0f, 1.0f) * 255.99f);
+        pixelValueData[2] = (stbi_uc)(mathkit::clamp(color.b, 0.0f, 1.0f) * 255.99f);
+        pixelValueData[3] = (stbi_uc)(mathkit::clamp(color.a, 0.0f, 1.0f) * 255.99f);
+        pixels = pixelValueData;
+        pixelsSize = sizeof(pixelValueData);
+    }
+
+    // Streamed textures only have their resident levels in the image, so only those are uploaded
+    uint32_t baseMipLevel = textureInfo(update.texture()).baseMipLevel;
+    size_t baseLevelOffset = 0;
+    if (baseMipLevel > 0) {
+        ASSERT(mipmappedImage);
+        baseLevelOffset = mipmappedImage->mipLevels()[baseMipLevel].offset;
+        pixels = static_cast<const uint8_t*>(pixels) + baseLevelOffset;
+        pixelsSize -= baseLevelOffset;
     }
 
     VkBufferCreateInfo bufferCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
@@ -1099,43 +1168,24 @@ void VulkanBackend::updateTexture(const TextureUpdate& update)
         LogError("VulkanBackend::updateTexture(): could not create staging buffer.\n");
     }
 
-    if (!setBufferMemoryUsingMapping(stagingAllocation, isHdr ? (void*)hdrPixels : (void*)pixels, pixelsSize)) {
-        LogError("VulkanBackend::updateTexture(): could set the buffer memory for the staging buffer.\n");
-        return;
-    }
-
     AT_SCOPE_EXIT([&]() {
         vmaDestroyBuffer(m_memoryAllocator, stagingBuffer, stagingAllocation);
-        if (update.hasPath()) {
-            stbi_image_free(pixels);
-        } else {
-            if (isHdr) {
-                stbi_image_free(hdrPixels);
-            } else {
-                stbi_image_free(pixels);
-            }
-        }
     });
 
-    TextureInfo& texInfo = textureInfo(update.texture());
-
-    // NOTE: Since we are updating the texture we don't care what was in the image before. For these cases undefined
-    //  works fine, since it will simply discard/ignore whatever data is in it before.
-    VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-    if (!transitionImageLayout(texInfo.image, update.texture().hasDepthFormat(), oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)) {
-        LogError("VulkanBackend::updateTexture(): could not transition the image to transfer layout.\n");
-    }
-    if (!copyBufferToImage(stagingBuffer, texInfo.image, width, height, update.texture().hasDepthFormat())) {
-        LogError("VulkanBackend::updateTexture(): could not copy the staging buffer to the image.\n");
+    if (!setBufferMemoryUsingMapping(stagingAllocation, pixels, pixelsSize)) {
+        LogError("VulkanBackend::updateTexture(): could set the buffer memory for the staging buffer.\n");
+        return;
     }
 
+    TextureInfo& texInfo = textureInfo(update.texture());
+    bool isDepthFormat = update.texture().hasDepthFormat();
+
     VkImageLayout finalLayout;
     switch (update.texture().usage()) {
     case Texture::Usage::AttachAndSample:
         // We probably want to render to it before sampling from it
     case Texture::Usage::Attachment:
-        finalLayout = update.texture().hasDepthFormat() ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        finalLayout = isDepthFormat ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         break;
     case Texture::Usage::Sampled:
         finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -1144,19 +1194,149 @@ void VulkanBackend::updateTexture(const TextureUpdate& update)
         finalLayout = VK_IMAGE_LAYOUT_GENERAL;
         break;
     }
+
+    // NOTE: Since we are updating the texture we don't care what was in the image before. For these cases undefined
+    //  works fine, since it will simply discard/ignore whatever data is in it before.
+    VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (mipmappedImage) {
+        uint32_t mipLevelCount = update.texture().mipLevels() - baseMipLevel;
+
+        std::vector<VkBufferImageCopy> regions {};
+        for (uint32_t level = 0; level < mipLevelCount; ++level) {
+            const Image::MipLevel& mipLevel = mipmappedImage->mipLevels()[baseMipLevel + level];
+
+            VkBufferImageCopy region = {};
+            region.bufferOffset = mipLevel.offset - baseLevelOffset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageOffset = VkOffset3D { 0, 0, 0 };
+            region.imageExtent = VkExtent3D { uint32_t(mipLevel.width), uint32_t(mipLevel.height), 1 };
+            region.imageSubresource.aspectMask = isDepthFormat ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            regions.push_back(region);
+        }
+
+        if (!transitionImageLayout(texInfo.image, isDepthFormat, oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, nullptr, mipLevelCount)) {
+            LogError("VulkanBackend::updateTexture(): could not transition the image to transfer layout.\n");
+        }
+        if (!copyBufferToImage(stagingBuffer, texInfo.image, regions)) {
+            LogError("VulkanBackend::updateTexture(): could not copy the staging buffer to the image.\n");
+        }
+        if (!transitionImageLayout(texInfo.image, isDepthFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout, nullptr, mipLevelCount)) {
+            LogError("VulkanBackend::updateTexture(): could not transition the image to the final image layout.\n");
+        }
+
+        texInfo.currentLayout = finalLayout;
+        return;
+    }
+
+    if (!transitionImageLayout(texInfo.image, isDepthFormat, oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)) {
+        LogError("VulkanBackend::updateTexture(): could not transition the image to transfer layout.\n");
+    }
+    if (!copyBufferToImage(stagingBuffer, texInfo.image, width, height, isDepthFormat)) {
+        LogError("VulkanBackend::updateTexture(): could not copy the staging buffer to the image.\n");
+    }
+
     texInfo.currentLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 
+    // (fallback for when the mipmaps weren't generated on the CPU, which we can't do for block compressed textures)
     auto extent = update.texture().extent();
-    if (update.generateMipmaps() && extent.width() > 1 && extent.height() > 1) {
+    if (update.generateMipmaps() && !update.texture().hasBlockCompressedFormat() && extent.width() > 1 && extent.height() > 1) {
         generateMipmaps(update.texture(), finalLayout);
     } else {
-        if (!transitionImageLayout(texInfo.image, update.texture().hasDepthFormat(), texInfo.currentLayout, finalLayout)) {
+        if (!transitionImageLayout(texInfo.image, isDepthFormat, texInfo.currentLayout, finalLayout)) {
             LogError("VulkanBackend::updateTexture(): could not transition the image to the final image layout.\n");
         }
     }
     texInfo.currentLayout = finalLayout;
 }
 
+void VulkanBackend::updateStreamedTextures()
+{
+    TextureStreamer& streamer = m_nodeRegistry->textureStreamer();
+    if (!streamer.isEnabled()) {
+        return;
+    }
+
+    std::vector<const Texture*> changedTextures = streamer.updateResidency();
+    if (changedTextures.empty()) {
+        return;
+    }
+
+    // Textures are reallocated with only the new set of resident levels, and since the frame in flight might still be
+    // sampling from the old images (and the descriptor sets below are rewritten in place) we have to let it finish first.
+    // NOTE: This stalls, and so does each upload since they wait for the queue to idle (see issueSingleTimeCommand), which
+    //  is why the streamer limits how much is streamed in per frame.
+    // TODO: Record all uploads into one command buffer & defer the old images and descriptor writes per frame in flight
+    vkDeviceWaitIdle(device());
+
+    for (const Texture* texture : changedTextures) {
+        deleteTexture(*texture);
+        newTexture(*texture, streamer.residentMipLevel(*texture));
+        updateTexture(streamer.textureUpdate(*texture));
+    }
+
+    updateTextureDescriptors(changedTextures);
+}
+
+void VulkanBackend::updateTextureDescriptors(const std::vector<const Texture*>& textures)
+{
+    std::unordered_set<const Texture*> changedTextures { textures.begin(), textures.end() };
+
+    std::vector<VkWriteDescriptorSet> descriptorSetWrites {};
+    std::vector<VkDescriptorImageInfo> descImageInfos {};
+
+    auto writeBindingSets = [&](const Registry& registry) {
+        for (const BindingSet& bindingSet : registry.bindingSets()) {
+            VkDescriptorSet descriptorSet = bindingSetInfo(bindingSet).descriptorSet;
+            for (const ShaderBinding& bindingInfo : bindingSet.shaderBindings()) {
+                if (bindingInfo.type != ShaderBindingType::TextureSampler && bindingInfo.type != ShaderBindingType::TextureSamplerArray) {
+                    continue;
+                }
+
+                // (see newBindingSet, unused array elements are filled with the first texture)
+                uint32_t elementCount = (bindingInfo.type == ShaderBindingType::TextureSamplerArray) ? bindingInfo.count : 1;
+                for (uint32_t element = 0; element < elementCount; ++element) {
+                    const Texture* texture = (element < bindingInfo.textures.size()) ? bindingInfo.textures[element] : bindingInfo.textures.front();
+                    if (changedTextures.find(texture) == changedTextures.end()) {
+                        continue;
+                    }
+
+                    const TextureInfo& texInfo = textureInfo(*texture);
+                    VkDescriptorImageInfo descImageInfo {};
+                    descImageInfo.sampler = texInfo.sampler;
+                    descImageInfo.imageView = texInfo.view;
+                    descImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                    descImageInfos.push_back(descImageInfo);
+
+                    VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                    write.dstSet = descriptorSet;
+                    write.dstBinding = bindingInfo.bindingIndex;
+                    write.dstArrayElement = element;
+                    write.descriptorCount = 1;
+                    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    descriptorSetWrites.push_back(write);
+                }
+            }
+        }
+    };
+
+    writeBindingSets(*m_nodeRegistry);
+    for (auto& frameRegistry : m_frameRegistries) {
+        writeBindingSets(*frameRegistry);
+    }
+
+    // (set the pointers last, since the image info vector might reallocate while we add to it)
+    for (size_t i = 0; i < descriptorSetWrites.size(); ++i) {
+        descriptorSetWrites[i].pImageInfo = &descImageInfos[i];
+    }
+
+    vkUpdateDescriptorSets(device(), descriptorSetWrites.size(), descriptorSetWrites.data(), 0, nullptr);
+}
+
 void VulkanBackend::generateMipmaps(const Texture& texture, VkImageLayout finalLayout)
 {
     ASSERT(texture.hasMipmaps());
@@ -1942,6 +2122,24 @@ void VulkanBackend::newRenderState(const RenderState& renderState)
             case VertexAttributeType::Float4:
                 format = VK_FORMAT_R32G32B32A32_SFLOAT;
                 break;
+            case VertexAttributeType::Half2:
+                format = VK_FORMAT_R16G16_SFLOAT;
+                break;
+            case VertexAttributeType::Half4:
+                format = VK_FORMAT_R16G16B16A16_SFLOAT;
+                break;
+            case VertexAttributeType::UNorm16x2:
+                format = VK_FORMAT_R16G16_UNORM;
+                break;
+            case VertexAttributeType::UNorm16x4:
+                format = VK_FORMAT_R16G16B16A16_UNORM;
+                break;
+            case VertexAttributeType::SNorm16x2:
+                format = VK_FORMAT_R16G16_SNORM;
+                break;
+            case VertexAttributeType::SNorm16x4:
+                format = VK_FORMAT_R16G16B16A16_SNORM;
+                break;
             }
             description.format = format;
 
@@ -2187,12 +2385,8 @@ void VulkanBackend::deleteRenderState(const RenderState& renderState)
     renderState.unregisterBackend(backendBadge());
 }
 
-void VulkanBackend::newBottomLevelAccelerationStructure(const BottomLevelAS& blas)
+std::vector<VkGeometryNV> VulkanBackend::createGeometriesForBottomLevelAccelerationStructure(const BottomLevelAS& blas, std::vector<std::pair<VkBuffer, VmaAllocation>>& associatedBuffers)
 {
-    if (!m_rtx.has_value()) {
-        LogErrorAndExit("Trying to create a bottom level acceleration structure, but there is no ray tracing support!\n");
-    }
-
     // All geometries in a BLAS must have the same type (i.e. AABB/triangles)
     bool isTriangleBLAS = blas.geometries().front().hasTriangles();
     for (size_t i = 1; i < blas.geometries().size(); ++i) {
@@ -2238,9 +2432,9 @@ void VulkanBackend::newBottomLevelAccelerationStructure(const BottomLevelAS& bla
             VkGeometryTrianglesNV triangles { VK_STRUCTURE_TYPE_GEOMETRY_TRIANGLES_NV };
 
             triangles.vertexData = bufferInfo(triGeo.vertexBuffer).buffer;
-            triangles.vertexOffset = 0;
+            triangles.vertexOffset = triGeo.vertexByteOffset;
             triangles.vertexStride = triGeo.vertexStride;
-            triangles.vertexCount = triGeo.vertexBuffer.size() / triangles.vertexStride;
+            triangles.vertexCount = triGeo.vertexCount;
             switch (triGeo.vertexFormat) {
             case VertexFormat::XYZ32F:
                 triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
@@ -2248,15 +2442,14 @@ void VulkanBackend::newBottomLevelAccelerationStructure(const BottomLevelAS& bla
             }
 
             triangles.indexData = bufferInfo(triGeo.indexBuffer).buffer;
-            triangles.indexOffset = 0;
+            triangles.indexOffset = triGeo.indexByteOffset;
+            triangles.indexCount = triGeo.indexCount;
             switch (triGeo.indexType) {
             case IndexType::UInt16:
                 triangles.indexType = VK_INDEX_TYPE_UINT16;
-                triangles.indexCount = triGeo.indexBuffer.size() / sizeof(uint16_t);
                 break;
             case IndexType::UInt32:
                 triangles.indexType = VK_INDEX_TYPE_UINT32;
-                triangles.indexCount = triGeo.indexBuffer.size() / sizeof(uint32_t);
                 break;
             }
 
@@ -2300,18 +2493,157 @@ void VulkanBackend::newBottomLevelAccelerationStructure(const BottomLevelAS& bla
         }
     }
 
-    VkAccelerationStructureInfoNV accelerationStructureInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV };
-    accelerationStructureInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
-    accelerationStructureInfo.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_NV;
-    accelerationStructureInfo.instanceCount = 0;
-    accelerationStructureInfo.geometryCount = geometries.size();
-    accelerationStructureInfo.pGeometries = geometries.data();
+    if (isTriangleBLAS) {
+        // (should persist for the lifetime of this BLAS)
+        associatedBuffers.push_back({ transformBuffer, transformBufferAllocation });
+    }
 
-    VkAccelerationStructureCreateInfoNV accelerationStructureCreateInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_NV };
-    accelerationStructureCreateInfo.info = accelerationStructureInfo;
+    return geometries;
+}
+
+void VulkanBackend::newBottomLevelAccelerationStructures(const std::vector<BottomLevelAS>& blases)
+{
+    if (blases.empty()) {
+        return;
+    }
+
+    if (!m_rtx.has_value()) {
+        LogErrorAndExit("Trying to create a bottom level acceleration structure, but there is no ray tracing support!\n");
+    }
+
+    // All BLASes are built in a single command buffer with a shared scratch buffer, instead of waiting for the queue once
+    // per BLAS. When built we query their compacted sizes and copy them into new (compacted) acceleration structures.
+    auto flags = VkBuildAccelerationStructureFlagsNV(VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_NV | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_NV);
+
+    std::vector<std::vector<VkGeometryNV>> geometries(blases.size());
+    std::vector<AccelerationStructureInfo> infos(blases.size());
+    std::vector<VkAccelerationStructureNV> accelerationStructures(blases.size());
+
+    VkDeviceSize scratchSize = 0;
+    VkDeviceSize totalSize = 0;
+
+    for (size_t i = 0; i < blases.size(); ++i) {
+        geometries[i] = createGeometriesForBottomLevelAccelerationStructure(blases[i], infos[i].associatedBuffers);
+
+        VkAccelerationStructureCreateInfoNV accelerationStructureCreateInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_NV };
+        accelerationStructureCreateInfo.info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
+        accelerationStructureCreateInfo.info.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
+        accelerationStructureCreateInfo.info.flags = flags;
+        accelerationStructureCreateInfo.info.instanceCount = 0;
+        accelerationStructureCreateInfo.info.geometryCount = geometries[i].size();
+        accelerationStructureCreateInfo.info.pGeometries = geometries[i].data();
+
+        VkDeviceSize memorySize;
+        accelerationStructures[i] = createAccelerationStructureWithMemory(accelerationStructureCreateInfo, infos[i].memory, &memorySize);
+        totalSize += memorySize;
+
+        scratchSize = std::max(scratchSize, scratchBufferSizeForAccelerationStructure(accelerationStructures[i], false));
+    }
+
+    VmaAllocation scratchAllocation;
+    VkBuffer scratchBuffer = createScratchBuffer(scratchSize, scratchAllocation);
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_NV;
+    queryPoolCreateInfo.queryCount = blases.size();
+    VkQueryPool queryPool;
+    if (vkCreateQueryPool(device(), &queryPoolCreateInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        LogErrorAndExit("Error trying to create query pool for the acceleration structure compacted sizes\n");
+    }
+
+    this->issueSingleTimeCommand([&](VkCommandBuffer commandBuffer) {
+        vkCmdResetQueryPool(commandBuffer, queryPool, 0, blases.size());
+
+        // (the scratch buffer is reused, so every build has to finish before the next one can start)
+        VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+        barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV;
+        barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_NV | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_NV;
+
+        for (size_t i = 0; i < blases.size(); ++i) {
+            VkAccelerationStructureInfoNV buildInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV };
+            buildInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
+            buildInfo.flags = flags;
+            buildInfo.geometryCount = geometries[i].size();
+            buildInfo.pGeometries = geometries[i].data();
+
+            m_rtx->vkCmdBuildAccelerationStructureNV(
+                commandBuffer,
+                &buildInfo,
+                VK_NULL_HANDLE, 0,
+                VK_FALSE,
+                accelerationStructures[i],
+                VK_NULL_HANDLE,
+                scratchBuffer, 0);
+
+            vkCmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
+                                 VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_NV,
+                                 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+
+        m_rtx->vkCmdWriteAccelerationStructuresPropertiesNV(commandBuffer,
+                                                            accelerationStructures.size(), accelerationStructures.data(),
+                                                            VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_NV,
+                                                            queryPool, 0);
+    });
+
+    vmaDestroyBuffer(m_memoryAllocator, scratchBuffer, scratchAllocation);
+
+    std::vector<VkDeviceSize> compactedSizes(blases.size());
+    if (vkGetQueryPoolResults(device(), queryPool, 0, blases.size(),
+                              compactedSizes.size() * sizeof(VkDeviceSize), compactedSizes.data(), sizeof(VkDeviceSize),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT)
+        != VK_SUCCESS) {
+        LogErrorAndExit("Error trying to get the acceleration structure compacted sizes\n");
+    }
+    vkDestroyQueryPool(device(), queryPool, nullptr);
+
+    VkDeviceSize totalCompactedSize = 0;
+    std::vector<VkDeviceMemory> uncompactedMemory(blases.size());
+    for (size_t i = 0; i < blases.size(); ++i) {
+        uncompactedMemory[i] = infos[i].memory;
+
+        // (when a compacted size is given the geometries aren't needed, the size is all that matters)
+        VkAccelerationStructureCreateInfoNV compactedCreateInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_NV };
+        compactedCreateInfo.compactedSize = compactedSizes[i];
+        compactedCreateInfo.info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV;
+        compactedCreateInfo.info.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
+        compactedCreateInfo.info.flags = flags;
+
+        VkDeviceSize memorySize;
+        infos[i].accelerationStructure = createAccelerationStructureWithMemory(compactedCreateInfo, infos[i].memory, &memorySize);
+        totalCompactedSize += memorySize;
+    }
+
+    this->issueSingleTimeCommand([&](VkCommandBuffer commandBuffer) {
+        for (size_t i = 0; i < blases.size(); ++i) {
+            m_rtx->vkCmdCopyAccelerationStructureNV(commandBuffer,
+                                                    infos[i].accelerationStructure, accelerationStructures[i],
+                                                    VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_NV);
+        }
+    });
+
+    for (size_t i = 0; i < blases.size(); ++i) {
+        m_rtx->vkDestroyAccelerationStructureNV(device(), accelerationStructures[i], nullptr);
+        vkFreeMemory(device(), uncompactedMemory[i], nullptr);
+
+        if (m_rtx->vkGetAccelerationStructureHandleNV(device(), infos[i].accelerationStructure, sizeof(uint64_t), &infos[i].handle) != VK_SUCCESS) {
+            LogErrorAndExit("Error trying to get acceleration structure handle\n");
+        }
+
+        size_t index = m_accStructInfos.add(infos[i]);
+        blases[i].registerBackend(backendBadge(), index);
+    }
+
+    LogInfo("VulkanBackend: built %zu bottom level acceleration structures, compacted from %.2f MB to %.2f MB\n",
+            blases.size(), totalSize / (1024.0 * 1024.0), totalCompactedSize / (1024.0 * 1024.0));
+}
+
+VkAccelerationStructureNV VulkanBackend::createAccelerationStructureWithMemory(const VkAccelerationStructureCreateInfoNV& createInfo, VkDeviceMemory& memory, VkDeviceSize* memorySize) const
+{
     VkAccelerationStructureNV accelerationStructure;
-    if (m_rtx->vkCreateAccelerationStructureNV(device(), &accelerationStructureCreateInfo, nullptr, &accelerationStructure) != VK_SUCCESS) {
-        LogErrorAndExit("Error trying to create bottom level acceleration structure\n");
+    if (m_rtx->vkCreateAccelerationStructureNV(device(), &createInfo, nullptr, &accelerationStructure) != VK_SUCCESS) {
+        LogErrorAndExit("Error trying to create acceleration structure\n");
     }
 
     VkAccelerationStructureMemoryRequirementsInfoNV memoryRequirementsInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_NV };
@@ -2323,7 +2655,6 @@ void VulkanBackend::newBottomLevelAccelerationStructure(const BottomLevelAS& bla
     VkMemoryAllocateInfo memoryAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
     memoryAllocateInfo.allocationSize = memoryRequirements2.memoryRequirements.size;
     memoryAllocateInfo.memoryTypeIndex = findAppropriateMemory(memoryRequirements2.memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    VkDeviceMemory memory;
     if (vkAllocateMemory(device(), &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS) {
         LogErrorAndExit("Error trying to create allocate memory for acceleration structure\n");
     }
@@ -2335,45 +2666,11 @@ void VulkanBackend::newBottomLevelAccelerationStructure(const BottomLevelAS& bla
         LogErrorAndExit("Error trying to bind memory to acceleration structure\n");
     }
 
-    uint64_t handle { 0 };
-    if (m_rtx->vkGetAccelerationStructureHandleNV(device(), accelerationStructure, sizeof(uint64_t), &handle) != VK_SUCCESS) {
-        LogErrorAndExit("Error trying to get acceleration structure handle\n");
+    if (memorySize) {
+        *memorySize = memoryAllocateInfo.allocationSize;
     }
 
-    VmaAllocation scratchAllocation;
-    VkBuffer scratchBuffer = createScratchBufferForAccelerationStructure(accelerationStructure, false, scratchAllocation);
-
-    VkAccelerationStructureInfoNV buildInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_INFO_NV };
-    buildInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_NV;
-    buildInfo.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_NV;
-    buildInfo.geometryCount = geometries.size();
-    buildInfo.pGeometries = geometries.data();
-
-    this->issueSingleTimeCommand([&](VkCommandBuffer commandBuffer) {
-        m_rtx->vkCmdBuildAccelerationStructureNV(
-            commandBuffer,
-            &buildInfo,
-            VK_NULL_HANDLE, 0,
-            VK_FALSE,
-            accelerationStructure,
-            VK_NULL_HANDLE,
-            scratchBuffer, 0);
-    });
-
-    vmaDestroyBuffer(m_memoryAllocator, scratchBuffer, scratchAllocation);
-
-    AccelerationStructureInfo info {};
-    info.accelerationStructure = accelerationStructure;
-    info.memory = memory;
-    info.handle = handle;
-
-    if (isTriangleBLAS) {
-        // (should persist for the lifetime of this BLAS)
-        info.associatedBuffers.push_back({ transformBuffer, transformBufferAllocation });
-    }
-
-    size_t index = m_accStructInfos.add(info);
-    blas.registerBackend(backendBadge(), index);
+    return accelerationStructure;
 }
 
 void VulkanBackend::deleteBottomLevelAccelerationStructure(const BottomLevelAS& blas)
@@ -2569,6 +2866,8 @@ void VulkanBackend::newRayTracingState(const RayTracingState& rtState)
     }
 
     // HitGroups
+    // (the same shaders can be used by many hit groups, e.g. with different shader records, so only create one stage per shader)
+    std::unordered_map<std::string, uint32_t> hitShaderStageIndices {};
     for (const HitGroup& hitGroup : sbt.hitGroups()) {
 
         VkRayTracingShaderGroupCreateInfoNV shaderGroup = { VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_NV };
@@ -2583,7 +2882,9 @@ void VulkanBackend::newRayTracingState(const RayTracingState& rtState)
         shaderGroup.intersectionShader = VK_SHADER_UNUSED_NV;
 
         // ClosestHit
-        {
+        if (auto entry = hitShaderStageIndices.find(hitGroup.closestHit().path()); entry != hitShaderStageIndices.end()) {
+            shaderGroup.closestHitShader = entry->second;
+        } else {
             VkShaderModuleCreateInfo moduleCreateInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
             const std::vector<uint32_t>& spirv = ShaderManager::instance().spirv(hitGroup.closestHit().path());
             moduleCreateInfo.codeSize = sizeof(uint32_t) * spirv.size();
@@ -2601,12 +2902,17 @@ void VulkanBackend::newRayTracingState(const RayTracingState& rtState)
             stageCreateInfo.pName = "main";
 
             shaderGroup.closestHitShader = shaderStages.size();
+            hitShaderStageIndices[hitGroup.closestHit().path()] = shaderGroup.closestHitShader;
             shaderStages.push_back(stageCreateInfo);
         }
 
         ASSERT(!hitGroup.hasAnyHitShader()); // for now!
 
-        if (hitGroup.hasIntersectionShader()) {
+        if (!hitGroup.hasIntersectionShader()) {
+            // (no intersection shader, i.e. the built-in triangle intersection)
+        } else if (auto entry = hitShaderStageIndices.find(hitGroup.intersection().path()); entry != hitShaderStageIndices.end()) {
+            shaderGroup.intersectionShader = entry->second;
+        } else {
             VkShaderModuleCreateInfo moduleCreateInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
             const std::vector<uint32_t>& spirv = ShaderManager::instance().spirv(hitGroup.intersection().path());
             moduleCreateInfo.codeSize = sizeof(uint32_t) * spirv.size();
@@ -2624,6 +2930,7 @@ void VulkanBackend::newRayTracingState(const RayTracingState& rtState)
             stageCreateInfo.pName = "main";
 
             shaderGroup.intersectionShader = shaderStages.size();
+            hitShaderStageIndices[hitGroup.intersection().path()] = shaderGroup.intersectionShader;
             shaderStages.push_back(stageCreateInfo);
         }
 
@@ -2702,6 +3009,16 @@ void VulkanBackend::newRayTracingState(const RayTracingState& rtState)
                       sbtData.begin() + dstOffset);
         }
 
+        // Shader records for the hit groups go right after their handles (the groups are ordered raygen, hit groups, miss)
+        for (size_t hitGroupIdx = 0; hitGroupIdx < sbt.hitGroups().size(); ++hitGroupIdx) {
+            const std::vector<uint32_t>& shaderRecord = sbt.hitGroups()[hitGroupIdx].shaderRecord();
+            size_t shaderRecordSize = shaderRecord.size() * sizeof(uint32_t);
+            ASSERT(sizeOfSingleHandle + shaderRecordSize <= baseAlignment);
+
+            uint32_t dstOffset = (1 + hitGroupIdx) * baseAlignment + sizeOfSingleHandle;
+            std::memcpy(sbtData.data() + dstOffset, shaderRecord.data(), shaderRecordSize);
+        }
+
         VkBufferCreateInfo sbtBufferCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
         sbtBufferCreateInfo.usage = VK_BUFFER_USAGE_RAY_TRACING_BIT_NV;
         sbtBufferCreateInfo.size = sbtSize;
@@ -2915,7 +3232,7 @@ void VulkanBackend::reconstructRenderGraphResources(RenderGraph& renderGraph)
     std::vector<std::unique_ptr<Registry>> frameRegistries {};
     for (uint32_t i = 0; i < numFrameManagers; ++i) {
         const RenderTarget& windowRenderTargetForFrame = m_swapchainMockRenderTargets[i];
-        frameRegistries.push_back(std::make_unique<Registry>(&windowRenderTargetForFrame));
+        frameRegistries.push_back(std::make_unique<Registry>(&windowRenderTargetForFrame, nodeRegistry.get()));
     }
 
     // TODO: Fix me, this is stupid..
@@ -2991,7 +3308,7 @@ void VulkanBackend::replaceResourcesForRegistry(Registry* previous, Registry* cu
             updateBuffer(bufferUpdate);
         }
         for (auto& texture : current->textures()) {
-            newTexture(texture);
+            newTexture(texture, current->textureStreamer().residentMipLevel(texture));
         }
         for (auto& textureUpdate : current->textureUpdates()) {
             updateTexture(textureUpdate);
@@ -2999,9 +3316,7 @@ void VulkanBackend::replaceResourcesForRegistry(Registry* previous, Registry* cu
         for (auto& renderTarget : current->renderTargets()) {
             newRenderTarget(renderTarget);
         }
-        for (auto& bottomLevelAS : current->bottomLevelAS()) {
-            newBottomLevelAccelerationStructure(bottomLevelAS);
-        }
+        newBottomLevelAccelerationStructures(current->bottomLevelAS());
         for (auto& topLevelAS : current->topLevelAS()) {
             newTopLevelAccelerationStructure(topLevelAS);
         }
@@ -3167,7 +3482,7 @@ void VulkanBackend::transitionImageLayoutDEBUG(VkImage image, VkImageLayout oldL
                          1, &imageMemoryBarrier);
 }
 
-bool VulkanBackend::transitionImageLayout(VkImage image, bool isDepthFormat, VkImageLayout oldLayout, VkImageLayout newLayout, VkCommandBuffer* currentCommandBuffer) const
+bool VulkanBackend::transitionImageLayout(VkImage image, bool isDepthFormat, VkImageLayout oldLayout, VkImageLayout newLayout, VkCommandBuffer* currentCommandBuffer, uint32_t mipLevelCount) const
 {
     if (oldLayout == newLayout) {
         LogWarning("VulkanBackend::transitionImageLayout(): old & new layout identical, ignoring.\n");
@@ -3183,7 +3498,7 @@ bool VulkanBackend::transitionImageLayout(VkImage image, bool isDepthFormat, VkI
     imageBarrier.image = image;
     imageBarrier.subresourceRange.aspectMask = isDepthFormat ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
     imageBarrier.subresourceRange.baseMipLevel = 0;
-    imageBarrier.subresourceRange.levelCount = 1;
+    imageBarrier.subresourceRange.levelCount = mipLevelCount;
     imageBarrier.subresourceRange.baseArrayLayer = 0;
     imageBarrier.subresourceRange.layerCount = 1;
 
@@ -3298,9 +3613,14 @@ bool VulkanBackend::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t w
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
 
+    return copyBufferToImage(buffer, image, { region });
+}
+
+bool VulkanBackend::copyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions) const
+{
     bool success = issueSingleTimeCommand([&](VkCommandBuffer commandBuffer) {
         // TODO/NOTE: This assumes that the image we are copying to has the VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL layout!
-        vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data());
     });
 
     if (!success) {
@@ -3311,10 +3631,10 @@ bool VulkanBackend::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t w
     return true;
 }
 
-VkBuffer VulkanBackend::createScratchBufferForAccelerationStructure(VkAccelerationStructureNV accelerationStructure, bool updateInPlace, VmaAllocation& allocation) const
+VkDeviceSize VulkanBackend::scratchBufferSizeForAccelerationStructure(VkAccelerationStructureNV accelerationStructure, bool updateInPlace) const
 {
     if (!m_rtx.has_value()) {
-        LogErrorAndExit("Trying to create a RTX scratch buffer, but there is no ray tracing support!\n");
+        LogErrorAndExit("Trying to get a RTX scratch buffer size, but there is no ray tracing support!\n");
     }
 
     VkAccelerationStructureMemoryRequirementsInfoNV memoryRequirementsInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_NV };
@@ -3326,10 +3646,15 @@ VkBuffer VulkanBackend::createScratchBufferForAccelerationStructure(VkAccelerati
     memoryRequirementsInfo.accelerationStructure = accelerationStructure;
     m_rtx->vkGetAccelerationStructureMemoryRequirementsNV(device(), &memoryRequirementsInfo, &scratchMemRequirements2);
 
+    return scratchMemRequirements2.memoryRequirements.size;
+}
+
+VkBuffer VulkanBackend::createScratchBuffer(VkDeviceSize size, VmaAllocation& allocation) const
+{
     VkBufferCreateInfo scratchBufferCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     scratchBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     scratchBufferCreateInfo.usage = VK_BUFFER_USAGE_RAY_TRACING_BIT_NV;
-    scratchBufferCreateInfo.size = scratchMemRequirements2.memoryRequirements.size;
+    scratchBufferCreateInfo.size = size;
 
     if (debugMode) {
         // for nsight debugging & similar stuff)
@@ -3341,12 +3666,17 @@ VkBuffer VulkanBackend::createScratchBufferForAccelerationStructure(VkAccelerati
 
     VkBuffer scratchBuffer;
     if (vmaCreateBuffer(m_memoryAllocator, &scratchBufferCreateInfo, &scratchAllocCreateInfo, &scratchBuffer, &allocation, nullptr) != VK_SUCCESS) {
-        LogError("VulkanBackend::createScratchBufferForAccelerationStructure(): could not create scratch buffer.\n");
+        LogError("VulkanBackend::createScratchBuffer(): could not create scratch buffer.\n");
     }
 
     return scratchBuffer;
 }
 
+VkBuffer VulkanBackend::createScratchBufferForAccelerationStructure(VkAccelerationStructureNV accelerationStructure, bool updateInPlace, VmaAllocation& allocation) const
+{
+    return createScratchBuffer(scratchBufferSizeForAccelerationStructure(accelerationStructure, updateInPlace), allocation);
+}
+
 VkBuffer VulkanBackend::createRTXInstanceBuffer(std::vector<RTGeometryInstance> instances, VmaAllocation& allocation)
 {
     if (!m_rtx.has_value()) {
@@ -59,11 +59,14 @@ private:
     void updateBuffer(const BufferUpdate&);
     void updateBuffer(const Buffer& buffer, const std::byte*, size_t);
 
-    void newTexture(const Texture&);
+    void newTexture(const Texture&, uint32_t baseMipLevel = 0);
     void deleteTexture(const Texture&);
     void updateTexture(const TextureUpdate&);
     void generateMipmaps(const Texture&, VkImageLayout finalLayout);
 
+    void updateStreamedTextures();
+    void updateTextureDescriptors(const std::vector<const Texture*>&);
+
     void newRenderTarget(const RenderTarget&);
     void deleteRenderTarget(const RenderTarget&);
     void setupWindowRenderTargets();
@@ -76,7 +79,7 @@ private:
     void deleteRenderState(const RenderState&);
 
     // Maybe move to VulkanRTX or similar. In theory we might want multiple possible RT backends, e.g. OptiX vs RTX
-    void newBottomLevelAccelerationStructure(const BottomLevelAS&);
+    void newBottomLevelAccelerationStructures(const std::vector<BottomLevelAS>&);
     void deleteBottomLevelAccelerationStructure(const BottomLevelAS&);
 
     void newTopLevelAccelerationStructure(const TopLevelAS&);
@@ -131,9 +134,15 @@ private:
 
     void transitionImageLayoutDEBUG(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags, VkCommandBuffer) const;
 
-    bool transitionImageLayout(VkImage, bool isDepthFormat, VkImageLayout oldLayout, VkImageLayout newLayout, VkCommandBuffer* = nullptr) const;
+    bool transitionImageLayout(VkImage, bool isDepthFormat, VkImageLayout oldLayout, VkImageLayout newLayout, VkCommandBuffer* = nullptr, uint32_t mipLevelCount = 1) const;
     bool copyBufferToImage(VkBuffer, VkImage, uint32_t width, uint32_t height, bool isDepthImage) const;
+    bool copyBufferToImage(VkBuffer, VkImage, const std::vector<VkBufferImageCopy>& regions) const;
+
+    std::vector<VkGeometryNV> createGeometriesForBottomLevelAccelerationStructure(const BottomLevelAS&, std::vector<std::pair<VkBuffer, VmaAllocation>>& associatedBuffers);
+    VkAccelerationStructureNV createAccelerationStructureWithMemory(const VkAccelerationStructureCreateInfoNV&, VkDeviceMemory&, VkDeviceSize* memorySize = nullptr) const;
 
+    VkDeviceSize scratchBufferSizeForAccelerationStructure(VkAccelerationStructureNV, bool updateInPlace) const;
+    VkBuffer createScratchBuffer(VkDeviceSize, VmaAllocation&) const;
     VkBuffer createScratchBufferForAccelerationStructure(VkAccelerationStructureNV, bool updateInPlace, VmaAllocation&) const;
     VkBuffer createRTXInstanceBuffer(std::vector<RTGeometryInstance>, VmaAllocation&);
 
@@ -212,6 +221,9 @@ private:
         VkSampler sampler {};
 
         VkImageLayout currentLayout {};
+
+        // The mip level of the texture that is level 0 of the image, which is only non-zero for streamed textures
+        uint32_t baseMipLevel {};
     };
 
     struct RenderTargetInfo {
@@ -78,6 +78,10 @@ void VulkanCommandList::setRenderState(const RenderState& renderState, ClearColo
     activeRayTracingState = nullptr;
     activeComputeState = nullptr;
 
+    m_boundVertexBuffer = VK_NULL_HANDLE;
+    m_boundIndexBuffer = VK_NULL_HANDLE;
+    m_boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
     const RenderTarget& renderTarget = renderState.renderTarget();
     const auto& targetInfo = m_backend.renderTargetInfo(renderTarget);
 
@@ -196,7 +200,7 @@ void VulkanCommandList::setComputeState(const ComputeState& computeState)
     vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeStateInfo.pipeline);
 }
 
-void VulkanCommandList::bindSet(BindingSet& bindingSet, uint32_t index)
+void VulkanCommandList::bindSet(const BindingSet& bindingSet, uint32_t index)
 {
     if (!activeRenderState && !activeRayTracingState && !activeComputeState) {
         LogErrorAndExit("bindSet: no active render or compute or ray tracing state to bind to!\n");
@@ -273,10 +277,12 @@ void VulkanCommandList::draw(Buffer& vertexBuffer, uint32_t vertexCount)
     VkDeviceSize offsets[] = { 0 };
 
     vkCmdBindVertexBuffers(m_commandBuffer, 0, 1, vertexBuffers, offsets);
+    m_boundVertexBuffer = vertBuffer;
+
     vkCmdDraw(m_commandBuffer, vertexCount, 1, 0, 0);
 }
 
-void VulkanCommandList::drawIndexed(Buffer& vertexBuffer, Buffer& indexBuffer, uint32_t indexCount, IndexType indexType, uint32_t instanceIndex)
+void VulkanCommandList::drawIndexed(const Buffer& vertexBuffer, const Buffer& indexBuffer, uint32_t indexCount, IndexType indexType, uint32_t instanceIndex, size_t indexByteOffset, int32_t vertexOffset)
 {
     if (!activeRenderState) {
         LogErrorAndExit("drawIndexed: no active render state!\n");
@@ -285,36 +291,53 @@ void VulkanCommandList::drawIndexed(Buffer& vertexBuffer, Buffer& indexBuffer, u
     VkBuffer vertBuffer = m_backend.bufferInfo(vertexBuffer).buffer;
     VkBuffer idxBuffer = m_backend.bufferInfo(indexBuffer).buffer;
 
-    VkBuffer vertexBuffers[] = { vertBuffer };
-    VkDeviceSize offsets[] = { 0 };
-
     VkIndexType vkIndexType;
+    size_t indexSize;
     switch (indexType) {
     case IndexType::UInt16:
         vkIndexType = VK_INDEX_TYPE_UINT16;
+        indexSize = sizeof(uint16_t);
         break;
     case IndexType::UInt32:
         vkIndexType = VK_INDEX_TYPE_UINT32;
+        indexSize = sizeof(uint32_t);
         break;
     }
 
-    vkCmdBindVertexBuffers(m_commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(m_commandBuffer, idxBuffer, 0, vkIndexType);
-    vkCmdDrawIndexed(m_commandBuffer, indexCount, 1, 0, 0, instanceIndex);
+    if (vertBuffer != m_boundVertexBuffer) {
+        VkBuffer vertexBuffers[] = { vertBuffer };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(m_commandBuffer, 0, 1, vertexBuffers, offsets);
+        m_boundVertexBuffer = vertBuffer;
+    }
+
+    // The index buffer is always bound from the start, and the offset is applied as the first index instead, so that
+    // the binding can be shared by all draws with the same index type
+    if (idxBuffer != m_boundIndexBuffer || vkIndexType != m_boundIndexType) {
+        vkCmdBindIndexBuffer(m_commandBuffer, idxBuffer, 0, vkIndexType);
+        m_boundIndexBuffer = idxBuffer;
+        m_boundIndexType = vkIndexType;
+    }
+
+    ASSERT(indexByteOffset % indexSize == 0);
+    uint32_t firstIndex = static_cast<uint32_t>(indexByteOffset / indexSize);
+
+    vkCmdDrawIndexed(m_commandBuffer, indexCount, 1, firstIndex, vertexOffset, instanceIndex);
 }
 
-void VulkanCommandList::rebuildTopLevelAcceratationStructure(TopLevelAS& tlas)
+void VulkanCommandList::rebuildTopLevelAcceratationStructure(TopLevelAS& tlas, AccelerationStructureBuildType buildType)
 {
     if (!m_backend.m_rtx.has_value()) {
         LogErrorAndExit("Trying to rebuild a top level acceleration structure but there is no ray tracing support!\n");
     }
 
     auto& tlasInfo = m_backend.accelerationStructureInfo(tlas);
+    bool updateInPlace = buildType == AccelerationStructureBuildType::Update;
 
     // TODO: Maybe don't throw the allocation away (when building the first time), so we can reuse it here?
     //  However, it's a different size, though! So maybe not. Or if we use the max(build, rebuild) size?
     VmaAllocation scratchAllocation;
-    VkBuffer scratchBuffer = m_backend.createScratchBufferForAccelerationStructure(tlasInfo.accelerationStructure, true, scratchAllocation);
+    VkBuffer scratchBuffer = m_backend.createScratchBufferForAccelerationStructure(tlasInfo.accelerationStructure, updateInPlace, scratchAllocation);
 
     VmaAllocation instanceAllocation;
     VkBuffer instanceBuffer = m_backend.createRTXInstanceBuffer(tlas.instances(), instanceAllocation);
@@ -330,9 +353,9 @@ void VulkanCommandList::rebuildTopLevelAcceratationStructure(TopLevelAS& tlas)
         m_commandBuffer,
         &buildInfo,
         instanceBuffer, 0,
-        VK_TRUE,
-        tlasInfo.accelerationStructure,
+        updateInPlace ? VK_TRUE : VK_FALSE,
         tlasInfo.accelerationStructure,
+        updateInPlace ? tlasInfo.accelerationStructure : VK_NULL_HANDLE,
         scratchBuffer, 0);
 
     VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
@@ -350,6 +373,8 @@ void VulkanCommandList::rebuildTopLevelAcceratationStructure(TopLevelAS& tlas)
     auto& [prevInstanceBuf, prevInstanceAlloc] = tlasInfo.associatedBuffers[0];
     vmaDestroyBuffer(m_backend.m_memoryAllocator, prevInstanceBuf, prevInstanceAlloc);
     tlasInfo.associatedBuffers[0] = { instanceBuffer, instanceAllocation };
+
+    tlas.markAsBuilt();
 }
 
 void VulkanCommandList::traceRays(Extent2D extent)
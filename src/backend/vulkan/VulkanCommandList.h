@@ -14,13 +14,13 @@ public:
     void setRayTracingState(const RayTracingState&) override;
     void setComputeState(const ComputeState&) override;
 
-    void bindSet(BindingSet&, uint32_t index) override;
+    void bindSet(const BindingSet&, uint32_t index) override;
     void pushConstants(ShaderStage, void*, size_t size, size_t byteOffset = 0u) override;
 
     void draw(Buffer& vertexBuffer, uint32_t vertexCount) override;
-    void drawIndexed(Buffer& vertexBuffer, Buffer& indexBuffer, uint32_t indexCount, IndexType, uint32_t instanceIndex) override;
+    void drawIndexed(const Buffer& vertexBuffer, const Buffer& indexBuffer, uint32_t indexCount, IndexType, uint32_t instanceIndex, size_t indexByteOffset, int32_t vertexOffset) override;
     
-    void rebuildTopLevelAcceratationStructure(TopLevelAS&) override;
+    void rebuildTopLevelAcceratationStructure(TopLevelAS&, AccelerationStructureBuildType) override;
     void traceRays(Extent2D) override;
 
     void dispatch(Extent3D globalSize, Extent3D localSize) override;
@@ -52,4 +52,10 @@ private:
     const RenderState* activeRenderState = nullptr;
     const ComputeState* activeComputeState = nullptr;
     const RayTracingState* activeRayTracingState = nullptr;
+
+    // Draws from the shared scene geometry buffers use the same vertex & index buffers, so only bind them when they change
+    // (reset for every render state, i.e. they are bound at least once per pass)
+    VkBuffer m_boundVertexBuffer { VK_NULL_HANDLE };
+    VkBuffer m_boundIndexBuffer { VK_NULL_HANDLE };
+    VkIndexType m_boundIndexType { VK_INDEX_TYPE_MAX_ENUM };
 };
@@ -13,16 +13,16 @@ public:
     virtual void setRayTracingState(const RayTracingState&) = 0;
     virtual void setComputeState(const ComputeState&) = 0;
 
-    virtual void bindSet(BindingSet&, uint32_t index) = 0;
+    virtual void bindSet(const BindingSet&, uint32_t index) = 0;
     virtual void pushConstants(ShaderStage, void*, size_t size, size_t byteOffset = 0u) = 0;
 
     template<typename T>
     void pushConstant(ShaderStage, T, size_t byteOffset = 0u);
 
     virtual void draw(Buffer& vertexBuffer, uint32_t vertexCount) = 0;
-    virtual void drawIndexed(Buffer& vertexBuffer, Buffer& indexBuffer, uint32_t indexCount, IndexType, uint32_t instanceIndex = 0) = 0;
+    virtual void drawIndexed(const Buffer& vertexBuffer, const Buffer& indexBuffer, uint32_t indexCount, IndexType, uint32_t instanceIndex = 0, size_t indexByteOffset = 0, int32_t vertexOffset = 0) = 0;
 
-    virtual void rebuildTopLevelAcceratationStructure(TopLevelAS&) = 0;
+    virtual void rebuildTopLevelAcceratationStructure(TopLevelAS&, AccelerationStructureBuildType) = 0;
     virtual void traceRays(Extent2D) = 0;
 
     virtual void dispatch(Extent3D globalSize, Extent3D localSize) = 0;
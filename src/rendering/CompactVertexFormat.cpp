@@ -0,0 +1,132 @@
+#include "CompactVertexFormat.h"
+
+#include "utility/Logging.h"
+#include <cstring>
+#include <half.hpp>
+
+namespace {
+
+uint16_t packUNorm16(float value)
+{
+    return static_cast<uint16_t>(std::round(mathkit::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+int16_t packSNorm16(float value)
+{
+    return static_cast<int16_t>(std::round(mathkit::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+vec2 octahedralEncode(vec3 v)
+{
+    float l1norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1norm < 1e-20f) {
+        return vec2(0.0f, 0.0f); // (decodes to +Z, better than NaNs for degenerate input)
+    }
+    v /= l1norm;
+
+    vec2 p = vec2(v.x, v.y);
+    if (v.z < 0.0f) {
+        vec2 signNotZero = vec2((p.x >= 0.0f) ? 1.0f : -1.0f, (p.y >= 0.0f) ? 1.0f : -1.0f);
+        p = (vec2(1.0f) - vec2(std::abs(p.y), std::abs(p.x))) * signNotZero;
+    }
+    return p;
+}
+
+}
+
+VertexLayout CompactVertexFormat::vertexLayout() const
+{
+    VertexAttributeType texcoordType;
+    switch (texcoordEncoding) {
+    case TexcoordEncoding::Float32:
+        texcoordType = VertexAttributeType::Float2;
+        break;
+    case TexcoordEncoding::Half:
+        texcoordType = VertexAttributeType::Half2;
+        break;
+    case TexcoordEncoding::UNorm16:
+        texcoordType = VertexAttributeType::UNorm16x2;
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+
+    return VertexLayout {
+        vertexStride(),
+        { { 0, VertexAttributeType::Float3, 0 },
+          { 1, texcoordType, texcoordOffset() },
+          { 2, VertexAttributeType::SNorm16x4, normalTangentOffset() } }
+    };
+}
+
+CompactVertexFormat::PackedVertices CompactVertexFormat::packVertices(const Mesh& mesh) const
+{
+    auto posData = mesh.positionData();
+    auto texData = mesh.texcoordData();
+    auto normalData = mesh.normalData();
+    auto tangentData = mesh.tangentData();
+
+    size_t vertexCount = posData.size();
+    size_t texSize = texData.size();
+    size_t normalSize = normalData.size();
+    size_t tangentSize = tangentData.size();
+
+    PackedVertices packed {};
+    packed.vertexData.resize(vertexCount * vertexStride());
+
+    vec2 texcoordMin { 0.0f };
+    vec2 texcoordExtent { 1.0f };
+    if (texcoordEncoding == TexcoordEncoding::UNorm16 && texSize > 0) {
+        vec2 texcoordMax { std::numeric_limits<float>::lowest() };
+        texcoordMin = vec2(std::numeric_limits<float>::max());
+        for (const vec2& texcoord : texData) {
+            texcoordMin = glm::min(texcoordMin, texcoord);
+            texcoordMax = glm::max(texcoordMax, texcoord);
+        }
+        texcoordExtent = texcoordMax - texcoordMin;
+        for (int i = 0; i < 2; ++i) {
+            if (texcoordExtent[i] <= 0.0f) {
+                texcoordExtent[i] = 1.0f;
+            }
+        }
+        packed.texcoordScaleBias = vec4(texcoordExtent, texcoordMin);
+    }
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        std::byte* vertex = packed.vertexData.data() + i * vertexStride();
+
+        std::memcpy(vertex, &posData[i], sizeof(vec3));
+
+        vec2 tex = (i < texSize) ? texData[i] : vec2(0.0f);
+        switch (texcoordEncoding) {
+        case TexcoordEncoding::Float32:
+            std::memcpy(vertex + texcoordOffset(), &tex, sizeof(vec2));
+            break;
+        case TexcoordEncoding::Half: {
+            half_float::half halfTex[2] = { half_float::half(tex.x), half_float::half(tex.y) };
+            std::memcpy(vertex + texcoordOffset(), halfTex, sizeof(halfTex));
+            break;
+        }
+        case TexcoordEncoding::UNorm16: {
+            vec2 normalized = (tex - texcoordMin) / texcoordExtent;
+            uint16_t quantized[2] = { packUNorm16(normalized.x), packUNorm16(normalized.y) };
+            std::memcpy(vertex + texcoordOffset(), quantized, sizeof(quantized));
+            break;
+        }
+        }
+
+        // The bitangent sign is stored in the sign of the last component, which then only encodes the octahedral y-coordinate
+        // remapped to [0, 1]. It's clamped away from zero so the sign always survives quantization.
+        vec3 norm = (i < normalSize) ? normalData[i] : vec3(0.0f, 0.0f, 1.0f);
+        vec4 tang = (i < tangentSize) ? tangentData[i] : vec4(1.0f, 0.0f, 0.0f, 1.0f);
+        vec2 octNormal = octahedralEncode(norm);
+        vec2 octTangent = octahedralEncode(vec3(tang));
+        float tangentSign = (tang.w < 0.0f) ? -1.0f : 1.0f;
+        float signedTangentY = tangentSign * std::max(octTangent.y * 0.5f + 0.5f, 1.0f / 32767.0f);
+
+        int16_t normalTangent[4] = { packSNorm16(octNormal.x), packSNorm16(octNormal.y), packSNorm16(octTangent.x), packSNorm16(signedTangentY) };
+        std::memcpy(vertex + normalTangentOffset(), normalTangent, sizeof(normalTangent));
+    }
+
+    return packed;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Resources.h"
+#include "utility/Model.h"
+#include "utility/mathkit.h"
+#include <vector>
+
+// Compact vertex layout used for rasterization. Normal & tangent are always octahedral encoded into a single
+// snorm16x4 attribute (with the bitangent sign folded into the tangent) and positions are always float32, since the
+// vertices are also used for building BLASs, while texture coordinates can be encoded in a few different ways.
+// Shader side, see shaders/octahedral.glsl and SceneGeometryData.h.
+//
+//  location 0: position       (vec3)
+//  location 1: texCoord       (vec2, dequantize with texcoordScaleBias)
+//  location 2: normalTangent  (vec4, decode with decodeTangentFrame)
+
+struct CompactVertexFormat {
+
+    enum class TexcoordEncoding {
+        Float32,
+        Half,
+        UNorm16, // quantized within the mesh texcoord bounds
+    };
+
+    TexcoordEncoding texcoordEncoding { TexcoordEncoding::UNorm16 };
+
+    struct PackedVertices {
+        std::vector<std::byte> vertexData {};
+        vec4 texcoordScaleBias { 1.0f, 1.0f, 0.0f, 0.0f };
+    };
+
+    static constexpr size_t texcoordSize(TexcoordEncoding encoding) { return (encoding == TexcoordEncoding::Float32) ? 2 * sizeof(float) : 2 * sizeof(uint16_t); }
+
+    // (byte offsets, so that the shader side of the layout can be checked at compile time)
+    [[nodiscard]] constexpr size_t texcoordOffset() const { return 3 * sizeof(float); }
+    [[nodiscard]] constexpr size_t normalTangentOffset() const { return texcoordOffset() + texcoordSize(texcoordEncoding); }
+    [[nodiscard]] constexpr size_t vertexStride() const { return normalTangentOffset() + 4 * sizeof(int16_t); }
+
+    [[nodiscard]] VertexLayout vertexLayout() const;
+
+    [[nodiscard]] PackedVertices packVertices(const Mesh&) const;
+};
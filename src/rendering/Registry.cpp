@@ -1,12 +1,16 @@
 #include "Registry.h"
 
-#include "utility/FileIO.h"
+#include "utility/DDSFile.h"
+#include "utility/HdrEncoding.h"
+#include "utility/Image.h"
 #include "utility/Logging.h"
+#include "utility/MipGenerator.h"
+#include "utility/ThreadPool.h"
 #include "utility/util.h"
-#include <stb_image.h>
 
-Registry::Registry(const RenderTarget* windowRenderTarget)
+Registry::Registry(const RenderTarget* windowRenderTarget, Registry* parentRegistry)
     : m_windowRenderTarget(windowRenderTarget)
+    , m_parentRegistry(parentRegistry)
 {
 }
 
@@ -79,28 +83,104 @@ Texture& Registry::createPixelTexture(vec4 pixelValue, bool srgb)
     return texture;
 }
 
-Texture& Registry::loadTexture2D(const std::string& imagePath, bool srgb, bool generateMipmaps)
+TextureStreamer& Registry::textureStreamer()
 {
-    if (!FileIO::isFileReadable(imagePath)) {
-        LogErrorAndExit("Could not read image at path '%s'.\n", imagePath.c_str());
+    if (m_parentRegistry) {
+        return m_parentRegistry->textureStreamer();
+    }
+    return m_textureStreamer;
+}
+
+Texture& Registry::loadTexture2D(const std::string& imagePath, bool srgb, bool generateMipmaps, bool isNormalMap, bool streamed)
+{
+    return loadTexture(imagePath, srgb, generateMipmaps, isNormalMap, Image::HdrFormat::Float16, streamed);
+}
+
+Texture& Registry::loadHdrTexture2D(const std::string& imagePath, Image::HdrFormat hdrFormat, bool generateMipmaps)
+{
+    // (if it's not actually an HDR image we assume it's color, e.g. an LDR environment map, so it's loaded as sRGB)
+    return loadTexture(imagePath, true, generateMipmaps, false, hdrFormat, false);
+}
+
+Texture& Registry::loadTexture(const std::string& imagePath, bool srgb, bool generateMipmaps, bool isNormalMap, Image::HdrFormat hdrFormat, bool streamed)
+{
+    if (m_parentRegistry) {
+        return m_parentRegistry->loadTexture(imagePath, srgb, generateMipmaps, isNormalMap, hdrFormat, streamed);
+    }
+
+    std::string cacheKey = imagePath + (srgb ? ":srgb" : ":linear") + (generateMipmaps ? ":mips" : ":nomips") + (isNormalMap ? ":normal" : "")
+        + ":hdr" + std::to_string(int(hdrFormat));
+    auto entry = m_loadedTextureMap.find(cacheKey);
+    if (entry != m_loadedTextureMap.end()) {
+        // (someone else streams this texture, but this user won't request any levels, so it has to stay fully resident)
+        if (!streamed && m_textureStreamer.isStreamed(*entry->second)) {
+            m_textureStreamer.keepFullyResident(*entry->second);
+        }
+        return *entry->second;
+    }
+
+    // Prefer the cooked version of the image (block compressed & with all mip levels) if there is an up-to-date one
+    std::string loadPath = DDSFile::findCookedImage(imagePath).value_or(imagePath);
+
+    std::optional<Image::Info> info = Image::probe(loadPath);
+    if (!info.has_value()) {
+        LogErrorAndExit("Could not read image at path '%s'.\n", loadPath.c_str());
     }
 
-    int width, height, componentCount;
-    stbi_info(imagePath.c_str(), &width, &height, &componentCount);
-    bool hdr = stbi_is_hdr(imagePath.c_str());
+    int width = info->width;
+    int height = info->height;
 
     Texture::Format format;
-    switch (componentCount) {
-    case 3:
-    case 4:
-        if (hdr) {
-            format = Texture::Format::RGBA32F;
-        } else {
-            format = (srgb) ? Texture::Format::sRGBA8 : Texture::Format::RGBA8;
+    if (info->blockFormat.has_value()) {
+        // (the cooked mips are filtered for the colour space the file says it's in, so that's what we have to sample it as)
+        if (info->isSrgb.has_value() && info->isSrgb.value() != srgb && info->blockFormat.value() != BlockCompression::Format::BC5) {
+            LogWarning("Image '%s' is stored as %s but is loaded as %s, using the stored colour space.\n",
+                       loadPath.c_str(), info->isSrgb.value() ? "sRGB" : "linear", srgb ? "sRGB" : "linear");
+            srgb = info->isSrgb.value();
+        }
+        switch (info->blockFormat.value()) {
+        case BlockCompression::Format::BC1:
+            format = (srgb) ? Texture::Format::BC1sRGB : Texture::Format::BC1;
+            break;
+        case BlockCompression::Format::BC3:
+            format = (srgb) ? Texture::Format::BC3sRGB : Texture::Format::BC3;
+            break;
+        case BlockCompression::Format::BC5:
+            format = Texture::Format::BC5;
+            break;
+        case BlockCompression::Format::BC7:
+            format = (srgb) ? Texture::Format::BC7sRGB : Texture::Format::BC7;
+            break;
+        }
+    } else {
+        switch (info->componentCount) {
+        case 3:
+        case 4:
+            if (info->isHdr) {
+                switch (hdrFormat) {
+                case Image::HdrFormat::Float32:
+                    format = Texture::Format::RGBA32F;
+                    break;
+                case Image::HdrFormat::Float16:
+                    format = Texture::Format::RGBA16F;
+                    break;
+                case Image::HdrFormat::RGB9E5:
+                    format = Texture::Format::RGB9E5;
+                    break;
+                }
+            } else {
+                format = (srgb) ? Texture::Format::sRGBA8 : Texture::Format::RGBA8;
+            }
+            break;
+        default:
+            LogErrorAndExit("Currently no support for other than (s)RGB(F) and (s)RGBA(F) texture loading!\n");
         }
-        break;
-    default:
-        LogErrorAndExit("Currently no support for other than (s)RGB(F) and (s)RGBA(F) texture loading!\n");
+    }
+
+    // (we can't generate mipmaps for block compressed textures, they have to come with the file)
+    if (generateMipmaps && info->blockFormat.has_value() && info->mipLevelCount != MipGenerator::mipLevelCount(width, height)) {
+        LogWarning("Block compressed image '%s' does not have a full mip chain, so it will not be mipmapped.\n", loadPath.c_str());
+        generateMipmaps = false;
     }
 
     // TODO: Maybe we want to allow more stuff..?
@@ -111,7 +191,39 @@ Texture& Registry::loadTexture2D(const std::string& imagePath, bool srgb, bool g
     m_textures.push_back({ {}, { width, height }, format, usage, Texture::MinFilter::Linear, Texture::MagFilter::Linear, mipmapMode, Texture::Multisampling::None });
     Texture& texture = m_textures.back();
 
-    m_immediateTextureUpdates.emplace_back(texture, imagePath, generateMipmaps);
+    // Start decoding right away, so that it's (hopefully) done by the time the backend wants to upload it. If we want
+    // mipmaps they are also generated (or read from the mipmap cache) on the worker thread, so the backend can upload
+    // all levels in one go instead of generating them with blits.
+    std::shared_future<Image> image;
+    if (generateMipmaps && !info->blockFormat.has_value()) {
+        MipGenerator::Options options {};
+        options.filter = MipGenerator::Filter::Kaiser;
+        if (isNormalMap) {
+            options.content = MipGenerator::Content::NormalMap;
+        } else if (srgb && !info->isHdr) {
+            options.content = MipGenerator::Content::sRGBColor;
+        } else {
+            options.content = MipGenerator::Content::LinearColor;
+        }
+        image = ThreadPool::global().enqueue([=, imageInfo = info.value()]() {
+            Image mipmappedImage = MipGenerator::loadWithMipmaps(loadPath, imageInfo, options);
+            return imageInfo.isHdr ? HdrEncoding::encode(mipmappedImage, hdrFormat) : mipmappedImage;
+        });
+    } else if (info->isHdr) {
+        // (HDR images are decoded to floats, so the mips are generated before packing them to the final format)
+        image = ThreadPool::global().enqueue([=, imageInfo = info.value()]() {
+            return HdrEncoding::encode(Image::load(loadPath, imageInfo, 4), hdrFormat);
+        });
+    } else {
+        image = Image::loadAsync(loadPath, info.value(), 4);
+    }
+    m_immediateTextureUpdates.emplace_back(texture, loadPath, std::move(image), generateMipmaps);
+    m_loadedTextureMap[cacheKey] = &texture;
+
+    // (the backend only uploads the levels that are resident, so the update above is also the initial upload)
+    if (streamed && generateMipmaps && m_textureStreamer.isEnabled()) {
+        m_textureStreamer.addTexture(texture, m_immediateTextureUpdates.back());
+    }
 
     return texture;
 }
@@ -187,6 +299,24 @@ void Registry::publish(const std::string& name, const TopLevelAS& tlas)
     m_nameTopLevelASMap[fullName] = &tlas;
 }
 
+void Registry::publish(const std::string& name, const BindingSet& bindingSet)
+{
+    ASSERT(m_currentNodeName.has_value());
+    std::string fullName = makeQualifiedName(m_currentNodeName.value(), name);
+    auto entry = m_nameBindingSetMap.find(fullName);
+    ASSERT(entry == m_nameBindingSetMap.end());
+    m_nameBindingSetMap[fullName] = &bindingSet;
+}
+
+void Registry::publishAnyData(const std::string& name, std::any data)
+{
+    ASSERT(m_currentNodeName.has_value());
+    std::string fullName = makeQualifiedName(m_currentNodeName.value(), name);
+    auto entry = m_nameDataMap.find(fullName);
+    ASSERT(entry == m_nameDataMap.end());
+    m_nameDataMap[fullName] = std::move(data);
+}
+
 std::optional<const Texture*> Registry::getTexture(const std::string& renderPass, const std::string& name)
 {
     std::string fullName = makeQualifiedName(renderPass, name);
@@ -238,6 +368,40 @@ const TopLevelAS* Registry::getTopLevelAccelerationStructure(const std::string&
     return tlas;
 }
 
+const BindingSet* Registry::getBindingSet(const std::string& renderPass, const std::string& name)
+{
+    std::string fullName = makeQualifiedName(renderPass, name);
+    auto entry = m_nameBindingSetMap.find(fullName);
+
+    if (entry == m_nameBindingSetMap.end()) {
+        return nullptr;
+    }
+
+    ASSERT(m_currentNodeName.has_value());
+    NodeDependency dependency { m_currentNodeName.value(), renderPass };
+    m_nodeDependencies.insert(dependency);
+
+    const BindingSet* bindingSet = entry->second;
+    return bindingSet;
+}
+
+const std::any* Registry::getAnyData(const std::string& renderPass, const std::string& name)
+{
+    std::string fullName = makeQualifiedName(renderPass, name);
+    auto entry = m_nameDataMap.find(fullName);
+
+    if (entry == m_nameDataMap.end()) {
+        return nullptr;
+    }
+
+    ASSERT(m_currentNodeName.has_value());
+    NodeDependency dependency { m_currentNodeName.value(), renderPass };
+    m_nodeDependencies.insert(dependency);
+
+    const std::any* data = &entry->second;
+    return data;
+}
+
 const std::unordered_set<NodeDependency>& Registry::nodeDependencies() const
 {
     return m_nodeDependencies;
@@ -4,14 +4,17 @@
 #include "NodeDependency.h"
 #include "ResourceChange.h"
 #include "Resources.h"
+#include "TextureStreamer.h"
+#include "utility/Image.h"
 #include "utility/CapList.h"
 #include "utility/util.h"
+#include <any>
 #include <unordered_map>
 #include <unordered_set>
 
 class Registry {
 public:
-    explicit Registry(const RenderTarget* windowRenderTarget = nullptr);
+    explicit Registry(const RenderTarget* windowRenderTarget = nullptr, Registry* parentRegistry = nullptr);
 
     void setCurrentNode(std::string);
 
@@ -19,9 +22,15 @@ public:
     [[nodiscard]] RenderTarget& createRenderTarget(std::initializer_list<RenderTarget::Attachment>);
 
     [[nodiscard]] Texture& createPixelTexture(vec4 pixelValue, bool srgb);
-    [[nodiscard]] Texture& loadTexture2D(const std::string& imagePath, bool srgb, bool generateMipmaps);
+    // Only pass streamed=true if the node also requests the mip levels it needs every frame, see TextureStreamer
+    [[nodiscard]] Texture& loadTexture2D(const std::string& imagePath, bool srgb, bool generateMipmaps, bool isNormalMap = false, bool streamed = false);
+    // HDR images are always packed to RGBA16F when loaded with loadTexture2D, but here the format can be picked explicitly
+    [[nodiscard]] Texture& loadHdrTexture2D(const std::string& imagePath, Image::HdrFormat, bool generateMipmaps);
     [[nodiscard]] Texture& createTexture2D(Extent2D, Texture::Format, Texture::Usage, Texture::Multisampling = Texture::Multisampling::None);
 
+    // If enabled, mipmapped textures loaded with streamed=true are streamed. Frame registries share the one of the parent.
+    [[nodiscard]] TextureStreamer& textureStreamer();
+
     [[nodiscard]] Buffer& createBuffer(size_t size, Buffer::Usage, Buffer::MemoryHint);
     template<typename T>
     [[nodiscard]] Buffer& createBuffer(std::vector<T>&& inData, Buffer::Usage usage, Buffer::MemoryHint);
@@ -42,10 +51,18 @@ public:
     void publish(const std::string& name, const Buffer&);
     void publish(const std::string& name, const Texture&);
     void publish(const std::string& name, const TopLevelAS&);
+    void publish(const std::string& name, const BindingSet&);
+
+    // Plain CPU-side data can also be published (e.g. something that several nodes need but that is expensive to compute)
+    template<typename T>
+    void publishData(const std::string& name, T data);
 
     [[nodiscard]] std::optional<const Texture*> getTexture(const std::string& renderPass, const std::string& name);
     [[nodiscard]] const Buffer* getBuffer(const std::string& renderPass, const std::string& name);
     [[nodiscard]] const TopLevelAS* getTopLevelAccelerationStructure(const std::string& renderPass, const std::string& name);
+    [[nodiscard]] const BindingSet* getBindingSet(const std::string& renderPass, const std::string& name);
+    template<typename T>
+    [[nodiscard]] const T* getData(const std::string& renderPass, const std::string& name);
 
     [[nodiscard]] const std::unordered_set<NodeDependency>& nodeDependencies() const;
 
@@ -66,15 +83,28 @@ public:
 protected:
     std::string makeQualifiedName(const std::string& node, const std::string& name);
 
+    Texture& loadTexture(const std::string& imagePath, bool srgb, bool generateMipmaps, bool isNormalMap, Image::HdrFormat, bool streamed);
+
+    void publishAnyData(const std::string& name, std::any);
+    const std::any* getAnyData(const std::string& renderPass, const std::string& name);
+
 private:
     std::optional<std::string> m_currentNodeName;
     std::unordered_set<NodeDependency> m_nodeDependencies;
 
     const RenderTarget* m_windowRenderTarget;
 
+    // Textures loaded from file never change, so they are cached on (path, srgb, mipmaps, normal map). Registries with a parent
+    // registry (i.e. frame registries) defer loading to the parent, so the textures are also shared across registries.
+    Registry* m_parentRegistry;
+    std::unordered_map<std::string, Texture*> m_loadedTextureMap;
+    TextureStreamer m_textureStreamer {};
+
     std::unordered_map<std::string, const Buffer*> m_nameBufferMap;
     std::unordered_map<std::string, const Texture*> m_nameTextureMap;
     std::unordered_map<std::string, const TopLevelAS*> m_nameTopLevelASMap;
+    std::unordered_map<std::string, const BindingSet*> m_nameBindingSetMap;
+    std::unordered_map<std::string, std::any> m_nameDataMap;
 
     std::vector<BufferUpdate> m_immediateBufferUpdates;
     std::vector<TextureUpdate> m_immediateTextureUpdates;
@@ -116,3 +146,22 @@ template<typename T>
     auto* binaryData = reinterpret_cast<const std::byte*>(inData.data());
     return createBuffer(binaryData, dataSize, usage, memoryHint);
 }
+
+template<typename T>
+void Registry::publishData(const std::string& name, T data)
+{
+    publishAnyData(name, std::make_any<T>(std::move(data)));
+}
+
+template<typename T>
+[[nodiscard]] const T* Registry::getData(const std::string& renderPass, const std::string& name)
+{
+    const std::any* data = getAnyData(renderPass, name);
+    if (!data) {
+        return nullptr;
+    }
+
+    const T* typedData = std::any_cast<T>(data);
+    ASSERT(typedData);
+    return typedData;
+}
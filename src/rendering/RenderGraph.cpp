@@ -22,6 +22,11 @@ void RenderGraph::constructAll(Registry& nodeManager, std::vector<Registry*> fra
 
     // TODO: For debugability it would be nice if the frame resources were constructed right after the node resources, for each node
 
+    // (before any node is constructed, so that all textures they load are streamed)
+    if (m_textureStreamingBudget.has_value()) {
+        nodeManager.textureStreamer().enable(m_textureStreamingBudget.value());
+    }
+
     for (auto& node : m_allNodes) {
         nodeManager.setCurrentNode(node->name());
         node->constructNode(nodeManager);
@@ -5,6 +5,7 @@
 #include "RenderGraphNode.h"
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
@@ -26,6 +27,9 @@ public:
         addNode(std::move(nodePtr));
     }
 
+    //! If set, all mipmapped textures that nodes load from file are streamed within this budget (see TextureStreamer)
+    void setTextureStreamingBudget(std::optional<size_t> budget) { m_textureStreamingBudget = budget; }
+
     //! Construct all nodes & set up a per-frame context for each resource manager frameManagers
     void constructAll(Registry& nodeManager, std::vector<Registry*> frameManagers);
 
@@ -46,4 +50,6 @@ private:
 
     //! The frame contexts, one per frame (i.e. image in the swapchain)
     std::unordered_map<const Registry*, FrameContext> m_frameContexts {};
+
+    std::optional<size_t> m_textureStreamingBudget {};
 };
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Resources.h"
+#include "utility/Image.h"
+#include <future>
 #include <variant>
 
 class BufferUpdate {
@@ -21,10 +23,11 @@ private:
 
 class TextureUpdate {
 public:
-    TextureUpdate(Texture& texture, std::string path, bool generateMipmaps)
+    TextureUpdate(Texture& texture, std::string path, std::shared_future<Image> image, bool generateMipmaps)
         : m_texture(texture)
         , m_generateMipmaps(generateMipmaps)
         , m_value(std::move(path))
+        , m_image(std::move(image))
     {
     }
 
@@ -44,10 +47,18 @@ public:
     std::string path() const { return *std::get_if<std::string>(&m_value); }
     vec4 pixelValue() const { return *std::get_if<vec4>(&m_value); }
 
+    // The image at path(), which is decoded in the background and so this might block until it's ready
+    const Image& image() const
+    {
+        ASSERT(hasPath());
+        return m_image.get();
+    }
+
 private:
     Texture& m_texture;
     bool m_generateMipmaps;
     std::variant<std::string, vec4> m_value;
+    std::shared_future<Image> m_image {};
 };
 
 class ResourceActions {
@@ -60,6 +60,22 @@ uint32_t Texture::mipLevels() const
     }
 }
 
+bool Texture::hasBlockCompressedFormat() const
+{
+    switch (m_format) {
+    case Format::BC1:
+    case Format::BC1sRGB:
+    case Format::BC3:
+    case Format::BC3sRGB:
+    case Format::BC5:
+    case Format::BC7:
+    case Format::BC7sRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool Texture::isMultisampled() const
 {
     return m_multisampling != Multisampling::None;
@@ -438,6 +454,8 @@ const std::vector<RTGeometry>& BottomLevelAS::geometries() const
 TopLevelAS::TopLevelAS(Badge<Registry>, std::vector<RTGeometryInstance> instances)
     : m_instances(instances)
 {
+    // (the backend builds it with the current transforms when it's created)
+    m_builtTransformVersion = transformVersion();
 }
 
 const std::vector<RTGeometryInstance>& TopLevelAS::instances() const
@@ -450,6 +468,26 @@ uint32_t TopLevelAS::instanceCount() const
     return m_instances.size();
 }
 
+bool TopLevelAS::hasMovedSinceLastBuild() const
+{
+    return transformVersion() != m_builtTransformVersion;
+}
+
+void TopLevelAS::markAsBuilt()
+{
+    m_builtTransformVersion = transformVersion();
+}
+
+uint64_t TopLevelAS::transformVersion() const
+{
+    // (versions only ever increase, so the sum changes if any single one of them does)
+    uint64_t version = 0;
+    for (const RTGeometryInstance& instance : m_instances) {
+        version += instance.transform.version();
+    }
+    return version;
+}
+
 RayTracingState::RayTracingState(Badge<Registry>, ShaderBindingTable sbt, std::vector<const BindingSet*> bindingSets, uint32_t maxRecursionDepth)
     : m_shaderBindingTable(sbt)
     , m_bindingSets(bindingSets)
@@ -60,7 +60,15 @@ struct Texture : public Resource {
         R16F,
         RGBA16F,
         RGBA32F,
-        Depth32F
+        RGB9E5,
+        Depth32F,
+        BC1,
+        BC1sRGB,
+        BC3,
+        BC3sRGB,
+        BC5,
+        BC7,
+        BC7sRGB,
     };
 
     enum class Usage {
@@ -117,6 +125,8 @@ struct Texture : public Resource {
         return m_format == Format::Depth32F;
     }
 
+    [[nodiscard]] bool hasBlockCompressedFormat() const;
+
 private:
     Extent2D m_extent;
     Format m_format;
@@ -181,6 +191,8 @@ struct Buffer : public Resource {
         Index,
         UniformBuffer,
         StorageBuffer,
+        VertexStorage, // (vertex buffer which can also be bound as a storage buffer)
+        IndexStorage, // (index buffer which can also be bound as a storage buffer)
     };
 
     enum class MemoryHint {
@@ -206,7 +218,13 @@ private:
 enum class VertexAttributeType {
     Float2,
     Float3,
-    Float4
+    Float4,
+    Half2,
+    Half4,
+    UNorm16x2,
+    UNorm16x4,
+    SNorm16x2,
+    SNorm16x4,
 };
 
 struct VertexAttribute {
@@ -391,9 +409,13 @@ struct RTTriangleGeometry {
     const Buffer& vertexBuffer;
     VertexFormat vertexFormat;
     size_t vertexStride;
+    size_t vertexByteOffset;
+    uint32_t vertexCount;
 
     const Buffer& indexBuffer;
     IndexType indexType;
+    size_t indexByteOffset;
+    uint32_t indexCount;
 
     mat4 transform;
 };
@@ -438,6 +460,11 @@ struct RTGeometryInstance {
     uint8_t hitMask;
 };
 
+enum class AccelerationStructureBuildType {
+    FullBuild,
+    Update,
+};
+
 class TopLevelAS : public Resource {
 public:
     TopLevelAS() = default;
@@ -447,8 +474,16 @@ public:
     [[nodiscard]] const std::vector<RTGeometryInstance>& instances() const;
     [[nodiscard]] uint32_t instanceCount() const;
 
+    // True if any of the instance transforms have changed since the last (re)build. The instances themselves can't change
+    // for a given TLAS (a new one is created for that), so a moved instance only ever requires an update, not a full build.
+    [[nodiscard]] bool hasMovedSinceLastBuild() const;
+    void markAsBuilt();
+
 private:
+    uint64_t transformVersion() const;
+
     std::vector<RTGeometryInstance> m_instances {};
+    uint64_t m_builtTransformVersion { 0 };
 };
 
 class HitGroup {
@@ -463,16 +498,20 @@ public:
     bool hasIntersectionShader() const { return m_intersection.has_value(); }
     const ShaderFile& intersection() const { return m_intersection.value(); }
 
+    // Data for the hit shaders to read through a shaderRecordNV buffer block (has to fit in the SBT record, so keep it small)
+    void setShaderRecord(std::vector<uint32_t> shaderRecord) { m_shaderRecord = std::move(shaderRecord); }
+    const std::vector<uint32_t>& shaderRecord() const { return m_shaderRecord; }
+
 private:
     ShaderFile m_closestHit;
     std::optional<ShaderFile> m_anyHit;
     std::optional<ShaderFile> m_intersection;
+    std::vector<uint32_t> m_shaderRecord {};
 };
 
 class ShaderBindingTable {
 public:
     // See https://www.willusher.io/graphics/2019/11/20/the-sbt-three-ways for all info you might want about SBT stuff!
-    // TODO: Add support for ShaderRecord instead of just shader file, so we can include parameters to the records.
 
     ShaderBindingTable(ShaderFile rayGen, std::vector<HitGroup> hitGroups, std::vector<ShaderFile> missShaders);
 
@@ -0,0 +1,237 @@
+#include "TextureStreamer.h"
+
+#include "utility/BlockCompression.h"
+#include "utility/Logging.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <tuple>
+
+namespace {
+
+size_t mipLevelSize(const Texture& texture, uint32_t level)
+{
+    int width = std::max(1, int(texture.extent().width()) >> level);
+    int height = std::max(1, int(texture.extent().height()) >> level);
+
+    switch (texture.format()) {
+    case Texture::Format::RGBA8:
+    case Texture::Format::sRGBA8:
+    case Texture::Format::RGB9E5:
+        return width * height * 4;
+    case Texture::Format::R16F:
+        return width * height * 2;
+    case Texture::Format::RGBA16F:
+        return width * height * 8;
+    case Texture::Format::RGBA32F:
+        return width * height * 16;
+    case Texture::Format::BC1:
+    case Texture::Format::BC1sRGB:
+        return BlockCompression::compressedSize(BlockCompression::Format::BC1, width, height);
+    case Texture::Format::BC3:
+    case Texture::Format::BC3sRGB:
+        return BlockCompression::compressedSize(BlockCompression::Format::BC3, width, height);
+    case Texture::Format::BC5:
+        return BlockCompression::compressedSize(BlockCompression::Format::BC5, width, height);
+    case Texture::Format::BC7:
+    case Texture::Format::BC7sRGB:
+        return BlockCompression::compressedSize(BlockCompression::Format::BC7, width, height);
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+}
+
+void TextureStreamer::enable(size_t budgetInBytes)
+{
+    m_enabled = true;
+    m_budget = budgetInBytes;
+}
+
+void TextureStreamer::addTexture(const Texture& texture, TextureUpdate update)
+{
+    ASSERT(m_enabled);
+    ASSERT(update.hasPath() && texture.hasMipmaps());
+    ASSERT(!isStreamed(texture));
+
+    StreamedTexture streamedTexture { .texture = &texture, .update = std::move(update) };
+
+    uint32_t mipLevelCount = texture.mipLevels();
+    streamedTexture.levelsSize.resize(mipLevelCount + 1, 0);
+    for (int level = int(mipLevelCount) - 1; level >= 0; --level) {
+        streamedTexture.levelsSize[level] = streamedTexture.levelsSize[level + 1] + mipLevelSize(texture, level);
+    }
+
+    uint32_t alwaysResidentMip = 0;
+    while (alwaysResidentMip < mipLevelCount - 1) {
+        int width = int(texture.extent().width()) >> alwaysResidentMip;
+        int height = int(texture.extent().height()) >> alwaysResidentMip;
+        if (std::max(width, height) <= alwaysResidentSize) {
+            break;
+        }
+        alwaysResidentMip += 1;
+    }
+    streamedTexture.alwaysResidentMip = alwaysResidentMip;
+    streamedTexture.residentMip = alwaysResidentMip;
+
+    m_textureIndices[&texture] = m_textures.size();
+    m_textures.push_back(std::move(streamedTexture));
+}
+
+bool TextureStreamer::isStreamed(const Texture& texture) const
+{
+    return m_textureIndices.find(&texture) != m_textureIndices.end();
+}
+
+uint32_t TextureStreamer::residentMipLevel(const Texture& texture) const
+{
+    auto entry = m_textureIndices.find(&texture);
+    if (entry == m_textureIndices.end()) {
+        return 0;
+    }
+    return m_textures[entry->second].residentMip;
+}
+
+const TextureUpdate& TextureStreamer::textureUpdate(const Texture& texture) const
+{
+    auto entry = m_textureIndices.find(&texture);
+    ASSERT(entry != m_textureIndices.end());
+    return m_textures[entry->second].update;
+}
+
+void TextureStreamer::requestMipLevel(const Texture& texture, uint32_t mipLevel)
+{
+    auto entry = m_textureIndices.find(&texture);
+    if (entry == m_textureIndices.end()) {
+        return;
+    }
+
+    StreamedTexture& streamedTexture = m_textures[entry->second];
+    mipLevel = std::min(mipLevel, streamedTexture.alwaysResidentMip);
+    streamedTexture.requestedMip = std::min(mipLevel, streamedTexture.requestedMip.value_or(mipLevel));
+}
+
+void TextureStreamer::keepFullyResident(const Texture& texture)
+{
+    auto entry = m_textureIndices.find(&texture);
+    ASSERT(entry != m_textureIndices.end());
+    m_textures[entry->second].keepFullyResident = true;
+}
+
+std::vector<const Texture*> TextureStreamer::updateResidency()
+{
+    size_t count = m_textures.size();
+    std::vector<uint32_t> neededMip(count);
+    std::vector<uint32_t> targetMip(count);
+    size_t totalSize = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        StreamedTexture& streamedTexture = m_textures[i];
+        neededMip[i] = streamedTexture.keepFullyResident ? 0 : streamedTexture.requestedMip.value_or(streamedTexture.alwaysResidentMip);
+        streamedTexture.requestedMip.reset();
+
+        // (keep whatever is already resident, until we need the space for something else)
+        targetMip[i] = std::min(streamedTexture.residentMip, neededMip[i]);
+        totalSize += streamedTexture.levelsSize[targetMip[i]];
+    }
+
+    // If over budget, drop levels one at a time. Start with levels that aren't needed this frame, and after that take the
+    // largest remaining level, so that the finest levels of the largest textures are the first to go.
+    if (totalSize > m_budget) {
+        using Candidate = std::tuple<bool, size_t, size_t>; // (not needed, size of finest level, texture index)
+        std::priority_queue<Candidate> candidates {};
+        auto addCandidate = [&](size_t i) {
+            const StreamedTexture& streamedTexture = m_textures[i];
+            uint32_t mip = targetMip[i];
+            if (mip < streamedTexture.alwaysResidentMip) {
+                size_t finestLevelSize = streamedTexture.levelsSize[mip] - streamedTexture.levelsSize[mip + 1];
+                candidates.emplace(mip < neededMip[i], finestLevelSize, i);
+            }
+        };
+
+        for (size_t i = 0; i < count; ++i) {
+            addCandidate(i);
+        }
+
+        while (totalSize > m_budget && !candidates.empty()) {
+            auto [notNeeded, finestLevelSize, i] = candidates.top();
+            candidates.pop();
+
+            totalSize -= finestLevelSize;
+            targetMip[i] += 1;
+            addCandidate(i);
+        }
+
+        if (totalSize > m_budget && !m_warnedOverBudget) {
+            LogWarning("TextureStreamer: the always resident mip levels alone are over the budget (%.1f MB of %.1f MB).\n",
+                       totalSize / (1024.0f * 1024.0f), m_budget / (1024.0f * 1024.0f));
+            m_warnedOverBudget = true;
+        }
+    }
+
+    // Stream in the levels of the most undersampled textures first. All resident levels are uploaded when a texture
+    // changes, so that's what counts towards the per-frame limit. (At least one texture is always allowed per frame,
+    // otherwise textures with a finest level larger than the limit would never get it.)
+    std::vector<size_t> growingTextures {};
+    for (size_t i = 0; i < count; ++i) {
+        if (targetMip[i] < m_textures[i].residentMip) {
+            growingTextures.push_back(i);
+        }
+    }
+    std::sort(growingTextures.begin(), growingTextures.end(), [&](size_t a, size_t b) {
+        return m_textures[a].residentMip - targetMip[a] > m_textures[b].residentMip - targetMip[b];
+    });
+
+    size_t streamedSize = 0;
+    for (size_t i : growingTextures) {
+        const StreamedTexture& streamedTexture = m_textures[i];
+        while (streamedSize > 0 && targetMip[i] < streamedTexture.residentMip && streamedSize + streamedTexture.levelsSize[targetMip[i]] > maxStreamedSizePerFrame) {
+            targetMip[i] += 1;
+        }
+        if (targetMip[i] < streamedTexture.residentMip) {
+            streamedSize += streamedTexture.levelsSize[targetMip[i]];
+        }
+    }
+
+    std::vector<const Texture*> changedTextures {};
+    for (size_t i = 0; i < count; ++i) {
+        StreamedTexture& streamedTexture = m_textures[i];
+        if (targetMip[i] != streamedTexture.residentMip) {
+            streamedTexture.residentMip = targetMip[i];
+            changedTextures.push_back(streamedTexture.texture);
+        }
+    }
+
+    return changedTextures;
+}
+
+size_t TextureStreamer::residentSize() const
+{
+    size_t size = 0;
+    for (const StreamedTexture& streamedTexture : m_textures) {
+        size += streamedTexture.levelsSize[streamedTexture.residentMip];
+    }
+    return size;
+}
+
+uint32_t TextureStreamer::requiredMipLevel(const Texture& texture, float texcoordsPerLocalUnit, float pixelsPerLocalUnit)
+{
+    uint32_t coarsestMip = texture.mipLevels() - 1;
+    if (texcoordsPerLocalUnit <= 0.0f || pixelsPerLocalUnit <= 0.0f) {
+        return coarsestMip;
+    }
+    if (std::isinf(pixelsPerLocalUnit)) {
+        return 0;
+    }
+
+    // (use the largest side, so anisotropic textures are never undersampled)
+    float textureSize = float(std::max(texture.extent().width(), texture.extent().height()));
+    float texelsPerPixel = textureSize * texcoordsPerLocalUnit / pixelsPerLocalUnit;
+    if (texelsPerPixel <= 1.0f) {
+        return 0;
+    }
+
+    float mip = std::floor(std::log2(texelsPerPixel));
+    return std::min(uint32_t(mip), coarsestMip);
+}
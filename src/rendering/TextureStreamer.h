@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ResourceChange.h"
+#include "Resources.h"
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Streams the mip levels of file-loaded (and mipmapped) textures in & out of VRAM, so that only the levels actually
+// needed on screen are resident, all within a fixed budget. Textures start out with only their smallest levels, and
+// nodes then request the finest level they need every frame, typically from the screen-space footprint of the meshes
+// using them (see requiredMipLevel). Once per frame the backend calls updateResidency() and reallocates the textures
+// whose resident levels changed. The full mip chains are kept in CPU memory, so it's only the VRAM that's saved.
+class TextureStreamer {
+public:
+    TextureStreamer() = default;
+
+    // The budget only covers the streamed textures, not render targets & other resources
+    void enable(size_t budgetInBytes);
+    bool isEnabled() const { return m_enabled; }
+    size_t budget() const { return m_budget; }
+
+    // Only textures with a full mip chain loaded from file (i.e. the update comes with an Image) can be streamed
+    void addTexture(const Texture&, TextureUpdate);
+    bool isStreamed(const Texture&) const;
+
+    // The finest resident mip level, i.e. the level that the backend should use as the base level of the texture.
+    // For textures that aren't streamed this is always 0.
+    uint32_t residentMipLevel(const Texture&) const;
+    const TextureUpdate& textureUpdate(const Texture&) const;
+
+    // Request that the given level (and all coarser levels) should be resident. All requests are for the current frame
+    // only, so they have to be made every frame. If there are multiple requests for a texture the finest one is used.
+    void requestMipLevel(const Texture&, uint32_t mipLevel);
+
+    // For streamed textures that are also used by something that doesn't request levels, e.g. ray tracing
+    void keepFullyResident(const Texture&);
+
+    // Resolves the requests of this frame against the budget, and returns all textures whose resident mip level changed
+    std::vector<const Texture*> updateResidency();
+
+    size_t residentSize() const;
+    size_t textureCount() const { return m_textures.size(); }
+
+    // The finest mip level needed when the texture is mapped with the given texcoord density (texcoords per mesh space
+    // unit, see Mesh::texcoordDensity()) onto a mesh where each mesh space unit covers pixelsPerLocalUnit pixels.
+    static uint32_t requiredMipLevel(const Texture&, float texcoordsPerLocalUnit, float pixelsPerLocalUnit);
+
+    // Levels up to this size are always resident, which is also all that is uploaded when the texture is first loaded
+    static constexpr int alwaysResidentSize = 128;
+
+    // Limits how much new data is streamed in each frame, so that moving the camera doesn't cause huge stalls
+    static constexpr size_t maxStreamedSizePerFrame = 64 * 1024 * 1024;
+
+private:
+    struct StreamedTexture {
+        const Texture* texture;
+        TextureUpdate update;
+
+        // levelsSize[level] is the size of that level and all coarser levels
+        std::vector<size_t> levelsSize {};
+
+        uint32_t alwaysResidentMip {}; // (this level and all coarser levels are always resident)
+        uint32_t residentMip {};
+        std::optional<uint32_t> requestedMip {};
+        bool keepFullyResident { false };
+    };
+
+    bool m_enabled { false };
+    size_t m_budget { 0 };
+    bool m_warnedOverBudget { false };
+
+    std::vector<StreamedTexture> m_textures {};
+    std::unordered_map<const Texture*, size_t> m_textureIndices {};
+};
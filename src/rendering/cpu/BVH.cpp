@@ -0,0 +1,245 @@
+#include "BVH.h"
+
+#include "utility/Logging.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+struct Bounds {
+    vec3 min { std::numeric_limits<float>::max() };
+    vec3 max { -std::numeric_limits<float>::max() };
+
+    void grow(const vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void grow(const vec3& otherMin, const vec3& otherMax)
+    {
+        min = glm::min(min, otherMin);
+        max = glm::max(max, otherMax);
+    }
+
+    float surfaceArea() const
+    {
+        vec3 extent = glm::max(max - min, vec3(0.0f));
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+};
+
+// (relative costs of a node traversal vs. a primitive intersection, in the SAH)
+constexpr float traversalCost = 1.0f;
+constexpr float intersectionCost = 1.0f;
+
+constexpr int binCount = 16;
+
+}
+
+struct BVH::BuildNode {
+    Bounds bounds;
+    uint32_t first;
+    uint32_t count; // (zero for inner nodes)
+    uint32_t left;
+    uint32_t right;
+};
+
+BVH::BVH(const std::vector<aabb3>& primitiveBounds)
+{
+    if (primitiveBounds.empty()) {
+        return;
+    }
+
+    ASSERT(primitiveBounds.size() < INT32_MAX);
+    uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+
+    std::vector<vec3> centroids {};
+    centroids.reserve(primitiveCount);
+    for (const aabb3& bounds : primitiveBounds) {
+        centroids.push_back(0.5f * (bounds.min + bounds.max));
+    }
+
+    m_primitiveIndices.resize(primitiveCount);
+    std::iota(m_primitiveIndices.begin(), m_primitiveIndices.end(), 0u);
+
+    std::vector<BuildNode> buildNodes {};
+    buildNodes.reserve(2 * primitiveCount);
+    buildRecursive(buildNodes, primitiveBounds, centroids, 0, primitiveCount);
+    m_bounds = aabb3(buildNodes[0].bounds.min, buildNodes[0].bounds.max);
+
+    m_nodes.reserve(buildNodes.size() / 2 + 1);
+    collapse(buildNodes, 0);
+}
+
+uint32_t BVH::buildRecursive(std::vector<BuildNode>& buildNodes, const std::vector<aabb3>& primitiveBounds, const std::vector<vec3>& centroids, uint32_t first, uint32_t count)
+{
+    Bounds bounds {};
+    Bounds centroidBounds {};
+    for (uint32_t i = first; i < first + count; ++i) {
+        uint32_t primitive = m_primitiveIndices[i];
+        bounds.grow(primitiveBounds[primitive].min, primitiveBounds[primitive].max);
+        centroidBounds.grow(centroids[primitive]);
+    }
+
+    uint32_t nodeIndex = static_cast<uint32_t>(buildNodes.size());
+    buildNodes.push_back({ .bounds = bounds, .first = first, .count = count, .left = 0, .right = 0 });
+
+    if (count == 1) {
+        return nodeIndex;
+    }
+
+    // Find the cheapest split between bins (by the surface area heuristic) along any of the axes
+
+    struct Bin {
+        Bounds bounds {};
+        uint32_t count { 0 };
+    };
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestSplit = 0;
+
+    float parentArea = bounds.surfaceArea();
+    auto binIndex = [&](const vec3& centroid, int axis) -> int {
+        float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+        int index = static_cast<int>(binCount * (centroid[axis] - centroidBounds.min[axis]) / extent);
+        return std::clamp(index, 0, binCount - 1);
+    };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (centroidBounds.max[axis] <= centroidBounds.min[axis]) {
+            continue;
+        }
+
+        Bin bins[binCount] {};
+        for (uint32_t i = first; i < first + count; ++i) {
+            uint32_t primitive = m_primitiveIndices[i];
+            Bin& bin = bins[binIndex(centroids[primitive], axis)];
+            bin.bounds.grow(primitiveBounds[primitive].min, primitiveBounds[primitive].max);
+            bin.count += 1;
+        }
+
+        // (sweep from the right first, so the left sweep can evaluate the cost directly)
+        float rightCost[binCount] {};
+        Bin right {};
+        for (int split = binCount - 1; split > 0; --split) {
+            right.bounds.grow(bins[split].bounds.min, bins[split].bounds.max);
+            right.count += bins[split].count;
+            rightCost[split] = right.bounds.surfaceArea() * right.count;
+        }
+
+        Bin left {};
+        for (int split = 1; split < binCount; ++split) {
+            left.bounds.grow(bins[split - 1].bounds.min, bins[split - 1].bounds.max);
+            left.count += bins[split - 1].count;
+            if (left.count == 0 || left.count == count) {
+                continue;
+            }
+
+            float cost = left.bounds.surfaceArea() * left.count + rightCost[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    // (if all primitives are flat & in the same plane there is no area to compare, so just prefer a leaf if possible)
+    float leafCost = intersectionCost * count;
+    if (bestAxis != -1) {
+        bestCost = parentArea > 0.0f ? traversalCost + intersectionCost * bestCost / parentArea : leafCost;
+    }
+
+    if (count <= maxLeafPrimitives && (bestAxis == -1 || leafCost <= bestCost)) {
+        return nodeIndex;
+    }
+
+    uint32_t middle;
+    if (bestAxis != -1) {
+        auto begin = m_primitiveIndices.begin() + first;
+        auto it = std::partition(begin, begin + count, [&](uint32_t primitive) {
+            return binIndex(centroids[primitive], bestAxis) < bestSplit;
+        });
+        middle = static_cast<uint32_t>(it - m_primitiveIndices.begin());
+    } else {
+        // All centroids are in the same place, so there is no good split, but there are too many primitives for a leaf
+        middle = first + count / 2;
+    }
+
+    uint32_t left = buildRecursive(buildNodes, primitiveBounds, centroids, first, middle - first);
+    uint32_t right = buildRecursive(buildNodes, primitiveBounds, centroids, middle, first + count - middle);
+
+    BuildNode& node = buildNodes[nodeIndex];
+    node.count = 0;
+    node.left = left;
+    node.right = right;
+
+    return nodeIndex;
+}
+
+int32_t BVH::collapse(const std::vector<BuildNode>& buildNodes, uint32_t buildNodeIndex)
+{
+    // Pull up grandchildren until there are four children, always opening the inner child with the largest surface area
+    uint32_t children[4];
+    int childCount = 0;
+
+    const BuildNode& buildNode = buildNodes[buildNodeIndex];
+    if (buildNode.count > 0) {
+        children[childCount++] = buildNodeIndex;
+    } else {
+        children[childCount++] = buildNode.left;
+        children[childCount++] = buildNode.right;
+    }
+
+    while (childCount < 4) {
+        int largestInner = -1;
+        float largestArea = -1.0f;
+        for (int i = 0; i < childCount; ++i) {
+            const BuildNode& child = buildNodes[children[i]];
+            if (child.count == 0 && child.bounds.surfaceArea() > largestArea) {
+                largestArea = child.bounds.surfaceArea();
+                largestInner = i;
+            }
+        }
+
+        if (largestInner == -1) {
+            break;
+        }
+
+        const BuildNode& opened = buildNodes[children[largestInner]];
+        children[largestInner] = opened.left;
+        children[childCount++] = opened.right;
+    }
+
+    int32_t nodeIndex = static_cast<int32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    Node node {};
+    for (int i = 0; i < childCount; ++i) {
+        const BuildNode& child = buildNodes[children[i]];
+
+        node.minX[i] = child.bounds.min.x;
+        node.minY[i] = child.bounds.min.y;
+        node.minZ[i] = child.bounds.min.z;
+        node.maxX[i] = child.bounds.max.x;
+        node.maxY[i] = child.bounds.max.y;
+        node.maxZ[i] = child.bounds.max.z;
+
+        if (child.count > 0) {
+            node.index[i] = static_cast<int32_t>(child.first);
+            node.count[i] = child.count;
+        } else {
+            node.index[i] = collapse(buildNodes, children[i]);
+            node.count[i] = 0;
+        }
+
+        node.childMask |= 1 << i;
+    }
+
+    // (not a reference above, since the recursion can reallocate the node vector)
+    m_nodes[nodeIndex] = node;
+
+    return nodeIndex;
+}
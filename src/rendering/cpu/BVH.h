@@ -0,0 +1,147 @@
+#pragma once
+
+#include "utility/mathkit.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <xmmintrin.h>
+
+struct Ray {
+    vec3 origin;
+    vec3 direction;
+    float tMin { 0.0f };
+    float tMax { std::numeric_limits<float>::infinity() };
+};
+
+// Bounding volume hierarchy over any kind of primitives, only given their bounding boxes. It's built top-down with binned
+// SAH splits and then collapsed into a 4-wide tree, so that each node visit tests the ray against four child boxes at
+// once (with SSE). The primitives themselves are intersected through a callback, see traverse().
+class BVH {
+public:
+    BVH() = default;
+    explicit BVH(const std::vector<aabb3>& primitiveBounds);
+
+    // Calls intersectPrimitive(primitiveIndex, ray) for all primitives with bounds that the ray hits, roughly front to
+    // back. The callback should return true if it found a hit, in which case it should also have shortened ray.tMax to
+    // the hit distance, so that anything further away is culled. If anyHit is set the traversal stops at the first hit.
+    // Returns true if any primitive was hit.
+    template<typename Func>
+    bool traverse(Ray& ray, Func&& intersectPrimitive, bool anyHit = false) const;
+
+    [[nodiscard]] bool isEmpty() const { return m_nodes.empty(); }
+    [[nodiscard]] aabb3 bounds() const { return m_bounds; }
+
+    [[nodiscard]] size_t nodeCount() const { return m_nodes.size(); }
+    [[nodiscard]] size_t primitiveCount() const { return m_primitiveIndices.size(); }
+    [[nodiscard]] size_t sizeInBytes() const { return m_nodes.size() * sizeof(Node) + m_primitiveIndices.size() * sizeof(uint32_t); }
+
+    static constexpr int maxLeafPrimitives = 4;
+
+private:
+    // Child bounds are stored as SoA so they can be loaded straight into SSE registers. A child with a primitive count
+    // is a leaf (with its primitives at index in m_primitiveIndices), otherwise the index is the child node. Nodes near
+    // the leaves might not use all four slots, so there is also a mask of the used ones.
+    struct alignas(16) Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int32_t index[4];
+        uint32_t count[4];
+        int childMask;
+    };
+
+    // The binary SAH tree, which is collapsed into the 4-wide one
+    struct BuildNode;
+    uint32_t buildRecursive(std::vector<BuildNode>&, const std::vector<aabb3>& primitiveBounds, const std::vector<vec3>& centroids, uint32_t first, uint32_t count);
+    int32_t collapse(const std::vector<BuildNode>&, uint32_t buildNodeIndex);
+
+    // Returns a 4-bit mask of the children that the ray hits (within [tMin, tMax]), and their entry distances
+    static int intersectChildren(const Node&, const __m128 origin[3], const __m128 invDirection[3], float tMin, float tMax, float* tEntry);
+
+    std::vector<Node> m_nodes {};
+    std::vector<uint32_t> m_primitiveIndices {};
+    aabb3 m_bounds { vec3(0.0f), vec3(0.0f) };
+};
+
+inline int BVH::intersectChildren(const Node& node, const __m128 origin[3], const __m128 invDirection[3], float tMin, float tMax, float* tEntry)
+{
+    __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), origin[0]), invDirection[0]);
+    __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), origin[0]), invDirection[0]);
+    __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), origin[1]), invDirection[1]);
+    __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), origin[1]), invDirection[1]);
+    __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), origin[2]), invDirection[2]);
+    __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), origin[2]), invDirection[2]);
+
+    __m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_set1_ps(tMin)));
+    __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(tMax)));
+
+    _mm_storeu_ps(tEntry, entry);
+    return _mm_movemask_ps(_mm_cmple_ps(entry, exit));
+}
+
+template<typename Func>
+bool BVH::traverse(Ray& ray, Func&& intersectPrimitive, bool anyHit) const
+{
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    // (avoid infinities for zero direction components, since inf * 0 in the slab test would give NaNs)
+    auto safeInverse = [](float x) { return std::abs(x) > 1e-20f ? 1.0f / x : std::copysign(1e20f, x); };
+    __m128 origin[3] = { _mm_set1_ps(ray.origin.x), _mm_set1_ps(ray.origin.y), _mm_set1_ps(ray.origin.z) };
+    __m128 invDirection[3] = { _mm_set1_ps(safeInverse(ray.direction.x)), _mm_set1_ps(safeInverse(ray.direction.y)), _mm_set1_ps(safeInverse(ray.direction.z)) };
+
+    struct StackEntry {
+        int32_t index;
+        uint32_t count;
+        float tEntry;
+    };
+
+    // (every visited node pushes at most four entries, so this can't overflow for any reasonably balanced tree)
+    constexpr int maxStackSize = 256;
+    StackEntry stack[maxStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0, ray.tMin };
+
+    bool didHit = false;
+    while (stackSize > 0) {
+        StackEntry entry = stack[--stackSize];
+        if (entry.tEntry > ray.tMax) {
+            continue;
+        }
+
+        if (entry.count > 0) {
+            for (uint32_t i = 0; i < entry.count; ++i) {
+                if (intersectPrimitive(m_primitiveIndices[entry.index + i], ray)) {
+                    didHit = true;
+                    if (anyHit) {
+                        return true;
+                    }
+                }
+            }
+            continue;
+        }
+
+        const Node& node = m_nodes[entry.index];
+        alignas(16) float tEntry[4];
+        int hitMask = intersectChildren(node, origin, invDirection, ray.tMin, ray.tMax, tEntry) & node.childMask;
+
+        // Push the hit children so that the closest one ends up on top of the stack (insertion sort, since it's at most four)
+        int firstPushed = stackSize;
+        for (int child = 0; child < 4; ++child) {
+            if ((hitMask & (1 << child)) == 0) {
+                continue;
+            }
+            ASSERT(stackSize < maxStackSize);
+            StackEntry childEntry { node.index[child], node.count[child], tEntry[child] };
+            int position = stackSize++;
+            while (position > firstPushed && stack[position - 1].tEntry < childEntry.tEntry) {
+                stack[position] = stack[position - 1];
+                position -= 1;
+            }
+            stack[position] = childEntry;
+        }
+    }
+
+    return didHit;
+}
@@ -0,0 +1,355 @@
+#include "CpuRayTracingScene.h"
+
+#include "Intersections.h"
+#include "utility/Logging.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <algorithm>
+
+std::vector<const Model*> CpuRayTracingScene::modelsOfScene(const Scene& scene)
+{
+    std::vector<const Model*> models {};
+    scene.forEachModel([&](size_t, const Model& model) {
+        models.push_back(&model);
+    });
+    return models;
+}
+
+CpuRayTracingScene::CpuRayTracingScene(const Scene& scene, bool useProxies)
+    : CpuRayTracingScene(modelsOfScene(scene), useProxies)
+{
+}
+
+CpuRayTracingScene::CpuRayTracingScene(const std::vector<const Model*>& models, bool useProxies)
+{
+    for (const Model* model : models) {
+        if (!useProxies) {
+            uint8_t hitMask = model->hasProxy() ? TriangleMeshWithProxy : TriangleMeshWithoutProxy;
+            addInstance(bottomLevelForTriangleMeshes(*model), *model, model->transform(), hitMask);
+            continue;
+        }
+
+        const Model& proxy = model->proxy();
+        if (proxy.hasMeshes()) {
+            addInstance(bottomLevelForTriangleMeshes(proxy), proxy, model->transform(), TriangleMeshWithoutProxy);
+        } else if (const auto* sphereSetModel = dynamic_cast<const SphereSetModel*>(&proxy)) {
+            addInstance(bottomLevelForSphereSet(*sphereSetModel), proxy, model->transform(), SphereSetHitMask);
+        } else if (const auto* voxelContourModel = dynamic_cast<const VoxelContourModel*>(&proxy)) {
+            addInstance(bottomLevelForVoxelContours(*voxelContourModel), proxy, model->transform(), VoxelContourHitMask);
+        } else {
+            ASSERT_NOT_REACHED();
+        }
+    }
+
+    std::vector<aabb3> instanceBounds {};
+    for (const Instance& instance : m_instances) {
+        aabb3 objectBounds = instance.bottomLevel->bvh.bounds();
+
+        vec3 worldMin { std::numeric_limits<float>::max() };
+        vec3 worldMax { -std::numeric_limits<float>::max() };
+        for (int corner = 0; corner < 8; ++corner) {
+            vec3 objectCorner { (corner & 1) ? objectBounds.max.x : objectBounds.min.x,
+                                (corner & 2) ? objectBounds.max.y : objectBounds.min.y,
+                                (corner & 4) ? objectBounds.max.z : objectBounds.min.z };
+            vec3 worldCorner = vec3(instance.worldFromObject * vec4(objectCorner, 1.0f));
+            worldMin = glm::min(worldMin, worldCorner);
+            worldMax = glm::max(worldMax, worldCorner);
+        }
+
+        instanceBounds.emplace_back(worldMin, worldMax);
+    }
+    m_topLevel = BVH(instanceBounds);
+}
+
+CpuRayTracingScene::~CpuRayTracingScene() = default;
+
+CpuRayTracingScene::BottomLevel& CpuRayTracingScene::bottomLevelForTriangleMeshes(const Model& model)
+{
+    std::vector<std::pair<const void*, mat4>> meshGeometries {};
+    model.forEachMesh([&](const Mesh& mesh) {
+        meshGeometries.emplace_back(mesh.geometrySource(), mesh.transform().localMatrix());
+    });
+
+    // Models that are instances of the same geometry share their BVH (cf. the shared BLASes)
+    for (auto& bottomLevel : m_bottomLevels) {
+        if (bottomLevel->geometry == Geometry::Triangles && bottomLevel->meshGeometries == meshGeometries) {
+            return *bottomLevel;
+        }
+    }
+
+    auto bottomLevel = std::make_unique<BottomLevel>();
+    bottomLevel->geometry = Geometry::Triangles;
+    bottomLevel->meshGeometries = std::move(meshGeometries);
+
+    std::vector<aabb3> triangleBounds {};
+    model.forEachMesh([&](const Mesh& mesh) {
+        uint32_t firstVertex = static_cast<uint32_t>(bottomLevel->positions.size());
+        mat4 localMatrix = mesh.transform().localMatrix();
+        for (const vec3& position : mesh.positionData()) {
+            bottomLevel->positions.push_back(vec3(localMatrix * vec4(position, 1.0f)));
+        }
+
+        std::vector<uint32_t> indices = mesh.indexData();
+        if (!mesh.isIndexed()) {
+            indices.resize(mesh.vertexCount());
+            for (uint32_t i = 0; i < indices.size(); ++i) {
+                indices[i] = i;
+            }
+        }
+
+        bottomLevel->meshes.push_back(&mesh);
+        bottomLevel->meshFirstTriangle.push_back(static_cast<uint32_t>(bottomLevel->indices.size() / 3));
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            vec3 v0 = bottomLevel->positions[firstVertex + indices[i + 0]];
+            vec3 v1 = bottomLevel->positions[firstVertex + indices[i + 1]];
+            vec3 v2 = bottomLevel->positions[firstVertex + indices[i + 2]];
+            triangleBounds.emplace_back(glm::min(v0, glm::min(v1, v2)), glm::max(v0, glm::max(v1, v2)));
+
+            bottomLevel->indices.push_back(firstVertex + indices[i + 0]);
+            bottomLevel->indices.push_back(firstVertex + indices[i + 1]);
+            bottomLevel->indices.push_back(firstVertex + indices[i + 2]);
+        }
+    });
+
+    bottomLevel->bvh = BVH(triangleBounds);
+
+    m_bottomLevels.push_back(std::move(bottomLevel));
+    return *m_bottomLevels.back();
+}
+
+CpuRayTracingScene::BottomLevel& CpuRayTracingScene::bottomLevelForSphereSet(const SphereSetModel& sphereSet)
+{
+    auto bottomLevel = std::make_unique<BottomLevel>();
+    bottomLevel->geometry = Geometry::Spheres;
+
+    // (the BVH uses the full precision spheres, like the AABBs of the BLAS, but the intersection uses the packed ones)
+    std::vector<aabb3> sphereBounds {};
+    for (const SphereSetModel::Sphere& sphere : sphereSet.spheres()) {
+        sphereBounds.emplace_back(vec3(sphere) - vec3(sphere.w), vec3(sphere) + vec3(sphere.w));
+    }
+    bottomLevel->bvh = BVH(sphereBounds);
+
+    const auto& packedSpheres = sphereSet.packedSpheres();
+    for (size_t i = 0; i + 3 < packedSpheres.size(); i += 4) {
+        bottomLevel->spheres.emplace_back(float(packedSpheres[i + 0]), float(packedSpheres[i + 1]), float(packedSpheres[i + 2]), float(packedSpheres[i + 3]));
+    }
+    ASSERT(bottomLevel->spheres.size() == sphereSet.spheres().size());
+
+    m_bottomLevels.push_back(std::move(bottomLevel));
+    return *m_bottomLevels.back();
+}
+
+CpuRayTracingScene::BottomLevel& CpuRayTracingScene::bottomLevelForVoxelContours(const VoxelContourModel& contourModel)
+{
+    auto bottomLevel = std::make_unique<BottomLevel>();
+    bottomLevel->geometry = Geometry::VoxelContours;
+
+    std::vector<aabb3> contourBounds {};
+    for (const VoxelContourModel::VoxelContour& contour : contourModel.contours()) {
+        contourBounds.push_back(contour.aabb);
+    }
+    bottomLevel->bvh = BVH(contourBounds);
+
+    const VoxelContourModel::PackedContours& packed = contourModel.packedContours();
+    for (size_t i = 0; i + 3 < packed.planes.size(); i += 4) {
+        bottomLevel->planes.emplace_back(float(packed.planes[i + 0]), float(packed.planes[i + 1]), float(packed.planes[i + 2]), float(packed.planes[i + 3]));
+    }
+    for (size_t i = 0; i + 2 < packed.aabbs.size(); i += 3) {
+        bottomLevel->aabbs.emplace_back(float(packed.aabbs[i + 0]), float(packed.aabbs[i + 1]), float(packed.aabbs[i + 2]));
+    }
+    ASSERT(bottomLevel->planes.size() == contourModel.contours().size());
+    ASSERT(bottomLevel->aabbs.size() == 2 * contourModel.contours().size());
+
+    m_bottomLevels.push_back(std::move(bottomLevel));
+    return *m_bottomLevels.back();
+}
+
+void CpuRayTracingScene::addInstance(const BottomLevel& bottomLevel, const Model& model, const Transform& transform, uint8_t hitMask)
+{
+    if (bottomLevel.bvh.isEmpty()) {
+        LogWarning("CpuRayTracingScene: model '%s' has no geometry, ignoring it\n", model.name().c_str());
+        return;
+    }
+
+    mat4 worldFromObject = transform.worldMatrix();
+    m_instances.push_back({ .bottomLevel = &bottomLevel,
+                            .model = &model,
+                            .worldFromObject = worldFromObject,
+                            .objectFromWorld = inverse(worldFromObject),
+                            .normalMatrix = transform.worldNormalMatrix(),
+                            .hitMask = hitMask });
+}
+
+std::optional<CpuRayTracingScene::Hit> CpuRayTracingScene::traceRay(const Ray& ray, uint8_t hitMask, bool cullBackFaces) const
+{
+    Ray worldRay = ray;
+    PendingHit pendingHit {};
+
+    bool didHit = m_topLevel.traverse(worldRay, [&](uint32_t instanceIndex, Ray& currentRay) {
+        const Instance& instance = m_instances[instanceIndex];
+        if ((instance.hitMask & hitMask) == 0) {
+            return false;
+        }
+        return intersectInstance(instance, currentRay, cullBackFaces, false, pendingHit);
+    });
+
+    if (!didHit) {
+        return {};
+    }
+
+    return resolveHit(pendingHit, worldRay);
+}
+
+bool CpuRayTracingScene::isOccluded(const Ray& ray, uint8_t hitMask) const
+{
+    Ray worldRay = ray;
+    PendingHit pendingHit {};
+
+    return m_topLevel.traverse(worldRay, [&](uint32_t instanceIndex, Ray& currentRay) {
+        const Instance& instance = m_instances[instanceIndex];
+        if ((instance.hitMask & hitMask) == 0) {
+            return false;
+        }
+        return intersectInstance(instance, currentRay, true, true, pendingHit);
+    }, true);
+}
+
+bool CpuRayTracingScene::intersectInstance(const Instance& instance, Ray& worldRay, bool cullBackFaces, bool anyHit, PendingHit& pendingHit) const
+{
+    const BottomLevel& bottomLevel = *instance.bottomLevel;
+
+    // (the direction isn't normalized, so that distances along the object space ray are the same as in world space)
+    Ray objectRay { .origin = vec3(instance.objectFromWorld * vec4(worldRay.origin, 1.0f)),
+                    .direction = mat3(instance.objectFromWorld) * worldRay.direction,
+                    .tMin = worldRay.tMin,
+                    .tMax = worldRay.tMax };
+
+    auto reportHit = [&](Ray& ray, float t, uint32_t primitive, vec2 barycentrics) {
+        ray.tMax = t;
+        worldRay.tMax = t;
+        pendingHit = { .instance = &instance, .primitive = primitive, .barycentrics = barycentrics };
+        return true;
+    };
+
+    switch (bottomLevel.geometry) {
+    case Geometry::Triangles:
+        return bottomLevel.bvh.traverse(objectRay, [&](uint32_t triangle, Ray& ray) {
+            vec3 v0 = bottomLevel.positions[bottomLevel.indices[3 * triangle + 0]];
+            vec3 v1 = bottomLevel.positions[bottomLevel.indices[3 * triangle + 1]];
+            vec3 v2 = bottomLevel.positions[bottomLevel.indices[3 * triangle + 2]];
+
+            float t;
+            vec2 barycentrics;
+            if (!Intersections::rayTriangle(v0, v1, v2, ray, cullBackFaces, t, barycentrics)) {
+                return false;
+            }
+            return reportHit(ray, t, triangle, barycentrics);
+        }, anyHit);
+
+    case Geometry::Spheres:
+        return bottomLevel.bvh.traverse(objectRay, [&](uint32_t sphereIndex, Ray& ray) {
+            // Just like sphere.rint, in world space
+            const vec4& sphere = bottomLevel.spheres[sphereIndex];
+            vec3 sphereCenter = vec3(instance.worldFromObject * vec4(vec3(sphere), 1.0f));
+            vec3 radiiPoint = vec3(instance.worldFromObject * vec4(vec3(sphere) + vec3(sphere.w, 0.0f, 0.0f), 1.0f));
+            float sphereRadius = distance(radiiPoint, sphereCenter);
+
+            float t;
+            if (!Intersections::raySphere(sphereCenter, sphereRadius, worldRay, t)) {
+                return false;
+            }
+            return reportHit(ray, t, sphereIndex, vec2(0.0f));
+        }, anyHit);
+
+    case Geometry::VoxelContours:
+        return bottomLevel.bvh.traverse(objectRay, [&](uint32_t contourIndex, Ray& ray) {
+            // Just like contour.rint, in object space
+            vec4 plane = bottomLevel.planes[contourIndex];
+            plane.w = -plane.w; // (see contour.rint)
+
+            float t;
+            if (!Intersections::rayPlane(vec3(plane), plane.w, ray, t) || t < ray.tMin || t > ray.tMax) {
+                return false;
+            }
+
+            vec3 hitPoint = ray.origin + t * ray.direction;
+            const vec3& aabbMin = bottomLevel.aabbs[2 * contourIndex + 0];
+            const vec3& aabbMax = bottomLevel.aabbs[2 * contourIndex + 1];
+            if (glm::any(glm::lessThan(hitPoint, aabbMin)) || glm::any(glm::greaterThan(hitPoint, aabbMax))) {
+                return false;
+            }
+
+            return reportHit(ray, t, contourIndex, vec2(0.0f));
+        }, anyHit);
+    }
+
+    ASSERT_NOT_REACHED();
+    return false;
+}
+
+CpuRayTracingScene::Hit CpuRayTracingScene::resolveHit(const PendingHit& pendingHit, const Ray& worldRay) const
+{
+    const Instance& instance = *pendingHit.instance;
+    const BottomLevel& bottomLevel = *instance.bottomLevel;
+
+    Hit hit {};
+    hit.t = worldRay.tMax;
+    hit.position = worldRay.origin + hit.t * worldRay.direction;
+    hit.geometry = bottomLevel.geometry;
+    hit.model = instance.model;
+    hit.mesh = nullptr;
+    hit.primitiveIndex = pendingHit.primitive;
+    hit.barycentrics = pendingHit.barycentrics;
+    hit.normalMatrix = instance.normalMatrix;
+
+    switch (bottomLevel.geometry) {
+    case Geometry::Triangles: {
+        uint32_t triangle = pendingHit.primitive;
+        vec3 v0 = bottomLevel.positions[bottomLevel.indices[3 * triangle + 0]];
+        vec3 v1 = bottomLevel.positions[bottomLevel.indices[3 * triangle + 1]];
+        vec3 v2 = bottomLevel.positions[bottomLevel.indices[3 * triangle + 2]];
+        hit.normal = normalize(instance.normalMatrix * cross(v1 - v0, v2 - v0));
+
+        // (find the mesh that the triangle belongs to, and make the index relative to it)
+        auto next = std::upper_bound(bottomLevel.meshFirstTriangle.begin(), bottomLevel.meshFirstTriangle.end(), triangle);
+        size_t meshSlot = std::distance(bottomLevel.meshFirstTriangle.begin(), next) - 1;
+        hit.mesh = bottomLevel.meshes[meshSlot];
+        hit.primitiveIndex = triangle - bottomLevel.meshFirstTriangle[meshSlot];
+        break;
+    }
+    case Geometry::Spheres: {
+        const vec4& sphere = bottomLevel.spheres[pendingHit.primitive];
+        vec3 sphereCenter = vec3(instance.worldFromObject * vec4(vec3(sphere), 1.0f));
+        hit.normal = normalize(hit.position - sphereCenter);
+        break;
+    }
+    case Geometry::VoxelContours: {
+        vec3 planeNormal = vec3(bottomLevel.planes[pendingHit.primitive]);
+        hit.normal = normalize(instance.normalMatrix * planeNormal);
+        break;
+    }
+    }
+
+    return hit;
+}
+
+size_t CpuRayTracingScene::primitiveCount() const
+{
+    size_t count = 0;
+    for (const auto& bottomLevel : m_bottomLevels) {
+        count += bottomLevel->bvh.primitiveCount();
+    }
+    return count;
+}
+
+size_t CpuRayTracingScene::sizeInBytes() const
+{
+    size_t size = m_topLevel.sizeInBytes() + m_instances.size() * sizeof(Instance);
+    for (const auto& bottomLevel : m_bottomLevels) {
+        size += bottomLevel->bvh.sizeInBytes();
+        size += bottomLevel->positions.size() * sizeof(vec3) + bottomLevel->indices.size() * sizeof(uint32_t);
+        size += bottomLevel->spheres.size() * sizeof(vec4) + bottomLevel->planes.size() * sizeof(vec4) + bottomLevel->aabbs.size() * sizeof(vec3);
+    }
+    return size;
+}
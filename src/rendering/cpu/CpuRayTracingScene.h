@@ -0,0 +1,106 @@
+#pragma once
+
+#include "BVH.h"
+#include "utility/Scene.h"
+#include <memory>
+#include <optional>
+#include <vector>
+
+class VoxelContourModel;
+
+// CPU counterpart of the acceleration structures that RTAccelerationStructures builds on the GPU: one BVH per unique
+// model geometry (cf. the BLASes) and one BVH over all instances of them (cf. the TLASes). The main scene uses the real
+// triangle meshes of all models, and the proxy scene uses their proxies, i.e. triangle meshes, sphere sets or voxel
+// contours. Sphere sets and voxel contours are intersected just like sphere.rint and contour.rint do on the GPU, from
+// the same packed (half precision) data, so this works as a reference for the proxies on machines without RT support.
+class CpuRayTracingScene {
+public:
+    // (same values as RTAccelerationStructures::HitMask, so masks can be passed the same as to traceNV)
+    enum HitMask : uint8_t {
+        TriangleMeshWithoutProxy = 0x01,
+        TriangleMeshWithProxy = 0x02,
+        SphereSetHitMask = 0x04,
+        VoxelContourHitMask = 0x08,
+    };
+
+    enum class Geometry {
+        Triangles,
+        Spheres,
+        VoxelContours,
+    };
+
+    struct Hit {
+        float t;
+        vec3 position;
+        vec3 normal; // (world space, geometric normal for triangles)
+
+        Geometry geometry;
+        const Model* model; // (the model that owns the geometry, i.e. the proxy model for sphere set & voxel contour hits)
+        const Mesh* mesh; // (triangles only)
+        uint32_t primitiveIndex; // triangle index within the mesh, or sphere or contour index within the proxy
+        vec2 barycentrics; // (triangles only)
+
+        mat3 normalMatrix; // (world from object, of the instance that was hit, e.g. for interpolated vertex normals)
+    };
+
+    CpuRayTracingScene(const Scene&, bool useProxies);
+    CpuRayTracingScene(const std::vector<const Model*>&, bool useProxies); // (e.g. for tools that load models without a scene)
+    ~CpuRayTracingScene();
+
+    // Closest hit along the ray, if any. The ray direction must be normalized (just like for the sphere intersection shader).
+    [[nodiscard]] std::optional<Hit> traceRay(const Ray&, uint8_t hitMask = 0xff, bool cullBackFaces = true) const;
+
+    // True if anything is hit along the ray, e.g. for shadow & AO rays (cf. gl_RayFlagsTerminateOnFirstHitNV)
+    [[nodiscard]] bool isOccluded(const Ray&, uint8_t hitMask = 0xff) const;
+
+    [[nodiscard]] size_t instanceCount() const { return m_instances.size(); }
+    [[nodiscard]] size_t primitiveCount() const;
+    [[nodiscard]] size_t sizeInBytes() const;
+
+private:
+    struct BottomLevel {
+        Geometry geometry;
+        BVH bvh {};
+
+        // Triangles of all meshes of a model, with the mesh transforms applied (like the geometries of a triangle BLAS)
+        std::vector<vec3> positions {};
+        std::vector<uint32_t> indices {};
+        std::vector<const Mesh*> meshes {};
+        std::vector<uint32_t> meshFirstTriangle {};
+        std::vector<std::pair<const void*, mat4>> meshGeometries {}; // (what the triangles were created from, for sharing)
+
+        // Spheres (center & radius), or contour planes (normal & distance) and AABBs, unpacked from the GPU data
+        std::vector<vec4> spheres {};
+        std::vector<vec4> planes {};
+        std::vector<vec3> aabbs {}; // (min & max interleaved)
+    };
+
+    struct Instance {
+        const BottomLevel* bottomLevel;
+        const Model* model;
+        mat4 worldFromObject;
+        mat4 objectFromWorld;
+        mat3 normalMatrix;
+        uint8_t hitMask;
+    };
+
+    struct PendingHit {
+        const Instance* instance {};
+        uint32_t primitive {};
+        vec2 barycentrics {};
+    };
+
+    static std::vector<const Model*> modelsOfScene(const Scene&);
+
+    BottomLevel& bottomLevelForTriangleMeshes(const Model&);
+    BottomLevel& bottomLevelForSphereSet(const SphereSetModel&);
+    BottomLevel& bottomLevelForVoxelContours(const VoxelContourModel&);
+    void addInstance(const BottomLevel&, const Model&, const Transform&, uint8_t hitMask);
+
+    bool intersectInstance(const Instance&, Ray& worldRay, bool cullBackFaces, bool anyHit, PendingHit&) const;
+    Hit resolveHit(const PendingHit&, const Ray& worldRay) const;
+
+    std::vector<std::unique_ptr<BottomLevel>> m_bottomLevels {};
+    std::vector<Instance> m_instances {};
+    BVH m_topLevel {};
+};
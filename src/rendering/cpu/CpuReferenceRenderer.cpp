@@ -0,0 +1,454 @@
+#include "CpuReferenceRenderer.h"
+
+#include "utility/Logging.h"
+#include "utility/ThreadPool.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stb_image_write.h>
+
+namespace {
+
+// Same random numbers as random.glsl, i.e. xorshift seeded with a wang hash
+class ShaderRandom {
+public:
+    explicit ShaderRandom(uint32_t seed)
+    {
+        seed = (seed ^ 61u) ^ (seed >> 16u);
+        seed *= 9u;
+        seed = seed ^ (seed >> 4u);
+        seed *= 0x27d4eb2du;
+        seed = seed ^ (seed >> 15u);
+        m_state = seed;
+    }
+
+    float randomFloat()
+    {
+        m_state ^= (m_state << 13u);
+        m_state ^= (m_state >> 17u);
+        m_state ^= (m_state << 5u);
+        return float(m_state) * (1.0f / 4294967296.0f);
+    }
+
+    vec3 randomPointOnSphere()
+    {
+        float theta = mathkit::TWO_PI * randomFloat();
+        float u = 2.0f * randomFloat() - 1.0f;
+        float sr = std::sqrt(1.0f - u * u);
+        return vec3(sr * std::cos(theta), sr * std::sin(theta), u);
+    }
+
+private:
+    uint32_t m_state;
+};
+
+// (see sampleSphericalHarmonic in common.glsl)
+vec3 sampleSphericalHarmonic(const SphericalHarmonics& sh, vec3 dir)
+{
+    float Y00 = +0.282095f;
+
+    float Y1_1 = -0.488603f * dir.y;
+    float Y10 = +0.488603f * dir.z;
+    float Y11 = -0.488603f * dir.x;
+
+    float Y2_2 = +1.092548f * dir.x * dir.y;
+    float Y2_1 = -1.092548f * dir.y * dir.z;
+    float Y20 = +0.315392f * (-dir.x * dir.x - dir.y * dir.y + 2.0f * dir.z * dir.z);
+    float Y21 = +1.092548f * dir.x * dir.z;
+    float Y22 = +0.546274f * (dir.x * dir.x - dir.y * dir.y);
+
+    return Y00 * vec3(sh.L00)
+        + Y1_1 * vec3(sh.L1_1) + Y10 * vec3(sh.L10) + Y11 * vec3(sh.L11)
+        + Y2_2 * vec3(sh.L2_2) + Y2_1 * vec3(sh.L2_1) + Y20 * vec3(sh.L20) + Y21 * vec3(sh.L21) + Y22 * vec3(sh.L22);
+}
+
+// Unpacks the SH of all spheres from the GPU buffer contents, just like loadSphericalHarmonics in sphericalHarmonics.glsl
+std::vector<SphericalHarmonics> unpackSphericalHarmonics(const std::vector<uint32_t>& bufferWords, size_t sphereCount)
+{
+    auto packing = static_cast<SphericalHarmonicsPacking>(bufferWords[0]);
+    size_t wordsPerSphere = SphereSetModel::packedSphericalHarmonicsWords(packing);
+    const uint32_t* words = bufferWords.data() + 1;
+
+    std::vector<SphericalHarmonics> sphericalHarmonics {};
+    sphericalHarmonics.reserve(sphereCount);
+
+    for (size_t sphereIdx = 0; sphereIdx < sphereCount; ++sphereIdx) {
+        const uint32_t* sphereWords = words + sphereIdx * wordsPerSphere;
+
+        auto coefficient = [&](size_t index) -> vec4 {
+            vec4 value { 0.0f };
+            if (packing == SphericalHarmonicsPacking::Float) {
+                std::memcpy(&value, &sphereWords[3 * index], 3 * sizeof(float));
+            } else if (packing == SphericalHarmonicsPacking::Half || index < 4) {
+                // (two halfs per word, with the first one in the low bits)
+                const auto* sphereHalfs = reinterpret_cast<const half_float::half*>(sphereWords);
+                for (int i = 0; i < 3; ++i) {
+                    value[i] = float(sphereHalfs[3 * index + i]);
+                }
+            }
+            return value;
+        };
+
+        SphericalHarmonics sh {};
+        sh.L00 = coefficient(0);
+        sh.L1_1 = coefficient(1);
+        sh.L10 = coefficient(2);
+        sh.L11 = coefficient(3);
+        sh.L2_2 = coefficient(4);
+        sh.L2_1 = coefficient(5);
+        sh.L20 = coefficient(6);
+        sh.L21 = coefficient(7);
+        sh.L22 = coefficient(8);
+        sphericalHarmonics.push_back(sh);
+    }
+
+    return sphericalHarmonics;
+}
+
+// (see spherical.glsl)
+vec2 sphericalUvFromDirection(vec3 direction)
+{
+    float phi = std::atan2(direction.z, direction.x);
+    float theta = std::acos(std::clamp(direction.y, -1.0f, +1.0f));
+
+    if (phi < 0.0f) {
+        phi += mathkit::TWO_PI;
+    }
+    return vec2(phi / mathkit::TWO_PI, theta / mathkit::PI);
+}
+
+}
+
+CpuReferenceRenderer::CpuReferenceRenderer(const Scene& scene, bool useProxies)
+    : m_scene(scene)
+{
+    m_meshScene = std::make_unique<CpuRayTracingScene>(scene, false);
+    if (useProxies) {
+        m_proxyScene = std::make_unique<CpuRayTracingScene>(scene, true);
+    }
+
+    scene.forEachModel([&](size_t, const Model& model) {
+        model.forEachMesh([&](const Mesh& mesh) { addMeshData(mesh); });
+        if (!useProxies) {
+            return;
+        }
+
+        const Model& proxy = model.proxy();
+        if (proxy.hasMeshes()) {
+            proxy.forEachMesh([&](const Mesh& mesh) { addMeshData(mesh); });
+        } else if (const auto* sphereSetModel = dynamic_cast<const SphereSetModel*>(&proxy)) {
+            // (the SH as the GPU sees them, i.e. with the precision of the scene's packing)
+            std::vector<uint32_t> packed = sphereSetModel->packedSphericalHarmonics(scene.sphericalHarmonicsPacking());
+            m_sphericalHarmonics[sphereSetModel] = unpackSphericalHarmonics(packed, sphereSetModel->spheres().size());
+        }
+    });
+
+    // (if it's not actually an HDR image we assume it's color, just like Registry::loadHdrTexture2D)
+    if (!scene.environmentMap().empty()) {
+        m_environmentMap = loadTexture(scene.environmentMap(), true);
+    }
+
+    for (auto& [texture, image] : m_pendingImages) {
+        texture->image = image.get();
+        if (!texture->image.isValid()) {
+            LogErrorAndExit("CpuReferenceRenderer: could not load image, exiting\n");
+        }
+    }
+    m_pendingImages.clear();
+}
+
+CpuReferenceRenderer::~CpuReferenceRenderer() = default;
+
+const CpuTexture* CpuReferenceRenderer::loadTexture(const std::string& path, bool srgb)
+{
+    std::string cacheKey = path + (srgb ? ":srgb" : ":linear");
+    auto entry = m_textures.find(cacheKey);
+    if (entry != m_textures.end()) {
+        return entry->second.get();
+    }
+
+    std::optional<Image::Info> info = Image::probe(path);
+    if (!info.has_value()) {
+        LogError("CpuReferenceRenderer: could not read image '%s', ignoring it\n", path.c_str());
+        m_textures[cacheKey] = nullptr;
+        return nullptr;
+    }
+    if (info->blockFormat.has_value()) {
+        LogWarning("CpuReferenceRenderer: can't sample block compressed image '%s', ignoring it (use the uncooked image)\n", path.c_str());
+        m_textures[cacheKey] = nullptr;
+        return nullptr;
+    }
+
+    auto texture = std::make_unique<CpuTexture>();
+    texture->srgb = srgb && !info->isHdr;
+
+    // (all images are decoded in parallel, and we wait for them at the end of the constructor)
+    m_pendingImages.emplace_back(texture.get(), Image::loadAsync(path, *info, 4));
+
+    const CpuTexture* texturePtr = texture.get();
+    m_textures[cacheKey] = std::move(texture);
+    return texturePtr;
+}
+
+void CpuReferenceRenderer::addMeshData(const Mesh& mesh)
+{
+    if (m_meshData.count(&mesh) > 0) {
+        return;
+    }
+
+    MeshData meshData {};
+
+    meshData.indices = mesh.indexData();
+    if (!mesh.isIndexed()) {
+        meshData.indices.resize(mesh.vertexCount());
+        for (uint32_t i = 0; i < meshData.indices.size(); ++i) {
+            meshData.indices[i] = i;
+        }
+    }
+
+    meshData.normals = mesh.normalData();
+    meshData.texcoords = mesh.texcoordData();
+    meshData.tangents = mesh.tangentData();
+    meshData.localNormalMatrix = mesh.transform().localNormalMatrix();
+
+    // (same as for the RT & forward passes, i.e. the factor is only used if there is no texture)
+    Material material = mesh.material();
+    meshData.baseColor = material.baseColor.empty() ? nullptr : loadTexture(material.baseColor, true);
+    meshData.baseColorFactor = vec3(material.baseColorFactor);
+    meshData.normalMap = material.normalMap.empty() ? nullptr : loadTexture(material.normalMap, false);
+
+    m_meshData[&mesh] = std::move(meshData);
+}
+
+CpuReferenceRenderer::SurfacePoint CpuReferenceRenderer::shadeHit(const CpuRayTracingScene::Hit& hit, bool normalMapping) const
+{
+    SurfacePoint point { .position = hit.position, .normal = hit.normal, .baseColor = vec3(1.0f) };
+
+    switch (hit.geometry) {
+    case CpuRayTracingScene::Geometry::Triangles: {
+        // Just like closestHit.rchit (and forward.frag for the first hit, which also applies the normal map)
+        const MeshData& meshData = m_meshData.at(hit.mesh);
+        uint32_t i0 = meshData.indices[3 * hit.primitiveIndex + 0];
+        uint32_t i1 = meshData.indices[3 * hit.primitiveIndex + 1];
+        uint32_t i2 = meshData.indices[3 * hit.primitiveIndex + 2];
+        vec3 b = vec3(1.0f - hit.barycentrics.x - hit.barycentrics.y, hit.barycentrics.x, hit.barycentrics.y);
+
+        if (!meshData.normals.empty()) {
+            vec3 N = meshData.normals[i0] * b.x + meshData.normals[i1] * b.y + meshData.normals[i2] * b.z;
+            N = normalize(meshData.localNormalMatrix * N);
+            point.normal = normalize(hit.normalMatrix * N);
+        }
+
+        vec2 uv = vec2(0.0f);
+        if (!meshData.texcoords.empty()) {
+            uv = meshData.texcoords[i0] * b.x + meshData.texcoords[i1] * b.y + meshData.texcoords[i2] * b.z;
+        }
+
+        point.baseColor = meshData.baseColor ? meshData.baseColor->sample(uv) : meshData.baseColorFactor;
+
+        if (normalMapping && meshData.normalMap && !meshData.normals.empty() && meshData.tangents.size() == meshData.normals.size()) {
+            vec4 tangent = meshData.tangents[i0] * b.x + meshData.tangents[i1] * b.y + meshData.tangents[i2] * b.z;
+            vec3 T = normalize(hit.normalMatrix * (meshData.localNormalMatrix * vec3(tangent)));
+            vec3 B = cross(point.normal, T) * (tangent.w < 0.0f ? -1.0f : 1.0f);
+
+            // (see unpackNormalMapNormal in common.glsl)
+            vec2 packedNormal = vec2(meshData.normalMap->sample(uv));
+            vec3 mappedNormal = vec3(packedNormal * 2.0f - 1.0f, 0.0f);
+            mappedNormal.z = std::sqrt(std::max(0.0f, 1.0f - dot(vec2(mappedNormal), vec2(mappedNormal))));
+
+            point.normal = normalize(mat3(T, B, point.normal) * mappedNormal);
+        }
+        break;
+    }
+    case CpuRayTracingScene::Geometry::Spheres: {
+        // Just like sphere.rchit
+        const auto* sphereSetModel = static_cast<const SphereSetModel*>(hit.model);
+        const SphericalHarmonics& sh = m_sphericalHarmonics.at(sphereSetModel)[hit.primitiveIndex];
+        point.baseColor = sampleSphericalHarmonic(sh, point.normal);
+        break;
+    }
+    case CpuRayTracingScene::Geometry::VoxelContours: {
+        // Just like contour.rchit
+        const auto* contourModel = static_cast<const VoxelContourModel*>(hit.model);
+        uint32_t colorIndex = contourModel->packedContours().colorIndices[hit.primitiveIndex];
+        point.baseColor = contourModel->colors()[colorIndex];
+        break;
+    }
+    }
+
+    return point;
+}
+
+vec3 CpuReferenceRenderer::evaluateDirectLight(const CpuRayTracingScene& rtScene, const SurfacePoint& point, const Settings& settings, uint64_t& rayCount) const
+{
+    // (see lighting.glsl)
+    vec3 diffuseBRDF = point.baseColor / mathkit::PI;
+    vec3 directLight { 0.0f };
+
+    auto inShadow = [&](vec3 L, float maxDistance) -> bool {
+        if (!settings.shadows) {
+            return false;
+        }
+        rayCount += 1;
+        Ray shadowRay { .origin = point.position, .direction = L, .tMin = 0.001f, .tMax = maxDistance };
+        return rtScene.isOccluded(shadowRay);
+    };
+
+    if (settings.sunLight) {
+        const SunLight& sun = m_scene.sun();
+        vec3 L = -normalize(sun.direction);
+        float LdotN = std::max(dot(L, point.normal), 0.0f);
+        if (LdotN > 0.0f && !inShadow(L, 10000.0f)) {
+            directLight += diffuseBRDF * LdotN * sun.intensity * sun.color;
+        }
+    }
+
+    if (settings.spotLights) {
+        for (const SpotLight& spotLight : m_scene.spotLights()) {
+            vec3 pointToLight = spotLight.position - point.position;
+            float distToLight = length(pointToLight);
+            vec3 L = pointToLight / distToLight;
+
+            if (dot(L, -normalize(spotLight.direction)) < std::cos(0.5f * spotLight.coneAngle)) {
+                continue;
+            }
+
+            float LdotN = std::max(dot(L, point.normal), 0.0f);
+            if (LdotN > 0.0f && !inShadow(L, distToLight)) {
+                float distanceAttenuation = 1.0f / (distToLight * distToLight + 1e-4f);
+                directLight += diffuseBRDF * LdotN * spotLight.intensity * spotLight.color * distanceAttenuation;
+            }
+        }
+    }
+
+    return directLight;
+}
+
+vec3 CpuReferenceRenderer::environmentRadiance(vec3 direction) const
+{
+    // Just like miss.rmiss (where a missing environment map is a white pixel)
+    vec3 skyColor = m_environmentMap ? m_environmentMap->sample(sphericalUvFromDirection(direction), true) : vec3(1.0f);
+    return m_scene.environmentMultiplier() * skyColor;
+}
+
+vec3 CpuReferenceRenderer::tracePixel(uint32_t x, uint32_t y, Extent2D size, const mat4& worldFromView, const mat4& viewFromProjection, const Settings& settings, uint64_t& rayCount) const
+{
+    // The first hit, i.e. what the G-buffer contains for this pixel
+    vec2 uv = (vec2(x, y) + vec2(0.5f)) / vec2(size.width(), size.height());
+    vec2 d = uv * 2.0f - 1.0f;
+
+    vec4 target = viewFromProjection * vec4(d.x, d.y, 1.0f, 1.0f);
+    Ray primaryRay { .origin = vec3(worldFromView * vec4(0, 0, 0, 1)),
+                     .direction = normalize(vec3(worldFromView * vec4(normalize(vec3(target) / target.w), 0.0f))),
+                     .tMin = 0.001f,
+                     .tMax = 10000.0f };
+
+    rayCount += 1;
+    std::optional<CpuRayTracingScene::Hit> firstHit = m_meshScene->traceRay(primaryRay);
+    if (!firstHit.has_value()) {
+        return vec3(0.0f);
+    }
+
+    SurfacePoint firstPoint = shadeHit(*firstHit, true);
+    vec3 firstHitColor = settings.ignoreColor ? vec3(1.0f) : firstPoint.baseColor;
+    vec3 N = firstPoint.normal;
+
+    const CpuRayTracingScene& bounceScene = m_proxyScene ? *m_proxyScene : *m_meshScene;
+
+    uint32_t passCount = std::max(1u, (settings.samplesPerPixel + samplesPerPass - 1) / samplesPerPass);
+    vec3 accumulated { 0.0f };
+
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        // Just like raygen.rgen
+        ShaderRandom random { (x + size.width() * y) + pass * (size.width() * size.height()) };
+
+        vec3 diffuse { 0.0f };
+        for (uint32_t i = 0; i < samplesPerPass; ++i) {
+            vec3 rayDirection = N + random.randomPointOnSphere();
+            float LdotN = dot(rayDirection, N);
+            if (LdotN <= 0.0f) {
+                // (no contribution, and would be a division by zero pdf)
+                continue;
+            }
+
+            rayDirection = normalize(rayDirection);
+            LdotN = dot(rayDirection, N);
+            float pdf = LdotN / mathkit::PI;
+
+            rayCount += 1;
+            Ray ray { .origin = firstPoint.position, .direction = rayDirection, .tMin = 0.001f, .tMax = 10000.0f };
+            std::optional<CpuRayTracingScene::Hit> hit = bounceScene.traceRay(ray);
+
+            vec3 hitValue = hit.has_value()
+                ? evaluateDirectLight(bounceScene, shadeHit(*hit, false), settings, rayCount)
+                : environmentRadiance(rayDirection);
+
+            diffuse += LdotN * hitValue / pdf;
+        }
+
+        diffuse /= float(samplesPerPass);
+        accumulated += firstHitColor * diffuse / mathkit::PI;
+    }
+
+    // (see averageAccum.comp)
+    return accumulated / float(passCount);
+}
+
+CpuReferenceRenderer::Result CpuReferenceRenderer::render(Extent2D size, const Settings& settings) const
+{
+    // (same setup as rt-firsthit/raygen.rgen, with the default field of view of the camera)
+    mat4 worldFromView = inverse(m_scene.camera().viewMatrix());
+    mat4 viewFromProjection = inverse(mathkit::perspective(mathkit::radians(60.0f), float(size.width()) / float(size.height()), 0.25f, 10000.0f));
+
+    Result result { .size = size, .pixels = {}, .rayCount = 0 };
+    result.pixels.resize(size.width() * size.height());
+
+    uint32_t tileSize = std::max(1u, settings.tileSize);
+    uint32_t tilesX = (size.width() + tileSize - 1) / tileSize;
+    uint32_t tilesY = (size.height() + tileSize - 1) / tileSize;
+    uint32_t tileCount = tilesX * tilesY;
+
+    // Every thread grabs the next tile until there are none left, so threads that happen to get cheap tiles (e.g. just
+    // sky) simply get more of them, and no thread ends up waiting while another has a queue of work left.
+    std::atomic<uint32_t> nextTile { 0 };
+    std::atomic<uint64_t> totalRayCount { 0 };
+
+    auto renderTiles = [&]() {
+        uint64_t rayCount = 0;
+        for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            uint32_t startX = (tile % tilesX) * tileSize;
+            uint32_t startY = (tile / tilesX) * tileSize;
+            uint32_t endX = std::min(startX + tileSize, size.width());
+            uint32_t endY = std::min(startY + tileSize, size.height());
+
+            for (uint32_t y = startY; y < endY; ++y) {
+                for (uint32_t x = startX; x < endX; ++x) {
+                    result.pixels[y * size.width() + x] = tracePixel(x, y, size, worldFromView, viewFromProjection, settings, rayCount);
+                }
+            }
+        }
+        totalRayCount += rayCount;
+    };
+
+    std::vector<std::future<void>> workers {};
+    for (uint32_t i = 0; i < ThreadPool::global().threadCount(); ++i) {
+        workers.push_back(ThreadPool::global().enqueue(renderTiles));
+    }
+    renderTiles();
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+
+    result.rayCount = totalRayCount;
+    return result;
+}
+
+bool CpuReferenceRenderer::writeHdrImage(const std::string& path, const Result& result)
+{
+    static_assert(sizeof(vec3) == 3 * sizeof(float));
+    const auto* data = reinterpret_cast<const float*>(result.pixels.data());
+    return stbi_write_hdr(path.c_str(), result.size.width(), result.size.height(), 3, data) != 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CpuRayTracingScene.h"
+#include "CpuTexture.h"
+#include "utility/Extent.h"
+#include "utility/Image.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// CPU path traced reference for the diffuse GI of RTDiffuseGINode, so that the error of the proxies can be measured on
+// machines without RT support. It uses the same estimator as rt-diffuseGI/raygen.rgen: the first hit is always on the
+// real meshes (cf. the G-buffer), from which passes of 16 cosine distributed rays are traced into either the meshes or
+// the proxies, and the radiance of whatever they hit (one bounce of direct light, or the environment) is averaged over
+// all passes, just like the GPU version accumulates frames. Even the random numbers are generated the same way, with
+// the pass index in place of the frame index.
+//
+// Unlike the GPU version (for now), the sun and all spot lights are evaluated, and optionally with shadows. Textures
+// are sampled bilinearly from the full resolution images, since there are no ray differentials to select mips with.
+//
+// The image is split up in tiles which all worker threads (including the calling thread) take turns grabbing until
+// they're all done. Every pixel has its own random sequence, so the result doesn't depend on the thread count.
+class CpuReferenceRenderer {
+public:
+    struct Settings {
+        uint32_t samplesPerPixel { 1024 }; // (rounded up to whole passes of 16 samples)
+        uint32_t tileSize { 16 };
+        bool ignoreColor { false }; // (of the first hit, like the "Ignore color" option of the GPU version)
+        bool sunLight { true };
+        bool spotLights { true };
+        bool shadows { true };
+    };
+
+    struct Result {
+        Extent2D size;
+        std::vector<vec3> pixels; // (row major, starting with the top row)
+        uint64_t rayCount;
+    };
+
+    CpuReferenceRenderer(const Scene&, bool useProxies);
+    ~CpuReferenceRenderer();
+
+    [[nodiscard]] Result render(Extent2D, const Settings&) const;
+
+    // The same samples as are averaged per frame in rt-diffuseGI/raygen.rgen
+    static constexpr uint32_t samplesPerPass = 16;
+
+    static bool writeHdrImage(const std::string& path, const Result&);
+
+private:
+    // All vertex data needed to shade a mesh, since the Mesh interface returns copies of it
+    struct MeshData {
+        std::vector<uint32_t> indices;
+        std::vector<vec3> normals;
+        std::vector<vec2> texcoords;
+        std::vector<vec4> tangents;
+        mat3 localNormalMatrix;
+
+        const CpuTexture* baseColor;
+        vec3 baseColorFactor;
+        const CpuTexture* normalMap;
+    };
+
+    struct SurfacePoint {
+        vec3 position;
+        vec3 normal;
+        vec3 baseColor;
+    };
+
+    const CpuTexture* loadTexture(const std::string& path, bool srgb);
+    void addMeshData(const Mesh&);
+
+    SurfacePoint shadeHit(const CpuRayTracingScene::Hit&, bool normalMapping) const;
+    vec3 evaluateDirectLight(const CpuRayTracingScene&, const SurfacePoint&, const Settings&, uint64_t& rayCount) const;
+    vec3 environmentRadiance(vec3 direction) const;
+
+    vec3 tracePixel(uint32_t x, uint32_t y, Extent2D, const mat4& worldFromView, const mat4& viewFromProjection, const Settings&, uint64_t& rayCount) const;
+
+    const Scene& m_scene;
+
+    std::unique_ptr<CpuRayTracingScene> m_meshScene {};
+    std::unique_ptr<CpuRayTracingScene> m_proxyScene {}; // (only when using proxies)
+
+    std::unordered_map<const Mesh*, MeshData> m_meshData {};
+    std::unordered_map<const SphereSetModel*, std::vector<SphericalHarmonics>> m_sphericalHarmonics {};
+    std::unordered_map<std::string, std::unique_ptr<CpuTexture>> m_textures {};
+    std::vector<std::pair<CpuTexture*, std::shared_future<Image>>> m_pendingImages {}; // (only during construction)
+    const CpuTexture* m_environmentMap {};
+};
@@ -0,0 +1,57 @@
+#include "CpuTexture.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+
+float sRGBToLinear(uint8_t value)
+{
+    static const auto table = []() {
+        std::array<float, 256> table {};
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            table[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+    return table[value];
+}
+
+}
+
+vec4 CpuTexture::texel(int x, int y) const
+{
+    size_t index = 4 * (size_t(y) * image.info().width + x);
+    if (image.info().isHdr) {
+        const float* pixels = static_cast<const float*>(image.pixels());
+        return vec4(pixels[index + 0], pixels[index + 1], pixels[index + 2], pixels[index + 3]);
+    }
+
+    const uint8_t* pixels = static_cast<const uint8_t*>(image.pixels());
+    if (srgb) {
+        return vec4(sRGBToLinear(pixels[index + 0]), sRGBToLinear(pixels[index + 1]), sRGBToLinear(pixels[index + 2]), pixels[index + 3] / 255.0f);
+    }
+    return vec4(pixels[index + 0], pixels[index + 1], pixels[index + 2], pixels[index + 3]) / 255.0f;
+}
+
+vec3 CpuTexture::sample(vec2 uv, bool clampV) const
+{
+    int width = image.info().width;
+    int height = image.info().height;
+
+    vec2 st = uv * vec2(width, height) - 0.5f;
+    vec2 base = glm::floor(st);
+    vec2 fraction = st - base;
+
+    auto wrap = [](int coord, int size) { return ((coord % size) + size) % size; };
+    int x0 = wrap(int(base.x), width);
+    int x1 = wrap(int(base.x) + 1, width);
+    int y0 = clampV ? std::clamp(int(base.y), 0, height - 1) : wrap(int(base.y), height);
+    int y1 = clampV ? std::clamp(int(base.y) + 1, 0, height - 1) : wrap(int(base.y) + 1, height);
+
+    vec4 top = glm::mix(texel(x0, y0), texel(x1, y0), fraction.x);
+    vec4 bottom = glm::mix(texel(x0, y1), texel(x1, y1), fraction.x);
+    return vec3(glm::mix(top, bottom, fraction.y));
+}
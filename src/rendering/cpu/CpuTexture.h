@@ -0,0 +1,14 @@
+#pragma once
+
+#include "utility/Image.h"
+#include "utility/mathkit.h"
+
+// Decoded image which is sampled like a texture with linear filtering & repeat wrapping (just from mip 0 though). The
+// image must be decoded with four components, and sRGB images are converted to linear when sampled.
+struct CpuTexture {
+    Image image;
+    bool srgb;
+
+    vec3 sample(vec2 uv, bool clampV = false) const;
+    vec4 texel(int x, int y) const;
+};
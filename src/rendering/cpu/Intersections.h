@@ -0,0 +1,100 @@
+#pragma once
+
+#include "BVH.h"
+#include "utility/mathkit.h"
+
+// CPU versions of the intersection tests in shaders/intersections.glsl (plus triangles, which the GPU does for us). They
+// are kept as close as possible to the GLSL, so that the CPU tracing gives the same results as the intersection shaders.
+namespace Intersections {
+
+inline bool raySphere(vec3 center, float radius, const Ray& ray, float& t)
+{
+    vec3 relOrigin = ray.origin - center;
+
+    // (quadratic formula)
+    float a = glm::dot(ray.direction, ray.direction);
+    float b = 2.0f * glm::dot(ray.direction, relOrigin);
+    float c = glm::dot(relOrigin, relOrigin) - radius * radius;
+
+    float discriminant = b * b - 4.0f * a * c;
+    if (discriminant < 0.0f) {
+        return false;
+    }
+
+    t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+    if (t >= ray.tMin && t <= ray.tMax) {
+        return true;
+    }
+
+    t = (-b + std::sqrt(discriminant)) / (2.0f * a);
+    if (t >= ray.tMin && t <= ray.tMax) {
+        return true;
+    }
+
+    return false;
+}
+
+// (single sided, like PLANE_DOUBLE_SIDED 0 in the shader)
+inline bool rayPlane(vec3 N, float d, const Ray& ray, float& t)
+{
+    float denom = glm::dot(N, ray.direction);
+    if (denom > 1e-6f) {
+        return false;
+    }
+
+    t = -(d + glm::dot(N, ray.origin)) / denom;
+    return t >= 0.0f;
+}
+
+inline bool rayAabb(vec3 aabbMin, vec3 aabbMax, const Ray& ray, float& tMin, float& tMax)
+{
+    vec3 t0 = (aabbMin - ray.origin) / ray.direction;
+    vec3 t1 = (aabbMax - ray.origin) / ray.direction;
+
+    vec3 tNear = glm::min(t0, t1);
+    vec3 tFar = glm::max(t0, t1);
+
+    tMin = std::max(std::max(tNear.x, tNear.y), tNear.z);
+    tMax = std::min(std::min(tFar.x, tFar.y), tFar.z);
+
+    return tMin <= tMax;
+}
+
+// Möller-Trumbore. Triangles are front facing if they are counter-clockwise as seen from the ray origin (i.e. same as
+// for rasterization), and the barycentrics are for the second and third vertex, like gl_HitAttributeNV / hitAttributeNV.
+inline bool rayTriangle(vec3 v0, vec3 v1, vec3 v2, const Ray& ray, bool cullBackFaces, float& t, vec2& barycentrics)
+{
+    vec3 edge1 = v1 - v0;
+    vec3 edge2 = v2 - v0;
+
+    vec3 p = glm::cross(ray.direction, edge2);
+    float determinant = glm::dot(edge1, p);
+
+    if (cullBackFaces ? determinant < 1e-12f : std::abs(determinant) < 1e-12f) {
+        return false;
+    }
+
+    float invDeterminant = 1.0f / determinant;
+    vec3 relOrigin = ray.origin - v0;
+
+    float u = glm::dot(relOrigin, p) * invDeterminant;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+
+    vec3 q = glm::cross(relOrigin, edge1);
+    float v = glm::dot(ray.direction, q) * invDeterminant;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+
+    t = glm::dot(edge2, q) * invDeterminant;
+    if (t < ray.tMin || t > ray.tMax) {
+        return false;
+    }
+
+    barycentrics = vec2(u, v);
+    return true;
+}
+
+}
@@ -1,6 +1,7 @@
 #include "ForwardRenderNode.h"
 
 #include "SceneUniformNode.h"
+#include <imgui.h>
 
 std::string ForwardRenderNode::name()
 {
@@ -19,46 +20,38 @@ void ForwardRenderNode::constructNode(Registry& nodeReg)
     m_materials.clear();
     m_textures.clear();
 
-    for (int i = 0; i < m_scene.modelCount(); ++i) {
-        const Model& model = *m_scene[i];
-        model.forEachMesh([&](const Mesh& mesh) {
-            std::vector<Vertex> vertices {};
-            {
-                auto posData = mesh.positionData();
-                auto texData = mesh.texcoordData();
-                auto normalData = mesh.normalData();
-                auto tangentData = mesh.tangentData();
-
-                ASSERT(posData.size() == texData.size());
-                ASSERT(posData.size() == normalData.size());
-                ASSERT(posData.size() == tangentData.size());
-
-                for (int i = 0; i < posData.size(); ++i) {
-                    vertices.push_back({ .position = posData[i],
-                                         .texCoord = texData[i],
-                                         .normal = normalData[i],
-                                         .tangent = tangentData[i] });
-                }
-            }
+    m_vertexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "vertices");
+    m_indexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "indices");
+    m_sceneMeshBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "meshes");
+
+    std::unordered_map<const Texture*, int> textureIndices {};
+    auto textureIndex = [&](const Texture& texture) -> int {
+        auto entry = textureIndices.find(&texture);
+        if (entry != textureIndices.end()) {
+            return entry->second;
+        }
+        int index = static_cast<int>(m_textures.size());
+        m_textures.push_back(&texture);
+        textureIndices[&texture] = index;
+        return index;
+    };
 
+    for (const SceneGeometryNode::MeshRange& range : SceneGeometryNode::meshRanges(nodeReg)) {
+        if (range.isProxy) {
+            continue;
+        }
+        const Mesh& mesh = *range.mesh;
+        {
             Drawable drawable {};
             drawable.mesh = &mesh;
+            drawable.range = range;
 
-            drawable.vertexBuffer = &nodeReg.createBuffer(std::move(vertices), Buffer::Usage::Vertex, Buffer::MemoryHint::GpuOptimal);
-            drawable.indexBuffer = &nodeReg.createBuffer(mesh.indexData(), Buffer::Usage::Index, Buffer::MemoryHint::GpuOptimal);
-            drawable.indexCount = mesh.indexCount();
-
-            // Create textures
-            // TODO: Remove redundant textures!
-            int baseColorIndex = m_textures.size();
+            // Create textures (the registry returns the same texture for the same path, so only add each one once)
             std::string baseColorPath = mesh.material().baseColor;
-            Texture& baseColorTexture = nodeReg.loadTexture2D(baseColorPath, true, true);
-            m_textures.push_back(&baseColorTexture);
+            int baseColorIndex = textureIndex(nodeReg.loadTexture2D(baseColorPath, true, true, false, true));
 
-            int normalMapIndex = m_textures.size();
             std::string normalMapPath = mesh.material().normalMap;
-            Texture& normalMapTexture = nodeReg.loadTexture2D(normalMapPath, false, true);
-            m_textures.push_back(&normalMapTexture);
+            int normalMapIndex = textureIndex(nodeReg.loadTexture2D(normalMapPath, false, true, true, true));
 
             // Create material
             // TODO: Remove redundant materials!
@@ -69,7 +62,7 @@ void ForwardRenderNode::constructNode(Registry& nodeReg)
             m_materials.push_back(material);
 
             m_drawables.push_back(drawable);
-        });
+        }
     }
 
     if (m_drawables.size() > FORWARD_MAX_DRAWABLES) {
@@ -90,13 +83,7 @@ RenderGraphNode::ExecuteCallback ForwardRenderNode::constructFrame(Registry& reg
     // TODO: Well, now it seems very reasonable to actually include this in the resource manager..
     Shader shader = Shader::createBasic("forward.vert", "forward.frag");
 
-    VertexLayout vertexLayout = VertexLayout {
-        sizeof(Vertex),
-        { { 0, VertexAttributeType::Float3, offsetof(Vertex, position) },
-          { 1, VertexAttributeType::Float2, offsetof(Vertex, texCoord) },
-          { 2, VertexAttributeType ::Float3, offsetof(Vertex, normal) },
-          { 3, VertexAttributeType ::Float4, offsetof(Vertex, tangent) } }
-    };
+    VertexLayout vertexLayout = SceneGeometryNode::vertexFormat().vertexLayout();
 
     size_t perObjectBufferSize = m_drawables.size() * sizeof(PerForwardObject);
     Buffer& perObjectBuffer = reg.createBuffer(perObjectBufferSize, Buffer::Usage::UniformBuffer, Buffer::MemoryHint::TransferOptimal);
@@ -108,7 +95,8 @@ RenderGraphNode::ExecuteCallback ForwardRenderNode::constructFrame(Registry& reg
     ShaderBinding perObjectBufferBinding = { 1, ShaderStageVertex, &perObjectBuffer };
     ShaderBinding materialBufferBinding = { 2, ShaderStageFragment, &materialBuffer };
     ShaderBinding textureSamplerBinding = { 3, ShaderStageFragment, m_textures, FORWARD_MAX_TEXTURES };
-    BindingSet& bindingSet = reg.createBindingSet({ cameraUniformBufferBinding, perObjectBufferBinding, materialBufferBinding, textureSamplerBinding });
+    ShaderBinding sceneMeshBufferBinding = { 4, ShaderStageVertex, m_sceneMeshBuffer, ShaderBindingType::StorageBuffer };
+    BindingSet& bindingSet = reg.createBindingSet({ cameraUniformBufferBinding, perObjectBufferBinding, materialBufferBinding, textureSamplerBinding, sceneMeshBufferBinding });
 
     // TODO: Create some builder class for these type of numerous (and often defaulted anyway) RenderState members
 
@@ -154,14 +142,41 @@ RenderGraphNode::ExecuteCallback ForwardRenderNode::constructFrame(Registry& reg
             perObjectData[i] = {
                 .worldFromLocal = drawable.mesh->transform().worldMatrix(),
                 .worldFromTangent = mat4(drawable.mesh->transform().worldNormalMatrix()),
-                .materialIndex = drawable.materialIndex
+                .materialIndex = drawable.materialIndex,
+                .meshIndex = static_cast<int>(drawable.range.meshIndex)
             };
         }
         cmdList.updateBufferImmediately(perObjectBuffer, perObjectData.data(), numDrawables * sizeof(PerForwardObject));
 
+        static float lodPixelError = 1.0f;
+        ImGui::SliderFloat("LOD pixel error", &lodPixelError, 0.0f, 10.0f);
+
+        const FpsCamera& camera = m_scene.camera();
+        mat4 projectionFromWorld = camera.projectionMatrix() * camera.viewMatrix();
+        float targetHeight = float(windowTarget.extent().height());
+
+        TextureStreamer& textureStreamer = reg.textureStreamer();
+        if (textureStreamer.isEnabled()) {
+            ImGui::Text("Streamed textures: %.1f / %.1f MB", textureStreamer.residentSize() / (1024.0f * 1024.0f), textureStreamer.budget() / (1024.0f * 1024.0f));
+        }
+
         for (int i = 0; i < numDrawables; ++i) {
             const Drawable& drawable = m_drawables[i];
-            cmdList.drawIndexed(*drawable.vertexBuffer, *drawable.indexBuffer, drawable.indexCount, drawable.mesh->indexType(), i);
+            const SceneGeometryNode::MeshRange& range = drawable.range;
+            mat4 worldFromLocal = drawable.mesh->transform().worldMatrix();
+
+            if (textureStreamer.isEnabled()) {
+                float pixelsPerLocalUnit = SceneGeometryNode::pixelsPerLocalUnit(range, worldFromLocal, projectionFromWorld, targetHeight);
+                const ForwardMaterial& material = m_materials[drawable.materialIndex];
+                for (int textureIndex : { material.baseColor, material.normalMap }) {
+                    const Texture& texture = *m_textures[textureIndex];
+                    textureStreamer.requestMipLevel(texture, TextureStreamer::requiredMipLevel(texture, range.texcoordDensity, pixelsPerLocalUnit));
+                }
+            }
+
+            uint32_t lodLevel = SceneGeometryNode::selectLod(range, worldFromLocal, projectionFromWorld, targetHeight, lodPixelError);
+            SceneGeometryNode::MeshRange::Lod lod = range.lod(lodLevel);
+            cmdList.drawIndexed(*m_vertexBuffer, *m_indexBuffer, lod.indexCount, range.indexType, i, lod.indexByteOffset, range.vertexOffset);
         }
     };
 }
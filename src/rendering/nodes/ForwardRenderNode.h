@@ -2,6 +2,7 @@
 
 #include "../RenderGraphNode.h"
 #include "ForwardData.h"
+#include "SceneGeometryNode.h"
 #include "utility/FpsCamera.h"
 #include "utility/Model.h"
 #include "utility/Scene.h"
@@ -18,18 +19,9 @@ public:
     ExecuteCallback constructFrame(Registry&) const override;
 
 private:
-    struct Vertex {
-        vec3 position;
-        vec2 texCoord;
-        vec3 normal;
-        vec4 tangent;
-    };
-
     struct Drawable {
         const Mesh* mesh {};
-        Buffer* vertexBuffer {};
-        Buffer* indexBuffer {};
-        uint32_t indexCount {};
+        SceneGeometryNode::MeshRange range {};
         int materialIndex {};
     };
 
@@ -37,4 +29,8 @@ private:
     std::vector<const Texture*> m_textures {};
     std::vector<ForwardMaterial> m_materials {};
     const Scene& m_scene;
+
+    const Buffer* m_vertexBuffer {};
+    const Buffer* m_indexBuffer {};
+    const Buffer* m_sceneMeshBuffer {};
 };
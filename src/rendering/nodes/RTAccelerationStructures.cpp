@@ -19,30 +19,31 @@ void RTAccelerationStructures::constructNode(Registry& nodeReg)
 {
     m_mainInstances.clear();
     m_proxyInstances.clear();
+    m_sharedBLASes.clear();
+
+    m_vertexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "vertices");
+    m_indexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "indices");
+
+    m_meshRanges.clear();
+    for (const SceneGeometryNode::MeshRange& range : SceneGeometryNode::meshRanges(nodeReg)) {
+        m_meshRanges[range.mesh] = range;
+    }
 
-    uint32_t nextTriangleInstanceId = 0;
     uint32_t nextSphereInstanceId = 0;
     uint32_t nextVoxelContourInstanceId = 0;
 
     m_scene.forEachModel([&](size_t, const Model& model) {
-        model.forEachMesh([&](const Mesh& mesh) {
-            RTGeometry geometry = createGeometryForTriangleMesh(mesh, nodeReg);
-            uint8_t hitMask = model.hasProxy() ? HitMask::TriangleMeshWithProxy : HitMask::TriangleMeshWithoutProxy;
-            RTGeometryInstance instance = createGeometryInstance(geometry, model.transform(), nextTriangleInstanceId++, hitMask, HitGroupIndex::Triangle, nodeReg);
-            m_mainInstances.push_back(instance);
-        });
+        uint8_t hitMask = model.hasProxy() ? HitMask::TriangleMeshWithProxy : HitMask::TriangleMeshWithoutProxy;
+        m_mainInstances.push_back(createInstanceForTriangleMeshes(model, model.transform(), hitMask, nodeReg));
 
         if (model.proxy().hasMeshes()) {
-            model.proxy().forEachMesh([&](const Mesh& proxyMesh) {
-                RTGeometry proxyGeometry = createGeometryForTriangleMesh(proxyMesh, nodeReg);
-                RTGeometryInstance instance = createGeometryInstance(proxyGeometry, model.transform(), nextTriangleInstanceId++, HitMask::TriangleMeshWithoutProxy, HitGroupIndex::Triangle, nodeReg);
-                m_proxyInstances.push_back(instance);
-            });
+            m_proxyInstances.push_back(createInstanceForTriangleMeshes(model.proxy(), model.transform(), HitMask::TriangleMeshWithoutProxy, nodeReg));
         } else {
             const auto* sphereSetModel = dynamic_cast<const SphereSetModel*>(&model.proxy());
             if (sphereSetModel) {
                 RTGeometry sphereSetGeometry = createGeometryForSphereSet(*sphereSetModel, nodeReg);
-                RTGeometryInstance instance = createGeometryInstance(sphereSetGeometry, model.transform(), nextSphereInstanceId++, HitMask::SphereSetHitMask, HitGroupIndex::Sphere, nodeReg);
+                BottomLevelAS& blas = nodeReg.createBottomLevelAccelerationStructure({ sphereSetGeometry });
+                RTGeometryInstance instance = createGeometryInstance(blas, model.transform(), nextSphereInstanceId++, HitMask::SphereSetHitMask, HitGroupIndex::Sphere, nodeReg);
                 m_proxyInstances.push_back(instance);
                 return;
             }
@@ -50,7 +51,8 @@ void RTAccelerationStructures::constructNode(Registry& nodeReg)
             const auto* voxelContourModel = dynamic_cast<const VoxelContourModel*>(&model.proxy());
             if (voxelContourModel) {
                 RTGeometry voxelContourGeometry = createGeometryForVoxelContours(*voxelContourModel, nodeReg);
-                RTGeometryInstance instance = createGeometryInstance(voxelContourGeometry, model.transform(), nextVoxelContourInstanceId++, HitMask::VoxelContourHitMask, HitGroupIndex::VoxelContour, nodeReg);
+                BottomLevelAS& blas = nodeReg.createBottomLevelAccelerationStructure({ voxelContourGeometry });
+                RTGeometryInstance instance = createGeometryInstance(blas, model.transform(), nextVoxelContourInstanceId++, HitMask::VoxelContourHitMask, HitGroupIndex::VoxelContour, nodeReg);
                 m_proxyInstances.push_back(instance);
                 return;
             }
@@ -69,18 +71,103 @@ RenderGraphNode::ExecuteCallback RTAccelerationStructures::constructFrame(Regist
     reg.publish("proxy", proxy);
 
     return [&](const AppState& appState, CommandList& cmdList) {
-        cmdList.rebuildTopLevelAcceratationStructure(main);
-        cmdList.rebuildTopLevelAcceratationStructure(proxy);
+        // The TLASes are fully built when created (i.e. whenever instances are added or removed), so here we only have to
+        // refit them when something has moved, which usually is only a few instances, if any at all.
+        for (TopLevelAS* tlas : { &main, &proxy }) {
+            if (tlas->hasMovedSinceLastBuild()) {
+                cmdList.rebuildTopLevelAcceratationStructure(*tlas, AccelerationStructureBuildType::Update);
+            }
+        }
     };
 }
 
+size_t RTAccelerationStructures::maxGeometriesPerInstance(const Scene& scene)
+{
+    size_t maxGeometries = 1;
+    scene.forEachModel([&](size_t, const Model& model) {
+        size_t meshCount = 0;
+        model.forEachMesh([&](const Mesh&) { meshCount += 1; });
+        maxGeometries = std::max(maxGeometries, meshCount);
+
+        if (model.proxy().hasMeshes()) {
+            size_t proxyMeshCount = 0;
+            model.proxy().forEachMesh([&](const Mesh&) { proxyMeshCount += 1; });
+            maxGeometries = std::max(maxGeometries, proxyMeshCount);
+        }
+    });
+    return maxGeometries;
+}
+
+std::vector<HitGroup> RTAccelerationStructures::hitGroupsForEveryGeometry(const std::vector<HitGroup>& hitGroups, const Scene& scene)
+{
+    // Only triangle instances have more than one geometry, but there is only one record stride for all, so the remaining
+    // hit groups are just repeated to fill out the table (they will never be used past geometry index 0)
+    std::vector<HitGroup> allHitGroups {};
+    size_t geometryCount = maxGeometriesPerInstance(scene);
+    for (size_t geometryIdx = 0; geometryIdx < geometryCount; ++geometryIdx) {
+        for (HitGroup hitGroup : hitGroups) {
+            hitGroup.setShaderRecord({ static_cast<uint32_t>(geometryIdx) });
+            allHitGroups.push_back(hitGroup);
+        }
+    }
+    return allHitGroups;
+}
+
+RTGeometryInstance RTAccelerationStructures::createInstanceForTriangleMeshes(const Model& model, const Transform& transform, uint8_t hitMask, Registry& reg)
+{
+    std::vector<const Mesh*> meshes {};
+    std::vector<SharedBLAS::Geometry> geometryKeys {};
+    std::optional<uint32_t> firstMeshIndex {};
+
+    model.forEachMesh([&](const Mesh& mesh) {
+        const SceneGeometryNode::MeshRange& range = m_meshRanges.at(&mesh);
+        if (!firstMeshIndex.has_value()) {
+            firstMeshIndex = range.meshIndex;
+        }
+
+        // (the closest hit shaders find the mesh as custom instance id + geometry index, so they must be in order)
+        ASSERT(range.meshIndex == firstMeshIndex.value() + meshes.size());
+        meshes.push_back(&mesh);
+        geometryKeys.push_back({ range.geometryMeshIndex, mesh.transform().localMatrix() });
+    });
+
+    ASSERT(!meshes.empty());
+
+    // Models with the same geometry (e.g. the same glTF placed many times) can share a single BLAS, since only the instance
+    // transform and custom id (i.e. which meshes & materials to use) differ between them
+    auto entry = std::find_if(m_sharedBLASes.begin(), m_sharedBLASes.end(), [&](const SharedBLAS& shared) {
+        return shared.geometries == geometryKeys;
+    });
+
+    const BottomLevelAS* blas;
+    if (entry != m_sharedBLASes.end()) {
+        blas = entry->blas;
+    } else {
+        std::vector<RTGeometry> geometries {};
+        for (const Mesh* mesh : meshes) {
+            geometries.push_back(createGeometryForTriangleMesh(*mesh, reg));
+        }
+        blas = &reg.createBottomLevelAccelerationStructure(std::move(geometries));
+        m_sharedBLASes.push_back({ std::move(geometryKeys), blas });
+    }
+
+    return createGeometryInstance(*blas, transform, firstMeshIndex.value(), hitMask, HitGroupIndex::Triangle, reg);
+}
+
 RTGeometry RTAccelerationStructures::createGeometryForTriangleMesh(const Mesh& mesh, Registry& reg) const
 {
-    RTTriangleGeometry geometry { .vertexBuffer = reg.createBuffer(mesh.positionData(), Buffer::Usage::Vertex, Buffer::MemoryHint::GpuOptimal),
+    const SceneGeometryNode::MeshRange& range = m_meshRanges.at(&mesh);
+    size_t vertexStride = SceneGeometryNode::vertexFormat().vertexStride();
+
+    RTTriangleGeometry geometry { .vertexBuffer = *m_vertexBuffer,
                                   .vertexFormat = VertexFormat::XYZ32F,
-                                  .vertexStride = sizeof(vec3),
-                                  .indexBuffer = reg.createBuffer(mesh.indexData(), Buffer::Usage::Index, Buffer::MemoryHint::GpuOptimal),
-                                  .indexType = mesh.indexType(),
+                                  .vertexStride = vertexStride,
+                                  .vertexByteOffset = range.vertexOffset * vertexStride,
+                                  .vertexCount = range.vertexCount,
+                                  .indexBuffer = *m_indexBuffer,
+                                  .indexType = range.indexType,
+                                  .indexByteOffset = range.indexByteOffset,
+                                  .indexCount = range.indexCount,
                                   .transform = mesh.transform().localMatrix() };
     return geometry;
 }
@@ -127,10 +214,8 @@ RTGeometry RTAccelerationStructures::createGeometryForVoxelContours(const VoxelC
     return geometry;
 }
 
-RTGeometryInstance RTAccelerationStructures::createGeometryInstance(const RTGeometry& geometry, const Transform& transform, uint32_t customId, uint8_t hitMask, uint32_t sbtOffset, Registry& reg) const
+RTGeometryInstance RTAccelerationStructures::createGeometryInstance(const BottomLevelAS& blas, const Transform& transform, uint32_t customId, uint8_t hitMask, uint32_t sbtOffset, Registry& reg) const
 {
-    // TODO: Later we probably want to keep all meshes of a model in a single BLAS, but that requires some fancy SBT stuff which I don't wanna mess with now.
-    BottomLevelAS& blas = reg.createBottomLevelAccelerationStructure({ geometry });
     RTGeometryInstance instance = { .blas = blas,
                                     .transform = transform,
                                     .shaderBindingTableOffset = sbtOffset,
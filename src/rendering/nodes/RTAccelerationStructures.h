@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../RenderGraphNode.h"
+#include "SceneGeometryNode.h"
 #include "utility/Scene.h"
+#include <unordered_map>
 
 class SphereSetModel;
 class VoxelContourModel;
@@ -33,16 +35,40 @@ public:
         VoxelContourHitMask = 0x08,
     };
 
+    // All meshes of a model share a single BLAS, so the closest hit shaders need to know which of the geometries was hit.
+    // There is no gl_GeometryIndex with GL_NV_ray_tracing, so instead the hit groups are repeated for every geometry index
+    // with the index in their shader record. The result is interleaved, so rays should be traced with the number of hit
+    // groups passed in here as the SBT record stride.
+    static std::vector<HitGroup> hitGroupsForEveryGeometry(const std::vector<HitGroup>&, const Scene&);
+    static size_t maxGeometriesPerInstance(const Scene&);
+
 private:
     RTGeometry createGeometryForTriangleMesh(const Mesh&, Registry&) const;
     RTGeometry createGeometryForSphereSet(const SphereSetModel&, Registry&) const;
     RTGeometry createGeometryForVoxelContours(const VoxelContourModel&, Registry&) const;
 
-    RTGeometryInstance createGeometryInstance(const RTGeometry&, const Transform&, uint32_t customId, uint8_t hitMask, uint32_t sbtOffset, Registry&) const;
+    RTGeometryInstance createInstanceForTriangleMeshes(const Model&, const Transform&, uint8_t hitMask, Registry&);
+    RTGeometryInstance createGeometryInstance(const BottomLevelAS&, const Transform&, uint32_t customId, uint8_t hitMask, uint32_t sbtOffset, Registry&) const;
 
 private:
     const Scene& m_scene;
 
     std::vector<RTGeometryInstance> m_mainInstances {};
     std::vector<RTGeometryInstance> m_proxyInstances {};
+
+    // Triangle BLASes, keyed by their geometries. There are only ever a handful of models, so a linear search is fine.
+    struct SharedBLAS {
+        struct Geometry {
+            uint32_t geometryMeshIndex; // (see SceneGeometryNode::MeshRange)
+            mat4 localMatrix;
+            bool operator==(const Geometry& other) const { return geometryMeshIndex == other.geometryMeshIndex && localMatrix == other.localMatrix; }
+        };
+        std::vector<Geometry> geometries;
+        const BottomLevelAS* blas;
+    };
+    std::vector<SharedBLAS> m_sharedBLASes {};
+
+    const Buffer* m_vertexBuffer {};
+    const Buffer* m_indexBuffer {};
+    std::unordered_map<const Mesh*, SceneGeometryNode::MeshRange> m_meshRanges {};
 };
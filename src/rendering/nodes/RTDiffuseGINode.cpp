@@ -3,11 +3,9 @@
 #include "ForwardRenderNode.h"
 #include "LightData.h"
 #include "RTAccelerationStructures.h"
+#include "RTSceneDataNode.h"
 #include "SceneUniformNode.h"
 #include "utility/GlobalState.h"
-#include "utility/models/SphereSetModel.h"
-#include "utility/models/VoxelContourModel.h"
-#include <half.hpp>
 #include <imgui.h>
 
 RTDiffuseGINode::RTDiffuseGINode(const Scene& scene)
@@ -23,138 +21,7 @@ std::string RTDiffuseGINode::name()
 
 void RTDiffuseGINode::constructNode(Registry& nodeReg)
 {
-    std::vector<const Buffer*> vertexBuffers {};
-    std::vector<const Buffer*> indexBuffers {};
-
-    std::vector<const Buffer*> sphereBuffers {};
-    std::vector<const Buffer*> shBuffers {};
-
-    std::vector<const Buffer*> contourPlaneBuffers {};
-    std::vector<const Buffer*> contourAabbBuffers {};
-
-    std::vector<vec4> contourColors {};
-    std::vector<const Buffer*> contourColorIdxBuffers {};
-
-    std::vector<const Texture*> allTextures {};
-    std::vector<RTMesh> rtMeshes {};
-
-    auto createTriangleMeshVertexBuffer = [&](const Mesh& mesh) {
-        std::vector<RTVertex> vertices {};
-        {
-            auto posData = mesh.positionData();
-            auto normalData = mesh.normalData();
-            auto texCoordData = mesh.texcoordData();
-
-            ASSERT(posData.size() == normalData.size());
-            ASSERT(posData.size() == texCoordData.size());
-
-            for (int i = 0; i < posData.size(); ++i) {
-                vertices.push_back({ .position = vec4(posData[i], 0.0f),
-                                     .normal = vec4(mesh.transform().localNormalMatrix() * normalData[i], 0.0f),
-                                     .texCoord = vec4(texCoordData[i], 0.0f, 0.0f) });
-            }
-        }
-
-        const Material& material = mesh.material();
-        Texture* baseColorTexture { nullptr };
-        if (material.baseColor.empty()) {
-            // the color is already in linear sRGB so we don't want to make an sRGB texture for it!
-            baseColorTexture = &nodeReg.createPixelTexture(material.baseColorFactor, false);
-        } else {
-            baseColorTexture = &nodeReg.loadTexture2D(material.baseColor, true, true);
-        }
-
-        size_t texIndex = allTextures.size();
-        allTextures.push_back(baseColorTexture);
-
-        rtMeshes.push_back({ .objectId = (int)rtMeshes.size(),
-                             .baseColor = (int)texIndex });
-
-        // TODO: Later, we probably want to have combined vertex/ssbo and index/ssbo buffers instead!
-        vertexBuffers.push_back(&nodeReg.createBuffer((std::byte*)vertices.data(), vertices.size() * sizeof(RTVertex), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-        indexBuffers.push_back(&nodeReg.createBuffer(mesh.indexData(), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-    };
-
-    m_scene.forEachModel([&](size_t, const Model& model) {
-        model.forEachMesh([&](const Mesh& mesh) {
-            createTriangleMeshVertexBuffer(mesh);
-        });
-        if (model.proxy().hasMeshes()) {
-            model.proxy().forEachMesh([&](const Mesh& proxyMesh) {
-                createTriangleMeshVertexBuffer(proxyMesh);
-            });
-        } else {
-            const auto* sphereSetModel = dynamic_cast<const SphereSetModel*>(&model.proxy());
-            if (sphereSetModel) {
-                using namespace half_float;
-                std::vector<half> spheresData;
-                for (const auto& sphere : sphereSetModel->spheres()) {
-                    spheresData.push_back(half(sphere.x));
-                    spheresData.push_back(half(sphere.y));
-                    spheresData.push_back(half(sphere.z));
-                    spheresData.push_back(half(sphere.w));
-                }
-                sphereBuffers.push_back(&nodeReg.createBuffer(std::move(spheresData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-
-                auto shData = sphereSetModel->sphericalHarmonics();
-                shBuffers.push_back(&nodeReg.createBuffer(std::move(shData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-
-                return;
-            }
-
-            const auto* voxelContourModel = dynamic_cast<const VoxelContourModel*>(&model.proxy());
-            if (voxelContourModel) {
-                using namespace half_float;
-                std::vector<half> contourPlaneData;
-                std::vector<half> contourAabbData;
-                std::vector<uint32_t> contourColorIdxData;
-                for (const auto& contour : voxelContourModel->contours()) {
-
-                    contourPlaneData.push_back(half(contour.normal.x));
-                    contourPlaneData.push_back(half(contour.normal.y));
-                    contourPlaneData.push_back(half(contour.normal.z));
-                    contourPlaneData.push_back(half(contour.distance));
-
-                    contourAabbData.push_back(half(contour.aabb.min.x));
-                    contourAabbData.push_back(half(contour.aabb.min.y));
-                    contourAabbData.push_back(half(contour.aabb.min.z));
-                    contourAabbData.push_back(half(contour.aabb.max.x));
-                    contourAabbData.push_back(half(contour.aabb.max.y));
-                    contourAabbData.push_back(half(contour.aabb.max.z));
-
-                    size_t colorIdxOffset = contourColors.size();
-                    size_t index = colorIdxOffset + contour.colorIndex;
-                    ASSERT(index < UINT32_MAX);
-                    contourColorIdxData.push_back(static_cast<uint32_t>(index));
-                }
-
-                for (const vec3& color : voxelContourModel->colors()) {
-                    contourColors.push_back(vec4(color, 0.0));
-                }
-
-                contourPlaneBuffers.push_back(&nodeReg.createBuffer(std::move(contourPlaneData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-                contourAabbBuffers.push_back(&nodeReg.createBuffer(std::move(contourAabbData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-                contourColorIdxBuffers.push_back(&nodeReg.createBuffer(std::move(contourColorIdxData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-
-                return;
-            }
-
-            ASSERT_NOT_REACHED();
-        }
-    });
-
-    Buffer& meshBuffer = nodeReg.createBuffer(std::move(rtMeshes), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal);
-    Buffer& contourColorBuffer = nodeReg.createBuffer(std::move(contourColors), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal);
-    m_objectDataBindingSet = &nodeReg.createBindingSet({ { 0, ShaderStageRTClosestHit, &meshBuffer, ShaderBindingType::StorageBuffer },
-                                                         { 1, ShaderStageRTClosestHit, vertexBuffers },
-                                                         { 2, ShaderStageRTClosestHit, indexBuffers },
-                                                         { 3, ShaderStageRTClosestHit, allTextures, RT_MAX_TEXTURES },
-                                                         { 4, ShaderStageRTIntersection, sphereBuffers },
-                                                         { 5, ShaderStageRTClosestHit, shBuffers },
-                                                         { 6, ShaderStageRTIntersection, contourPlaneBuffers },
-                                                         { 7, ShaderStageRTIntersection, contourAabbBuffers },
-                                                         { 8, ShaderStageRTIntersection, contourColorIdxBuffers },
-                                                         { 9, ShaderStageRTClosestHit, &contourColorBuffer, ShaderBindingType::StorageBuffer } });
+    m_objectDataBindingSet = nodeReg.getBindingSet(RTSceneDataNode::name(), "objectData");
 
     Extent2D windowExtent = GlobalState::get().windowExtent();
     m_accumulationTexture = &nodeReg.createTexture2D(windowExtent, Texture::Format::RGBA16F, Texture::Usage::StorageAndSample);
@@ -184,7 +51,7 @@ RenderGraphNode::ExecuteCallback RTDiffuseGINode::constructFrame(Registry& reg)
         HitGroup contourHitGroup { ShaderFile("rt-diffuseGI/contour.rchit"), {}, ShaderFile("rt-diffuseGI/contour.rint") };
         std::vector<ShaderFile> missShaders { ShaderFile("rt-diffuseGI/miss.rmiss"),
                                               ShaderFile("rt-diffuseGI/shadow.rmiss") };
-        ShaderBindingTable sbt { raygen, { mainHitGroup, sphereSetHitGroup, contourHitGroup }, missShaders };
+        ShaderBindingTable sbt { raygen, RTAccelerationStructures::hitGroupsForEveryGeometry({ mainHitGroup, sphereSetHitGroup, contourHitGroup }, m_scene), missShaders };
 
         uint32_t maxRecursionDepth = 1;
         RayTracingState& rtState = reg.createRayTracingState(sbt, { &frameBindingSet, m_objectDataBindingSet }, maxRecursionDepth);
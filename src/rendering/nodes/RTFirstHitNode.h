@@ -19,5 +19,5 @@ public:
 
 private:
     const Scene& m_scene;
-    BindingSet* m_objectDataBindingSet {};
+    const BindingSet* m_objectDataBindingSet {};
 };
@@ -3,6 +3,7 @@
 #include "ForwardRenderNode.h"
 #include "LightData.h"
 #include "RTAccelerationStructures.h"
+#include "RTSceneDataNode.h"
 #include "SceneUniformNode.h"
 
 RTReflectionsNode::RTReflectionsNode(const Scene& scene)
@@ -18,55 +19,7 @@ std::string RTReflectionsNode::name()
 
 void RTReflectionsNode::constructNode(Registry& nodeReg)
 {
-    std::vector<const Buffer*> vertexBuffers {};
-    std::vector<const Buffer*> indexBuffers {};
-    std::vector<RTMesh> rtMeshes {};
-    std::vector<const Texture*> allTextures {};
-
-    m_scene.forEachModel([&](size_t, const Model& model) {
-        model.forEachMesh([&](const Mesh& mesh) {
-            std::vector<RTVertex> vertices {};
-            {
-                auto posData = mesh.positionData();
-                auto normalData = mesh.normalData();
-                auto texCoordData = mesh.texcoordData();
-
-                ASSERT(posData.size() == normalData.size());
-                ASSERT(posData.size() == texCoordData.size());
-
-                for (int i = 0; i < posData.size(); ++i) {
-                    vertices.push_back({ .position = vec4(posData[i], 0.0f),
-                                         .normal = vec4(mesh.transform().localNormalMatrix() * normalData[i], 0.0f),
-                                         .texCoord = vec4(texCoordData[i], 0.0f, 0.0f) });
-                }
-            }
-
-            const Material& material = mesh.material();
-            Texture* baseColorTexture { nullptr };
-            if (material.baseColor.empty()) {
-                // the color is already in linear sRGB so we don't want to make an sRGB texture for it!
-                baseColorTexture = &nodeReg.createPixelTexture(material.baseColorFactor, false);
-            } else {
-                baseColorTexture = &nodeReg.loadTexture2D(material.baseColor, true, true);
-            }
-
-            size_t texIndex = allTextures.size();
-            allTextures.push_back(baseColorTexture);
-
-            rtMeshes.push_back({ .objectId = (int)rtMeshes.size(),
-                                 .baseColor = (int)texIndex });
-
-            // TODO: Later, we probably want to have combined vertex/ssbo and index/ssbo buffers instead!
-            vertexBuffers.push_back(&nodeReg.createBuffer((std::byte*)vertices.data(), vertices.size() * sizeof(RTVertex), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-            indexBuffers.push_back(&nodeReg.createBuffer(mesh.indexData(), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
-        });
-    });
-
-    Buffer& meshBuffer = nodeReg.createBuffer(std::move(rtMeshes), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal);
-    m_objectDataBindingSet = &nodeReg.createBindingSet({ { 0, ShaderStageRTClosestHit, &meshBuffer, ShaderBindingType::StorageBuffer },
-                                                         { 1, ShaderStageRTClosestHit, vertexBuffers },
-                                                         { 2, ShaderStageRTClosestHit, indexBuffers },
-                                                         { 3, ShaderStageRTClosestHit, allTextures, RT_MAX_TEXTURES } });
+    m_objectDataBindingSet = nodeReg.getBindingSet(RTSceneDataNode::name(), "objectData");
 }
 
 RenderGraphNode::ExecuteCallback RTReflectionsNode::constructFrame(Registry& reg) const
@@ -93,7 +46,7 @@ RenderGraphNode::ExecuteCallback RTReflectionsNode::constructFrame(Registry& reg
     HitGroup mainHitGroup { ShaderFile("rt-reflections/closestHit.rchit") };
     std::vector<ShaderFile> missShaders { ShaderFile("rt-reflections/miss.rmiss"),
                                           ShaderFile("rt-reflections/shadow.rmiss") };
-    ShaderBindingTable sbt { raygen, { mainHitGroup }, missShaders };
+    ShaderBindingTable sbt { raygen, RTAccelerationStructures::hitGroupsForEveryGeometry({ mainHitGroup }, m_scene), missShaders };
 
     uint32_t maxRecursionDepth = 2;
     RayTracingState& rtState = reg.createRayTracingState(sbt, { &frameBindingSet, m_objectDataBindingSet }, maxRecursionDepth);
@@ -0,0 +1,111 @@
+#include "RTSceneDataNode.h"
+
+#include "SceneGeometryNode.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+
+RTSceneDataNode::RTSceneDataNode(const Scene& scene)
+    : RenderGraphNode(RTSceneDataNode::name())
+    , m_scene(scene)
+{
+}
+
+std::string RTSceneDataNode::name()
+{
+    return "rt-scene-data";
+}
+
+void RTSceneDataNode::constructNode(Registry& nodeReg)
+{
+    std::vector<const Buffer*> sphereBuffers {};
+    std::vector<const Buffer*> shBuffers {};
+
+    std::vector<const Buffer*> contourPlaneBuffers {};
+    std::vector<const Buffer*> contourAabbBuffers {};
+
+    std::vector<vec4> contourColors {};
+    std::vector<const Buffer*> contourColorIdxBuffers {};
+
+    std::vector<const Texture*> allTextures {};
+    std::vector<RTMesh> rtMeshes {};
+
+    // All triangle meshes (including proxies) live in the shared scene geometry buffers, and the instance custom id + geometry index is the mesh index
+    for (const SceneGeometryNode::MeshRange& range : SceneGeometryNode::meshRanges(nodeReg)) {
+        const Material& material = range.mesh->material();
+        Texture* baseColorTexture { nullptr };
+        if (material.baseColor.empty()) {
+            // the color is already in linear sRGB so we don't want to make an sRGB texture for it!
+            baseColorTexture = &nodeReg.createPixelTexture(material.baseColorFactor, false);
+        } else {
+            baseColorTexture = &nodeReg.loadTexture2D(material.baseColor, true, true);
+        }
+
+        size_t texIndex = allTextures.size();
+        allTextures.push_back(baseColorTexture);
+
+        rtMeshes.push_back({ .objectId = (int)range.meshIndex,
+                             .baseColor = (int)texIndex });
+    }
+
+    m_scene.forEachModel([&](size_t, const Model& model) {
+        if (!model.proxy().hasMeshes()) {
+            const auto* sphereSetModel = dynamic_cast<const SphereSetModel*>(&model.proxy());
+            if (sphereSetModel) {
+                auto spheresData = sphereSetModel->packedSpheres();
+                sphereBuffers.push_back(&nodeReg.createBuffer(std::move(spheresData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
+
+                auto shData = sphereSetModel->packedSphericalHarmonics(m_scene.sphericalHarmonicsPacking());
+                shBuffers.push_back(&nodeReg.createBuffer(std::move(shData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
+
+                return;
+            }
+
+            const auto* voxelContourModel = dynamic_cast<const VoxelContourModel*>(&model.proxy());
+            if (voxelContourModel) {
+                auto contourPlaneData = voxelContourModel->packedContours().planes;
+                auto contourAabbData = voxelContourModel->packedContours().aabbs;
+
+                // (all colors go into the same buffer, so offset the indices to where this model's colors end up)
+                std::vector<uint32_t> contourColorIdxData = voxelContourModel->packedContours().colorIndices;
+                size_t colorIdxOffset = contourColors.size();
+                ASSERT(colorIdxOffset + voxelContourModel->colors().size() < UINT32_MAX);
+                for (uint32_t& colorIndex : contourColorIdxData) {
+                    colorIndex += static_cast<uint32_t>(colorIdxOffset);
+                }
+
+                for (const vec3& color : voxelContourModel->colors()) {
+                    contourColors.push_back(vec4(color, 0.0));
+                }
+
+                contourPlaneBuffers.push_back(&nodeReg.createBuffer(std::move(contourPlaneData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
+                contourAabbBuffers.push_back(&nodeReg.createBuffer(std::move(contourAabbData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
+                contourColorIdxBuffers.push_back(&nodeReg.createBuffer(std::move(contourColorIdxData), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal));
+
+                return;
+            }
+
+            ASSERT_NOT_REACHED();
+        }
+    });
+
+    Buffer& meshBuffer = nodeReg.createBuffer(std::move(rtMeshes), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal);
+    Buffer& contourColorBuffer = nodeReg.createBuffer(std::move(contourColors), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal);
+    BindingSet& objectDataBindingSet = nodeReg.createBindingSet({ { 0, ShaderStageRTClosestHit, &meshBuffer, ShaderBindingType::StorageBuffer },
+                                                                  { 1, ShaderStageRTClosestHit, nodeReg.getBuffer(SceneGeometryNode::name(), "vertices"), ShaderBindingType::StorageBuffer },
+                                                                  { 2, ShaderStageRTClosestHit, nodeReg.getBuffer(SceneGeometryNode::name(), "indices"), ShaderBindingType::StorageBuffer },
+                                                                  { 3, ShaderStageRTClosestHit, allTextures, RT_MAX_TEXTURES },
+                                                                  { 4, ShaderStageRTIntersection, sphereBuffers },
+                                                                  { 5, ShaderStageRTClosestHit, shBuffers },
+                                                                  { 6, ShaderStageRTIntersection, contourPlaneBuffers },
+                                                                  { 7, ShaderStageRTIntersection, contourAabbBuffers },
+                                                                  { 8, ShaderStageRTIntersection, contourColorIdxBuffers },
+                                                                  { 9, ShaderStageRTClosestHit, &contourColorBuffer, ShaderBindingType::StorageBuffer },
+                                                                  { 10, ShaderStageRTClosestHit, nodeReg.getBuffer(SceneGeometryNode::name(), "meshes"), ShaderBindingType::StorageBuffer } });
+    nodeReg.publish("objectData", objectDataBindingSet);
+}
+
+RenderGraphNode::ExecuteCallback RTSceneDataNode::constructFrame(Registry& reg) const
+{
+    // All object data is static and uploaded once at node construction
+    return [](const AppState& appState, CommandList& cmdList) {};
+}
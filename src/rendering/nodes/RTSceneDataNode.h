@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../RenderGraphNode.h"
+#include "RTData.h"
+#include "utility/Scene.h"
+
+// Creates the object data that all ray tracing passes use in their closest hit & intersection shaders, so it's only
+// uploaded once instead of once per pass. Published resources (node registry):
+//
+//  "objectData": binding set with all object data, which the RT passes bind to set index 1:
+//                   0: RTMesh data for all meshes     4: sphere sets             8: contour color indices
+//                   1: SceneGeometryNode "vertices"   5: sphere set SH           9: contour colors
+//                   2: SceneGeometryNode "indices"    6: contour planes         10: SceneGeometryNode "meshes"
+//                   3: base color textures            7: contour AABBs
+
+class RTSceneDataNode final : public RenderGraphNode {
+public:
+    explicit RTSceneDataNode(const Scene&);
+    ~RTSceneDataNode() override = default;
+
+    std::optional<std::string> displayName() const override { return "RT Scene Data"; }
+
+    static std::string name();
+
+    void constructNode(Registry&) override;
+    ExecuteCallback constructFrame(Registry&) const override;
+
+private:
+    const Scene& m_scene;
+};
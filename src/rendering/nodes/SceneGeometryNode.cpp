@@ -0,0 +1,237 @@
+#include "SceneGeometryNode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+std::string SceneGeometryNode::name()
+{
+    return "scene-geometry";
+}
+
+SceneGeometryNode::SceneGeometryNode(const Scene& scene)
+    : RenderGraphNode(SceneGeometryNode::name())
+    , m_scene(scene)
+{
+}
+
+// (the shaders read the vertices as words, see sceneGeometry.glsl)
+static_assert(SceneGeometryNode::vertexFormat().texcoordOffset() == SCENE_VERTEX_TEXCOORD_WORD * sizeof(uint32_t));
+static_assert(SceneGeometryNode::vertexFormat().normalTangentOffset() == SCENE_VERTEX_NORMAL_TANGENT_WORD * sizeof(uint32_t));
+static_assert(SceneGeometryNode::vertexFormat().vertexStride() == SCENE_VERTEX_STRIDE_WORDS * sizeof(uint32_t));
+
+const std::vector<SceneGeometryNode::MeshRange>& SceneGeometryNode::meshRanges(Registry& reg)
+{
+    const auto* ranges = reg.getData<std::vector<MeshRange>>(SceneGeometryNode::name(), "ranges");
+    if (!ranges) {
+        LogErrorAndExit("SceneGeometryNode: mesh ranges requested but the node isn't constructed yet, exiting\n");
+    }
+    return *ranges;
+}
+
+std::vector<SceneGeometryNode::MeshRange> SceneGeometryNode::computeMeshRanges(const Scene& scene)
+{
+    std::vector<MeshRange> ranges {};
+
+    uint32_t nextVertexOffset = 0;
+    size_t nextIndexByteOffset = 0;
+
+    std::unordered_map<const void*, uint32_t> geometrySourceMeshIndices {};
+
+    auto addMesh = [&](const Mesh& mesh, bool isProxy) {
+        MeshRange range {};
+        range.mesh = &mesh;
+        range.meshIndex = static_cast<uint32_t>(ranges.size());
+        range.isProxy = isProxy;
+
+        // (e.g. the same model placed many times, where only the first one needs its geometry in the buffers)
+        auto [entry, didInsert] = geometrySourceMeshIndices.try_emplace(mesh.geometrySource(), range.meshIndex);
+        const MeshRange* sharedRange = didInsert ? nullptr : &ranges[entry->second];
+        if (sharedRange && sharedRange->isProxy == isProxy) {
+            range.geometryMeshIndex = sharedRange->meshIndex;
+            range.vertexOffset = sharedRange->vertexOffset;
+            range.vertexCount = sharedRange->vertexCount;
+            range.indexType = sharedRange->indexType;
+            range.indexByteOffset = sharedRange->indexByteOffset;
+            range.indexCount = sharedRange->indexCount;
+            range.lods = sharedRange->lods;
+            range.boundingSphere = sharedRange->boundingSphere;
+            range.texcoordDensity = sharedRange->texcoordDensity;
+            ranges.push_back(range);
+            return;
+        }
+
+        range.geometryMeshIndex = range.meshIndex;
+
+        range.vertexOffset = nextVertexOffset;
+        range.vertexCount = static_cast<uint32_t>(mesh.vertexCount());
+        nextVertexOffset += range.vertexCount;
+
+        range.indexType = mesh.indexType();
+        size_t indexSize = (range.indexType == IndexType::UInt16) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        auto allocateIndices = [&](size_t indexCount) -> size_t {
+            size_t indexByteOffset = nextIndexByteOffset;
+            nextIndexByteOffset += (indexCount * indexSize + 3) & ~size_t(3);
+            return indexByteOffset;
+        };
+
+        range.indexCount = static_cast<uint32_t>(mesh.indexCount());
+        range.indexByteOffset = allocateIndices(range.indexCount);
+
+        // (proxies are only ever ray traced, so they don't need any LODs)
+        if (!isProxy) {
+            range.boundingSphere = mesh.boundingSphere();
+            range.texcoordDensity = mesh.texcoordDensity();
+            for (const MeshLod& meshLod : mesh.levelsOfDetail()) {
+                MeshRange::Lod lod {};
+                lod.indexCount = static_cast<uint32_t>(meshLod.indices.size());
+                lod.indexByteOffset = allocateIndices(lod.indexCount);
+                lod.error = meshLod.error;
+                range.lods.push_back(lod);
+            }
+        }
+
+        ranges.push_back(range);
+    };
+
+    // NOTE: Models without a proxy use themselves as proxy, but we don't want to store those meshes twice
+    scene.forEachModel([&](size_t, const Model& model) {
+        model.forEachMesh([&](const Mesh& mesh) {
+            addMesh(mesh, false);
+        });
+        if (model.hasProxy() && model.proxy().hasMeshes()) {
+            model.proxy().forEachMesh([&](const Mesh& proxyMesh) {
+                addMesh(proxyMesh, true);
+            });
+        }
+    });
+
+    return ranges;
+}
+
+void SceneGeometryNode::constructNode(Registry& nodeReg)
+{
+    constexpr CompactVertexFormat format = vertexFormat();
+
+    std::vector<MeshRange> ranges = computeMeshRanges(m_scene);
+    if (ranges.empty()) {
+        LogWarning("SceneGeometryNode: no meshes in scene\n");
+    }
+
+    size_t totalVertexCount = 0;
+    size_t totalIndexDataSize = 0;
+    for (const MeshRange& range : ranges) {
+        totalVertexCount = std::max(totalVertexCount, size_t(range.vertexOffset + range.vertexCount));
+        size_t indexSize = (range.indexType == IndexType::UInt16) ? sizeof(uint16_t) : sizeof(uint32_t);
+        const MeshRange::Lod& lastLod = range.lod(range.lodCount() - 1);
+        totalIndexDataSize = std::max(totalIndexDataSize, lastLod.indexByteOffset + lastLod.indexCount * indexSize);
+    }
+    totalIndexDataSize = (totalIndexDataSize + 3) & ~size_t(3);
+
+    std::vector<std::byte> vertexData(totalVertexCount * format.vertexStride());
+    std::vector<std::byte> indexData(totalIndexDataSize);
+    std::vector<SceneMesh> sceneMeshes {};
+
+    size_t uniqueMeshCount = 0;
+    for (const MeshRange& range : ranges) {
+        const Mesh& mesh = *range.mesh;
+
+        if (range.geometryMeshIndex != range.meshIndex) {
+            // (the geometry is already in the buffers, but the transform and material are per mesh)
+            SceneMesh sceneMesh = sceneMeshes[range.geometryMeshIndex];
+            sceneMesh.localNormalMatrix = mat4(mesh.transform().localNormalMatrix());
+            sceneMeshes.push_back(sceneMesh);
+            continue;
+        }
+
+        uniqueMeshCount += 1;
+        CompactVertexFormat::PackedVertices packedVertices = format.packVertices(mesh);
+        ASSERT(packedVertices.vertexData.size() == range.vertexCount * format.vertexStride());
+        std::memcpy(vertexData.data() + range.vertexOffset * format.vertexStride(), packedVertices.vertexData.data(), packedVertices.vertexData.size());
+
+        std::vector<std::byte> packedIndices = mesh.packedIndexData();
+        std::memcpy(indexData.data() + range.indexByteOffset, packedIndices.data(), packedIndices.size());
+
+        for (uint32_t level = 1; level < range.lodCount(); ++level) {
+            std::vector<std::byte> packedLodIndices = mesh.packIndexData(mesh.levelsOfDetail()[level - 1].indices);
+            std::memcpy(indexData.data() + range.lod(level).indexByteOffset, packedLodIndices.data(), packedLodIndices.size());
+        }
+
+        SceneMesh sceneMesh {};
+        sceneMesh.localNormalMatrix = mat4(mesh.transform().localNormalMatrix());
+        sceneMesh.texcoordScaleBias = packedVertices.texcoordScaleBias;
+        sceneMesh.vertexOffset = static_cast<int>(range.vertexOffset);
+        sceneMesh.firstIndexWord = static_cast<int>(range.indexByteOffset / sizeof(uint32_t));
+        sceneMesh.indexType = (range.indexType == IndexType::UInt16) ? SCENE_INDEX_TYPE_UINT16 : SCENE_INDEX_TYPE_UINT32;
+        sceneMeshes.push_back(sceneMesh);
+    }
+
+    LogInfo("SceneGeometryNode: %u meshes (%u unique), %.2f MB vertex data, %.2f MB index data\n",
+            uint32_t(ranges.size()), uint32_t(uniqueMeshCount), vertexData.size() / (1024.0f * 1024.0f), indexData.size() / (1024.0f * 1024.0f));
+
+    Buffer& vertexBuffer = nodeReg.createBuffer(std::move(vertexData), Buffer::Usage::VertexStorage, Buffer::MemoryHint::GpuOptimal);
+    nodeReg.publish("vertices", vertexBuffer);
+
+    Buffer& indexBuffer = nodeReg.createBuffer(std::move(indexData), Buffer::Usage::IndexStorage, Buffer::MemoryHint::GpuOptimal);
+    nodeReg.publish("indices", indexBuffer);
+
+    Buffer& meshBuffer = nodeReg.createBuffer(std::move(sceneMeshes), Buffer::Usage::StorageBuffer, Buffer::MemoryHint::GpuOptimal);
+    nodeReg.publish("meshes", meshBuffer);
+
+    nodeReg.publishData("ranges", std::move(ranges));
+}
+
+uint32_t SceneGeometryNode::selectLod(const MeshRange& range, const mat4& worldFromLocal, const mat4& projectionFromWorld, float targetHeight, float maxPixelError)
+{
+    if (range.lods.empty()) {
+        return 0;
+    }
+
+    float pixelsPerUnit = pixelsPerLocalUnit(range, worldFromLocal, projectionFromWorld, targetHeight);
+    if (std::isinf(pixelsPerUnit)) {
+        return 0;
+    }
+
+    for (uint32_t level = range.lodCount() - 1; level > 0; --level) {
+        if (range.lod(level).error * pixelsPerUnit <= maxPixelError) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+float SceneGeometryNode::pixelsPerLocalUnit(const MeshRange& range, const mat4& worldFromLocal, const mat4& projectionFromWorld, float targetHeight)
+{
+    float worldPerLocalUnit = std::max({ glm::length(vec3(worldFromLocal[0])),
+                                         glm::length(vec3(worldFromLocal[1])),
+                                         glm::length(vec3(worldFromLocal[2])) });
+    float worldRadius = worldPerLocalUnit * range.boundingSphere.w;
+    vec4 clipCenter = projectionFromWorld * worldFromLocal * vec4(vec3(range.boundingSphere), 1.0f);
+
+    // For perspective projections use the distance to the closest point of the bounding sphere, while for orthographic
+    // projections w is always 1 so we can use it as is.
+    float distance = clipCenter.w;
+    bool isPerspective = projectionFromWorld[0][3] != 0.0f || projectionFromWorld[1][3] != 0.0f || projectionFromWorld[2][3] != 0.0f;
+    if (isPerspective) {
+        if (distance + worldRadius < 0.0f) {
+            return 0.0f;
+        }
+        distance -= worldRadius;
+        if (distance <= 0.0f) {
+            return std::numeric_limits<float>::infinity();
+        }
+    }
+
+    // The y-row of the projection is the y-scale of the projection (rotated by the view), for both projection types
+    float ndcPerWorldUnit = glm::length(vec3(projectionFromWorld[0][1], projectionFromWorld[1][1], projectionFromWorld[2][1])) / distance;
+    return worldPerLocalUnit * ndcPerWorldUnit * 0.5f * targetHeight;
+}
+
+RenderGraphNode::ExecuteCallback SceneGeometryNode::constructFrame(Registry& reg) const
+{
+    // All geometry is static and uploaded once at node construction
+    return [](const AppState& appState, CommandList& cmdList) {};
+}
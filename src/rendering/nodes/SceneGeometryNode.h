@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../CompactVertexFormat.h"
+#include "../RenderGraphNode.h"
+#include "SceneGeometryData.h"
+#include "utility/Model.h"
+#include "utility/Scene.h"
+
+// Uploads the geometry of all meshes in the scene (including triangle mesh proxies) to one shared vertex buffer and
+// one shared index buffer, which are published for all other nodes to use. Published resources (node registry):
+//
+//  "vertices": all vertices, in the vertexFormat() layout (meshes with the same geometry source are only stored once)
+//  "indices":  all indices, in each mesh's own index type (each mesh & LOD starts at a 4-byte aligned offset)
+//  "meshes":   SceneMesh data for all meshes (see SceneGeometryData.h)
+//  "ranges":   the MeshRange of all meshes (CPU-side data, use meshRanges(Registry&) to get it)
+
+class SceneGeometryNode final : public RenderGraphNode {
+public:
+    explicit SceneGeometryNode(const Scene&);
+
+    std::optional<std::string> displayName() const override { return "Scene Geometry"; }
+
+    static std::string name();
+
+    // The layout of the shared vertex buffer, as defined by SCENE_TEXCOORD_ENCODING in SceneGeometryData.h
+    static constexpr CompactVertexFormat vertexFormat()
+    {
+        CompactVertexFormat format {};
+        switch (SCENE_TEXCOORD_ENCODING) {
+        case SCENE_TEXCOORD_ENCODING_FLOAT32:
+            format.texcoordEncoding = CompactVertexFormat::TexcoordEncoding::Float32;
+            break;
+        case SCENE_TEXCOORD_ENCODING_HALF:
+            format.texcoordEncoding = CompactVertexFormat::TexcoordEncoding::Half;
+            break;
+        case SCENE_TEXCOORD_ENCODING_UNORM16:
+            format.texcoordEncoding = CompactVertexFormat::TexcoordEncoding::UNorm16;
+            break;
+        }
+        return format;
+    }
+
+    // The range of a single mesh in the shared buffers
+    struct MeshRange {
+        const Mesh* mesh {};
+        uint32_t meshIndex {};
+        bool isProxy {};
+
+        // Meshes with the same geometry source (see Mesh::geometrySource()) share the same ranges in the buffers, and this
+        // is the index of the first of them, i.e. the mesh that the data was uploaded for. For unshared meshes it's meshIndex.
+        uint32_t geometryMeshIndex {};
+
+        uint32_t vertexOffset {};
+        uint32_t vertexCount {};
+
+        size_t indexByteOffset {};
+        uint32_t indexCount {};
+        IndexType indexType {};
+
+        // Simplified levels of detail using the same vertices, see Mesh::levelsOfDetail(). LOD 0 is the full mesh above.
+        struct Lod {
+            size_t indexByteOffset {};
+            uint32_t indexCount {};
+            float error {}; // (in mesh space units)
+        };
+        std::vector<Lod> lods {};
+        vec4 boundingSphere {}; // (in mesh space)
+        float texcoordDensity {}; // (texcoords per mesh space unit, see Mesh::texcoordDensity())
+
+        uint32_t lodCount() const { return 1 + uint32_t(lods.size()); }
+        Lod lod(uint32_t level) const { return (level == 0) ? Lod { indexByteOffset, indexCount, 0.0f } : lods[level - 1]; }
+    };
+
+    // All meshes in the order they appear in the shared buffers, as published by this node. The ranges include the
+    // LODs of the meshes, which are expensive to generate, so they are only computed once when the node is constructed.
+    static const std::vector<MeshRange>& meshRanges(Registry&);
+
+    // Selects the coarsest level of detail whose error projects to at most maxPixelError pixels on a render target of
+    // the given height. Works for both perspective and orthographic projections.
+    static uint32_t selectLod(const MeshRange&, const mat4& worldFromLocal, const mat4& projectionFromWorld, float targetHeight, float maxPixelError);
+
+    // How many pixels a mesh space unit covers (at most) on a render target of the given height. Returns infinity if the
+    // camera is inside the bounding sphere of the mesh, and zero if the mesh is completely behind the camera.
+    static float pixelsPerLocalUnit(const MeshRange&, const mat4& worldFromLocal, const mat4& projectionFromWorld, float targetHeight);
+
+    void constructNode(Registry&) override;
+    ExecuteCallback constructFrame(Registry&) const override;
+
+private:
+    static std::vector<MeshRange> computeMeshRanges(const Scene&);
+
+    const Scene& m_scene;
+};
@@ -26,7 +26,7 @@ SceneUniformNode::ExecuteCallback SceneUniformNode::constructFrame(Registry& reg
 
     Texture& envTexture = m_scene.environmentMap().empty()
         ? reg.createPixelTexture(vec4(1.0f), true)
-        : reg.loadTexture2D(m_scene.environmentMap(), true, false);
+        : reg.loadHdrTexture2D(m_scene.environmentMap(), m_scene.environmentMapFormat(), m_scene.environmentMapMipmaps());
     reg.publish("environmentMap", envTexture);
 
     Buffer& dirLightBuffer = reg.createBuffer(sizeof(DirectionalLight), Buffer::Usage::UniformBuffer, Buffer::MemoryHint::TransferOptimal);
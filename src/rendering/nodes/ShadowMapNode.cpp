@@ -2,6 +2,7 @@
 
 #include "ShadowData.h"
 #include "utility/mathkit.h"
+#include <imgui.h>
 
 std::string ShadowMapNode::name()
 {
@@ -18,16 +19,19 @@ void ShadowMapNode::constructNode(Registry& nodeReg)
 {
     m_drawables.clear();
 
-    m_scene.forEachDrawable([&](int, const Mesh& mesh) {
-        Drawable drawable {};
-        drawable.mesh = &mesh;
+    m_vertexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "vertices");
+    m_indexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "indices");
 
-        drawable.vertexBuffer = &nodeReg.createBuffer(mesh.positionData(), Buffer::Usage::Vertex, Buffer::MemoryHint::GpuOptimal);
-        drawable.indexBuffer = &nodeReg.createBuffer(mesh.indexData(), Buffer::Usage::Index, Buffer::MemoryHint::GpuOptimal);
-        drawable.indexCount = mesh.indexCount();
+    for (const SceneGeometryNode::MeshRange& range : SceneGeometryNode::meshRanges(nodeReg)) {
+        if (range.isProxy) {
+            continue;
+        }
 
+        Drawable drawable {};
+        drawable.mesh = range.mesh;
+        drawable.range = range;
         m_drawables.push_back(drawable);
-    });
+    }
 }
 
 RenderGraphNode::ExecuteCallback ShadowMapNode::constructFrame(Registry& reg) const
@@ -36,7 +40,8 @@ RenderGraphNode::ExecuteCallback ShadowMapNode::constructFrame(Registry& reg) co
     BindingSet& transformBindingSet = reg.createBindingSet({ { 0, ShaderStageVertex, &transformDataBuffer } });
 
     Shader shader = Shader::createVertexOnly("light/shadow.vert");
-    VertexLayout vertexLayout = VertexLayout { sizeof(vec3), { { 0, VertexAttributeType::Float3, 0 } } };
+    // (only the position is used, which is at offset 0 of the shared scene vertices)
+    VertexLayout vertexLayout = VertexLayout { SceneGeometryNode::vertexFormat().vertexStride(), { { 0, VertexAttributeType::Float3, 0 } } };
 
     struct DrawContext {
         const RenderState* renderState {};
@@ -72,15 +77,25 @@ RenderGraphNode::ExecuteCallback ShadowMapNode::constructFrame(Registry& reg) co
         }
         cmdList.updateBufferImmediately(transformDataBuffer, objectTransforms, m_drawables.size() * sizeof(mat4));
 
+        // (shadow maps are filtered & blurry anyway, so we can be more aggressive than for the main view)
+        static float lodPixelError = 2.0f;
+        ImGui::SliderFloat("Shadow LOD pixel error", &lodPixelError, 0.0f, 10.0f);
+
         for (const DrawContext& ctx : drawContexts) {
 
             cmdList.setRenderState(*ctx.renderState, ClearColor(1, 0, 1), 1.0f);
             cmdList.pushConstant(ShaderStageVertex, ctx.light->lightProjection());
             cmdList.bindSet(transformBindingSet, 0);
 
+            mat4 lightProjection = ctx.light->lightProjection();
+            float shadowMapHeight = float(ctx.light->shadowMap.value().size.height());
+
             for (uint32_t idx = 0; idx < m_drawables.size(); ++idx) {
                 auto& drawable = m_drawables[idx];
-                cmdList.drawIndexed(*drawable.vertexBuffer, *drawable.indexBuffer, drawable.indexCount, drawable.mesh->indexType(), idx);
+                const SceneGeometryNode::MeshRange& range = drawable.range;
+                uint32_t lodLevel = SceneGeometryNode::selectLod(range, objectTransforms[idx], lightProjection, shadowMapHeight, lodPixelError);
+                SceneGeometryNode::MeshRange::Lod lod = range.lod(lodLevel);
+                cmdList.drawIndexed(*m_vertexBuffer, *m_indexBuffer, lod.indexCount, range.indexType, idx, lod.indexByteOffset, range.vertexOffset);
             };
         }
     };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "rendering/RenderGraphNode.h"
+#include "rendering/nodes/SceneGeometryNode.h"
 #include "utility/FpsCamera.h"
 #include "utility/Model.h"
 #include "utility/Scene.h"
@@ -20,11 +21,11 @@ public:
 private:
     struct Drawable {
         const Mesh* mesh {};
-        Buffer* vertexBuffer {};
-        Buffer* indexBuffer {};
-        uint32_t indexCount {};
+        SceneGeometryNode::MeshRange range {};
     };
 
     const Scene& m_scene;
     std::vector<Drawable> m_drawables {};
+    const Buffer* m_vertexBuffer {};
+    const Buffer* m_indexBuffer {};
 };
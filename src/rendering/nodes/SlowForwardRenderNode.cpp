@@ -16,42 +16,19 @@ void SlowForwardRenderNode::constructNode(Registry& nodeReg)
 {
     m_drawables.clear();
 
-    for (int i = 0; i < m_scene.modelCount(); ++i) {
-        const Model& model = *m_scene[i];
-        model.forEachMesh([&](const Mesh& mesh) {
-            std::vector<Vertex> vertices {};
-            {
-                auto posData = mesh.positionData();
-                auto texData = mesh.texcoordData();
-                auto normalData = mesh.normalData();
-                auto tangentData = mesh.tangentData();
-
-                size_t texSize = texData.size();
-                size_t normalSize = normalData.size();
-                size_t tangentSize = tangentData.size();
-                //ASSERT(posData.size() == texData.size());
-                //ASSERT(posData.size() == normalData.size());
-                //ASSERT(posData.size() == tangentData.size());
-
-                for (int i = 0; i < posData.size(); ++i) {
-
-                    vec2 tex = (i < texSize) ? texData[i] : vec2(0.0f);
-                    vec3 norm = (i < normalSize) ? normalData[i] : vec3(0.0f);
-                    vec4 tang = (i < tangentSize) ? tangentData[i] : vec4(0.0f);
-
-                    vertices.push_back({ .position = posData[i],
-                                         .texCoord = tex,
-                                         .normal = norm,
-                                         .tangent = tang });
-                }
-            }
+    m_vertexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "vertices");
+    m_indexBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "indices");
+    m_sceneMeshBuffer = nodeReg.getBuffer(SceneGeometryNode::name(), "meshes");
 
+    for (const SceneGeometryNode::MeshRange& range : SceneGeometryNode::meshRanges(nodeReg)) {
+        if (range.isProxy) {
+            continue;
+        }
+        const Mesh& mesh = *range.mesh;
+        {
             Drawable drawable {};
             drawable.mesh = &mesh;
-
-            drawable.vertexBuffer = &nodeReg.createBuffer(std::move(vertices), Buffer::Usage::Vertex, Buffer::MemoryHint::GpuOptimal);
-            drawable.indexBuffer = &nodeReg.createBuffer(mesh.indexData(), Buffer::Usage::Index, Buffer::MemoryHint::GpuOptimal);
-            drawable.indexCount = mesh.indexCount();
+            drawable.range = range;
 
             drawable.objectDataBuffer = &nodeReg.createBuffer(sizeof(PerForwardObject), Buffer::Usage::UniformBuffer, Buffer::MemoryHint::TransferOptimal);
 
@@ -64,15 +41,15 @@ void SlowForwardRenderNode::constructNode(Registry& nodeReg)
                 // the color is already in linear sRGB so we don't want to make an sRGB texture for it!
                 baseColorTexture = &nodeReg.createPixelTexture(material.baseColorFactor, false);
             } else {
-                baseColorTexture = &nodeReg.loadTexture2D(baseColorPath, true, true);
+                baseColorTexture = &nodeReg.loadTexture2D(baseColorPath, true, true, false, true);
             }
 
             std::string normalMapPath = material.normalMap;
-            Texture& normalMapTexture = nodeReg.loadTexture2D(normalMapPath, false, true);
+            Texture& normalMapTexture = nodeReg.loadTexture2D(normalMapPath, false, true, true, true);
             std::string metallicRoughnessPath = material.metallicRoughness;
-            Texture& metallicRoughnessTexture = nodeReg.loadTexture2D(metallicRoughnessPath, false, true);
+            Texture& metallicRoughnessTexture = nodeReg.loadTexture2D(metallicRoughnessPath, false, true, false, true);
             std::string emissivePath = material.emissive;
-            Texture& emissiveTexture = nodeReg.loadTexture2D(emissivePath, true, true);
+            Texture& emissiveTexture = nodeReg.loadTexture2D(emissivePath, true, true, false, true);
 
             // Create binding set
             drawable.bindingSet = &nodeReg.createBindingSet(
@@ -81,9 +58,10 @@ void SlowForwardRenderNode::constructNode(Registry& nodeReg)
                   { 2, ShaderStageFragment, &normalMapTexture },
                   { 3, ShaderStageFragment, &metallicRoughnessTexture },
                   { 4, ShaderStageFragment, &emissiveTexture } });
+            drawable.textures = { baseColorTexture, &normalMapTexture, &metallicRoughnessTexture, &emissiveTexture };
 
             m_drawables.push_back(drawable);
-        });
+        }
     }
 }
 
@@ -109,7 +87,8 @@ RenderGraphNode::ExecuteCallback SlowForwardRenderNode::constructFrame(Registry&
                                                           { RenderTarget::AttachmentType::Depth, &depthTexture } });
 
     const Buffer* cameraUniformBuffer = reg.getBuffer(SceneUniformNode::name(), "camera");
-    BindingSet& fixedBindingSet = reg.createBindingSet({ { 0, ShaderStage(ShaderStageVertex | ShaderStageFragment), cameraUniformBuffer } });
+    BindingSet& fixedBindingSet = reg.createBindingSet({ { 0, ShaderStage(ShaderStageVertex | ShaderStageFragment), cameraUniformBuffer },
+                                                         { 1, ShaderStageVertex, m_sceneMeshBuffer, ShaderBindingType::StorageBuffer } });
 
     const Texture* shadowMap = reg.getTexture(ShadowMapNode::name(), "directional").value_or(&reg.createPixelTexture(vec4(1.0), false));
     BindingSet& dirLightBindingSet = reg.createBindingSet({ { 0, ShaderStageFragment, shadowMap },
@@ -120,13 +99,7 @@ RenderGraphNode::ExecuteCallback SlowForwardRenderNode::constructFrame(Registry&
                                                              { 1, ShaderStageFragment, reg.getBuffer(SceneUniformNode::name(), "spotLight") } });
 
     Shader shader = Shader::createBasic("forwardSlow.vert", "forwardSlow.frag");
-    VertexLayout vertexLayout = VertexLayout {
-        sizeof(Vertex),
-        { { 0, VertexAttributeType::Float3, offsetof(Vertex, position) },
-          { 1, VertexAttributeType::Float2, offsetof(Vertex, texCoord) },
-          { 2, VertexAttributeType ::Float3, offsetof(Vertex, normal) },
-          { 3, VertexAttributeType ::Float4, offsetof(Vertex, tangent) } }
-    };
+    VertexLayout vertexLayout = SceneGeometryNode::vertexFormat().vertexLayout();
 
     RenderStateBuilder renderStateBuilder { renderTarget, shader, vertexLayout };
     renderStateBuilder.polygonMode = PolygonMode::Filled;
@@ -153,12 +126,34 @@ RenderGraphNode::ExecuteCallback SlowForwardRenderNode::constructFrame(Registry&
         cmdList.bindSet(dirLightBindingSet, 2);
         cmdList.bindSet(spotLightBindingSet, 3);
 
+        static float lodPixelError = 1.0f;
+        ImGui::SliderFloat("LOD pixel error", &lodPixelError, 0.0f, 10.0f);
+
+        const FpsCamera& camera = m_scene.camera();
+        mat4 projectionFromWorld = camera.projectionMatrix() * camera.viewMatrix();
+        float targetHeight = float(renderTarget.extent().height());
+
+        TextureStreamer& textureStreamer = reg.textureStreamer();
+        if (textureStreamer.isEnabled()) {
+            ImGui::Text("Streamed textures: %.1f / %.1f MB", textureStreamer.residentSize() / (1024.0f * 1024.0f), textureStreamer.budget() / (1024.0f * 1024.0f));
+        }
+
         for (const Drawable& drawable : m_drawables) {
+            const SceneGeometryNode::MeshRange& range = drawable.range;
+            mat4 worldFromLocal = drawable.mesh->transform().worldMatrix();
+
+            if (textureStreamer.isEnabled()) {
+                float pixelsPerLocalUnit = SceneGeometryNode::pixelsPerLocalUnit(range, worldFromLocal, projectionFromWorld, targetHeight);
+                for (const Texture* texture : drawable.textures) {
+                    textureStreamer.requestMipLevel(*texture, TextureStreamer::requiredMipLevel(*texture, range.texcoordDensity, pixelsPerLocalUnit));
+                }
+            }
 
             // TODO: Hmm, it still looks very much like it happens in line with the other commands..
             PerForwardObject objectData {
-                .worldFromLocal = drawable.mesh->transform().worldMatrix(),
-                .worldFromTangent = mat4(drawable.mesh->transform().worldNormalMatrix())
+                .worldFromLocal = worldFromLocal,
+                .worldFromTangent = mat4(drawable.mesh->transform().worldNormalMatrix()),
+                .meshIndex = static_cast<int>(drawable.range.meshIndex)
             };
             cmdList.updateBufferImmediately(*drawable.objectDataBuffer, &objectData, sizeof(PerForwardObject));
 
@@ -167,7 +162,9 @@ RenderGraphNode::ExecuteCallback SlowForwardRenderNode::constructFrame(Registry&
             cmdList.pushConstant(ShaderStageFragment, ambientAmount, 8);
 
             cmdList.bindSet(*drawable.bindingSet, 1);
-            cmdList.drawIndexed(*drawable.vertexBuffer, *drawable.indexBuffer, drawable.indexCount, drawable.mesh->indexType());
+            uint32_t lodLevel = SceneGeometryNode::selectLod(range, worldFromLocal, projectionFromWorld, targetHeight, lodPixelError);
+            SceneGeometryNode::MeshRange::Lod lod = range.lod(lodLevel);
+            cmdList.drawIndexed(*m_vertexBuffer, *m_indexBuffer, lod.indexCount, range.indexType, 0, lod.indexByteOffset, range.vertexOffset);
         }
     };
 }
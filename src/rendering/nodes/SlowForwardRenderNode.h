@@ -2,6 +2,7 @@
 
 #include "../RenderGraphNode.h"
 #include "ForwardData.h"
+#include "SceneGeometryNode.h"
 #include "utility/FpsCamera.h"
 #include "utility/Model.h"
 #include "utility/Scene.h"
@@ -16,22 +17,18 @@ public:
     ExecuteCallback constructFrame(Registry&) const override;
 
 private:
-    struct Vertex {
-        vec3 position;
-        vec2 texCoord;
-        vec3 normal;
-        vec4 tangent;
-    };
-
     struct Drawable {
         const Mesh* mesh {};
-        Buffer* vertexBuffer {};
-        Buffer* indexBuffer {};
-        uint32_t indexCount {};
+        SceneGeometryNode::MeshRange range {};
         Buffer* objectDataBuffer {};
         BindingSet* bindingSet {};
+        std::vector<const Texture*> textures {};
     };
 
     std::vector<Drawable> m_drawables {};
     const Scene& m_scene;
+
+    const Buffer* m_vertexBuffer {};
+    const Buffer* m_indexBuffer {};
+    const Buffer* m_sceneMeshBuffer {};
 };
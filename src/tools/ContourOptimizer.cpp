@@ -0,0 +1,195 @@
+#include "rendering/cpu/CpuRayTracingScene.h"
+#include "utility/Logging.h"
+#include "utility/ProxyFile.h"
+#include "utility/ThreadPool.h"
+#include "utility/VoxelContourOptimizer.h"
+#include "utility/models/GltfModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <vector>
+
+// Optimizes a voxel-contour proxy (see VoxelContourOptimizer) and writes it as a binary .proxy file. To make sure that
+// nothing is lost on the way, both the original and the optimized contours are ray traced (on the CPU) from a number of
+// directions around the mesh they were generated from, and the error of both versions against the mesh is reported.
+//
+//  usage: ContourOptimizer [--max-angle DEG] [--max-distance VOXELS] [--output path.proxy] <mesh gltf> <contours json/proxy>
+//
+// If no output path is given, the file is written to where ProxyFile::findConvertedProxy will look for it, so it
+// replaces the plain conversion of the JSON file.
+
+namespace {
+
+constexpr int viewDirectionCount = 64;
+constexpr int raysPerSide = 128;
+
+struct TraceResult {
+    double milliseconds;
+    std::vector<float> hitDistances; // (negative for misses)
+};
+
+// Orthographic views of the bounding sphere, from directions evenly spread over the sphere (a Fibonacci lattice)
+TraceResult traceViews(const CpuRayTracingScene& rtScene, vec3 center, float radius)
+{
+    TraceResult result {};
+    result.hitDistances.resize(viewDirectionCount * raysPerSide * raysPerSide);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<void>> views {};
+    for (int view = 0; view < viewDirectionCount; ++view) {
+        views.push_back(ThreadPool::global().enqueue([&, view]() {
+            float z = 1.0f - 2.0f * (float(view) + 0.5f) / float(viewDirectionCount);
+            float phi = float(view) * mathkit::PI * (3.0f - std::sqrt(5.0f));
+            float r = std::sqrt(1.0f - z * z);
+            vec3 direction = -vec3(r * std::cos(phi), r * std::sin(phi), z);
+
+            vec3 tangent = normalize(cross(std::abs(direction.y) < 0.99f ? vec3(0, 1, 0) : vec3(1, 0, 0), direction));
+            vec3 bitangent = cross(direction, tangent);
+
+            for (int y = 0; y < raysPerSide; ++y) {
+                for (int x = 0; x < raysPerSide; ++x) {
+                    vec2 offset = ((vec2(x, y) + 0.5f) / float(raysPerSide) * 2.0f - 1.0f) * radius;
+                    Ray ray { .origin = center - 2.0f * radius * direction + offset.x * tangent + offset.y * bitangent,
+                              .direction = direction,
+                              .tMin = 0.0f,
+                              .tMax = 4.0f * radius };
+
+                    std::optional<CpuRayTracingScene::Hit> hit = rtScene.traceRay(ray, 0xff, false);
+                    result.hitDistances[(view * raysPerSide + y) * raysPerSide + x] = hit.has_value() ? hit->t : -1.0f;
+                }
+            }
+        }));
+    }
+    for (auto& view : views) {
+        view.wait();
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void reportError(const char* name, const VoxelContourModel& contours, const TraceResult& meshResult, vec3 center, float radius)
+{
+    CpuRayTracingScene rtScene { { &contours }, true };
+    TraceResult result = traceViews(rtScene, center, radius);
+
+    size_t matchingCoverage = 0;
+    std::vector<float> depthErrors {};
+    for (size_t i = 0; i < meshResult.hitDistances.size(); ++i) {
+        float meshT = meshResult.hitDistances[i];
+        float contourT = result.hitDistances[i];
+        if ((meshT >= 0.0f) == (contourT >= 0.0f)) {
+            matchingCoverage += 1;
+        }
+        if (meshT >= 0.0f && contourT >= 0.0f) {
+            depthErrors.push_back(std::abs(meshT - contourT));
+        }
+    }
+
+    double meanError = 0.0;
+    float p95Error = 0.0f;
+    float maxError = 0.0f;
+    if (!depthErrors.empty()) {
+        for (float error : depthErrors) {
+            meanError += error;
+        }
+        meanError /= double(depthErrors.size());
+        std::sort(depthErrors.begin(), depthErrors.end());
+        p95Error = depthErrors[depthErrors.size() * 95 / 100];
+        maxError = depthErrors.back();
+    }
+
+    LogInfo("  %-9s %7zu contours  trace %8.2f ms  coverage %6.2f%%  depth error mean %.5f (%.3f%%) p95 %.5f (%.3f%%) max %.5f (%.3f%%)\n",
+            name, contours.contours().size(), result.milliseconds, 100.0 * matchingCoverage / meshResult.hitDistances.size(),
+            meanError, 100.0 * meanError / radius, p95Error, 100.0 * p95Error / radius, maxError, 100.0 * maxError / radius);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    VoxelContourOptimizer::Settings settings {};
+    std::string outputPath {};
+    std::vector<std::string> inputPaths {};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-angle" && i + 1 < argc) {
+            settings.maxMergeAngle = mathkit::radians(float(std::atof(argv[++i])));
+        } else if (arg == "--max-distance" && i + 1 < argc) {
+            settings.maxMergeDistance = float(std::atof(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            inputPaths.push_back(arg);
+        }
+    }
+
+    if (inputPaths.size() != 2) {
+        LogErrorAndExit("usage: ContourOptimizer [--max-angle DEG] [--max-distance VOXELS] [--output path.proxy] <mesh gltf> <contours json/proxy>\n");
+    }
+    const std::string& meshPath = inputPaths[0];
+    const std::string& contoursPath = inputPaths[1];
+
+    if (outputPath.empty()) {
+        if (!ProxyFile::isJsonProxyPath(contoursPath)) {
+            LogErrorAndExit("ContourOptimizer: an output path is needed when the input isn't a JSON proxy.\n");
+        }
+        outputPath = ProxyFile::binaryPathForJson(contoursPath);
+    }
+
+    std::unique_ptr<Model> mesh = GltfModel::load(meshPath);
+    std::unique_ptr<Model> input = ProxyFile::isBinaryProxyPath(contoursPath) ? ProxyFile::loadBinary(contoursPath) : ProxyFile::loadJson(contoursPath);
+    const auto* contours = dynamic_cast<const VoxelContourModel*>(input.get());
+    if (!mesh || !contours) {
+        LogErrorAndExit("ContourOptimizer: could not load '%s' as a mesh and '%s' as voxel contours.\n", meshPath.c_str(), contoursPath.c_str());
+    }
+
+    auto optimizeStart = std::chrono::steady_clock::now();
+    VoxelContourOptimizer::Statistics statistics {};
+    std::unique_ptr<VoxelContourModel> optimized = VoxelContourOptimizer::optimize(*contours, settings, &statistics);
+    double optimizeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - optimizeStart).count();
+
+    LogInfo("ContourOptimizer: '%s' in %.1f ms (voxel size %.4f x %.4f x %.4f)\n", contoursPath.c_str(), optimizeTime,
+            statistics.voxelSize.x, statistics.voxelSize.y, statistics.voxelSize.z);
+    LogInfo("  contours %zu -> %zu (%.1f%%), colors %zu -> %zu, average AABB volume %.3f voxels\n",
+            statistics.inputContours, statistics.outputContours, 100.0 * statistics.outputContours / std::max(statistics.inputContours, size_t(1)),
+            statistics.inputColors, statistics.outputColors, statistics.averageAabbVolume);
+    if (statistics.colorMismatches > 0) {
+        LogErrorAndExit("ContourOptimizer: %zu contours didn't keep their color (within %.4f) when optimized!\n",
+                        statistics.colorMismatches, settings.colorTolerance);
+    }
+
+    // (the error is measured over the bounding sphere of the original contours, relative to its radius)
+    vec3 boundsMin { std::numeric_limits<float>::max() };
+    vec3 boundsMax { -std::numeric_limits<float>::max() };
+    for (const VoxelContourModel::VoxelContour& contour : contours->contours()) {
+        boundsMin = glm::min(boundsMin, contour.aabb.min);
+        boundsMax = glm::max(boundsMax, contour.aabb.max);
+    }
+    vec3 center = 0.5f * (boundsMin + boundsMax);
+    float radius = 0.5f * length(boundsMax - boundsMin);
+
+    CpuRayTracingScene meshScene { { mesh.get() }, false };
+    TraceResult meshResult = traceViews(meshScene, center, radius);
+    LogInfo("  %-9s %7zu triangles trace %8.2f ms  (%d views of %dx%d rays, against the mesh)\n", "mesh", meshScene.primitiveCount(),
+            meshResult.milliseconds, viewDirectionCount, raysPerSide, raysPerSide);
+    reportError("original", *contours, meshResult, center, radius);
+    reportError("optimized", *optimized, meshResult, center, radius);
+
+    if (!ProxyFile::writeBinary(outputPath, *optimized)) {
+        LogErrorAndExit("ContourOptimizer: could not write '%s'.\n", outputPath.c_str());
+    }
+
+    std::error_code error;
+    auto inputSize = std::filesystem::file_size(contoursPath, error);
+    auto outputSize = std::filesystem::file_size(outputPath, error);
+    LogInfo("  wrote '%s' (%.1f kB, input was %.1f kB)\n", outputPath.c_str(), outputSize / 1024.0, inputSize / 1024.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "rendering/cpu/CpuRayTracingScene.h"
+#include "utility/Logging.h"
+#include "utility/Scene.h"
+#include "utility/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <vector>
+
+// Benchmark of the CPU ray tracing (see src/rendering/cpu/), which traces primary rays from the main camera through the
+// scene, once with the full triangle meshes and once with their proxies. Apart from the timings it reports how well the
+// proxies cover the real geometry, which makes it possible to validate proxies without an RT capable GPU.
+//
+//  usage: CpuRayTracingBenchmark [--size WxH] [--iterations N] [scene]
+//
+// Run it from the root of the repo, since that's what the paths in the scene files are relative to.
+
+namespace {
+
+struct TraceResult {
+    double milliseconds;
+    std::vector<float> hitDistances; // (negative for misses)
+};
+
+TraceResult tracePrimaryRays(const CpuRayTracingScene& rtScene, const Scene& scene, Extent2D size)
+{
+    // (same setup as rt-firsthit/raygen.rgen, with the default field of view of the camera)
+    mat4 worldFromView = inverse(scene.camera().viewMatrix());
+    mat4 viewFromProjection = inverse(mathkit::perspective(mathkit::radians(60.0f), float(size.width()) / float(size.height()), 0.25f, 10000.0f));
+
+    TraceResult result {};
+    result.hitDistances.resize(size.width() * size.height());
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<void>> rows {};
+    for (uint32_t y = 0; y < size.height(); ++y) {
+        rows.push_back(ThreadPool::global().enqueue([&, y]() {
+            for (uint32_t x = 0; x < size.width(); ++x) {
+                vec2 uv = (vec2(x, y) + vec2(0.5f)) / vec2(size.width(), size.height());
+                vec2 d = uv * 2.0f - 1.0f;
+
+                vec4 target = viewFromProjection * vec4(d.x, d.y, 1.0f, 1.0f);
+                Ray ray { .origin = vec3(worldFromView * vec4(0, 0, 0, 1)),
+                          .direction = normalize(vec3(worldFromView * vec4(normalize(vec3(target) / target.w), 0.0f))),
+                          .tMin = 0.001f,
+                          .tMax = 10000.0f };
+
+                std::optional<CpuRayTracingScene::Hit> hit = rtScene.traceRay(ray);
+                result.hitDistances[y * size.width() + x] = hit.has_value() ? hit->t : -1.0f;
+            }
+        }));
+    }
+    for (auto& row : rows) {
+        row.wait();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+    return result;
+}
+
+TraceResult benchmark(const char* name, const Scene& scene, bool useProxies, Extent2D size, int iterations)
+{
+    auto buildStart = std::chrono::steady_clock::now();
+    CpuRayTracingScene rtScene { scene, useProxies };
+    double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    std::vector<double> times {};
+    TraceResult result {};
+    for (int i = 0; i < iterations; ++i) {
+        result = tracePrimaryRays(rtScene, scene, size);
+        times.push_back(result.milliseconds);
+    }
+    std::sort(times.begin(), times.end());
+    double medianTime = times[times.size() / 2];
+
+    size_t hitCount = std::count_if(result.hitDistances.begin(), result.hitDistances.end(), [](float t) { return t >= 0.0f; });
+    double megaRaysPerSecond = result.hitDistances.size() / (medianTime * 1000.0);
+
+    LogInfo("  %-8s %9zu primitives %8.2f MB  build %8.1f ms  trace %8.2f ms (%6.2f Mrays/s)  %5.1f%% hit\n", name,
+            rtScene.primitiveCount(), rtScene.sizeInBytes() / (1024.0 * 1024.0), buildTime, medianTime, megaRaysPerSecond,
+            100.0 * hitCount / result.hitDistances.size());
+
+    return result;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 5;
+    Extent2D size { 1280, 720 };
+    std::string scenePath = "assets/Scenes/eval/bunny_test.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--size" && i + 1 < argc) {
+            int width, height;
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                LogErrorAndExit("CpuRayTracingBenchmark: invalid size '%s', expected e.g. 1280x720.\n", argv[i]);
+            }
+            size = Extent2D(width, height);
+        } else {
+            scenePath = arg;
+        }
+    }
+
+    std::unique_ptr<Scene> scene = Scene::loadFromFile(scenePath);
+
+    LogInfo("CpuRayTracingBenchmark: '%s' at %ux%u (median of %d iterations, %u threads)\n", scenePath.c_str(),
+            size.width(), size.height(), iterations, ThreadPool::global().threadCount());
+    TraceResult meshResult = benchmark("meshes", *scene, false, size, iterations);
+    TraceResult proxyResult = benchmark("proxies", *scene, true, size, iterations);
+
+    // How well do the proxies match the meshes they stand in for?
+    size_t matchingCoverage = 0;
+    size_t bothHit = 0;
+    double depthErrorSum = 0.0;
+    for (size_t i = 0; i < meshResult.hitDistances.size(); ++i) {
+        float meshT = meshResult.hitDistances[i];
+        float proxyT = proxyResult.hitDistances[i];
+        if ((meshT >= 0.0f) == (proxyT >= 0.0f)) {
+            matchingCoverage += 1;
+        }
+        if (meshT >= 0.0f && proxyT >= 0.0f) {
+            bothHit += 1;
+            depthErrorSum += std::abs(meshT - proxyT) / meshT;
+        }
+    }
+
+    LogInfo("  proxies match the meshes in %.2f%% of pixels, with %.2f%% average relative depth error where both are hit\n",
+            100.0 * matchingCoverage / meshResult.hitDistances.size(), bothHit > 0 ? 100.0 * depthErrorSum / bothHit : 0.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+#include "utility/FileIO.h"
+#include "utility/Logging.h"
+#include "utility/ProxyFile.h"
+#include "utility/SceneFile.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Benchmark of the streaming (SAX) JSON parsing against the old DOM parsing, for scene files and the proxies they use.
+//
+//  usage: JsonParseBenchmark [--iterations N] [scene or directory]...
+//
+// If no scenes are given the eval scenes (assets/Scenes/eval) are used. Run it from the root of the repo, since that's
+// what the paths in the scene files are relative to. Proxies that can't be found (e.g. absolute paths to some other
+// machine) are skipped.
+
+namespace {
+
+// Returns the median time in milliseconds
+double timeIterations(int iterations, const std::function<void()>& function)
+{
+    std::vector<double> times {};
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void printResult(const std::string& path, size_t fileSize, double domTime, double streamingTime)
+{
+    LogInfo("  %-52s %8.1f kB  DOM %8.3f ms  streaming %8.3f ms  (%.2fx)\n", path.c_str(), fileSize / 1024.0f,
+            domTime, streamingTime, domTime / streamingTime);
+}
+
+// (both parsers read the same text, but one goes through double, so allow for a difference in the last bit or so)
+bool equal(float a, float b)
+{
+    return std::abs(a - b) <= 1e-6f * std::max(1.0f, std::max(std::abs(a), std::abs(b)));
+}
+
+bool equal(vec3 a, vec3 b)
+{
+    return equal(a.x, b.x) && equal(a.y, b.y) && equal(a.z, b.z);
+}
+
+bool equal(vec4 a, vec4 b)
+{
+    return equal(vec3(a), vec3(b)) && equal(a.w, b.w);
+}
+
+// Returns a description of the first difference between the two parsed scenes, or an empty string if they are the same
+std::string findDifference(const SceneFile::Description& dom, const SceneFile::Description& streaming)
+{
+    if (dom.environmentMap != streaming.environmentMap || !equal(dom.environmentMultiplier, streaming.environmentMultiplier)
+        || dom.environmentMapFormat != streaming.environmentMapFormat || dom.environmentMapMipmaps != streaming.environmentMapMipmaps) {
+        return "environment";
+    }
+    if (dom.textureStreamingBudgetMB.has_value() != streaming.textureStreamingBudgetMB.has_value()
+        || (dom.textureStreamingBudgetMB.has_value() && !equal(*dom.textureStreamingBudgetMB, *streaming.textureStreamingBudgetMB))
+        || dom.shPacking != streaming.shPacking || dom.sphereOrder != streaming.sphereOrder) {
+        return "settings";
+    }
+
+    if (dom.models.size() != streaming.models.size()) {
+        return "model count";
+    }
+    for (size_t i = 0; i < dom.models.size(); ++i) {
+        const SceneFile::ModelDescription& a = dom.models[i];
+        const SceneFile::ModelDescription& b = streaming.models[i];
+        if (a.name != b.name || a.gltf != b.gltf || a.proxy != b.proxy || a.optimize != b.optimize) {
+            return "model " + std::to_string(i);
+        }
+        if (!equal(a.translation, b.translation) || !equal(a.rotationAxis, b.rotationAxis)
+            || !equal(a.rotationAngle, b.rotationAngle) || !equal(a.scale, b.scale)) {
+            return "transform of model " + std::to_string(i);
+        }
+    }
+
+    if (dom.sun.has_value() != streaming.sun.has_value()) {
+        return "sun";
+    }
+    if (dom.sun.has_value()) {
+        const SceneFile::SunDescription& a = *dom.sun;
+        const SceneFile::SunDescription& b = *streaming.sun;
+        if (!equal(a.color, b.color) || !equal(a.intensity, b.intensity) || !equal(a.direction, b.direction) || !equal(a.worldExtent, b.worldExtent)
+            || a.shadowMapSize[0] != b.shadowMapSize[0] || a.shadowMapSize[1] != b.shadowMapSize[1]) {
+            return "sun";
+        }
+    }
+
+    if (dom.cameras.size() != streaming.cameras.size() || dom.mainCamera != streaming.mainCamera) {
+        return "cameras";
+    }
+    for (size_t i = 0; i < dom.cameras.size(); ++i) {
+        const SceneFile::CameraDescription& a = dom.cameras[i];
+        const SceneFile::CameraDescription& b = streaming.cameras[i];
+        if (a.name != b.name || !equal(a.origin, b.origin) || !equal(a.target, b.target)) {
+            return "camera " + std::to_string(i);
+        }
+    }
+
+    return {};
+}
+
+// Same as above, but for two parsed proxies
+std::string findDifference(const Model* dom, const Model* streaming)
+{
+    const auto* domSpheres = dynamic_cast<const SphereSetModel*>(dom);
+    const auto* streamingSpheres = dynamic_cast<const SphereSetModel*>(streaming);
+    if (domSpheres && streamingSpheres) {
+        if (domSpheres->spheres().size() != streamingSpheres->spheres().size()) {
+            return "sphere count";
+        }
+        for (size_t i = 0; i < domSpheres->spheres().size(); ++i) {
+            if (!equal(domSpheres->spheres()[i], streamingSpheres->spheres()[i])) {
+                return "sphere " + std::to_string(i);
+            }
+            const SphericalHarmonics& a = domSpheres->sphericalHarmonics()[i];
+            const SphericalHarmonics& b = streamingSpheres->sphericalHarmonics()[i];
+            for (vec4 SphericalHarmonics::*coefficient : { &SphericalHarmonics::L00, &SphericalHarmonics::L1_1, &SphericalHarmonics::L10,
+                                                            &SphericalHarmonics::L11, &SphericalHarmonics::L2_2, &SphericalHarmonics::L2_1,
+                                                            &SphericalHarmonics::L20, &SphericalHarmonics::L21, &SphericalHarmonics::L22 }) {
+                if (!equal(a.*coefficient, b.*coefficient)) {
+                    return "SH of sphere " + std::to_string(i);
+                }
+            }
+        }
+        return {};
+    }
+
+    const auto* domContours = dynamic_cast<const VoxelContourModel*>(dom);
+    const auto* streamingContours = dynamic_cast<const VoxelContourModel*>(streaming);
+    if (domContours && streamingContours) {
+        if (domContours->contours().size() != streamingContours->contours().size()) {
+            return "contour count";
+        }
+        for (size_t i = 0; i < domContours->contours().size(); ++i) {
+            const VoxelContourModel::VoxelContour& a = domContours->contours()[i];
+            const VoxelContourModel::VoxelContour& b = streamingContours->contours()[i];
+            if (!equal(a.normal, b.normal) || !equal(a.distance, b.distance)) {
+                return "plane of contour " + std::to_string(i);
+            }
+            if (!equal(a.aabb.min, b.aabb.min) || !equal(a.aabb.max, b.aabb.max)) {
+                return "AABB of contour " + std::to_string(i);
+            }
+            if (a.colorIndex != b.colorIndex) {
+                return "color index of contour " + std::to_string(i);
+            }
+        }
+        if (domContours->colors().size() != streamingContours->colors().size()) {
+            return "color count";
+        }
+        for (size_t i = 0; i < domContours->colors().size(); ++i) {
+            if (!equal(domContours->colors()[i], streamingContours->colors()[i])) {
+                return "color " + std::to_string(i);
+            }
+        }
+        return {};
+    }
+
+    return "proxy type";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 20;
+    std::vector<std::string> scenePaths {};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto& entry : std::filesystem::directory_iterator(arg)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                    scenePaths.push_back(entry.path().generic_string());
+                }
+            }
+        } else if (std::filesystem::is_regular_file(arg)) {
+            scenePaths.push_back(arg);
+        } else {
+            LogErrorAndExit("JsonParseBenchmark: '%s' is not an option, scene, or directory.\n", arg.c_str());
+        }
+    }
+
+    if (scenePaths.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator("assets/Scenes/eval")) {
+            scenePaths.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(scenePaths.begin(), scenePaths.end());
+
+    bool allMatching = true;
+    std::vector<std::string> proxyPaths {};
+
+    LogInfo("JsonParseBenchmark: scenes (median of %d iterations)\n", iterations);
+    for (const std::string& scenePath : scenePaths) {
+        std::optional<FileIO::MappedFile> file = FileIO::mapFile(scenePath);
+        if (!file.has_value()) {
+            LogError("JsonParseBenchmark: could not read '%s'.\n", scenePath.c_str());
+            continue;
+        }
+
+        auto domDescription = SceneFile::parse(file->begin(), file->end(), scenePath, JsonParser::Dom);
+        auto streamingDescription = SceneFile::parse(file->begin(), file->end(), scenePath, JsonParser::Streaming);
+        if (!domDescription.has_value() || !streamingDescription.has_value()) {
+            LogError("JsonParseBenchmark: the parsers don't agree on whether '%s' is valid!\n", scenePath.c_str());
+            allMatching = false;
+            continue;
+        }
+        if (std::string difference = findDifference(*domDescription, *streamingDescription); !difference.empty()) {
+            LogError("JsonParseBenchmark: the parsers don't agree on the %s of '%s'!\n", difference.c_str(), scenePath.c_str());
+            allMatching = false;
+            continue;
+        }
+
+        double domTime = timeIterations(iterations, [&]() { SceneFile::parse(file->begin(), file->end(), scenePath, JsonParser::Dom); });
+        double streamingTime = timeIterations(iterations, [&]() { SceneFile::parse(file->begin(), file->end(), scenePath, JsonParser::Streaming); });
+        printResult(scenePath, file->size(), domTime, streamingTime);
+
+        for (const SceneFile::ModelDescription& model : streamingDescription->models) {
+            if (ProxyFile::isJsonProxyPath(model.proxy) && FileIO::isFileReadable(model.proxy)
+                && std::find(proxyPaths.begin(), proxyPaths.end(), model.proxy) == proxyPaths.end()) {
+                proxyPaths.push_back(model.proxy);
+            }
+        }
+    }
+
+    LogInfo("JsonParseBenchmark: proxies (median of %d iterations)\n", iterations);
+    for (const std::string& proxyPath : proxyPaths) {
+        auto domProxy = ProxyFile::loadJson(proxyPath, JsonParser::Dom);
+        auto streamingProxy = ProxyFile::loadJson(proxyPath, JsonParser::Streaming);
+        if (!domProxy || !streamingProxy) {
+            LogError("JsonParseBenchmark: the parsers don't agree on whether '%s' is valid!\n", proxyPath.c_str());
+            allMatching = false;
+            continue;
+        }
+        if (std::string difference = findDifference(domProxy.get(), streamingProxy.get()); !difference.empty()) {
+            LogError("JsonParseBenchmark: the parsers don't agree on the %s of '%s'!\n", difference.c_str(), proxyPath.c_str());
+            allMatching = false;
+            continue;
+        }
+
+        double domTime = timeIterations(iterations, [&]() { ProxyFile::loadJson(proxyPath, JsonParser::Dom); });
+        double streamingTime = timeIterations(iterations, [&]() { ProxyFile::loadJson(proxyPath, JsonParser::Streaming); });
+        printResult(proxyPath, std::filesystem::file_size(proxyPath), domTime, streamingTime);
+    }
+
+    if (!allMatching) {
+        LogErrorAndExit("JsonParseBenchmark: the streaming & DOM parsers don't produce the same results!\n");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "utility/Logging.h"
+#include "utility/ProxyFile.h"
+#include "utility/ThreadPool.h"
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Offline proxy converter: converts sphere-set & voxel-contour proxies from JSON to the binary .proxy format, and
+// writes them next to the original files. Scene::loadProxy will then pick up the binary version instead.
+//
+//  usage: ProxyConverter [--force] <proxy json or directory>...
+//
+// Directories are searched recursively for files ending in _spheres.json or _contours.json.
+
+namespace {
+
+bool isProxyJson(const std::filesystem::path& path)
+{
+    std::string fileName = path.filename().string();
+    auto endsWith = [&](const std::string& suffix) {
+        return fileName.size() >= suffix.size() && fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith("_spheres.json") || endsWith("_contours.json");
+}
+
+bool convertProxy(const std::string& jsonPath, bool force)
+{
+    std::string binaryPath = ProxyFile::binaryPathForJson(jsonPath);
+    if (!force && ProxyFile::findConvertedProxy(jsonPath).has_value()) {
+        LogInfo("  %s (up to date)\n", jsonPath.c_str());
+        return true;
+    }
+
+    std::unique_ptr<Model> proxy = ProxyFile::loadJson(jsonPath);
+    if (!proxy) {
+        return false;
+    }
+
+    if (!ProxyFile::writeBinary(binaryPath, *proxy)) {
+        return false;
+    }
+
+    std::error_code error;
+    auto jsonSize = std::filesystem::file_size(jsonPath, error);
+    auto binarySize = std::filesystem::file_size(binaryPath, error);
+    LogInfo("  %s -> %s (%.1f kB -> %.1f kB)\n", jsonPath.c_str(), binaryPath.c_str(), jsonSize / 1024.0f, binarySize / 1024.0f);
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    bool force = false;
+    std::vector<std::string> jsonPaths {};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--force") {
+            force = true;
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(arg)) {
+                if (entry.is_regular_file() && isProxyJson(entry.path())) {
+                    jsonPaths.push_back(entry.path().generic_string());
+                }
+            }
+        } else if (std::filesystem::is_regular_file(arg)) {
+            jsonPaths.push_back(arg);
+        } else {
+            LogErrorAndExit("ProxyConverter: '%s' is not an option, proxy file, or directory.\n", arg.c_str());
+        }
+    }
+
+    if (jsonPaths.empty()) {
+        LogErrorAndExit("usage: ProxyConverter [--force] <proxy json or directory>...\n");
+    }
+
+    LogInfo("ProxyConverter: converting %u proxies\n", uint32_t(jsonPaths.size()));
+
+    // (every proxy is converted on its own worker thread)
+    std::vector<std::future<bool>> results {};
+    for (const std::string& jsonPath : jsonPaths) {
+        results.push_back(ThreadPool::global().enqueue([force, jsonPath]() {
+            return convertProxy(jsonPath, force);
+        }));
+    }
+
+    int failureCount = 0;
+    for (auto& result : results) {
+        if (!result.get()) {
+            failureCount += 1;
+        }
+    }
+
+    if (failureCount > 0) {
+        LogError("ProxyConverter: failed to convert %d of %u proxies.\n", failureCount, uint32_t(jsonPaths.size()));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
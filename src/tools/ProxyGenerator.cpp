@@ -0,0 +1,137 @@
+#include "utility/Logging.h"
+#include "utility/ProxyFile.h"
+#include "utility/ProxyGenerator.h"
+#include "utility/ThreadPool.h"
+#include "utility/models/GltfModel.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Generates sphere-set & voxel-contour proxies for a glTF model (see ProxyGenerator) at one or more primitive budgets,
+// and writes them as binary .proxy files which can be used as the "proxy" of the model in the scene files. Everything
+// that doesn't depend on the budget is only done once, so sweeping over many budgets is fast, e.g.
+//
+//  ProxyGenerator --spheres 8,16,32,64 --contours 500,1000,2000,4000 assets/Bunny/bunny_lowres.gltf
+//
+// writes assets/Bunny/bunny_lowres_spheres_8.proxy etc. The colors are fitted to the base color of the model, so use a
+// model with a baked color texture (e.g. the lowres versions of the models in the assets). To measure the error of the
+// proxies, see the ReferenceRenderer & ContourOptimizer tools.
+//
+//  usage: ProxyGenerator [--spheres N,..] [--contours N,..] [--samples N] [--resolution N] [--colors N] [--seed N]
+//                        [--output-dir dir] <model gltf>
+
+namespace {
+
+std::vector<uint32_t> parseBudgets(const char* list)
+{
+    std::vector<uint32_t> budgets {};
+    std::stringstream stream { list };
+    std::string budget;
+    while (std::getline(stream, budget, ',')) {
+        int value = std::atoi(budget.c_str());
+        if (value <= 0) {
+            LogErrorAndExit("ProxyGenerator: invalid budget '%s', expected e.g. 500,1000,2000.\n", budget.c_str());
+        }
+        budgets.push_back(uint32_t(value));
+    }
+    return budgets;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    ProxyGenerator::Settings settings {};
+    std::vector<uint32_t> sphereBudgets {};
+    std::vector<uint32_t> contourBudgets {};
+    std::string outputDirectory {};
+    std::string modelPath {};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--spheres" && i + 1 < argc) {
+            sphereBudgets = parseBudgets(argv[++i]);
+        } else if (arg == "--contours" && i + 1 < argc) {
+            contourBudgets = parseBudgets(argv[++i]);
+        } else if (arg == "--samples" && i + 1 < argc) {
+            settings.surfaceSampleCount = uint32_t(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--resolution" && i + 1 < argc) {
+            settings.volumeResolution = uint32_t(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--colors" && i + 1 < argc) {
+            settings.contourColorCount = uint32_t(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            settings.seed = uint32_t(std::atoi(argv[++i]));
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            outputDirectory = argv[++i];
+        } else {
+            modelPath = arg;
+        }
+    }
+
+    if (modelPath.empty()) {
+        LogErrorAndExit("usage: ProxyGenerator [--spheres N,..] [--contours N,..] [--samples N] [--resolution N] [--colors N] [--seed N] [--output-dir dir] <model gltf>\n");
+    }
+    if (sphereBudgets.empty() && contourBudgets.empty()) {
+        sphereBudgets = { 32 };
+        contourBudgets = { 2000 };
+    }
+
+    std::filesystem::path basePath = modelPath;
+    if (!outputDirectory.empty()) {
+        basePath = std::filesystem::path(outputDirectory) / basePath.filename();
+    }
+    auto outputPath = [&](const char* type, uint32_t budget) {
+        std::filesystem::path path = basePath;
+        path.replace_filename(basePath.stem().string() + "_" + type + "_" + std::to_string(budget) + ".proxy");
+        return path.string();
+    };
+
+    std::unique_ptr<Model> model = GltfModel::load(modelPath);
+    if (!model) {
+        LogErrorAndExit("ProxyGenerator: could not load '%s'.\n", modelPath.c_str());
+    }
+
+    auto setupStart = std::chrono::steady_clock::now();
+    ProxyGenerator generator { *model, settings };
+    LogInfo("ProxyGenerator: '%s', setup in %.1f ms (%u threads, %u surface samples, up to %zu spheres)\n", modelPath.c_str(),
+            millisecondsSince(setupStart), ThreadPool::global().threadCount() + 1, settings.surfaceSampleCount, generator.maxSphereCount());
+
+    for (uint32_t budget : sphereBudgets) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<SphereSetModel> sphereSet = generator.generateSphereSet(budget);
+        double time = millisecondsSince(start);
+
+        std::string path = outputPath("spheres", budget);
+        if (!ProxyFile::writeBinary(path, *sphereSet)) {
+            LogErrorAndExit("ProxyGenerator: could not write '%s'.\n", path.c_str());
+        }
+        LogInfo("  %6u spheres  -> %6zu  in %8.1f ms  -> %s\n", budget, sphereSet->spheres().size(), time, path.c_str());
+    }
+
+    for (uint32_t budget : contourBudgets) {
+        auto start = std::chrono::steady_clock::now();
+        ProxyGenerator::ContourStatistics statistics {};
+        std::unique_ptr<VoxelContourModel> voxelContours = generator.generateVoxelContours(budget, &statistics);
+        double time = millisecondsSince(start);
+
+        std::string path = outputPath("contours", budget);
+        if (!ProxyFile::writeBinary(path, *voxelContours)) {
+            LogErrorAndExit("ProxyGenerator: could not write '%s'.\n", path.c_str());
+        }
+        LogInfo("  %6u contours -> %6zu  in %8.1f ms  -> %s  (resolution %u, voxel size %.4f, %zu before merging, %zu colors)\n",
+                budget, voxelContours->contours().size(), time, path.c_str(), statistics.resolution, statistics.voxelSize,
+                statistics.unmergedContours, voxelContours->colors().size());
+    }
+
+    return EXIT_SUCCESS;
+}
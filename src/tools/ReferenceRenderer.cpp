@@ -0,0 +1,114 @@
+#include "rendering/cpu/CpuReferenceRenderer.h"
+#include "utility/Logging.h"
+#include "utility/Scene.h"
+#include "utility/ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// Renders the diffuse GI of the main camera view with the CPU reference renderer (see CpuReferenceRenderer) and writes it
+// to a Radiance HDR image. With --compare it's rendered once with the meshes and once with the proxies, and the error of
+// the proxies is reported, which is what the reference is for. The output is the same for any number of threads.
+//
+//  usage: ReferenceRenderer [--size WxH] [--spp N] [--proxies | --compare] [--ignore-color] [--no-shadows]
+//                           [--output path.hdr] [scene]
+//
+// Run it from the root of the repo, since that's what the paths in the scene files are relative to.
+
+namespace {
+
+CpuReferenceRenderer::Result renderAndWrite(const Scene& scene, bool useProxies, Extent2D size, const CpuReferenceRenderer::Settings& settings, const std::string& outputPath)
+{
+    auto setupStart = std::chrono::steady_clock::now();
+    CpuReferenceRenderer renderer { scene, useProxies };
+    double setupTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+
+    auto renderStart = std::chrono::steady_clock::now();
+    CpuReferenceRenderer::Result result = renderer.render(size, settings);
+    double renderTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+
+    LogInfo("  %-8s setup %6.2f s  render %8.2f s  (%.2f Mrays/s)  -> %s\n", useProxies ? "proxies" : "meshes",
+            setupTime, renderTime, result.rayCount / (renderTime * 1'000'000.0), outputPath.c_str());
+
+    if (!CpuReferenceRenderer::writeHdrImage(outputPath, result)) {
+        LogErrorAndExit("ReferenceRenderer: could not write image '%s'.\n", outputPath.c_str());
+    }
+
+    return result;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Extent2D size { 640, 360 };
+    CpuReferenceRenderer::Settings settings {};
+    bool useProxies = false;
+    bool compare = false;
+    std::string outputPath = "reference.hdr";
+    std::string scenePath = "assets/Scenes/eval/bunny_test.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            int width, height;
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                LogErrorAndExit("ReferenceRenderer: invalid size '%s', expected e.g. 640x360.\n", argv[i]);
+            }
+            size = Extent2D(width, height);
+        } else if (arg == "--spp" && i + 1 < argc) {
+            settings.samplesPerPixel = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--proxies") {
+            useProxies = true;
+        } else if (arg == "--compare") {
+            compare = true;
+        } else if (arg == "--ignore-color") {
+            settings.ignoreColor = true;
+        } else if (arg == "--no-shadows") {
+            settings.shadows = false;
+        } else {
+            scenePath = arg;
+        }
+    }
+
+    std::unique_ptr<Scene> scene = Scene::loadFromFile(scenePath);
+
+    uint32_t passCount = (settings.samplesPerPixel + CpuReferenceRenderer::samplesPerPass - 1) / CpuReferenceRenderer::samplesPerPass;
+    LogInfo("ReferenceRenderer: '%s' at %ux%u, %u SPP (%u threads)\n", scenePath.c_str(), size.width(), size.height(),
+            passCount * CpuReferenceRenderer::samplesPerPass, ThreadPool::global().threadCount() + 1);
+
+    if (!compare) {
+        renderAndWrite(*scene, useProxies, size, settings, outputPath);
+        return EXIT_SUCCESS;
+    }
+
+    std::filesystem::path proxyOutputPath = outputPath;
+    proxyOutputPath.replace_filename(proxyOutputPath.stem().string() + "_proxies" + proxyOutputPath.extension().string());
+
+    CpuReferenceRenderer::Result meshResult = renderAndWrite(*scene, false, size, settings, outputPath);
+    CpuReferenceRenderer::Result proxyResult = renderAndWrite(*scene, true, size, settings, proxyOutputPath.string());
+
+    // Error of the proxies, relative to the mean luminance of the reference so it's comparable between scenes
+    double squaredErrorSum = 0.0;
+    double absoluteErrorSum = 0.0;
+    double luminanceSum = 0.0;
+    for (size_t i = 0; i < meshResult.pixels.size(); ++i) {
+        vec3 difference = proxyResult.pixels[i] - meshResult.pixels[i];
+        float differenceLuminance = dot(difference, vec3(0.2126f, 0.7152f, 0.0722f));
+        squaredErrorSum += differenceLuminance * differenceLuminance;
+        absoluteErrorSum += std::abs(differenceLuminance);
+        luminanceSum += dot(meshResult.pixels[i], vec3(0.2126f, 0.7152f, 0.0722f));
+    }
+
+    double pixelCount = double(meshResult.pixels.size());
+    double meanLuminance = std::max(luminanceSum / pixelCount, 1e-9);
+    LogInfo("  proxy error: RMSE %.5f (%.2f%% of the mean luminance), mean absolute error %.5f (%.2f%%)\n",
+            std::sqrt(squaredErrorSum / pixelCount), 100.0 * std::sqrt(squaredErrorSum / pixelCount) / meanLuminance,
+            absoluteErrorSum / pixelCount, 100.0 * (absoluteErrorSum / pixelCount) / meanLuminance);
+
+    return EXIT_SUCCESS;
+}
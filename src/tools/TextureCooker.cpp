@@ -0,0 +1,190 @@
+#include "utility/BlockCompression.h"
+#include "utility/DDSFile.h"
+#include "utility/Image.h"
+#include "utility/Logging.h"
+#include "utility/MipGenerator.h"
+#include "utility/ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Offline texture cooker: generates all mip levels for the given images, block compresses them, and writes them next to
+// the original images as .dds files. Registry::loadTexture2D will then pick up the cooked version instead.
+//
+//  usage: TextureCooker [--format bc1|bc3|bc5|bc7] [--srgb|--linear] [--normal-map] [--force] <image or directory>...
+//
+// Unless specified, the format & color space is guessed from the file name (normal maps to BC5, data textures such as
+// metallic-roughness as linear BC7, and everything else as sRGB BC7). Directories are searched recursively.
+
+namespace {
+
+struct CookSettings {
+    std::optional<BlockCompression::Format> format {};
+    std::optional<bool> srgb {};
+    bool normalMap { false };
+    bool force { false };
+};
+
+std::string lowercase(std::string string)
+{
+    std::transform(string.begin(), string.end(), string.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    return string;
+}
+
+bool isCookableImage(const std::filesystem::path& path)
+{
+    std::string extension = lowercase(path.extension().string());
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+bool nameContainsAny(const std::string& fileName, std::initializer_list<const char*> words)
+{
+    return std::any_of(words.begin(), words.end(), [&](const char* word) { return fileName.find(word) != std::string::npos; });
+}
+
+bool cookImage(const std::string& imagePath, const CookSettings& settings)
+{
+    std::string cookedPath = DDSFile::cookedPathForImage(imagePath);
+    if (!settings.force && DDSFile::findCookedImage(imagePath).has_value()) {
+        LogInfo("  %s (up to date)\n", imagePath.c_str());
+        return true;
+    }
+
+    std::optional<Image::Info> info = Image::probe(imagePath);
+    if (!info.has_value()) {
+        LogError("TextureCooker: could not read image '%s'.\n", imagePath.c_str());
+        return false;
+    }
+    if (info->isHdr) {
+        LogError("TextureCooker: '%s' is an HDR image, which can't be block compressed to any of the supported formats.\n", imagePath.c_str());
+        return false;
+    }
+
+    std::string fileName = lowercase(std::filesystem::path(imagePath).filename().string());
+    bool normalMap = settings.normalMap || settings.format == BlockCompression::Format::BC5
+        || (!settings.format.has_value() && nameContainsAny(fileName, { "normal", "_nrm", "_n." }));
+    bool dataTexture = nameContainsAny(fileName, { "metal", "rough", "occlusion", "_orm", "_ao", "height", "mask" });
+    bool srgb = settings.srgb.value_or(!normalMap && !dataTexture);
+
+    BlockCompression::Format format = settings.format.value_or(normalMap ? BlockCompression::Format::BC5 : BlockCompression::Format::BC7);
+
+    MipGenerator::Options mipOptions {};
+    mipOptions.filter = MipGenerator::Filter::Kaiser;
+    if (normalMap) {
+        mipOptions.content = MipGenerator::Content::NormalMap;
+    } else {
+        mipOptions.content = srgb ? MipGenerator::Content::sRGBColor : MipGenerator::Content::LinearColor;
+    }
+
+    Image image = Image::load(imagePath, info.value(), 4);
+    if (!image.isValid()) {
+        return false;
+    }
+    Image mipmappedImage = MipGenerator::generate(image, mipOptions);
+
+    Image::Info compressedInfo = info.value();
+    compressedInfo.componentCount = (format == BlockCompression::Format::BC5) ? 2 : 4;
+    compressedInfo.blockFormat = format;
+    compressedInfo.mipLevelCount = uint32_t(mipmappedImage.mipLevels().size());
+
+    std::vector<Image::MipLevel> compressedLevels {};
+    size_t compressedDataSize = 0;
+    for (const Image::MipLevel& level : mipmappedImage.mipLevels()) {
+        compressedLevels.push_back({ .offset = compressedDataSize, .width = level.width, .height = level.height });
+        compressedDataSize += BlockCompression::compressedSize(format, level.width, level.height);
+    }
+
+    std::shared_ptr<void> compressedData = std::shared_ptr<void>(std::malloc(compressedDataSize), [](void* data) { std::free(data); });
+    for (size_t i = 0; i < compressedLevels.size(); ++i) {
+        const Image::MipLevel& level = mipmappedImage.mipLevels()[i];
+        const uint8_t* levelPixels = static_cast<const uint8_t*>(mipmappedImage.pixels()) + level.offset;
+        uint8_t* levelDestination = static_cast<uint8_t*>(compressedData.get()) + compressedLevels[i].offset;
+        BlockCompression::compress(format, levelPixels, level.width, level.height, levelDestination);
+    }
+
+    Image compressedImage { compressedInfo, compressedInfo.componentCount, std::move(compressedData), std::move(compressedLevels) };
+    if (!DDSFile::write(cookedPath, compressedImage, srgb)) {
+        return false;
+    }
+
+    size_t originalSize = mipmappedImage.pixelDataSize();
+    LogInfo("  %s -> %s (%s%s, %u levels, %.1f MB -> %.1f MB)\n", imagePath.c_str(), cookedPath.c_str(),
+            BlockCompression::formatName(format), srgb ? " sRGB" : "", compressedInfo.mipLevelCount,
+            originalSize / (1024.0f * 1024.0f), compressedImage.pixelDataSize() / (1024.0f * 1024.0f));
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    CookSettings settings {};
+    std::vector<std::string> imagePaths {};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            std::string formatName = lowercase(argv[++i]);
+            if (formatName == "bc1") {
+                settings.format = BlockCompression::Format::BC1;
+            } else if (formatName == "bc3") {
+                settings.format = BlockCompression::Format::BC3;
+            } else if (formatName == "bc5") {
+                settings.format = BlockCompression::Format::BC5;
+            } else if (formatName == "bc7") {
+                settings.format = BlockCompression::Format::BC7;
+            } else {
+                LogErrorAndExit("TextureCooker: unknown format '%s'.\n", formatName.c_str());
+            }
+        } else if (arg == "--srgb") {
+            settings.srgb = true;
+        } else if (arg == "--linear") {
+            settings.srgb = false;
+        } else if (arg == "--normal-map") {
+            settings.normalMap = true;
+        } else if (arg == "--force") {
+            settings.force = true;
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(arg)) {
+                if (entry.is_regular_file() && isCookableImage(entry.path())) {
+                    imagePaths.push_back(entry.path().generic_string());
+                }
+            }
+        } else if (std::filesystem::is_regular_file(arg)) {
+            imagePaths.push_back(arg);
+        } else {
+            LogErrorAndExit("TextureCooker: '%s' is not an option, image, or directory.\n", arg.c_str());
+        }
+    }
+
+    if (imagePaths.empty()) {
+        LogErrorAndExit("usage: TextureCooker [--format bc1|bc3|bc5|bc7] [--srgb|--linear] [--normal-map] [--force] <image or directory>...\n");
+    }
+
+    LogInfo("TextureCooker: cooking %u images\n", uint32_t(imagePaths.size()));
+
+    // (every image is cooked on its own worker thread)
+    std::vector<std::future<bool>> results {};
+    for (const std::string& imagePath : imagePaths) {
+        results.push_back(ThreadPool::global().enqueue([&settings, imagePath]() {
+            return cookImage(imagePath, settings);
+        }));
+    }
+
+    int failureCount = 0;
+    for (auto& result : results) {
+        if (!result.get()) {
+            failureCount += 1;
+        }
+    }
+
+    if (failureCount > 0) {
+        LogError("TextureCooker: failed to cook %d of %u images.\n", failureCount, uint32_t(imagePaths.size()));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
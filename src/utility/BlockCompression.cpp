@@ -0,0 +1,476 @@
+#include "BlockCompression.h"
+
+#include "utility/Logging.h"
+#include "utility/mathkit.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using namespace BlockCompression;
+
+// A 4x4 block of pixels with all components in [0, 255]
+struct PixelBlock {
+    vec4 pixels[16];
+};
+
+PixelBlock loadBlock(const uint8_t* rgbaPixels, int width, int height, int blockX, int blockY)
+{
+    PixelBlock block {};
+    for (int y = 0; y < 4; ++y) {
+        int pixelY = std::min(4 * blockY + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int pixelX = std::min(4 * blockX + x, width - 1);
+            const uint8_t* pixel = rgbaPixels + 4 * (size_t(pixelY) * width + pixelX);
+            block.pixels[4 * y + x] = vec4(pixel[0], pixel[1], pixel[2], pixel[3]);
+        }
+    }
+    return block;
+}
+
+// Finds the extent of the pixels along their principal axis, which is a good initial guess for the endpoints of
+// the line segment that all pixels in the block will be approximated with. Zero the channel mask to ignore channels.
+void principalAxisEndpoints(const PixelBlock& block, vec4 channelMask, vec4& outStart, vec4& outEnd)
+{
+    vec4 mean { 0.0f };
+    vec4 minPixel { 255.0f };
+    vec4 maxPixel { 0.0f };
+    for (const vec4& pixel : block.pixels) {
+        vec4 masked = pixel * channelMask;
+        mean += masked;
+        minPixel = glm::min(minPixel, masked);
+        maxPixel = glm::max(maxPixel, masked);
+    }
+    mean /= 16.0f;
+
+    mat4 covariance { 0.0f };
+    for (const vec4& pixel : block.pixels) {
+        vec4 delta = pixel * channelMask - mean;
+        covariance += glm::outerProduct(delta, delta);
+    }
+
+    // Power iteration, starting from the diagonal of the bounding box which is usually very close to the axis already
+    vec4 axis = maxPixel - minPixel;
+    if (glm::dot(axis, axis) < 1e-6f) {
+        outStart = mean;
+        outEnd = mean;
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        vec4 nextAxis = covariance * axis;
+        float lengthSquared = glm::dot(nextAxis, nextAxis);
+        if (lengthSquared < 1e-12f) {
+            break;
+        }
+        axis = nextAxis / std::sqrt(lengthSquared);
+    }
+    axis = glm::normalize(axis);
+
+    float minT = std::numeric_limits<float>::max();
+    float maxT = std::numeric_limits<float>::lowest();
+    for (const vec4& pixel : block.pixels) {
+        float t = glm::dot(pixel * channelMask - mean, axis);
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    outStart = glm::clamp(mean + minT * axis, vec4(0.0f), vec4(255.0f));
+    outEnd = glm::clamp(mean + maxT * axis, vec4(0.0f), vec4(255.0f));
+}
+
+// Given the current index assignment (as interpolation factors between the two endpoints), solves for the endpoints
+// that minimize the squared error, i.e. a least squares fit. Returns false if the system is degenerate.
+bool leastSquaresEndpoints(const PixelBlock& block, vec4 channelMask, const float factors[16], vec4& outStart, vec4& outEnd)
+{
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    vec4 ax { 0.0f }, bx { 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        float b = factors[i];
+        float a = 1.0f - b;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        ax += a * block.pixels[i] * channelMask;
+        bx += b * block.pixels[i] * channelMask;
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+
+    outStart = glm::clamp((ax * bb - bx * ab) / determinant, vec4(0.0f), vec4(255.0f));
+    outEnd = glm::clamp((bx * aa - ax * ab) / determinant, vec4(0.0f), vec4(255.0f));
+    return true;
+}
+
+float squaredDistance(vec4 a, vec4 b, vec4 channelMask)
+{
+    vec4 delta = (a - b) * channelMask;
+    return glm::dot(delta, delta);
+}
+
+void writeLittleEndian(uint8_t* destination, uint64_t value, int byteCount)
+{
+    for (int i = 0; i < byteCount; ++i) {
+        destination[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+//
+// BC1
+//
+
+uint16_t packRGB565(vec4 color)
+{
+    uint16_t r = static_cast<uint16_t>(std::round(color.r * 31.0f / 255.0f));
+    uint16_t g = static_cast<uint16_t>(std::round(color.g * 63.0f / 255.0f));
+    uint16_t b = static_cast<uint16_t>(std::round(color.b * 31.0f / 255.0f));
+    return (r << 11) | (g << 5) | b;
+}
+
+vec4 unpackRGB565(uint16_t packed)
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    return vec4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0.0f);
+}
+
+struct BC1Fit {
+    uint16_t color0;
+    uint16_t color1;
+    uint8_t indices[16];
+    float error;
+};
+
+BC1Fit fitBC1(const PixelBlock& block, vec4 start, vec4 end)
+{
+    const vec4 rgbMask { 1.0f, 1.0f, 1.0f, 0.0f };
+
+    BC1Fit fit {};
+    fit.color0 = packRGB565(end);
+    fit.color1 = packRGB565(start);
+
+    // Always use the four color mode (color0 > color1), which is also the only mode allowed in BC3
+    if (fit.color0 < fit.color1) {
+        std::swap(fit.color0, fit.color1);
+    }
+
+    vec4 palette[4];
+    palette[0] = unpackRGB565(fit.color0);
+    palette[1] = unpackRGB565(fit.color1);
+    palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+    palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+
+    int paletteSize = (fit.color0 == fit.color1) ? 1 : 4;
+
+    for (int i = 0; i < 16; ++i) {
+        float bestDistance = std::numeric_limits<float>::max();
+        for (int p = 0; p < paletteSize; ++p) {
+            float distance = squaredDistance(block.pixels[i], palette[p], rgbMask);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                fit.indices[i] = uint8_t(p);
+            }
+        }
+        fit.error += bestDistance;
+    }
+
+    return fit;
+}
+
+void encodeBC1(const PixelBlock& block, uint8_t* destination)
+{
+    const vec4 rgbMask { 1.0f, 1.0f, 1.0f, 0.0f };
+
+    vec4 start, end;
+    principalAxisEndpoints(block, rgbMask, start, end);
+    BC1Fit fit = fitBC1(block, start, end);
+
+    // (one round of least squares refinement of the endpoints usually gives a noticeable improvement)
+    constexpr float indexFactors[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float factors[16];
+    bool color0IsEnd = packRGB565(end) == fit.color0;
+    for (int i = 0; i < 16; ++i) {
+        factors[i] = color0IsEnd ? indexFactors[fit.indices[i]] : 1.0f - indexFactors[fit.indices[i]];
+    }
+    if (leastSquaresEndpoints(block, rgbMask, factors, start, end)) {
+        BC1Fit refinedFit = fitBC1(block, start, end);
+        if (refinedFit.error < fit.error) {
+            fit = refinedFit;
+        }
+    }
+
+    uint32_t indexBits = 0;
+    for (int i = 0; i < 16; ++i) {
+        indexBits |= uint32_t(fit.indices[i]) << (2 * i);
+    }
+
+    writeLittleEndian(destination + 0, fit.color0, 2);
+    writeLittleEndian(destination + 2, fit.color1, 2);
+    writeLittleEndian(destination + 4, indexBits, 4);
+}
+
+//
+// BC4 (one channel, used as the alpha block of BC3 and for both channels of BC5)
+//
+
+void encodeBC4(const float values[16], uint8_t* destination)
+{
+    float minValue = *std::min_element(values, values + 16);
+    float maxValue = *std::max_element(values, values + 16);
+
+    // Always use the eight value mode (value0 > value1)
+    int value0 = int(std::round(maxValue));
+    int value1 = int(std::round(minValue));
+
+    uint64_t indexBits = 0;
+    if (value0 != value1) {
+        float palette[8];
+        palette[0] = float(value0);
+        palette[1] = float(value1);
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = float((8 - i) * value0 + (i - 1) * value1) / 7.0f;
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            uint64_t bestIndex = 0;
+            float bestDistance = std::numeric_limits<float>::max();
+            for (int p = 0; p < 8; ++p) {
+                float distance = std::abs(values[i] - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indexBits |= bestIndex << (3 * i);
+        }
+    }
+
+    destination[0] = uint8_t(value0);
+    destination[1] = uint8_t(value1);
+    writeLittleEndian(destination + 2, indexBits, 6);
+}
+
+void encodeBC4Channel(const PixelBlock& block, int channel, uint8_t* destination)
+{
+    float values[16];
+    for (int i = 0; i < 16; ++i) {
+        values[i] = block.pixels[i][channel];
+    }
+    encodeBC4(values, destination);
+}
+
+//
+// BC7 (always mode 6, i.e. a single RGBA line segment with 7777.1 endpoints and 4-bit indices)
+//
+
+constexpr int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BC7Endpoint {
+    int values[4]; // 7 bits each
+    int pBit;
+
+    [[nodiscard]] vec4 decoded() const
+    {
+        return vec4((values[0] << 1) | pBit, (values[1] << 1) | pBit, (values[2] << 1) | pBit, (values[3] << 1) | pBit);
+    }
+};
+
+BC7Endpoint quantizeBC7Endpoint(vec4 endpoint)
+{
+    BC7Endpoint best {};
+    float bestError = std::numeric_limits<float>::max();
+
+    for (int pBit = 0; pBit <= 1; ++pBit) {
+        BC7Endpoint candidate {};
+        candidate.pBit = pBit;
+        for (int c = 0; c < 4; ++c) {
+            candidate.values[c] = std::clamp(int(std::round((endpoint[c] - float(pBit)) / 2.0f)), 0, 127);
+        }
+
+        float error = squaredDistance(candidate.decoded(), endpoint, vec4(1.0f));
+        if (error < bestError) {
+            bestError = error;
+            best = candidate;
+        }
+    }
+
+    return best;
+}
+
+struct BC7Fit {
+    BC7Endpoint endpoint0;
+    BC7Endpoint endpoint1;
+    uint8_t indices[16];
+    float error;
+};
+
+BC7Fit fitBC7(const PixelBlock& block, vec4 start, vec4 end)
+{
+    BC7Fit fit {};
+    fit.endpoint0 = quantizeBC7Endpoint(start);
+    fit.endpoint1 = quantizeBC7Endpoint(end);
+
+    vec4 decoded0 = fit.endpoint0.decoded();
+    vec4 decoded1 = fit.endpoint1.decoded();
+
+    vec4 palette[16];
+    for (int p = 0; p < 16; ++p) {
+        int weight = BC7Weights[p];
+        for (int c = 0; c < 4; ++c) {
+            palette[p][c] = float(((64 - weight) * int(decoded0[c]) + weight * int(decoded1[c]) + 32) >> 6);
+        }
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        float bestDistance = std::numeric_limits<float>::max();
+        for (int p = 0; p < 16; ++p) {
+            float distance = squaredDistance(block.pixels[i], palette[p], vec4(1.0f));
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                fit.indices[i] = uint8_t(p);
+            }
+        }
+        fit.error += bestDistance;
+    }
+
+    return fit;
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* destination)
+        : m_destination(destination)
+    {
+    }
+
+    void write(uint32_t value, int bitCount)
+    {
+        for (int i = 0; i < bitCount; ++i, ++m_bitPosition) {
+            m_destination[m_bitPosition / 8] |= uint8_t(((value >> i) & 1u) << (m_bitPosition % 8));
+        }
+    }
+
+private:
+    uint8_t* m_destination;
+    int m_bitPosition { 0 };
+};
+
+void encodeBC7(const PixelBlock& block, uint8_t* destination)
+{
+    vec4 start, end;
+    principalAxisEndpoints(block, vec4(1.0f), start, end);
+    BC7Fit fit = fitBC7(block, start, end);
+
+    float factors[16];
+    for (int i = 0; i < 16; ++i) {
+        factors[i] = float(BC7Weights[fit.indices[i]]) / 64.0f;
+    }
+    if (leastSquaresEndpoints(block, vec4(1.0f), factors, start, end)) {
+        BC7Fit refinedFit = fitBC7(block, start, end);
+        if (refinedFit.error < fit.error) {
+            fit = refinedFit;
+        }
+    }
+
+    // The most significant bit of the first index is implicitly zero, so swap the endpoints if needed
+    if (fit.indices[0] >= 8) {
+        std::swap(fit.endpoint0, fit.endpoint1);
+        for (uint8_t& index : fit.indices) {
+            index = 15 - index;
+        }
+    }
+
+    std::memset(destination, 0, 16);
+    BitWriter writer { destination };
+
+    writer.write(1u << 6, 7); // (mode 6)
+    for (int c = 0; c < 4; ++c) {
+        writer.write(fit.endpoint0.values[c], 7);
+        writer.write(fit.endpoint1.values[c], 7);
+    }
+    writer.write(fit.endpoint0.pBit, 1);
+    writer.write(fit.endpoint1.pBit, 1);
+
+    writer.write(fit.indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.write(fit.indices[i], 4);
+    }
+}
+
+}
+
+namespace BlockCompression {
+
+const char* formatName(Format format)
+{
+    switch (format) {
+    case Format::BC1:
+        return "BC1";
+    case Format::BC3:
+        return "BC3";
+    case Format::BC5:
+        return "BC5";
+    case Format::BC7:
+        return "BC7";
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+size_t blockSize(Format format)
+{
+    switch (format) {
+    case Format::BC1:
+        return 8;
+    case Format::BC3:
+    case Format::BC5:
+    case Format::BC7:
+        return 16;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+size_t compressedSize(Format format, int width, int height)
+{
+    size_t blockCountX = (size_t(width) + 3) / 4;
+    size_t blockCountY = (size_t(height) + 3) / 4;
+    return blockCountX * blockCountY * blockSize(format);
+}
+
+void compress(Format format, const uint8_t* rgbaPixels, int width, int height, uint8_t* destination)
+{
+    int blockCountX = (width + 3) / 4;
+    int blockCountY = (height + 3) / 4;
+    size_t size = blockSize(format);
+
+    for (int blockY = 0; blockY < blockCountY; ++blockY) {
+        for (int blockX = 0; blockX < blockCountX; ++blockX) {
+
+            PixelBlock block = loadBlock(rgbaPixels, width, height, blockX, blockY);
+            uint8_t* blockDestination = destination + (size_t(blockY) * blockCountX + blockX) * size;
+
+            switch (format) {
+            case Format::BC1:
+                encodeBC1(block, blockDestination);
+                break;
+            case Format::BC3:
+                encodeBC4Channel(block, 3, blockDestination);
+                encodeBC1(block, blockDestination + 8);
+                break;
+            case Format::BC5:
+                encodeBC4Channel(block, 0, blockDestination);
+                encodeBC4Channel(block, 1, blockDestination + 8);
+                break;
+            case Format::BC7:
+                encodeBC7(block, blockDestination);
+                break;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Encoders for the BCn block compressed texture formats. All formats encode blocks of 4x4 pixels, and the input is
+// always 8-bit RGBA. Used by the texture cooker, since the encoding is way too slow to do at load time.
+namespace BlockCompression {
+
+enum class Format {
+    BC1, // RGB, 4 bpp
+    BC3, // RGBA, 8 bpp
+    BC5, // RG (e.g. normal maps), 8 bpp
+    BC7, // RGBA, 8 bpp (better quality than BC1 & BC3)
+};
+
+const char* formatName(Format);
+
+size_t blockSize(Format);
+size_t compressedSize(Format, int width, int height);
+
+// Compresses the RGBA8 image into blocks (in row major order). Edge blocks of images with a size not divisible by four
+// get their missing pixels from clamping to the edge of the image.
+void compress(Format, const uint8_t* rgbaPixels, int width, int height, uint8_t* destination);
+
+}
@@ -0,0 +1,328 @@
+#include "DDSFile.h"
+
+#include "utility/Logging.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+using BlockCompression::Format;
+
+constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+{
+    return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+constexpr uint32_t DDSMagic = makeFourCC('D', 'D', 'S', ' ');
+
+constexpr uint32_t DDSD_CAPS = 0x1;
+constexpr uint32_t DDSD_HEIGHT = 0x2;
+constexpr uint32_t DDSD_WIDTH = 0x4;
+constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+
+constexpr uint32_t DDPF_FOURCC = 0x4;
+
+constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+constexpr uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+constexpr uint32_t D3D10_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+enum DXGIFormat : uint32_t {
+    DXGI_FORMAT_BC1_UNORM = 71,
+    DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+    DXGI_FORMAT_BC3_UNORM = 77,
+    DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+    DXGI_FORMAT_BC5_UNORM = 83,
+    DXGI_FORMAT_BC7_UNORM = 98,
+    DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+};
+
+struct DDSPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DDSHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDSPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DDSHeaderDX10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DDSHeader) == 124);
+static_assert(sizeof(DDSHeaderDX10) == 20);
+
+std::optional<Format> formatFromDXGI(uint32_t dxgiFormat)
+{
+    switch (dxgiFormat) {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+        return Format::BC1;
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+        return Format::BC3;
+    case DXGI_FORMAT_BC5_UNORM:
+        return Format::BC5;
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return Format::BC7;
+    default:
+        return {};
+    }
+}
+
+bool isSrgbDXGI(uint32_t dxgiFormat)
+{
+    return dxgiFormat == DXGI_FORMAT_BC1_UNORM_SRGB || dxgiFormat == DXGI_FORMAT_BC3_UNORM_SRGB || dxgiFormat == DXGI_FORMAT_BC7_UNORM_SRGB;
+}
+
+uint32_t dxgiFromFormat(Format format, bool srgb)
+{
+    switch (format) {
+    case Format::BC1:
+        return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+    case Format::BC3:
+        return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+    case Format::BC5:
+        return DXGI_FORMAT_BC5_UNORM;
+    case Format::BC7:
+        return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+int componentCountForFormat(Format format)
+{
+    return (format == Format::BC5) ? 2 : 4;
+}
+
+// Reads the headers and leaves the stream at the start of the pixel data
+std::optional<Image::Info> readHeaders(std::ifstream& file, const std::string& path)
+{
+    uint32_t magic;
+    DDSHeader header {};
+    if (!file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != DDSMagic
+        || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.size != sizeof(DDSHeader)) {
+        LogError("DDSFile: '%s' is not a valid DDS file.\n", path.c_str());
+        return {};
+    }
+
+    if (header.caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) {
+        LogError("DDSFile: '%s' is a cube map or volume texture, which is not supported.\n", path.c_str());
+        return {};
+    }
+
+    std::optional<Format> format {};
+    std::optional<bool> isSrgb {};
+    if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == makeFourCC('D', 'X', '1', '0')) {
+        DDSHeaderDX10 headerDX10 {};
+        if (!file.read(reinterpret_cast<char*>(&headerDX10), sizeof(headerDX10))) {
+            LogError("DDSFile: '%s' is not a valid DDS file.\n", path.c_str());
+            return {};
+        }
+        if (headerDX10.resourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || headerDX10.arraySize > 1
+            || (headerDX10.miscFlag & D3D10_RESOURCE_MISC_TEXTURECUBE)) {
+            LogError("DDSFile: '%s' is not a plain 2D texture, which is not supported.\n", path.c_str());
+            return {};
+        }
+        format = formatFromDXGI(headerDX10.dxgiFormat);
+        isSrgb = isSrgbDXGI(headerDX10.dxgiFormat);
+    } else if (header.pixelFormat.flags & DDPF_FOURCC) {
+        // (legacy four character codes, as written by most older tools)
+        switch (header.pixelFormat.fourCC) {
+        case makeFourCC('D', 'X', 'T', '1'):
+            format = Format::BC1;
+            break;
+        case makeFourCC('D', 'X', 'T', '5'):
+            format = Format::BC3;
+            break;
+        case makeFourCC('A', 'T', 'I', '2'):
+        case makeFourCC('B', 'C', '5', 'U'):
+            format = Format::BC5;
+            break;
+        }
+    }
+
+    if (!format.has_value()) {
+        LogError("DDSFile: '%s' is not in any of the supported formats (BC1, BC3, BC5, BC7).\n", path.c_str());
+        return {};
+    }
+
+    Image::Info info {};
+    info.width = int(header.width);
+    info.height = int(header.height);
+    info.componentCount = componentCountForFormat(format.value());
+    info.isHdr = false;
+    info.blockFormat = format;
+    info.isSrgb = isSrgb;
+    info.mipLevelCount = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mipMapCount) : 1;
+    return info;
+}
+
+}
+
+namespace DDSFile {
+
+bool isDDSPath(const std::string& path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".dds" || extension == ".DDS";
+}
+
+std::string cookedPathForImage(const std::string& imagePath)
+{
+    return std::filesystem::path(imagePath).replace_extension(".dds").string();
+}
+
+std::optional<std::string> findCookedImage(const std::string& imagePath)
+{
+    if (isDDSPath(imagePath)) {
+        return {};
+    }
+
+    std::string cookedPath = cookedPathForImage(imagePath);
+
+    std::error_code error;
+    if (!std::filesystem::exists(cookedPath, error)) {
+        return {};
+    }
+
+    auto imageWriteTime = std::filesystem::last_write_time(imagePath, error);
+    if (!error) {
+        auto cookedWriteTime = std::filesystem::last_write_time(cookedPath, error);
+        if (error || cookedWriteTime < imageWriteTime) {
+            LogWarning("DDSFile: cooked texture '%s' is out of date, using the original image. Run the texture cooker again!\n", cookedPath.c_str());
+            return {};
+        }
+    }
+
+    return cookedPath;
+}
+
+std::optional<Image::Info> probe(const std::string& path)
+{
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open()) {
+        return {};
+    }
+    return readHeaders(file, path);
+}
+
+Image load(const std::string& path, const Image::Info& expectedInfo)
+{
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open()) {
+        LogError("DDSFile: could not open '%s'.\n", path.c_str());
+        return {};
+    }
+
+    std::optional<Image::Info> info = readHeaders(file, path);
+    if (!info.has_value()) {
+        return {};
+    }
+    if (info->width != expectedInfo.width || info->height != expectedInfo.height || info->blockFormat != expectedInfo.blockFormat
+        || info->mipLevelCount != expectedInfo.mipLevelCount) {
+        LogError("DDSFile: the file at '%s' has changed since it was probed.\n", path.c_str());
+        return {};
+    }
+
+    BlockCompression::Format format = info->blockFormat.value();
+
+    std::vector<Image::MipLevel> mipLevels {};
+    size_t dataSize = 0;
+    int width = info->width;
+    int height = info->height;
+    for (uint32_t level = 0; level < info->mipLevelCount; ++level) {
+        mipLevels.push_back({ .offset = dataSize, .width = width, .height = height });
+        dataSize += BlockCompression::compressedSize(format, width, height);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    std::shared_ptr<void> data = std::shared_ptr<void>(std::malloc(dataSize), [](void* data) { std::free(data); });
+    if (!data || !file.read(static_cast<char*>(data.get()), dataSize)) {
+        LogError("DDSFile: could not read the contents of '%s'.\n", path.c_str());
+        return {};
+    }
+
+    return Image(info.value(), info->componentCount, std::move(data), std::move(mipLevels));
+}
+
+bool write(const std::string& path, const Image& image, bool srgb)
+{
+    ASSERT(image.isBlockCompressed());
+    BlockCompression::Format format = image.info().blockFormat.value();
+    uint32_t mipLevelCount = uint32_t(image.mipLevels().size());
+
+    DDSHeader header {};
+    header.size = sizeof(DDSHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = uint32_t(image.info().height);
+    header.width = uint32_t(image.info().width);
+    header.pitchOrLinearSize = uint32_t(image.mipLevelDataSize(image.mipLevels().front()));
+    header.mipMapCount = mipLevelCount;
+    header.pixelFormat.size = sizeof(DDSPixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+    header.caps = DDSCAPS_TEXTURE;
+    if (mipLevelCount > 1) {
+        header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+
+    DDSHeaderDX10 headerDX10 {};
+    headerDX10.dxgiFormat = dxgiFromFormat(format, srgb);
+    headerDX10.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+    headerDX10.arraySize = 1;
+
+    std::ofstream file { path, std::ios::binary | std::ios::trunc };
+    if (!file.is_open()) {
+        LogError("DDSFile: could not create '%s'.\n", path.c_str());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&DDSMagic), sizeof(DDSMagic));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+    file.write(static_cast<const char*>(image.pixels()), image.pixelDataSize());
+
+    if (!file.good()) {
+        LogError("DDSFile: could not write '%s'.\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "utility/Image.h"
+#include <optional>
+#include <string>
+
+// Reading & writing of block compressed textures (with all their mip levels) in the DDS container format. Only 2D
+// textures in the BCn formats of BlockCompression are supported, written with the DX10 header extension.
+namespace DDSFile {
+
+bool isDDSPath(const std::string& path);
+
+// The path where the texture cooker puts the cooked version of the image, i.e. the same path but with a .dds extension
+std::string cookedPathForImage(const std::string& imagePath);
+
+// Returns the path of the cooked version of the image, if it exists and is newer than the image itself
+std::optional<std::string> findCookedImage(const std::string& imagePath);
+
+std::optional<Image::Info> probe(const std::string& path);
+Image load(const std::string& path, const Image::Info&);
+
+// Writes a block compressed image with all its mip levels. The sRGB flag is stored in the DXGI format, and is read back
+// into Image::Info::isSrgb when probing or loading the file.
+bool write(const std::string& path, const Image&, bool srgb);
+
+}
@@ -1,48 +1,200 @@
 #include "FileIO.h"
 
-#include <fstream>
+#include "utility/ThreadPool.h"
+#include <cstdio>
+#include <utility>
 
-std::optional<FileIO::BinaryData> FileIO::readEntireFileAsByteBuffer(const std::string& filePath)
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Reads the whole file with a single read into the given (resizable) container
+template<typename Container>
+std::optional<Container> readFileInto(const std::string& filePath)
 {
-    // Open file as binary and immediately seek to the end
-    std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+    FILE* file = std::fopen(filePath.c_str(), "rb");
+    if (!file) {
+        return {};
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    long sizeInBytes = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
 
-    if (!file.is_open())
+    if (sizeInBytes < 0) {
+        std::fclose(file);
         return {};
+    }
+
+    Container contents {};
+    contents.resize(size_t(sizeInBytes));
+    size_t readBytes = std::fread(contents.data(), 1, contents.size(), file);
+    std::fclose(file);
 
-    size_t sizeInBytes = file.tellg();
-    FileIO::BinaryData binaryData(sizeInBytes);
+    if (readBytes != contents.size()) {
+        return {};
+    }
+    return contents;
+}
 
-    file.seekg(0);
-    file.read(binaryData.data(), sizeInBytes);
+}
 
-    file.close();
-    return binaryData;
+std::optional<FileIO::BinaryData> FileIO::readEntireFileAsByteBuffer(const std::string& filePath)
+{
+    return readFileInto<FileIO::BinaryData>(filePath);
 }
 
 std::optional<std::string> FileIO::readEntireFile(const std::string& filePath)
 {
-    // Open file as binary and immediately seek to the end
-    std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+    return readFileInto<std::string>(filePath);
+}
+
+bool FileIO::isFileReadable(const std::string& filePath)
+{
+    // (checks the permissions without actually opening the file)
+#ifdef _WIN32
+    return _access(filePath.c_str(), 4) == 0;
+#else
+    return access(filePath.c_str(), R_OK) == 0;
+#endif
+}
+
+FileIO::MappedFile::~MappedFile()
+{
+    release();
+}
+
+FileIO::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+FileIO::MappedFile& FileIO::MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+        m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void FileIO::MappedFile::release()
+{
+#ifdef _WIN32
+    // (empty files have no mapping, see mapFile)
+    if (m_mappingHandle) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mappingHandle);
+    }
+    m_mappingHandle = nullptr;
+#else
+    if (m_data && m_size > 0) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+std::optional<FileIO::MappedFile> FileIO::mapFile(const std::string& filePath)
+{
+    MappedFile mappedFile {};
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return {};
+    }
 
-    if (!file.is_open())
+    LARGE_INTEGER fileSize {};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
         return {};
+    }
 
-    std::string contents {};
+    // (empty files can't be mapped, but that's still a successful read)
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        static const char emptyFile[1] = {};
+        mappedFile.m_data = emptyFile;
+        return mappedFile;
+    }
 
-    size_t sizeInBytes = file.tellg();
-    contents.reserve(sizeInBytes);
-    file.seekg(0, std::ios::beg);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // (the mapping keeps its own reference to the file)
+    if (!mapping) {
+        return {};
+    }
 
-    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return {};
+    }
 
-    file.close();
-    return contents;
+    mappedFile.m_mappingHandle = mapping;
+    mappedFile.m_data = static_cast<const char*>(view);
+    mappedFile.m_size = size_t(fileSize.QuadPart);
+#else
+    int file = open(filePath.c_str(), O_RDONLY);
+    if (file == -1) {
+        return {};
+    }
+
+    struct stat fileStatus {};
+    if (fstat(file, &fileStatus) != 0 || !S_ISREG(fileStatus.st_mode)) {
+        close(file);
+        return {};
+    }
+
+    // (empty files can't be mapped, but that's still a successful read)
+    if (fileStatus.st_size == 0) {
+        close(file);
+        static const char emptyFile[1] = {};
+        mappedFile.m_data = emptyFile;
+        return mappedFile;
+    }
+
+    void* view = mmap(nullptr, size_t(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file); // (the mapping keeps its own reference to the file)
+    if (view == MAP_FAILED) {
+        return {};
+    }
+
+    // All our files are parsed front to back, so let the kernel read ahead aggressively
+    madvise(view, size_t(fileStatus.st_size), MADV_SEQUENTIAL);
+
+    mappedFile.m_data = static_cast<const char*>(view);
+    mappedFile.m_size = size_t(fileStatus.st_size);
+#endif
+
+    return mappedFile;
 }
 
-bool FileIO::isFileReadable(const std::string& filePath)
+std::vector<std::future<std::optional<FileIO::BinaryData>>> FileIO::readFilesAsync(const std::vector<std::string>& filePaths)
 {
-    std::ifstream file(filePath);
-    bool isGood = file.good();
-    return isGood;
+    std::vector<std::future<std::optional<BinaryData>>> results {};
+    results.reserve(filePaths.size());
+
+    for (const std::string& filePath : filePaths) {
+        results.push_back(ThreadPool::global().enqueue([filePath]() {
+            return readEntireFileAsByteBuffer(filePath);
+        }));
+    }
+
+    return results;
 }
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <future>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace FileIO {
@@ -13,4 +16,43 @@ std::optional<std::string> readEntireFile(const std::string& filePath);
 
 bool isFileReadable(const std::string& filePath);
 
+// Read-only memory mapped view of an entire file, so that parsers (stb_image, json, etc.) can read straight from the
+// page cache without first copying everything into a buffer. The mapping is released when the object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&&) noexcept;
+    MappedFile& operator=(MappedFile&&) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+
+    std::string_view text() const { return { m_data, m_size }; }
+
+private:
+    friend std::optional<MappedFile> mapFile(const std::string&);
+    void release();
+
+    const char* m_data { nullptr };
+    size_t m_size { 0 };
+
+#ifdef _WIN32
+    void* m_mappingHandle { nullptr };
+#endif
+};
+
+// (an empty file maps to a valid but empty view)
+std::optional<MappedFile> mapFile(const std::string& filePath);
+
+// Reads all the files on the global thread pool and returns one future per file, in the same order as the paths, so
+// that loaders can kick off all their reads at once and only wait when they actually need the data.
+std::vector<std::future<std::optional<BinaryData>>> readFilesAsync(const std::vector<std::string>& filePaths);
+
 }
@@ -0,0 +1,161 @@
+#include "HdrEncoding.h"
+
+#include "utility/Logging.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace {
+
+constexpr float maxHalfValue = 65504.0f;
+
+// Converts four floats to halfs at once (rounding to nearest even). For normal halfs, multiplying by 2^-112 rebiases the
+// exponent from float to half, so we only have to round the mantissa. For denormal halfs we instead add 0.5, which puts
+// the half's denormal mantissa in the low bits of the float (and lets the FPU do the rounding).
+__m128i floatToHalf4(__m128 value)
+{
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000u)));
+    const __m128 rebias = _mm_castsi128_ps(_mm_set1_epi32(15 << 23)); // 2^-112
+    const __m128 denormalMagic = _mm_set1_ps(0.5f);
+    const __m128 minNormalHalf = _mm_set1_ps(6.103515625e-05f); // 2^-14
+
+    __m128 absValue = _mm_andnot_ps(signMask, value);
+    absValue = _mm_min_ps(absValue, _mm_set1_ps(maxHalfValue)); // (also maps NaN to max, since the second operand is returned)
+
+    __m128i bits = _mm_castps_si128(_mm_mul_ps(absValue, rebias));
+    __m128i roundingBias = _mm_add_epi32(_mm_set1_epi32(0x0fff), _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1)));
+    __m128i normal = _mm_srli_epi32(_mm_add_epi32(bits, roundingBias), 13);
+
+    __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absValue, denormalMagic)), _mm_castps_si128(denormalMagic));
+
+    __m128i isDenormal = _mm_castps_si128(_mm_cmplt_ps(absValue, minNormalHalf));
+    __m128i half = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+
+    __m128i sign = _mm_srli_epi32(_mm_castps_si128(_mm_and_ps(value, signMask)), 16);
+    return _mm_or_si128(half, sign);
+}
+
+uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float exp2i(int exponent)
+{
+    // (only valid for exponents in the normal float range, which is always the case here)
+    uint32_t bits = uint32_t(exponent + 127) << 23;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+namespace HdrEncoding {
+
+uint16_t packHalf(float value)
+{
+    __m128i half = floatToHalf4(_mm_set1_ps(value));
+    return uint16_t(_mm_cvtsi128_si32(half));
+}
+
+uint32_t packRGB9E5(float r, float g, float b)
+{
+    // See the EXT_texture_shared_exponent spec
+    constexpr int mantissaBits = 9;
+    constexpr int exponentBias = 15;
+    constexpr float maxValue = (511.0f / 512.0f) * 65536.0f;
+
+    // (written so that NaN ends up as zero)
+    r = (r > 0.0f) ? std::min(r, maxValue) : 0.0f;
+    g = (g > 0.0f) ? std::min(g, maxValue) : 0.0f;
+    b = (b > 0.0f) ? std::min(b, maxValue) : 0.0f;
+    float maxComponent = std::max({ r, g, b });
+
+    // floor(log2(maxComponent)) straight from the float exponent (zero & denormals give -127, which is clamped anyway)
+    int floorLog2 = int((floatBits(maxComponent) >> 23) & 0xff) - 127;
+    int sharedExponent = std::max(-exponentBias - 1, floorLog2) + 1 + exponentBias;
+
+    // Rounding can overflow the mantissa, and then we need one more step of exponent
+    float scale = exp2i(mantissaBits + exponentBias - sharedExponent);
+    if (uint32_t(maxComponent * scale + 0.5f) == (1u << mantissaBits)) {
+        sharedExponent += 1;
+        scale *= 0.5f;
+    }
+
+    uint32_t rm = uint32_t(r * scale + 0.5f);
+    uint32_t gm = uint32_t(g * scale + 0.5f);
+    uint32_t bm = uint32_t(b * scale + 0.5f);
+    return rm | (gm << 9) | (bm << 18) | (uint32_t(sharedExponent) << 27);
+}
+
+Image encode(const Image& image, Image::HdrFormat format)
+{
+    // (pass on failed loads as they are, so the error is reported by whoever uses the image)
+    if (!image.isValid() || format == Image::HdrFormat::Float32) {
+        return image;
+    }
+
+    ASSERT(image.info().isHdr && image.info().hdrFormat == Image::HdrFormat::Float32);
+    ASSERT(image.componentCount() == 4);
+
+    Image::Info info = image.info();
+    info.hdrFormat = format;
+    int componentCount = (format == Image::HdrFormat::RGB9E5) ? 3 : 4;
+    size_t bytesPerPixel = (format == Image::HdrFormat::RGB9E5) ? sizeof(uint32_t) : 4 * sizeof(uint16_t);
+
+    std::vector<Image::MipLevel> mipLevels {};
+    size_t dataSize = 0;
+    for (const Image::MipLevel& level : image.mipLevels()) {
+        mipLevels.push_back({ .offset = dataSize, .width = level.width, .height = level.height });
+        dataSize += size_t(level.width) * size_t(level.height) * bytesPerPixel;
+    }
+
+    std::shared_ptr<void> data = std::shared_ptr<void>(std::malloc(dataSize), [](void* data) { std::free(data); });
+
+    for (size_t levelIndex = 0; levelIndex < mipLevels.size(); ++levelIndex) {
+        const Image::MipLevel& level = image.mipLevels()[levelIndex];
+        const float* source = reinterpret_cast<const float*>(static_cast<const uint8_t*>(image.pixels()) + level.offset);
+        uint8_t* destination = static_cast<uint8_t*>(data.get()) + mipLevels[levelIndex].offset;
+        size_t pixelCount = size_t(level.width) * size_t(level.height);
+
+        switch (format) {
+        case Image::HdrFormat::Float16: {
+            // (two pixels at a time, packed into one register)
+            auto* destinationHalfs = reinterpret_cast<uint16_t*>(destination);
+            size_t pixel = 0;
+            for (; pixel + 2 <= pixelCount; pixel += 2) {
+                __m128i first = floatToHalf4(_mm_loadu_ps(source + 4 * pixel));
+                __m128i second = floatToHalf4(_mm_loadu_ps(source + 4 * pixel + 4));
+                // (sign extend so the signed saturating pack keeps all 16 bits as they are)
+                first = _mm_srai_epi32(_mm_slli_epi32(first, 16), 16);
+                second = _mm_srai_epi32(_mm_slli_epi32(second, 16), 16);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destinationHalfs + 4 * pixel), _mm_packs_epi32(first, second));
+            }
+            for (; pixel < pixelCount; ++pixel) {
+                for (int c = 0; c < 4; ++c) {
+                    destinationHalfs[4 * pixel + c] = packHalf(source[4 * pixel + c]);
+                }
+            }
+            break;
+        }
+        case Image::HdrFormat::RGB9E5: {
+            auto* destinationPacked = reinterpret_cast<uint32_t*>(destination);
+            for (size_t pixel = 0; pixel < pixelCount; ++pixel) {
+                const float* rgba = source + 4 * pixel;
+                destinationPacked[pixel] = packRGB9E5(rgba[0], rgba[1], rgba[2]);
+            }
+            break;
+        }
+        default:
+            ASSERT_NOT_REACHED();
+        }
+    }
+
+    return Image { info, componentCount, std::move(data), std::move(mipLevels) };
+}
+
+}
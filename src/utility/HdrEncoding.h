@@ -0,0 +1,18 @@
+#pragma once
+
+#include "utility/Image.h"
+#include <cstdint>
+
+// Packing of float HDR images to the more compact formats of Image::HdrFormat, to save memory & bandwidth when sampling
+// e.g. environment maps. Both formats can store values up to ~65k, but RGB9E5 can't store alpha or negative values.
+namespace HdrEncoding {
+
+// (values out of range are clamped to the largest representable value, and negative values to zero for RGB9E5)
+uint16_t packHalf(float);
+uint32_t packRGB9E5(float r, float g, float b);
+
+// Returns a copy of the four component float image (including all its mip levels) packed to the given format. Invalid
+// images are returned as they are.
+Image encode(const Image&, Image::HdrFormat);
+
+}
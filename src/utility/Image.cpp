@@ -0,0 +1,126 @@
+#include "Image.h"
+
+#include "utility/DDSFile.h"
+#include "utility/FileIO.h"
+#include "utility/Logging.h"
+#include "utility/ThreadPool.h"
+#include <stb_image.h>
+
+Image::Image(const Info& info, int componentCount, std::shared_ptr<void> pixels, std::vector<MipLevel> mipLevels)
+    : m_info(info)
+    , m_componentCount(componentCount)
+    , m_pixels(std::move(pixels))
+    , m_mipLevels(std::move(mipLevels))
+{
+}
+
+std::optional<Image::Info> Image::probe(const std::string& imagePath)
+{
+    if (DDSFile::isDDSPath(imagePath)) {
+        return DDSFile::probe(imagePath);
+    }
+
+    // (only the header is parsed, so only the first few pages of the mapping are ever read from disk)
+    std::optional<FileIO::MappedFile> file = FileIO::mapFile(imagePath);
+    if (!file.has_value()) {
+        return {};
+    }
+
+    auto* fileData = reinterpret_cast<const stbi_uc*>(file->data());
+    int fileSize = int(file->size());
+
+    Info info {};
+    int success = stbi_info_from_memory(fileData, fileSize, &info.width, &info.height, &info.componentCount);
+    info.isHdr = stbi_is_hdr_from_memory(fileData, fileSize);
+
+    if (!success) {
+        return {};
+    }
+    return info;
+}
+
+Image Image::load(const std::string& imagePath, const Info& info, int desiredComponentCount)
+{
+    if (info.blockFormat.has_value()) {
+        return DDSFile::load(imagePath, info);
+    }
+
+    Image image {};
+    image.m_info = info;
+    image.m_componentCount = desiredComponentCount;
+
+    // Decode straight from the mapped file, instead of having stb_image read it through its small stdio buffer
+    std::optional<FileIO::MappedFile> file = FileIO::mapFile(imagePath);
+    if (!file.has_value()) {
+        LogError("Image: could not open '%s'.\n", imagePath.c_str());
+        return image;
+    }
+
+    auto* fileData = reinterpret_cast<const stbi_uc*>(file->data());
+    int fileSize = int(file->size());
+
+    int width, height;
+    void* pixels;
+    if (info.isHdr) {
+        pixels = stbi_loadf_from_memory(fileData, fileSize, &width, &height, nullptr, desiredComponentCount);
+    } else {
+        pixels = stbi_load_from_memory(fileData, fileSize, &width, &height, nullptr, desiredComponentCount);
+    }
+
+    if (!pixels) {
+        LogError("Image: stb_image could not read the contents of '%s'.\n", imagePath.c_str());
+        return image;
+    }
+
+    if (width != info.width || height != info.height) {
+        LogError("Image: the image at '%s' does not match its own header.\n", imagePath.c_str());
+        stbi_image_free(pixels);
+        return image;
+    }
+
+    image.m_pixels = std::shared_ptr<void>(pixels, [](void* pixels) { stbi_image_free(pixels); });
+    image.m_mipLevels = { MipLevel { 0, width, height } };
+    return image;
+}
+
+std::shared_future<Image> Image::loadAsync(const std::string& imagePath, const Info& info, int desiredComponentCount)
+{
+    return ThreadPool::global().enqueue([=]() {
+        return Image::load(imagePath, info, desiredComponentCount);
+    });
+}
+
+size_t Image::bytesPerPixel() const
+{
+    if (!m_info.isHdr) {
+        return size_t(m_componentCount) * sizeof(stbi_uc);
+    }
+
+    switch (m_info.hdrFormat) {
+    case HdrFormat::Float32:
+        return size_t(m_componentCount) * sizeof(float);
+    case HdrFormat::Float16:
+        return size_t(m_componentCount) * sizeof(uint16_t);
+    case HdrFormat::RGB9E5:
+        return sizeof(uint32_t);
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+size_t Image::mipLevelDataSize(const MipLevel& level) const
+{
+    if (m_info.blockFormat.has_value()) {
+        return BlockCompression::compressedSize(m_info.blockFormat.value(), level.width, level.height);
+    }
+    return size_t(level.width) * size_t(level.height) * bytesPerPixel();
+}
+
+size_t Image::pixelDataSize() const
+{
+    if (m_mipLevels.empty()) {
+        return 0;
+    }
+    const MipLevel& lastLevel = m_mipLevels.back();
+    return lastLevel.offset + mipLevelDataSize(lastLevel);
+}
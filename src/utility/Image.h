@@ -0,0 +1,73 @@
+#pragma once
+
+#include "utility/BlockCompression.h"
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// CPU-side image data, decoded from an image file using stb_image, or block compressed data read from a DDS file
+class Image {
+public:
+    // HDR images are always decoded to 32-bit floats, but can be packed to a more compact format with HdrEncoding
+    enum class HdrFormat {
+        Float32, // RGBA32F
+        Float16, // RGBA16F
+        RGB9E5, // 9-bit mantissas with a shared 5-bit exponent, no alpha
+    };
+
+    struct Info {
+        int width { 0 };
+        int height { 0 };
+        int componentCount { 0 };
+        bool isHdr { false };
+        HdrFormat hdrFormat { HdrFormat::Float32 };
+
+        // (only set for block compressed images, which also always come with all their mip levels)
+        std::optional<BlockCompression::Format> blockFormat {};
+        uint32_t mipLevelCount { 1 };
+
+        // (only known for block compressed images with a DX10 header, which says if the data is sRGB or not)
+        std::optional<bool> isSrgb {};
+    };
+
+    // Reads only the image header, i.e. it's cheap compared to actually loading the image
+    static std::optional<Info> probe(const std::string& imagePath);
+
+    // Decodes the image with the given number of components per pixel, as 8-bit components or floats if HDR. Block
+    // compressed images are loaded as-is, so for those the component count is ignored.
+    static Image load(const std::string& imagePath, const Info&, int desiredComponentCount);
+
+    // Same as load(..) but the decoding happens on the global thread pool
+    static std::shared_future<Image> loadAsync(const std::string& imagePath, const Info&, int desiredComponentCount);
+
+    // All mip levels are stored in the same pixel data, tightly packed and one after the other
+    struct MipLevel {
+        size_t offset { 0 };
+        int width { 0 };
+        int height { 0 };
+    };
+
+    Image() = default;
+    Image(const Info&, int componentCount, std::shared_ptr<void> pixels, std::vector<MipLevel>);
+
+    [[nodiscard]] bool isValid() const { return m_pixels != nullptr; }
+
+    [[nodiscard]] const Info& info() const { return m_info; }
+    [[nodiscard]] int componentCount() const { return m_componentCount; }
+    [[nodiscard]] size_t bytesPerPixel() const;
+    [[nodiscard]] bool isBlockCompressed() const { return m_info.blockFormat.has_value(); }
+
+    [[nodiscard]] const std::vector<MipLevel>& mipLevels() const { return m_mipLevels; }
+    [[nodiscard]] size_t mipLevelDataSize(const MipLevel&) const;
+
+    [[nodiscard]] const void* pixels() const { return m_pixels.get(); }
+    [[nodiscard]] size_t pixelDataSize() const;
+
+private:
+    Info m_info {};
+    int m_componentCount { 0 };
+    std::shared_ptr<void> m_pixels {};
+    std::vector<MipLevel> m_mipLevels {};
+};
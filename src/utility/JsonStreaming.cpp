@@ -0,0 +1,159 @@
+#include "JsonStreaming.h"
+
+#include "utility/Logging.h"
+
+bool JsonStreamingParser::parse(const char* begin, const char* end, const std::string& nameForErrors)
+{
+    m_depth = 0;
+    m_error.clear();
+
+    if (!nlohmann::json::sax_parse(begin, end, this)) {
+        LogError("JsonStreamingParser: could not parse '%s': %s\n", nameForErrors.c_str(), m_error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool JsonStreamingParser::pathIs(std::initializer_list<std::string_view> pattern) const
+{
+    if (pattern.size() != m_depth) {
+        return false;
+    }
+
+    size_t level = 0;
+    for (std::string_view element : pattern) {
+        const PathElement& pathElement = m_path[level++];
+        if (element == "[]") {
+            if (!pathElement.inArray) {
+                return false;
+            }
+        } else if (pathElement.inArray || (element != "*" && element != pathElement.key)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const std::string& JsonStreamingParser::keyAt(size_t level) const
+{
+    ASSERT(level < m_depth && !m_path[level].inArray);
+    return m_path[level].key;
+}
+
+size_t JsonStreamingParser::indexAt(size_t level) const
+{
+    ASSERT(level < m_depth && m_path[level].inArray);
+    return m_path[level].index;
+}
+
+void JsonStreamingParser::push(bool isArray)
+{
+    // (keep popped elements around, so their key strings can be reused without reallocating)
+    if (m_depth == m_path.size()) {
+        m_path.emplace_back();
+    }
+
+    PathElement& element = m_path[m_depth++];
+    element.inArray = isArray;
+    element.index = 0;
+    element.key.clear();
+}
+
+void JsonStreamingParser::pop()
+{
+    ASSERT(m_depth > 0);
+    m_depth -= 1;
+}
+
+void JsonStreamingParser::advance()
+{
+    if (m_depth > 0 && m_path[m_depth - 1].inArray) {
+        m_path[m_depth - 1].index += 1;
+    }
+}
+
+bool JsonStreamingParser::null()
+{
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::boolean(bool value)
+{
+    onBool(value);
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::number_integer(number_integer_t value)
+{
+    onNumber(float(value));
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::number_unsigned(number_unsigned_t value)
+{
+    onNumber(float(value));
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::number_float(number_float_t value, const string_t&)
+{
+    onNumber(float(value));
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::string(string_t& value)
+{
+    onString(value);
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::start_object(std::size_t)
+{
+    onBeginObject();
+    push(false);
+    return true;
+}
+
+bool JsonStreamingParser::key(string_t& key)
+{
+    ASSERT(m_depth > 0);
+    m_path[m_depth - 1].key = key;
+    return true;
+}
+
+bool JsonStreamingParser::end_object()
+{
+    pop();
+    onEndObject();
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::start_array(std::size_t)
+{
+    onBeginArray();
+    push(true);
+    return true;
+}
+
+bool JsonStreamingParser::end_array()
+{
+    pop();
+    onEndArray();
+    advance();
+    return true;
+}
+
+bool JsonStreamingParser::parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& exception)
+{
+    m_error = exception.what();
+    return false;
+}
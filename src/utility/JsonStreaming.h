@@ -0,0 +1,71 @@
+#pragma once
+
+#include <initializer_list>
+#include <json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// How to parse the JSON files. The DOM parser is still around for the benchmark (see tools/JsonParseBenchmark.cpp) and
+// for comparing results, but everything loads with the streaming parser by default.
+enum class JsonParser {
+    Streaming,
+    Dom,
+};
+
+// Base for SAX style (streaming) parsing with nlohmann::json, for loading straight into our own structures without first
+// building a full DOM of the file. The parser keeps track of the path to the current value, so that subclasses only have
+// to match on it, e.g. the number at spheres[3].center[1] has the path { "spheres", 3, "center", 1 }, which matches
+// the pattern { "spheres", "[]", "center", "[]" }. (Path elements are reused, so there are no allocations per value.)
+class JsonStreamingParser : public nlohmann::json_sax<nlohmann::json> {
+public:
+    // Returns false (and logs an error) if the document couldn't be parsed
+    bool parse(const char* begin, const char* end, const std::string& nameForErrors);
+
+    // (nlohmann::json_sax interface, which sax_parse requires to be public)
+    bool null() override;
+    bool boolean(bool) override;
+    bool number_integer(number_integer_t) override;
+    bool number_unsigned(number_unsigned_t) override;
+    bool number_float(number_float_t, const string_t&) override;
+    bool string(string_t&) override;
+    bool start_object(std::size_t) override;
+    bool key(string_t&) override;
+    bool end_object() override;
+    bool start_array(std::size_t) override;
+    bool end_array() override;
+    bool parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception&) override;
+
+protected:
+    // The value callbacks are called with the path of the value, and the container callbacks with the path of the
+    // container itself (i.e. not including any of its children)
+    virtual void onNumber(float) { }
+    virtual void onString(const std::string&) { }
+    virtual void onBool(bool) { }
+    virtual void onBeginObject() { }
+    virtual void onEndObject() { }
+    virtual void onBeginArray() { }
+    virtual void onEndArray() { }
+
+    // Patterns are matched element by element, where "[]" matches any array index and "*" matches any object key
+    bool pathIs(std::initializer_list<std::string_view> pattern) const;
+
+    size_t depth() const { return m_depth; }
+    const std::string& keyAt(size_t level) const;
+    size_t indexAt(size_t level) const;
+
+private:
+    struct PathElement {
+        bool inArray;
+        size_t index;
+        std::string key;
+    };
+
+    void push(bool isArray);
+    void pop();
+    void advance();
+
+    std::vector<PathElement> m_path {};
+    size_t m_depth { 0 };
+    std::string m_error {};
+};
@@ -0,0 +1,746 @@
+#include "MeshOptimizer.h"
+
+#include "utility/Logging.h"
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+// FIFO cache simulation, using timestamps so that resetting is just a matter of bumping the time
+class FifoCache {
+public:
+    FifoCache(size_t vertexCount, uint32_t cacheSize)
+        : m_timestamps(vertexCount, 0)
+        , m_cacheSize(cacheSize)
+        , m_time(cacheSize + 1)
+    {
+    }
+
+    // Returns the number of cache misses for the triangle
+    uint32_t processTriangle(uint32_t a, uint32_t b, uint32_t c)
+    {
+        return processVertex(a) + processVertex(b) + processVertex(c);
+    }
+
+    void reset()
+    {
+        m_time += m_cacheSize + 1;
+    }
+
+private:
+    uint32_t processVertex(uint32_t v)
+    {
+        if (m_time - m_timestamps[v] > m_cacheSize) {
+            m_timestamps[v] = m_time++;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::vector<uint32_t> m_timestamps;
+    uint32_t m_cacheSize;
+    uint32_t m_time;
+};
+
+// Symmetric 4x4 error quadric, where only the upper triangle is stored
+struct Quadric {
+    double a00 { 0.0 }, a01 { 0.0 }, a02 { 0.0 }, a03 { 0.0 };
+    double a11 { 0.0 }, a12 { 0.0 }, a13 { 0.0 };
+    double a22 { 0.0 }, a23 { 0.0 };
+    double a33 { 0.0 };
+
+    static Quadric fromPlane(double a, double b, double c, double d)
+    {
+        Quadric q {};
+        q.a00 = a * a, q.a01 = a * b, q.a02 = a * c, q.a03 = a * d;
+        q.a11 = b * b, q.a12 = b * c, q.a13 = b * d;
+        q.a22 = c * c, q.a23 = c * d;
+        q.a33 = d * d;
+        return q;
+    }
+
+    void add(const Quadric& q)
+    {
+        a00 += q.a00, a01 += q.a01, a02 += q.a02, a03 += q.a03;
+        a11 += q.a11, a12 += q.a12, a13 += q.a13;
+        a22 += q.a22, a23 += q.a23;
+        a33 += q.a33;
+    }
+
+    // Sum of squared distances from the point to all planes of the quadric
+    double evaluate(vec3 p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+            + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+            + a22 * z * z + 2.0 * a23 * z
+            + a33;
+        return std::max(error, 0.0);
+    }
+};
+
+// Gathers all non-empty streams with the new vertex order, where remap[newIndex] = oldIndex
+void remapVertexStreams(MeshOptimizer::MeshData& mesh, const std::vector<uint32_t>& remap)
+{
+    auto remapStream = [&](auto& stream) {
+        if (stream.empty()) {
+            return;
+        }
+        using StreamType = std::remove_reference_t<decltype(stream)>;
+        StreamType newStream {};
+        newStream.reserve(remap.size());
+        for (uint32_t oldIndex : remap) {
+            newStream.push_back(stream[oldIndex]);
+        }
+        stream = std::move(newStream);
+    };
+
+    remapStream(mesh.positions);
+    remapStream(mesh.texcoords);
+    remapStream(mesh.normals);
+    remapStream(mesh.tangents);
+}
+
+}
+
+MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+    ASSERT(indices.size() % 3 == 0);
+    if (indices.empty()) {
+        return {};
+    }
+
+    FifoCache cache { vertexCount, cacheSize };
+    std::vector<bool> referenced(vertexCount, false);
+
+    size_t misses = 0;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        misses += cache.processTriangle(indices[i + 0], indices[i + 1], indices[i + 2]);
+        referenced[indices[i + 0]] = referenced[indices[i + 1]] = referenced[indices[i + 2]] = true;
+    }
+
+    size_t referencedCount = std::count(referenced.begin(), referenced.end(), true);
+
+    VertexCacheStatistics stats {};
+    stats.acmr = float(misses) / float(indices.size() / 3);
+    stats.atvr = float(misses) / float(referencedCount);
+    return stats;
+}
+
+void MeshOptimizer::deduplicateVertices(MeshData& mesh)
+{
+    size_t vertexCount = mesh.vertexCount();
+
+    auto bitwiseEqual = [](const auto& stream, uint32_t a, uint32_t b) -> bool {
+        if (stream.empty()) {
+            return true;
+        }
+        return std::memcmp(&stream[a], &stream[b], sizeof(stream[a])) == 0;
+    };
+
+    auto hashStream = [](const auto& stream, uint32_t v, size_t hash) -> size_t {
+        if (stream.empty()) {
+            return hash;
+        }
+        // FNV-1a over the raw bytes of the attribute
+        auto* bytes = reinterpret_cast<const uint8_t*>(&stream[v]);
+        for (size_t i = 0; i < sizeof(stream[v]); ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    };
+
+    auto vertexHash = [&](uint32_t v) -> size_t {
+        size_t hash = 14695981039346656037ull;
+        hash = hashStream(mesh.positions, v, hash);
+        hash = hashStream(mesh.texcoords, v, hash);
+        hash = hashStream(mesh.normals, v, hash);
+        hash = hashStream(mesh.tangents, v, hash);
+        return hash;
+    };
+
+    auto vertexEqual = [&](uint32_t a, uint32_t b) -> bool {
+        return bitwiseEqual(mesh.positions, a, b)
+            && bitwiseEqual(mesh.texcoords, a, b)
+            && bitwiseEqual(mesh.normals, a, b)
+            && bitwiseEqual(mesh.tangents, a, b);
+    };
+
+    std::unordered_set<uint32_t, decltype(vertexHash), decltype(vertexEqual)> uniqueVertices { vertexCount, vertexHash, vertexEqual };
+
+    std::vector<uint32_t> oldToNew(vertexCount, InvalidIndex);
+    std::vector<uint32_t> newToOld {};
+
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        auto [it, inserted] = uniqueVertices.insert(v);
+        if (inserted) {
+            oldToNew[v] = uint32_t(newToOld.size());
+            newToOld.push_back(v);
+        } else {
+            oldToNew[v] = oldToNew[*it];
+        }
+    }
+
+    if (newToOld.size() == vertexCount) {
+        return;
+    }
+
+    for (uint32_t& index : mesh.indices) {
+        index = oldToNew[index];
+    }
+    remapVertexStreams(mesh, newToOld);
+}
+
+void MeshOptimizer::optimizeVertexCache(MeshData& mesh)
+{
+    size_t vertexCount = mesh.vertexCount();
+    size_t triangleCount = mesh.triangleCount();
+    const std::vector<uint32_t>& indices = mesh.indices;
+
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Scoring constants from the original article
+    constexpr int maxCacheSize = 32;
+    constexpr float cacheDecayPower = 1.5f;
+    constexpr float lastTriangleScore = 0.75f;
+    constexpr float valenceBoostScale = 2.0f;
+    constexpr float valenceBoostPower = 0.5f;
+
+    auto vertexScore = [&](int cachePosition, uint32_t activeTriangles) -> float {
+        if (activeTriangles == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                score = lastTriangleScore;
+            } else {
+                float scaler = 1.0f / float(maxCacheSize - 3);
+                score = std::pow(1.0f - float(cachePosition - 3) * scaler, cacheDecayPower);
+            }
+        }
+        score += valenceBoostScale * std::pow(float(activeTriangles), -valenceBoostPower);
+        return score;
+    };
+
+    // Build vertex -> triangle adjacency (CSR-style)
+    std::vector<uint32_t> activeTriangles(vertexCount, 0);
+    for (uint32_t index : indices) {
+        activeTriangles[index] += 1;
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[3 * t + k];
+                adjacency[fill[v]++] = t;
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScores[v] = vertexScore(-1, activeTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScores[t] = vertexScores[indices[3 * t + 0]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+    }
+
+    std::vector<uint32_t> newIndices {};
+    newIndices.reserve(indices.size());
+
+    std::vector<uint32_t> cache {};
+    std::vector<uint32_t> newCache {};
+    cache.reserve(maxCacheSize + 3);
+    newCache.reserve(maxCacheSize + 3);
+
+    uint32_t bestTriangle = uint32_t(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    size_t inputCursor = 0;
+
+    for (size_t emitCount = 0; emitCount < triangleCount; ++emitCount) {
+
+        // If no triangle is adjacent to the cache just pick the next one in input order (this is what makes it linear time)
+        if (bestTriangle == InvalidIndex) {
+            while (emitted[inputCursor]) {
+                inputCursor += 1;
+            }
+            bestTriangle = uint32_t(inputCursor);
+        }
+
+        const uint32_t* tri = &indices[3 * bestTriangle];
+        newIndices.insert(newIndices.end(), tri, tri + 3);
+        emitted[bestTriangle] = true;
+
+        // Remove triangle from the active adjacency of its vertices
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+            uint32_t* end = begin + activeTriangles[v];
+            uint32_t* it = std::find(begin, end, bestTriangle);
+            ASSERT(it != end);
+            std::swap(*it, *(end - 1));
+            activeTriangles[v] -= 1;
+        }
+
+        // Push the triangle's vertices to the front of the LRU cache
+        newCache.clear();
+        newCache.insert(newCache.end(), tri, tri + 3);
+        for (uint32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache.push_back(v);
+            }
+        }
+        std::swap(cache, newCache);
+
+        for (size_t i = 0; i < cache.size(); ++i) {
+            uint32_t v = cache[i];
+            cachePosition[v] = (i < maxCacheSize) ? int(i) : -1;
+            vertexScores[v] = vertexScore(cachePosition[v], activeTriangles[v]);
+        }
+
+        // Update scores of all triangles touched by the cache and find the best candidate among them
+        bestTriangle = InvalidIndex;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t i = 0; i < activeTriangles[v]; ++i) {
+                uint32_t t = adjacency[adjacencyOffsets[v] + i];
+                float score = vertexScores[indices[3 * t + 0]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (cache.size() > maxCacheSize) {
+            cache.resize(maxCacheSize);
+        }
+    }
+
+    mesh.indices = std::move(newIndices);
+}
+
+void MeshOptimizer::optimizeOverdraw(MeshData& mesh, float threshold)
+{
+    size_t vertexCount = mesh.vertexCount();
+    size_t triangleCount = mesh.triangleCount();
+    const std::vector<uint32_t>& indices = mesh.indices;
+
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // This is a variant of Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw":
+    // split the cache optimized index buffer into clusters where the cache is naturally flushed anyway, and
+    // then sort these clusters so that ones facing away from the center of the mesh are drawn first.
+
+    constexpr uint32_t cacheSize = 16;
+    FifoCache cache { vertexCount, cacheSize };
+
+    // Hard boundaries, i.e. where all three vertices missed the cache
+    std::vector<uint32_t> hardClusters {};
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        uint32_t misses = cache.processTriangle(indices[3 * t + 0], indices[3 * t + 1], indices[3 * t + 2]);
+        if (t == 0 || misses == 3) {
+            hardClusters.push_back(t);
+        }
+    }
+
+    // Soft boundaries, i.e. split the hard clusters further where we can do so without hurting the ACMR too much
+    std::vector<uint32_t> clusters {};
+    for (size_t i = 0; i < hardClusters.size(); ++i) {
+        uint32_t start = hardClusters[i];
+        uint32_t end = (i + 1 < hardClusters.size()) ? hardClusters[i + 1] : uint32_t(triangleCount);
+
+        cache.reset();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            clusterMisses += cache.processTriangle(indices[3 * t + 0], indices[3 * t + 1], indices[3 * t + 2]);
+        }
+        float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+        cache.reset();
+        clusters.push_back(start);
+        uint32_t clusterStart = start;
+        uint32_t misses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            misses += cache.processTriangle(indices[3 * t + 0], indices[3 * t + 1], indices[3 * t + 2]);
+            float runningAcmr = float(misses) / float(t - clusterStart + 1);
+            if (runningAcmr <= clusterThreshold && t + 1 < end) {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                misses = 0;
+                cache.reset();
+            }
+        }
+    }
+
+    // (only over the referenced vertices, since e.g. the LODs use a subset of the vertices of the full mesh)
+    std::vector<bool> isReferenced(vertexCount, false);
+    for (uint32_t index : indices) {
+        isReferenced[index] = true;
+    }
+    vec3 meshCentroid { 0.0f };
+    size_t referencedVertexCount = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (isReferenced[v]) {
+            meshCentroid += mesh.positions[v];
+            referencedVertexCount += 1;
+        }
+    }
+    meshCentroid /= float(referencedVertexCount);
+
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        uint32_t start = clusters[i];
+        uint32_t end = (i + 1 < clusters.size()) ? clusters[i + 1] : uint32_t(triangleCount);
+
+        vec3 centroid { 0.0f };
+        vec3 areaNormal { 0.0f };
+        float totalArea = 0.0f;
+
+        for (uint32_t t = start; t < end; ++t) {
+            const vec3& a = mesh.positions[indices[3 * t + 0]];
+            const vec3& b = mesh.positions[indices[3 * t + 1]];
+            const vec3& c = mesh.positions[indices[3 * t + 2]];
+
+            vec3 normal = glm::cross(b - a, c - a);
+            float area = glm::length(normal);
+
+            centroid += (a + b + c) * (area / 3.0f);
+            areaNormal += normal;
+            totalArea += area;
+        }
+
+        if (totalArea > 0.0f) {
+            centroid /= totalArea;
+        }
+
+        float normalLength = glm::length(areaNormal);
+        if (normalLength > 0.0f) {
+            areaNormal /= normalLength;
+        }
+
+        sortKeys[i] = glm::dot(centroid - meshCentroid, areaNormal);
+    }
+
+    std::vector<uint32_t> clusterOrder(clusters.size());
+    for (uint32_t i = 0; i < clusterOrder.size(); ++i) {
+        clusterOrder[i] = i;
+    }
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return sortKeys[lhs] > sortKeys[rhs];
+    });
+
+    std::vector<uint32_t> newIndices {};
+    newIndices.reserve(indices.size());
+    for (uint32_t clusterIdx : clusterOrder) {
+        uint32_t start = clusters[clusterIdx];
+        uint32_t end = (clusterIdx + 1 < clusters.size()) ? clusters[clusterIdx + 1] : uint32_t(triangleCount);
+        newIndices.insert(newIndices.end(), indices.begin() + 3 * start, indices.begin() + 3 * end);
+    }
+
+    mesh.indices = std::move(newIndices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData& mesh)
+{
+    std::vector<uint32_t> oldToNew(mesh.vertexCount(), InvalidIndex);
+    std::vector<uint32_t> newToOld {};
+    newToOld.reserve(mesh.vertexCount());
+
+    for (uint32_t& index : mesh.indices) {
+        if (oldToNew[index] == InvalidIndex) {
+            oldToNew[index] = uint32_t(newToOld.size());
+            newToOld.push_back(index);
+        }
+        index = oldToNew[index];
+    }
+
+    remapVertexStreams(mesh, newToOld);
+}
+
+void MeshOptimizer::optimize(MeshData& mesh, const std::string& debugName)
+{
+    size_t vertexCountBefore = mesh.vertexCount();
+    VertexCacheStatistics before = analyzeVertexCache(mesh.indices, mesh.vertexCount());
+
+    deduplicateVertices(mesh);
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+
+    VertexCacheStatistics after = analyzeVertexCache(mesh.indices, mesh.vertexCount());
+
+    LogInfo("MeshOptimizer: '%s' (%u triangles): vertices %u -> %u, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+            debugName.c_str(), uint32_t(mesh.triangleCount()),
+            uint32_t(vertexCountBefore), uint32_t(mesh.vertexCount()),
+            before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+MeshOptimizer::SimplifiedIndices MeshOptimizer::simplify(const std::vector<vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError)
+{
+    ASSERT(indices.size() % 3 == 0);
+    size_t vertexCount = positions.size();
+    size_t triangleCount = indices.size() / 3;
+
+    if (indices.size() <= targetIndexCount) {
+        return { .indices = indices, .error = 0.0f };
+    }
+
+    // Weld vertices with identical positions so the mesh is treated as connected over uv & normal seams. All topology
+    // below is in terms of these canonical vertices, while the triangles keep referencing the actual vertices.
+    std::vector<uint32_t> canonical(vertexCount);
+    std::vector<uint32_t> copyCount(vertexCount, 0);
+    {
+        auto positionHash = [&](uint32_t v) -> size_t {
+            uint32_t bits[3];
+            std::memcpy(bits, &positions[v], sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        };
+        auto positionEqual = [&](uint32_t a, uint32_t b) -> bool {
+            return std::memcmp(&positions[a], &positions[b], sizeof(vec3)) == 0;
+        };
+        std::unordered_set<uint32_t, decltype(positionHash), decltype(positionEqual)> uniquePositions { vertexCount, positionHash, positionEqual };
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            uint32_t canonicalVertex = *uniquePositions.insert(v).first;
+            canonical[v] = canonicalVertex;
+            copyCount[canonicalVertex] += 1;
+        }
+    }
+
+    std::vector<uint32_t> triangles = indices;
+    std::vector<bool> triangleRemoved(triangleCount, false);
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+    size_t liveIndexCount = 0;
+
+    std::unordered_map<uint64_t, uint32_t> edgeUseCount {};
+    auto edgeKey = [](uint32_t a, uint32_t b) -> uint64_t {
+        return (uint64_t(std::min(a, b)) << 32u) | uint64_t(std::max(a, b));
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        uint32_t c0 = canonical[triangles[3 * t + 0]];
+        uint32_t c1 = canonical[triangles[3 * t + 1]];
+        uint32_t c2 = canonical[triangles[3 * t + 2]];
+        if (c0 == c1 || c1 == c2 || c2 == c0) {
+            triangleRemoved[t] = true;
+            continue;
+        }
+        liveIndexCount += 3;
+
+        vertexTriangles[c0].push_back(uint32_t(t));
+        vertexTriangles[c1].push_back(uint32_t(t));
+        vertexTriangles[c2].push_back(uint32_t(t));
+
+        edgeUseCount[edgeKey(c0, c1)] += 1;
+        edgeUseCount[edgeKey(c1, c2)] += 1;
+        edgeUseCount[edgeKey(c2, c0)] += 1;
+
+        vec3 p0 = positions[c0];
+        vec3 normal = glm::cross(positions[c1] - p0, positions[c2] - p0);
+        float normalLength = glm::length(normal);
+        if (normalLength > 0.0f) {
+            normal /= normalLength;
+            Quadric planeQuadric = Quadric::fromPlane(normal.x, normal.y, normal.z, -glm::dot(normal, p0));
+            quadrics[c0].add(planeQuadric);
+            quadrics[c1].add(planeQuadric);
+            quadrics[c2].add(planeQuadric);
+        }
+    }
+
+    // Vertices on seams, borders, and non-manifold edges are locked in place, since collapsing them would tear the mesh
+    std::vector<bool> locked(vertexCount, false);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (copyCount[canonical[v]] > 1) {
+            locked[canonical[v]] = true;
+        }
+    }
+    for (auto& [key, useCount] : edgeUseCount) {
+        if (useCount != 2) {
+            locked[uint32_t(key >> 32u)] = true;
+            locked[uint32_t(key & 0xffffffffu)] = true;
+        }
+    }
+
+    struct Collapse {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t version;
+        bool operator>(const Collapse& other) const { return cost > other.cost; }
+    };
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapseQueue {};
+
+    std::vector<uint32_t> version(vertexCount, 0);
+    std::vector<bool> collapsed(vertexCount, false);
+
+    auto forEachLiveTriangle = [&](uint32_t v, auto&& callback) {
+        for (uint32_t t : vertexTriangles[v]) {
+            if (!triangleRemoved[t]) {
+                callback(t);
+            }
+        }
+    };
+
+    // Queue up collapses of v into all of its neighbours and (optionally) collapses of all neighbours into v
+    auto queueCollapses = [&](uint32_t v, bool includeIncoming) {
+        forEachLiveTriangle(v, [&](uint32_t t) {
+            for (int i = 0; i < 3; ++i) {
+                uint32_t u = canonical[triangles[3 * t + i]];
+                if (u == v) {
+                    continue;
+                }
+                if (!locked[v]) {
+                    collapseQueue.push({ quadrics[v].evaluate(positions[u]), v, u, version[v] });
+                }
+                if (includeIncoming && !locked[u]) {
+                    collapseQueue.push({ quadrics[u].evaluate(positions[v]), u, v, version[u] });
+                }
+            }
+        });
+    };
+
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (canonical[v] == v && !locked[v]) {
+            queueCollapses(v, false);
+        }
+    }
+
+    double maxErrorSquared = double(maxError) * double(maxError);
+    double resultErrorSquared = 0.0;
+
+    std::unordered_set<uint32_t> neighboursOfA {};
+    std::unordered_set<uint32_t> commonNeighbours {};
+
+    while (liveIndexCount > targetIndexCount && !collapseQueue.empty()) {
+        Collapse collapse = collapseQueue.top();
+        collapseQueue.pop();
+
+        uint32_t a = collapse.from;
+        uint32_t b = collapse.to;
+        if (collapsed[a] || collapsed[b] || collapse.version != version[a]) {
+            continue;
+        }
+
+        // Since we never move vertices, the cost of a valid collapse can't change, so nothing cheaper remains
+        if (collapse.cost > maxErrorSquared) {
+            break;
+        }
+
+        // The edge might not exist anymore, and we also need the actual vertex (not only the position) to collapse into
+        uint32_t targetVertex = InvalidIndex;
+        neighboursOfA.clear();
+        forEachLiveTriangle(a, [&](uint32_t t) {
+            for (int i = 0; i < 3; ++i) {
+                uint32_t u = canonical[triangles[3 * t + i]];
+                if (u == b) {
+                    targetVertex = triangles[3 * t + i];
+                } else if (u != a) {
+                    neighboursOfA.insert(u);
+                }
+            }
+        });
+        if (targetVertex == InvalidIndex) {
+            continue;
+        }
+
+        // Link condition: an interior edge can only share two neighbours, otherwise the collapse makes the mesh non-manifold
+        commonNeighbours.clear();
+        forEachLiveTriangle(b, [&](uint32_t t) {
+            for (int i = 0; i < 3; ++i) {
+                uint32_t u = canonical[triangles[3 * t + i]];
+                if (neighboursOfA.count(u) > 0) {
+                    commonNeighbours.insert(u);
+                }
+            }
+        });
+        if (commonNeighbours.size() > 2) {
+            continue;
+        }
+
+        // Don't allow any of the remaining triangles to flip
+        bool flipsTriangle = false;
+        forEachLiveTriangle(a, [&](uint32_t t) {
+            vec3 oldCorners[3];
+            vec3 newCorners[3];
+            bool containsB = false;
+            for (int i = 0; i < 3; ++i) {
+                uint32_t u = canonical[triangles[3 * t + i]];
+                containsB |= (u == b);
+                oldCorners[i] = positions[u];
+                newCorners[i] = (u == a) ? positions[b] : positions[u];
+            }
+            if (containsB) {
+                return;
+            }
+            vec3 oldNormal = glm::cross(oldCorners[1] - oldCorners[0], oldCorners[2] - oldCorners[0]);
+            vec3 newNormal = glm::cross(newCorners[1] - newCorners[0], newCorners[2] - newCorners[0]);
+            if (glm::dot(oldNormal, newNormal) <= 0.0f) {
+                flipsTriangle = true;
+            }
+        });
+        if (flipsTriangle) {
+            continue;
+        }
+
+        forEachLiveTriangle(a, [&](uint32_t t) {
+            bool containsB = false;
+            for (int i = 0; i < 3; ++i) {
+                containsB |= (canonical[triangles[3 * t + i]] == b);
+            }
+            if (containsB) {
+                triangleRemoved[t] = true;
+                liveIndexCount -= 3;
+                return;
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (canonical[triangles[3 * t + i]] == a) {
+                    triangles[3 * t + i] = targetVertex;
+                }
+            }
+            vertexTriangles[b].push_back(t);
+        });
+
+        vertexTriangles[a].clear();
+        collapsed[a] = true;
+
+        quadrics[b].add(quadrics[a]);
+        version[b] += 1;
+        resultErrorSquared = std::max(resultErrorSquared, collapse.cost);
+
+        queueCollapses(b, true);
+    }
+
+    SimplifiedIndices result {};
+    result.indices.reserve(liveIndexCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!triangleRemoved[t]) {
+            result.indices.push_back(triangles[3 * t + 0]);
+            result.indices.push_back(triangles[3 * t + 1]);
+            result.indices.push_back(triangles[3 * t + 2]);
+        }
+    }
+    result.error = float(std::sqrt(resultErrorSquared));
+
+    return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "utility/mathkit.h"
+#include <string>
+#include <vector>
+
+namespace MeshOptimizer {
+
+// Plain CPU-side copy of all mesh data, with all non-empty vertex streams having the same length
+struct MeshData {
+    std::vector<vec3> positions {};
+    std::vector<vec2> texcoords {};
+    std::vector<vec3> normals {};
+    std::vector<vec4> tangents {};
+
+    std::vector<uint32_t> indices {};
+
+    [[nodiscard]] size_t vertexCount() const { return positions.size(); }
+    [[nodiscard]] size_t triangleCount() const { return indices.size() / 3; }
+};
+
+struct VertexCacheStatistics {
+    float acmr { 0.0f }; // average cache miss ratio, i.e. transformed vertices per triangle (0.5 is optimal, 3.0 is worst case)
+    float atvr { 0.0f }; // average transformed vertex ratio, i.e. transformed vertices per referenced vertex (1.0 is optimal)
+};
+
+// Simulates a FIFO post-transform cache of the given size for the index buffer
+VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Merges all vertices that are bitwise identical across all streams and rewrites the index buffer
+void deduplicateVertices(MeshData&);
+
+// Reorders triangles for post-transform vertex cache efficiency (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+void optimizeVertexCache(MeshData&);
+
+// Reorders clusters of triangles so that outwards facing ones are drawn first, while keeping the ACMR within
+// the threshold factor of the cache optimized index buffer. Must be run after optimizeVertexCache!
+void optimizeOverdraw(MeshData&, float threshold = 1.05f);
+
+// Reorders vertices in order of first use by the index buffer, and removes any unused vertices
+void optimizeVertexFetch(MeshData&);
+
+struct SimplifiedIndices {
+    std::vector<uint32_t> indices {};
+    float error { 0.0f }; // max quadric error of any collapse, roughly a distance in the units of the positions
+};
+
+// Simplifies the mesh by collapsing edges in order of quadric error (Garland & Heckbert) until the index count is at
+// most the target, or until the next collapse would introduce an error larger than maxError. Vertices are never moved
+// or created so the new indices can be used with the original vertices. Border & seam vertices are never collapsed.
+SimplifiedIndices simplify(const std::vector<vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError);
+
+// Runs the full pipeline on the mesh data (dedup, vertex cache, overdraw, vertex fetch) and logs before & after statistics
+void optimize(MeshData&, const std::string& debugName);
+
+}
@@ -0,0 +1,509 @@
+#include "MipGenerator.h"
+
+#include "utility/Logging.h"
+#include "utility/mathkit.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <xmmintrin.h>
+
+namespace {
+
+using namespace MipGenerator;
+
+// All filtering happens on linear float RGBA pixels, loaded as one __m128 per pixel
+struct FloatLevel {
+    int width { 0 };
+    int height { 0 };
+    std::vector<float> pixels {};
+
+    FloatLevel(int width, int height)
+        : width(width)
+        , height(height)
+        , pixels(4 * size_t(width) * size_t(height))
+    {
+    }
+
+    [[nodiscard]] float* pixel(int x, int y) { return pixels.data() + 4 * (size_t(y) * width + x); }
+    [[nodiscard]] const float* pixel(int x, int y) const { return pixels.data() + 4 * (size_t(y) * width + x); }
+};
+
+float sRGBToLinear(float value)
+{
+    return (value <= 0.04045f)
+        ? value / 12.92f
+        : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSRGB(float value)
+{
+    return (value <= 0.0031308f)
+        ? value * 12.92f
+        : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+uint8_t encodeUNorm8(float value)
+{
+    return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Decoding from 8-bit to the linear space the filtering happens in, per content type (alpha is always linear)
+std::array<float, 256> makeDecodeTable(Content content)
+{
+    std::array<float, 256> table {};
+    for (int i = 0; i < 256; ++i) {
+        float value = float(i) / 255.0f;
+        switch (content) {
+        case Content::LinearColor:
+            table[i] = value;
+            break;
+        case Content::sRGBColor:
+            table[i] = sRGBToLinear(value);
+            break;
+        case Content::NormalMap:
+            table[i] = value * 2.0f - 1.0f;
+            break;
+        }
+    }
+    return table;
+}
+
+// Separable windowed sinc, see e.g. the Kaiser filter in NVIDIA Texture Tools. With six taps the filter covers 1.25
+// destination texels to each side of the center, which is enough for the window to have fallen off to almost nothing.
+constexpr int KaiserTapCount = 6;
+constexpr float KaiserWindowWidth = 1.5f;
+constexpr float KaiserAlpha = 4.0f;
+
+float besselI0(float x)
+{
+    // (power series, converges quickly for the small arguments we use)
+    float sum = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k < 32; ++k) {
+        float factor = x / (2.0f * float(k));
+        term *= factor * factor;
+        sum += term;
+        if (term < sum * 1e-8f) {
+            break;
+        }
+    }
+    return sum;
+}
+
+std::array<float, KaiserTapCount> makeKaiserWeights()
+{
+    std::array<float, KaiserTapCount> weights {};
+    float weightSum = 0.0f;
+
+    for (int tap = 0; tap < KaiserTapCount; ++tap) {
+        // Distance from the destination texel center, in destination texels
+        float t = (float(tap) - 0.5f * float(KaiserTapCount - 1)) / 2.0f;
+
+        float sinc = std::sin(mathkit::PI * t) / (mathkit::PI * t);
+        float windowX = t / KaiserWindowWidth;
+        float window = besselI0(KaiserAlpha * std::sqrt(std::max(0.0f, 1.0f - windowX * windowX))) / besselI0(KaiserAlpha);
+
+        weights[tap] = sinc * window;
+        weightSum += weights[tap];
+    }
+
+    for (float& weight : weights) {
+        weight /= weightSum;
+    }
+    return weights;
+}
+
+template<typename LoadPixel>
+void downsampleBox(int srcWidth, int srcHeight, LoadPixel&& loadPixel, FloatLevel& dst)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for (int y = 0; y < dst.height; ++y) {
+        int y0 = std::min(2 * y, srcHeight - 1);
+        int y1 = std::min(2 * y + 1, srcHeight - 1);
+        for (int x = 0; x < dst.width; ++x) {
+            int x0 = std::min(2 * x, srcWidth - 1);
+            int x1 = std::min(2 * x + 1, srcWidth - 1);
+
+            __m128 sum = _mm_add_ps(_mm_add_ps(loadPixel(x0, y0), loadPixel(x1, y0)),
+                                    _mm_add_ps(loadPixel(x0, y1), loadPixel(x1, y1)));
+            _mm_storeu_ps(dst.pixel(x, y), _mm_mul_ps(sum, quarter));
+        }
+    }
+}
+
+template<typename LoadPixel>
+void downsampleKaiser(int srcWidth, int srcHeight, LoadPixel&& loadPixel, FloatLevel& dst)
+{
+    static const std::array<float, KaiserTapCount> weights = makeKaiserWeights();
+    constexpr int firstTapOffset = -(KaiserTapCount / 2 - 1);
+
+    // Horizontally filtered source rows. Every such row is used by three destination rows, so keep the last few around
+    // instead of filtering the full level horizontally first, which would require a lot of memory for large images.
+    constexpr int rowCacheSize = 8;
+    static_assert(rowCacheSize >= KaiserTapCount);
+    std::array<std::vector<float>, rowCacheSize> rowCache {};
+    std::array<int, rowCacheSize> cachedRowIndex {};
+    cachedRowIndex.fill(-1);
+
+    auto horizontallyFilteredRow = [&](int srcY) -> const float* {
+        int slot = srcY % rowCacheSize;
+        std::vector<float>& row = rowCache[slot];
+        if (cachedRowIndex[slot] != srcY) {
+            row.resize(4 * size_t(dst.width));
+            for (int x = 0; x < dst.width; ++x) {
+                __m128 sum = _mm_setzero_ps();
+                for (int tap = 0; tap < KaiserTapCount; ++tap) {
+                    int srcX = std::clamp(2 * x + firstTapOffset + tap, 0, srcWidth - 1);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), loadPixel(srcX, srcY)));
+                }
+                _mm_storeu_ps(row.data() + 4 * x, sum);
+            }
+            cachedRowIndex[slot] = srcY;
+        }
+        return row.data();
+    };
+
+    for (int y = 0; y < dst.height; ++y) {
+        // (the rows of one destination row are always consecutive, so they are never evicted from the cache in between)
+        std::array<const float*, KaiserTapCount> rows {};
+        for (int tap = 0; tap < KaiserTapCount; ++tap) {
+            int srcY = std::clamp(2 * y + firstTapOffset + tap, 0, srcHeight - 1);
+            rows[tap] = horizontallyFilteredRow(srcY);
+        }
+
+        for (int x = 0; x < dst.width; ++x) {
+            __m128 sum = _mm_setzero_ps();
+            for (int tap = 0; tap < KaiserTapCount; ++tap) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), _mm_loadu_ps(rows[tap] + 4 * x)));
+            }
+            _mm_storeu_ps(dst.pixel(x, y), sum);
+        }
+    }
+}
+
+template<typename LoadPixel>
+FloatLevel downsample(int srcWidth, int srcHeight, LoadPixel&& loadPixel, Options options, bool isHdr)
+{
+    FloatLevel dst { std::max(1, srcWidth / 2), std::max(1, srcHeight / 2) };
+
+    switch (options.filter) {
+    case Filter::Box:
+        downsampleBox(srcWidth, srcHeight, loadPixel, dst);
+        break;
+    case Filter::Kaiser:
+        downsampleKaiser(srcWidth, srcHeight, loadPixel, dst);
+        break;
+    }
+
+    // The negative lobes of the Kaiser filter can cause some over/undershoot, so clamp to the valid range of the content
+    // before the level is used to generate the next one. Normal maps are also renormalized here for the same reason.
+    float minColorValue = (options.content == Content::NormalMap) ? -1.0f : 0.0f;
+    const __m128 minValue = _mm_set_ps(0.0f, minColorValue, minColorValue, minColorValue);
+    const __m128 maxValue = _mm_set1_ps(isHdr ? std::numeric_limits<float>::max() : 1.0f);
+    for (size_t i = 0; i < dst.pixels.size(); i += 4) {
+        float* pixel = dst.pixels.data() + i;
+        _mm_storeu_ps(pixel, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pixel), minValue), maxValue));
+
+        if (options.content == Content::NormalMap) {
+            float length = std::sqrt(pixel[0] * pixel[0] + pixel[1] * pixel[1] + pixel[2] * pixel[2]);
+            if (length > 1e-6f) {
+                pixel[0] /= length;
+                pixel[1] /= length;
+                pixel[2] /= length;
+            } else {
+                pixel[0] = 0.0f;
+                pixel[1] = 0.0f;
+                pixel[2] = 1.0f;
+            }
+        }
+    }
+
+    return dst;
+}
+
+void encodeLevel(const FloatLevel& level, Content content, bool isHdr, uint8_t* destination)
+{
+    size_t pixelCount = size_t(level.width) * size_t(level.height);
+
+    if (isHdr) {
+        std::memcpy(destination, level.pixels.data(), pixelCount * 4 * sizeof(float));
+        return;
+    }
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const float* pixel = level.pixels.data() + 4 * i;
+        uint8_t* encoded = destination + 4 * i;
+        for (int c = 0; c < 3; ++c) {
+            switch (content) {
+            case Content::LinearColor:
+                encoded[c] = encodeUNorm8(pixel[c]);
+                break;
+            case Content::sRGBColor:
+                encoded[c] = encodeUNorm8(linearToSRGB(pixel[c]));
+                break;
+            case Content::NormalMap:
+                encoded[c] = encodeUNorm8(pixel[c] * 0.5f + 0.5f);
+                break;
+            }
+        }
+        encoded[3] = encodeUNorm8(pixel[3]);
+    }
+}
+
+// Mipmap cache file: a header, the path of the source image (to guard against hash collisions), the mip level table,
+// and finally the pixel data for all levels exactly as in Image
+constexpr uint32_t CacheFileMagic = 0x5350494d; // "MIPS"
+constexpr uint32_t CacheFileVersion = 1;
+constexpr const char* CacheDirectory = "cache/mipmaps";
+
+struct CacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceFileSize;
+    int64_t sourceWriteTime;
+    uint32_t filter;
+    uint32_t content;
+    int32_t width;
+    int32_t height;
+    int32_t componentCount;
+    int32_t isHdr;
+    uint32_t mipLevelCount;
+    uint32_t sourcePathLength;
+    uint64_t pixelDataSize;
+};
+
+struct CacheFileMipLevel {
+    uint64_t offset;
+    int32_t width;
+    int32_t height;
+};
+
+std::filesystem::path cacheFilePath(const std::string& imagePath, Options options)
+{
+    std::string key = imagePath + ":" + std::to_string(int(options.filter)) + ":" + std::to_string(int(options.content));
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.mips", static_cast<unsigned long long>(std::hash<std::string> {}(key)));
+    return std::filesystem::path(CacheDirectory) / fileName;
+}
+
+std::shared_ptr<void> allocatePixelData(size_t size)
+{
+    return std::shared_ptr<void>(std::malloc(size), [](void* pixels) { std::free(pixels); });
+}
+
+std::optional<Image> readCacheFile(const std::filesystem::path& cachePath, const CacheFileHeader& expected, const std::string& imagePath)
+{
+    std::ifstream file { cachePath, std::ios::binary };
+    if (!file.is_open()) {
+        return {};
+    }
+
+    CacheFileHeader header {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return {};
+    }
+
+    // (an out-of-date file is simply overwritten later, so no need to warn about it)
+    if (header.magic != expected.magic || header.version != expected.version
+        || header.sourceFileSize != expected.sourceFileSize || header.sourceWriteTime != expected.sourceWriteTime
+        || header.filter != expected.filter || header.content != expected.content
+        || header.width != expected.width || header.height != expected.height
+        || header.componentCount != expected.componentCount || header.isHdr != expected.isHdr
+        || header.mipLevelCount != expected.mipLevelCount || header.sourcePathLength != imagePath.size()) {
+        return {};
+    }
+
+    std::string sourcePath(header.sourcePathLength, '\0');
+    if (!file.read(sourcePath.data(), sourcePath.size()) || sourcePath != imagePath) {
+        return {};
+    }
+
+    std::vector<CacheFileMipLevel> fileMipLevels(header.mipLevelCount);
+    if (!file.read(reinterpret_cast<char*>(fileMipLevels.data()), fileMipLevels.size() * sizeof(CacheFileMipLevel))) {
+        return {};
+    }
+
+    std::shared_ptr<void> pixels = allocatePixelData(header.pixelDataSize);
+    if (!pixels || !file.read(static_cast<char*>(pixels.get()), header.pixelDataSize)) {
+        LogWarning("MipGenerator: could not read cached mipmaps in '%s', will regenerate.\n", cachePath.string().c_str());
+        return {};
+    }
+
+    std::vector<Image::MipLevel> mipLevels {};
+    for (const CacheFileMipLevel& level : fileMipLevels) {
+        mipLevels.push_back({ .offset = level.offset, .width = level.width, .height = level.height });
+    }
+
+    Image::Info info { .width = header.width, .height = header.height, .componentCount = header.componentCount, .isHdr = header.isHdr != 0 };
+    return Image(info, header.componentCount, std::move(pixels), std::move(mipLevels));
+}
+
+void writeCacheFile(const std::filesystem::path& cachePath, CacheFileHeader header, const std::string& imagePath, const Image& image)
+{
+    std::error_code error;
+    std::filesystem::create_directories(cachePath.parent_path(), error);
+
+    // Write to a temporary file first so a partially written file is never mistaken for a valid one. (Several threads
+    // might be writing the same image at once, so each writer needs its own temporary file.)
+    static std::atomic<uint32_t> nextTempFileIndex { 0 };
+    size_t threadHash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::filesystem::path tempPath = cachePath;
+    tempPath += "." + std::to_string(threadHash) + "." + std::to_string(nextTempFileIndex++) + ".tmp";
+
+    {
+        std::ofstream file { tempPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            LogWarning("MipGenerator: could not create mipmap cache file '%s'.\n", tempPath.string().c_str());
+            return;
+        }
+
+        header.pixelDataSize = image.pixelDataSize();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(imagePath.data(), imagePath.size());
+        for (const Image::MipLevel& level : image.mipLevels()) {
+            CacheFileMipLevel fileLevel { .offset = level.offset, .width = level.width, .height = level.height };
+            file.write(reinterpret_cast<const char*>(&fileLevel), sizeof(fileLevel));
+        }
+        file.write(static_cast<const char*>(image.pixels()), image.pixelDataSize());
+
+        if (!file.good()) {
+            LogWarning("MipGenerator: could not write mipmap cache file '%s'.\n", tempPath.string().c_str());
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        LogWarning("MipGenerator: could not write mipmap cache file '%s'.\n", cachePath.string().c_str());
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+}
+
+namespace MipGenerator {
+
+uint32_t mipLevelCount(int width, int height)
+{
+    return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+Image generate(const Image& image, Options options)
+{
+    ASSERT(image.isValid());
+    ASSERT(image.componentCount() == 4);
+    ASSERT(image.mipLevels().size() == 1);
+
+    const Image::Info& info = image.info();
+    bool isHdr = info.isHdr;
+    if (isHdr && options.content != Content::LinearColor) {
+        LogWarning("MipGenerator: HDR images are always treated as linear color.\n");
+        options.content = Content::LinearColor;
+    }
+
+    uint32_t levelCount = mipLevelCount(info.width, info.height);
+    size_t bytesPerPixel = image.bytesPerPixel();
+
+    std::vector<Image::MipLevel> mipLevels {};
+    size_t dataSize = 0;
+    {
+        int width = info.width;
+        int height = info.height;
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            mipLevels.push_back({ .offset = dataSize, .width = width, .height = height });
+            dataSize += size_t(width) * size_t(height) * bytesPerPixel;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+
+    std::shared_ptr<void> data = allocatePixelData(dataSize);
+    uint8_t* dataBytes = static_cast<uint8_t*>(data.get());
+
+    // The first level is always exactly the source image
+    std::memcpy(dataBytes, image.pixels(), mipLevels[0].width * mipLevels[0].height * bytesPerPixel);
+
+    if (levelCount > 1) {
+        FloatLevel previousLevel = [&]() {
+            if (isHdr) {
+                const float* src = static_cast<const float*>(image.pixels());
+                auto loadPixel = [&](int x, int y) { return _mm_loadu_ps(src + 4 * (size_t(y) * info.width + x)); };
+                return downsample(info.width, info.height, loadPixel, options, isHdr);
+            } else {
+                // (decode on the fly for the first level, so we never have to keep a full float copy of the source image)
+                static const std::array<float, 256> alphaTable = makeDecodeTable(Content::LinearColor);
+                const std::array<float, 256> colorTable = makeDecodeTable(options.content);
+                const uint8_t* src = static_cast<const uint8_t*>(image.pixels());
+                auto loadPixel = [&](int x, int y) {
+                    const uint8_t* pixel = src + 4 * (size_t(y) * info.width + x);
+                    return _mm_set_ps(alphaTable[pixel[3]], colorTable[pixel[2]], colorTable[pixel[1]], colorTable[pixel[0]]);
+                };
+                return downsample(info.width, info.height, loadPixel, options, isHdr);
+            }
+        }();
+        encodeLevel(previousLevel, options.content, isHdr, dataBytes + mipLevels[1].offset);
+
+        for (uint32_t level = 2; level < levelCount; ++level) {
+            const FloatLevel& src = previousLevel;
+            auto loadPixel = [&](int x, int y) { return _mm_loadu_ps(src.pixel(x, y)); };
+            FloatLevel nextLevel = downsample(src.width, src.height, loadPixel, options, isHdr);
+            encodeLevel(nextLevel, options.content, isHdr, dataBytes + mipLevels[level].offset);
+            previousLevel = std::move(nextLevel);
+        }
+    }
+
+    return Image(info, image.componentCount(), std::move(data), std::move(mipLevels));
+}
+
+Image loadWithMipmaps(const std::string& imagePath, const Image::Info& info, Options options)
+{
+    constexpr int componentCount = 4;
+
+    std::error_code sizeError, timeError;
+    uintmax_t sourceFileSize = std::filesystem::file_size(imagePath, sizeError);
+    auto sourceWriteTime = std::filesystem::last_write_time(imagePath, timeError);
+    bool canUseCache = !sizeError && !timeError;
+
+    CacheFileHeader header {};
+    header.magic = CacheFileMagic;
+    header.version = CacheFileVersion;
+    header.sourceFileSize = sourceFileSize;
+    header.sourceWriteTime = canUseCache ? sourceWriteTime.time_since_epoch().count() : 0;
+    header.filter = uint32_t(options.filter);
+    header.content = uint32_t(options.content);
+    header.width = info.width;
+    header.height = info.height;
+    header.componentCount = componentCount;
+    header.isHdr = info.isHdr ? 1 : 0;
+    header.mipLevelCount = mipLevelCount(info.width, info.height);
+    header.sourcePathLength = uint32_t(imagePath.size());
+
+    std::filesystem::path cachePath = cacheFilePath(imagePath, options);
+    if (canUseCache) {
+        if (auto cachedImage = readCacheFile(cachePath, header, imagePath)) {
+            return std::move(*cachedImage);
+        }
+    }
+
+    Image image = Image::load(imagePath, info, componentCount);
+    if (!image.isValid()) {
+        return image;
+    }
+
+    Image mipmappedImage = generate(image, options);
+    if (canUseCache) {
+        writeCacheFile(cachePath, header, imagePath, mipmappedImage);
+    }
+
+    return mipmappedImage;
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "utility/Image.h"
+#include <string>
+
+// CPU mipmap generation for 8-bit & float RGBA images, as an alternative to generating them with GPU blits. All filtering
+// is done in linear space (sRGB images are linearized first) and normal maps are renormalized for every level.
+namespace MipGenerator {
+
+enum class Filter {
+    Box,
+    Kaiser,
+};
+
+enum class Content {
+    LinearColor,
+    sRGBColor,
+    NormalMap,
+};
+
+struct Options {
+    Filter filter { Filter::Kaiser };
+    Content content { Content::sRGBColor };
+};
+
+// Same mip level count as Texture::mipLevels(), i.e. all the way down to 1x1
+uint32_t mipLevelCount(int width, int height);
+
+// Returns a copy of the (single level, four component) image with all mip levels
+Image generate(const Image&, Options);
+
+// Loads the image and generates all its mipmaps, unless a previous result is found in the mipmap cache. The cache is
+// keyed on the image path & options, and the cached file is regenerated if the source image is modified.
+Image loadWithMipmaps(const std::string& imagePath, const Image::Info&, Options);
+
+}
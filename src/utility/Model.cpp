@@ -1,5 +1,175 @@
 #include "Model.h"
 
+#include "utility/Logging.h"
+#include "utility/MeshOptimizer.h"
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+std::vector<std::byte> Mesh::packedIndexData() const
+{
+    return packIndexData(indexData());
+}
+
+std::vector<std::byte> Mesh::packIndexData(const std::vector<uint32_t>& indices) const
+{
+    switch (indexType()) {
+    case IndexType::UInt16: {
+        std::vector<std::byte> data(indices.size() * sizeof(uint16_t));
+        auto* indices16 = reinterpret_cast<uint16_t*>(data.data());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            ASSERT(indices[i] <= UINT16_MAX);
+            indices16[i] = static_cast<uint16_t>(indices[i]);
+        }
+        return data;
+    }
+    case IndexType::UInt32: {
+        std::vector<std::byte> data(indices.size() * sizeof(uint32_t));
+        std::memcpy(data.data(), indices.data(), data.size());
+        return data;
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+Mesh::GeometryData& Mesh::geometryData() const
+{
+    if (!m_geometryData) {
+        // A geometry source stays alive for as long as any mesh using it, so if the entry has expired the source is gone
+        // and the key can safely be reused by whatever source now lives at that address.
+        static std::mutex sharedGeometryDataMutex {};
+        static std::unordered_map<const void*, std::weak_ptr<GeometryData>> sharedGeometryData {};
+
+        std::scoped_lock<std::mutex> lock { sharedGeometryDataMutex };
+        std::weak_ptr<GeometryData>& entry = sharedGeometryData[geometrySource()];
+        m_geometryData = entry.lock();
+        if (!m_geometryData) {
+            m_geometryData = std::make_shared<GeometryData>();
+            entry = m_geometryData;
+        }
+    }
+    return *m_geometryData;
+}
+
+const std::vector<MeshLod>& Mesh::levelsOfDetail() const
+{
+    GeometryData& data = geometryData();
+    if (!data.levelsOfDetail.has_value()) {
+        data.levelsOfDetail = generateLevelsOfDetail();
+    }
+    return data.levelsOfDetail.value();
+}
+
+vec4 Mesh::boundingSphere() const
+{
+    GeometryData& data = geometryData();
+    if (!data.boundingSphere.has_value()) {
+        std::vector<vec3> positions = positionData();
+        if (positions.empty()) {
+            data.boundingSphere = vec4(0.0f);
+        } else {
+            // Not the tightest sphere, but good enough for LOD selection
+            vec3 minPosition = positions[0];
+            vec3 maxPosition = positions[0];
+            for (const vec3& position : positions) {
+                minPosition = glm::min(minPosition, position);
+                maxPosition = glm::max(maxPosition, position);
+            }
+            vec3 center = (minPosition + maxPosition) / 2.0f;
+            float radius = 0.0f;
+            for (const vec3& position : positions) {
+                radius = std::max(radius, glm::distance(center, position));
+            }
+            data.boundingSphere = vec4(center, radius);
+        }
+    }
+    return data.boundingSphere.value();
+}
+
+float Mesh::texcoordDensity() const
+{
+    GeometryData& data = geometryData();
+    if (!data.texcoordDensity.has_value()) {
+        std::vector<vec3> positions = positionData();
+        std::vector<vec2> texcoords = texcoordData();
+        std::vector<uint32_t> indices = indexData();
+        if (!isIndexed()) {
+            indices.resize(vertexCount());
+            for (uint32_t i = 0; i < indices.size(); ++i) {
+                indices[i] = i;
+            }
+        }
+
+        // Ratio of the total texcoord area and the total surface area, so it's an average weighted by triangle area
+        double surfaceArea = 0.0;
+        double texcoordArea = 0.0;
+        if (texcoords.size() == positions.size()) {
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                uint32_t i0 = indices[i + 0];
+                uint32_t i1 = indices[i + 1];
+                uint32_t i2 = indices[i + 2];
+                surfaceArea += 0.5 * glm::length(glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]));
+                vec2 uv1 = texcoords[i1] - texcoords[i0];
+                vec2 uv2 = texcoords[i2] - texcoords[i0];
+                texcoordArea += 0.5 * std::abs(uv1.x * uv2.y - uv1.y * uv2.x);
+            }
+        }
+
+        data.texcoordDensity = (surfaceArea > 0.0) ? float(std::sqrt(texcoordArea / surfaceArea)) : 0.0f;
+    }
+    return data.texcoordDensity.value();
+}
+
+std::vector<MeshLod> Mesh::generateLevelsOfDetail() const
+{
+    constexpr float maxRelativeError = 0.25f;
+    constexpr size_t minIndexCount = 3 * 64;
+
+    std::vector<MeshLod> lods {};
+    if (!isIndexed()) {
+        return lods;
+    }
+
+    MeshOptimizer::MeshData lodMesh {};
+    lodMesh.positions = positionData();
+    std::vector<uint32_t> fullIndices = indexData();
+
+    float maxError = maxRelativeError * boundingSphere().w;
+    float accumulatedError = 0.0f;
+
+    // Every level tries to halve the triangle count of the previous one
+    while (lods.size() < maxLevelsOfDetail) {
+        const std::vector<uint32_t>& previousIndices = lods.empty() ? fullIndices : lods.back().indices;
+        size_t targetIndexCount = 3 * (previousIndices.size() / 6);
+        if (targetIndexCount < minIndexCount) {
+            break;
+        }
+
+        MeshOptimizer::SimplifiedIndices simplified = MeshOptimizer::simplify(lodMesh.positions, previousIndices, targetIndexCount, maxError - accumulatedError);
+
+        // Not worth having an extra level if we couldn't remove a decent amount of triangles (e.g. due to many seams)
+        if (simplified.indices.size() > previousIndices.size() * 3 / 4) {
+            break;
+        }
+
+        lodMesh.indices = std::move(simplified.indices);
+        MeshOptimizer::optimizeVertexCache(lodMesh);
+
+        accumulatedError += simplified.error;
+        lods.push_back({ .indices = std::move(lodMesh.indices),
+                         .error = accumulatedError });
+    }
+
+    if (!lods.empty()) {
+        LogInfo("Mesh: generated %u levels of detail, %u -> %u triangles (error %.4f)\n",
+                uint32_t(lods.size()), uint32_t(fullIndices.size() / 3), uint32_t(lods.back().indices.size() / 3), lods.back().error);
+    }
+
+    return lods;
+}
+
 bool Model::hasProxy() const
 {
     return m_proxy != nullptr;
@@ -3,6 +3,8 @@
 #include "utility/FpsCamera.h"
 #include "utility/mathkit.h"
 #include <functional>
+#include <memory>
+#include <optional>
 
 class Material {
 public:
@@ -25,6 +27,7 @@ public:
     void setLocalMatrix(mat4 matrix)
     {
         m_localMatrix = matrix;
+        m_version += 1;
     }
 
     mat4 localMatrix() const
@@ -47,6 +50,15 @@ public:
         return normalMatrix;
     }
 
+    // Changes whenever this transform or any of its parents have changed, so users can tell if they need to update anything
+    uint64_t version() const
+    {
+        if (!m_parent) {
+            return m_version;
+        }
+        return m_parent->version() + m_version;
+    }
+
     mat3 localNormalMatrix() const
     {
         mat3 local3x3 = mat3(localMatrix());
@@ -63,6 +75,7 @@ private:
     //vec3 m_scale { 1.0 };
     const Transform* m_parent {};
     mutable mat4 m_localMatrix { 1.0f };
+    uint64_t m_version { 0 };
 };
 
 enum class VertexFormat {
@@ -74,6 +87,11 @@ enum class IndexType {
     UInt32,
 };
 
+struct MeshLod {
+    std::vector<uint32_t> indices {};
+    float error { 0.0f }; // geometric error (in mesh space units) compared to the full resolution mesh
+};
+
 class Mesh {
 public:
     Mesh(Transform transform)
@@ -84,6 +102,10 @@ public:
 
     virtual const Transform& transform() const { return m_transform; }
 
+    // Meshes with the same geometry source have identical vertex and index data (e.g. the same glTF primitive used by
+    // several models), so they can share any GPU data derived from it. By default every mesh is its own source.
+    virtual const void* geometrySource() const { return this; }
+
     virtual Material material() const = 0;
 
     virtual std::vector<vec3> positionData() const = 0;
@@ -91,6 +113,8 @@ public:
     virtual std::vector<vec3> normalData() const = 0;
     virtual std::vector<vec4> tangentData() const = 0;
 
+    virtual size_t vertexCount() const = 0;
+
     virtual VertexFormat vertexFormat() const = 0;
     virtual IndexType indexType() const = 0;
 
@@ -98,8 +122,34 @@ public:
     virtual size_t indexCount() const = 0;
     virtual bool isIndexed() const = 0;
 
+    // Index data in the format specified by indexType(), i.e. ready to be uploaded to an index buffer
+    std::vector<std::byte> packedIndexData() const;
+    std::vector<std::byte> packIndexData(const std::vector<uint32_t>& indices) const;
+
+    // Simplified versions of the index data, from finest to coarsest, not including the full resolution mesh. All levels
+    // use the same vertices as the full mesh. They are generated on first request and then cached for the geometry
+    // source, so meshes sharing a source only generate them once (same goes for the bounding sphere & texcoord density).
+    const std::vector<MeshLod>& levelsOfDetail() const;
+    static constexpr size_t maxLevelsOfDetail = 4;
+
+    // Bounding sphere in mesh space (xyz: center, w: radius)
+    vec4 boundingSphere() const;
+
+    // Average number of texcoord units per mesh space unit, i.e. how densely textures are mapped onto the surface
+    float texcoordDensity() const;
+
 private:
+    std::vector<MeshLod> generateLevelsOfDetail() const;
+
+    struct GeometryData {
+        std::optional<std::vector<MeshLod>> levelsOfDetail {};
+        std::optional<vec4> boundingSphere {};
+        std::optional<float> texcoordDensity {};
+    };
+    GeometryData& geometryData() const;
+
     Transform m_transform {};
+    mutable std::shared_ptr<GeometryData> m_geometryData {};
 };
 
 class Model {
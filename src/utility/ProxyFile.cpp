@@ -0,0 +1,523 @@
+#include "ProxyFile.h"
+
+#include "utility/FileIO.h"
+#include "utility/Logging.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <json.hpp>
+#include <utility>
+
+namespace {
+
+using json = nlohmann::json;
+using half_float::half;
+
+// File layout: the header, followed by tightly packed arrays (in this order) of
+//
+//  sphere-set:     spheres (4 halfs each), spherical harmonics (as SH_PACKING_HALF, see shared/SphericalHarmonics.h)
+//  voxel-contours: planes (4 halfs each), AABBs (6 halfs each), color indices, colors (4 floats each)
+//
+// which is exactly how the data is laid out in the GPU buffers, except that the color indices are stored with as few
+// bytes as the color count allows (see colorIndexSize) and are widened to uint32 when loaded.
+
+constexpr char ProxyMagic[4] = { 'A', 'P', 'X', 'Y' };
+constexpr uint32_t ProxyVersion = 2;
+
+enum class ProxyType : uint32_t {
+    SphereSet = 1,
+    VoxelContours = 2,
+};
+
+struct ProxyHeader {
+    char magic[4];
+    uint32_t version;
+    ProxyType type;
+    uint32_t primitiveCount; // (spheres or contours)
+    uint32_t colorCount;
+    uint32_t colorIndexSize; // (in bytes, where 0 means 4 for files written before it was a thing)
+    uint32_t reserved[2];
+};
+static_assert(sizeof(ProxyHeader) == 32);
+
+// (in the order they are packed in)
+constexpr std::pair<const char*, vec4 SphericalHarmonics::*> shCoefficients[] = {
+    { "L00", &SphericalHarmonics::L00 },
+    { "L1_1", &SphericalHarmonics::L1_1 },
+    { "L10", &SphericalHarmonics::L10 },
+    { "L11", &SphericalHarmonics::L11 },
+    { "L2_2", &SphericalHarmonics::L2_2 },
+    { "L2_1", &SphericalHarmonics::L2_1 },
+    { "L20", &SphericalHarmonics::L20 },
+    { "L21", &SphericalHarmonics::L21 },
+    { "L22", &SphericalHarmonics::L22 },
+};
+
+constexpr size_t sphereSetDataSize(size_t sphereCount)
+{
+    return sphereCount * (4 * sizeof(half) + SH_PACKED_WORDS_HALF * sizeof(uint32_t));
+}
+
+constexpr size_t voxelContoursDataSize(size_t contourCount, size_t colorCount, size_t colorIndexSize)
+{
+    return contourCount * ((4 + 6) * sizeof(half) + colorIndexSize) + colorCount * 4 * sizeof(float);
+}
+
+constexpr uint32_t colorIndexSizeForColorCount(size_t colorCount)
+{
+    if (colorCount <= 0x100) {
+        return sizeof(uint8_t);
+    } else if (colorCount <= 0x10000) {
+        return sizeof(uint16_t);
+    }
+    return sizeof(uint32_t);
+}
+
+bool hasExtension(const std::string& path, const char* extension)
+{
+    return std::filesystem::path(path).extension() == extension;
+}
+
+vec3 readVec3(const json& jsonArray)
+{
+    return { jsonArray[0].get<float>(), jsonArray[1].get<float>(), jsonArray[2].get<float>() };
+}
+
+std::unique_ptr<Model> loadSphereSetJson(const json& proxy)
+{
+    const json& jsonSpheres = proxy.at("spheres");
+
+    std::vector<SphereSetModel::Sphere> spheres;
+    std::vector<SphericalHarmonics> sphereSH;
+    spheres.reserve(jsonSpheres.size());
+    sphereSH.reserve(jsonSpheres.size());
+
+    for (auto& jsonSphere : jsonSpheres) {
+        vec3 center = readVec3(jsonSphere.at("center"));
+        float radius = jsonSphere.at("radius");
+        spheres.emplace_back(center, radius);
+
+        auto& jsonSh = jsonSphere.at("sh");
+        SphericalHarmonics sh;
+        sh.L00 = vec4(readVec3(jsonSh.at("L00")), 0);
+        sh.L1_1 = vec4(readVec3(jsonSh.at("L1_1")), 0);
+        sh.L10 = vec4(readVec3(jsonSh.at("L10")), 0);
+        sh.L11 = vec4(readVec3(jsonSh.at("L11")), 0);
+        sh.L2_2 = vec4(readVec3(jsonSh.at("L2_2")), 0);
+        sh.L2_1 = vec4(readVec3(jsonSh.at("L2_1")), 0);
+        sh.L20 = vec4(readVec3(jsonSh.at("L20")), 0);
+        sh.L21 = vec4(readVec3(jsonSh.at("L21")), 0);
+        sh.L22 = vec4(readVec3(jsonSh.at("L22")), 0);
+        sphereSH.push_back(sh);
+    }
+
+    return std::make_unique<SphereSetModel>(std::move(spheres), std::move(sphereSH));
+}
+
+std::unique_ptr<Model> loadVoxelContoursJson(const json& proxy)
+{
+    const json& jsonContours = proxy.at("contours");
+
+    std::vector<VoxelContourModel::VoxelContour> contours;
+    contours.reserve(jsonContours.size());
+
+    for (auto& jsonContour : jsonContours) {
+        aabb3 aabb { readVec3(jsonContour.at("aabbMin")), readVec3(jsonContour.at("aabbMax")) };
+        vec3 normal = readVec3(jsonContour.at("normal"));
+        float distance = jsonContour.at("distance");
+        uint32_t colorIndex = jsonContour.at("colorIndex");
+
+        contours.push_back({ aabb, normal, distance, colorIndex });
+    }
+
+    std::vector<vec3> colors;
+    for (auto& jsonColor : proxy.at("colors")) {
+        colors.push_back(readVec3(jsonColor));
+    }
+
+    return std::make_unique<VoxelContourModel>(std::move(contours), std::move(colors));
+}
+
+// Parses either kind of proxy straight into the model data, without going through a DOM
+class ProxyStreamingParser final : public JsonStreamingParser {
+public:
+    std::string type {};
+
+    std::vector<SphereSetModel::Sphere> spheres {};
+    std::vector<SphericalHarmonics> sphereSH {};
+
+    std::vector<VoxelContourModel::VoxelContour> contours {};
+    std::vector<vec3> colors {};
+
+private:
+    void onBeginObject() override
+    {
+        if (pathIs({ "spheres", "[]" })) {
+            spheres.emplace_back(0.0f);
+            sphereSH.emplace_back();
+        } else if (pathIs({ "contours", "[]" })) {
+            contours.push_back({ aabb3 { vec3(0.0f), vec3(0.0f) }, vec3(0.0f), 0.0f, 0 });
+        }
+    }
+
+    void onBeginArray() override
+    {
+        if (pathIs({ "colors", "[]" })) {
+            colors.emplace_back(0.0f);
+        }
+    }
+
+    void onString(const std::string& value) override
+    {
+        if (pathIs({ "proxy" })) {
+            type = value;
+        }
+    }
+
+    void onNumber(float value) override
+    {
+        // (components past the third are ignored, like for the DOM parser)
+        auto setComponent = [&](vec3& vector, size_t level) {
+            size_t component = indexAt(level);
+            if (component < 3) {
+                vector[int(component)] = value;
+            }
+        };
+
+        if (pathIs({ "spheres", "[]", "center", "[]" })) {
+            vec3 center = vec3(spheres.back());
+            setComponent(center, 3);
+            spheres.back() = vec4(center, spheres.back().w);
+        } else if (pathIs({ "spheres", "[]", "radius" })) {
+            spheres.back().w = value;
+        } else if (pathIs({ "spheres", "[]", "sh", "*", "[]" })) {
+            if (vec4* coefficient = shCoefficient(sphereSH.back(), keyAt(3))) {
+                vec3 rgb = vec3(*coefficient);
+                setComponent(rgb, 4);
+                *coefficient = vec4(rgb, 0.0f);
+            }
+        } else if (pathIs({ "contours", "[]", "aabbMin", "[]" })) {
+            setComponent(contours.back().aabb.min, 3);
+        } else if (pathIs({ "contours", "[]", "aabbMax", "[]" })) {
+            setComponent(contours.back().aabb.max, 3);
+        } else if (pathIs({ "contours", "[]", "normal", "[]" })) {
+            setComponent(contours.back().normal, 3);
+        } else if (pathIs({ "contours", "[]", "distance" })) {
+            contours.back().distance = value;
+        } else if (pathIs({ "contours", "[]", "colorIndex" })) {
+            contours.back().colorIndex = uint32_t(value);
+        } else if (pathIs({ "colors", "[]", "[]" })) {
+            setComponent(colors.back(), 2);
+        }
+    }
+
+    static vec4* shCoefficient(SphericalHarmonics& sh, const std::string& name)
+    {
+        for (auto& [coefficientName, member] : shCoefficients) {
+            if (name == coefficientName) {
+                return &(sh.*member);
+            }
+        }
+        return nullptr;
+    }
+};
+
+template<typename T>
+std::vector<T> readArray(const char*& cursor, size_t count)
+{
+    std::vector<T> values(count);
+    std::memcpy(values.data(), cursor, count * sizeof(T));
+    cursor += count * sizeof(T);
+    return values;
+}
+
+std::unique_ptr<Model> loadSphereSetBinary(const char* data, size_t sphereCount)
+{
+    std::vector<half> packedSpheres = readArray<half>(data, 4 * sphereCount);
+    std::vector<uint32_t> packedSH = readArray<uint32_t>(data, SH_PACKED_WORDS_HALF * sphereCount);
+
+    // (the CPU side copies are decoded from the packed data, so they match what's on the GPU exactly)
+    std::vector<SphereSetModel::Sphere> spheres(sphereCount);
+    std::vector<SphericalHarmonics> sphereSH(sphereCount);
+    for (size_t i = 0; i < sphereCount; ++i) {
+        const half* sphere = &packedSpheres[4 * i];
+        spheres[i] = { float(sphere[0]), float(sphere[1]), float(sphere[2]), float(sphere[3]) };
+
+        const half* halfs = reinterpret_cast<const half*>(&packedSH[SH_PACKED_WORDS_HALF * i]);
+        for (size_t c = 0; c < std::size(shCoefficients); ++c) {
+            const half* coefficient = &halfs[3 * c];
+            sphereSH[i].*shCoefficients[c].second = { float(coefficient[0]), float(coefficient[1]), float(coefficient[2]), 0.0f };
+        }
+    }
+
+    return std::make_unique<SphereSetModel>(std::move(spheres), std::move(sphereSH), std::move(packedSpheres));
+}
+
+template<typename T>
+std::vector<uint32_t> readWidenedArray(const char*& cursor, size_t count)
+{
+    std::vector<T> values = readArray<T>(cursor, count);
+    return std::vector<uint32_t>(values.begin(), values.end());
+}
+
+std::unique_ptr<Model> loadVoxelContoursBinary(const std::string& path, const char* data, size_t contourCount, size_t colorCount, uint32_t colorIndexSize)
+{
+    VoxelContourModel::PackedContours packed {};
+    packed.planes = readArray<half>(data, 4 * contourCount);
+    packed.aabbs = readArray<half>(data, 6 * contourCount);
+    switch (colorIndexSize) {
+    case sizeof(uint8_t):
+        packed.colorIndices = readWidenedArray<uint8_t>(data, contourCount);
+        break;
+    case sizeof(uint16_t):
+        packed.colorIndices = readWidenedArray<uint16_t>(data, contourCount);
+        break;
+    default:
+        packed.colorIndices = readArray<uint32_t>(data, contourCount);
+        break;
+    }
+    for (uint32_t colorIndex : packed.colorIndices) {
+        if (colorIndex >= colorCount) {
+            LogError("ProxyFile: color index %u is out of range (%zu colors) in '%s'.\n", colorIndex, colorCount, path.c_str());
+            return nullptr;
+        }
+    }
+    std::vector<vec4> packedColors = readArray<vec4>(data, colorCount);
+
+    std::vector<VoxelContourModel::VoxelContour> contours;
+    contours.reserve(contourCount);
+    for (size_t i = 0; i < contourCount; ++i) {
+        const half* plane = &packed.planes[4 * i];
+        const half* aabb = &packed.aabbs[6 * i];
+        contours.push_back({ .aabb = { vec3(float(aabb[0]), float(aabb[1]), float(aabb[2])), vec3(float(aabb[3]), float(aabb[4]), float(aabb[5])) },
+                             .normal = vec3(float(plane[0]), float(plane[1]), float(plane[2])),
+                             .distance = float(plane[3]),
+                             .colorIndex = packed.colorIndices[i] });
+    }
+
+    std::vector<vec3> colors(colorCount);
+    for (size_t i = 0; i < colorCount; ++i) {
+        colors[i] = vec3(packedColors[i]);
+    }
+
+    return std::make_unique<VoxelContourModel>(std::move(contours), std::move(colors), std::move(packed));
+}
+
+template<typename T>
+void writeArray(std::ofstream& file, const std::vector<T>& values)
+{
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template<typename T>
+void writeNarrowedArray(std::ofstream& file, const std::vector<uint32_t>& values)
+{
+    writeArray(file, std::vector<T>(values.begin(), values.end()));
+}
+
+}
+
+namespace ProxyFile {
+
+bool isBinaryProxyPath(const std::string& path)
+{
+    return hasExtension(path, ".proxy");
+}
+
+bool isJsonProxyPath(const std::string& path)
+{
+    return hasExtension(path, ".json");
+}
+
+std::string binaryPathForJson(const std::string& jsonPath)
+{
+    return std::filesystem::path(jsonPath).replace_extension(".proxy").generic_string();
+}
+
+std::optional<std::string> findConvertedProxy(const std::string& jsonPath)
+{
+    std::string binaryPath = binaryPathForJson(jsonPath);
+
+    std::error_code error;
+    if (!std::filesystem::exists(binaryPath, error)) {
+        return {};
+    }
+
+    auto jsonWriteTime = std::filesystem::last_write_time(jsonPath, error);
+    if (!error) {
+        auto binaryWriteTime = std::filesystem::last_write_time(binaryPath, error);
+        if (error || binaryWriteTime < jsonWriteTime) {
+            LogWarning("ProxyFile: binary proxy '%s' is out of date, using the JSON file. Run the proxy converter again!\n", binaryPath.c_str());
+            return {};
+        }
+    }
+
+    return binaryPath;
+}
+
+std::unique_ptr<Model> loadJson(const std::string& path, JsonParser parser)
+{
+    std::optional<FileIO::MappedFile> file = FileIO::mapFile(path);
+    if (!file.has_value()) {
+        LogError("ProxyFile: could not read proxy file '%s'.\n", path.c_str());
+        return nullptr;
+    }
+
+    std::string type;
+    if (parser == JsonParser::Streaming) {
+        ProxyStreamingParser streamingParser {};
+        if (!streamingParser.parse(file->begin(), file->end(), path)) {
+            return nullptr;
+        }
+
+        type = streamingParser.type;
+        if (type == "sphere-set") {
+            return std::make_unique<SphereSetModel>(std::move(streamingParser.spheres), std::move(streamingParser.sphereSH));
+        } else if (type == "voxel-contours") {
+            return std::make_unique<VoxelContourModel>(std::move(streamingParser.contours), std::move(streamingParser.colors));
+        }
+    } else {
+        json jsonProxy = json::parse(file->begin(), file->end());
+
+        type = jsonProxy.at("proxy");
+        if (type == "sphere-set") {
+            return loadSphereSetJson(jsonProxy);
+        } else if (type == "voxel-contours") {
+            return loadVoxelContoursJson(jsonProxy);
+        }
+    }
+
+    LogError("ProxyFile: unknown proxy type '%s' in '%s'.\n", type.c_str(), path.c_str());
+    return nullptr;
+}
+
+std::unique_ptr<Model> loadBinary(const std::string& path)
+{
+    std::optional<FileIO::MappedFile> file = FileIO::mapFile(path);
+    if (!file.has_value()) {
+        LogError("ProxyFile: could not read proxy file '%s'.\n", path.c_str());
+        return nullptr;
+    }
+
+    ProxyHeader header {};
+    if (file->size() < sizeof(header)) {
+        LogError("ProxyFile: '%s' is too small to be a proxy file.\n", path.c_str());
+        return nullptr;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, ProxyMagic, sizeof(ProxyMagic)) != 0 || header.version != ProxyVersion) {
+        LogError("ProxyFile: '%s' is not a proxy file of version %u.\n", path.c_str(), ProxyVersion);
+        return nullptr;
+    }
+
+    size_t dataSize;
+    switch (header.type) {
+    case ProxyType::SphereSet:
+        dataSize = sphereSetDataSize(header.primitiveCount);
+        break;
+    case ProxyType::VoxelContours:
+        if (header.colorIndexSize == 0) {
+            header.colorIndexSize = sizeof(uint32_t);
+        }
+        if (header.colorIndexSize != sizeof(uint8_t) && header.colorIndexSize != sizeof(uint16_t) && header.colorIndexSize != sizeof(uint32_t)) {
+            LogError("ProxyFile: invalid color index size %u in '%s'.\n", header.colorIndexSize, path.c_str());
+            return nullptr;
+        }
+        dataSize = voxelContoursDataSize(header.primitiveCount, header.colorCount, header.colorIndexSize);
+        break;
+    default:
+        LogError("ProxyFile: unknown proxy type %u in '%s'.\n", uint32_t(header.type), path.c_str());
+        return nullptr;
+    }
+
+    if (file->size() != sizeof(header) + dataSize) {
+        LogError("ProxyFile: '%s' does not match the size of its own header.\n", path.c_str());
+        return nullptr;
+    }
+
+    const char* data = file->data() + sizeof(header);
+    if (header.type == ProxyType::SphereSet) {
+        return loadSphereSetBinary(data, header.primitiveCount);
+    } else {
+        return loadVoxelContoursBinary(path, data, header.primitiveCount, header.colorCount, header.colorIndexSize);
+    }
+}
+
+bool writeBinary(const std::string& path, const Model& model)
+{
+    ProxyHeader header {};
+    std::memcpy(header.magic, ProxyMagic, sizeof(ProxyMagic));
+    header.version = ProxyVersion;
+
+    std::ofstream file;
+    auto openFile = [&]() {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LogError("ProxyFile: could not create '%s'.\n", path.c_str());
+            return false;
+        }
+        return true;
+    };
+
+    if (const auto* sphereSetModel = dynamic_cast<const SphereSetModel*>(&model)) {
+        header.type = ProxyType::SphereSet;
+        header.primitiveCount = uint32_t(sphereSetModel->spheres().size());
+
+        // (skipping the first word, since the packing is implied by the file format)
+        std::vector<uint32_t> packedSH = sphereSetModel->packedSphericalHarmonics(SphericalHarmonicsPacking::Half);
+
+        if (!openFile()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(file, sphereSetModel->packedSpheres());
+        file.write(reinterpret_cast<const char*>(packedSH.data() + 1), (packedSH.size() - 1) * sizeof(uint32_t));
+
+    } else if (const auto* voxelContourModel = dynamic_cast<const VoxelContourModel*>(&model)) {
+        header.type = ProxyType::VoxelContours;
+        header.primitiveCount = uint32_t(voxelContourModel->contours().size());
+        header.colorCount = uint32_t(voxelContourModel->colors().size());
+        header.colorIndexSize = colorIndexSizeForColorCount(header.colorCount);
+
+        std::vector<vec4> packedColors {};
+        for (const vec3& color : voxelContourModel->colors()) {
+            packedColors.emplace_back(color, 0.0f);
+        }
+
+        if (!openFile()) {
+            return false;
+        }
+        const VoxelContourModel::PackedContours& packed = voxelContourModel->packedContours();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(file, packed.planes);
+        writeArray(file, packed.aabbs);
+        switch (header.colorIndexSize) {
+        case sizeof(uint8_t):
+            writeNarrowedArray<uint8_t>(file, packed.colorIndices);
+            break;
+        case sizeof(uint16_t):
+            writeNarrowedArray<uint16_t>(file, packed.colorIndices);
+            break;
+        default:
+            writeArray(file, packed.colorIndices);
+            break;
+        }
+        writeArray(file, packedColors);
+
+    } else {
+        LogError("ProxyFile: can only write sphere-set & voxel-contour proxies.\n");
+        return false;
+    }
+
+    if (!file.good()) {
+        LogError("ProxyFile: could not write '%s'.\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "utility/JsonStreaming.h"
+#include "utility/Model.h"
+#include <memory>
+#include <optional>
+#include <string>
+
+// Loading of the sphere-set & voxel-contour proxies, from either their original JSON files or from the compact binary
+// .proxy files written by the ProxyConverter tool. The binary files store the data packed exactly as the GPU wants it
+// (see SphereSetModel::packedSpheres and VoxelContourModel::packedContours), so loading them is mostly a few memcpys
+// out of the mapped file.
+namespace ProxyFile {
+
+bool isBinaryProxyPath(const std::string& path);
+bool isJsonProxyPath(const std::string& path);
+
+// The path where the converter puts the binary version of a JSON proxy, i.e. the same path but with a .proxy extension
+std::string binaryPathForJson(const std::string& jsonPath);
+
+// Returns the path of the binary version of the JSON proxy, if it exists and is newer than the JSON file itself
+std::optional<std::string> findConvertedProxy(const std::string& jsonPath);
+
+std::unique_ptr<Model> loadJson(const std::string& path, JsonParser = JsonParser::Streaming);
+std::unique_ptr<Model> loadBinary(const std::string& path);
+
+// Only SphereSetModel & VoxelContourModel proxies can be written
+bool writeBinary(const std::string& path, const Model&);
+
+}
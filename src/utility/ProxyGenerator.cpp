@@ -0,0 +1,783 @@
+#include "ProxyGenerator.h"
+
+#include "rendering/cpu/CpuRayTracingScene.h"
+#include "utility/Logging.h"
+#include "utility/ThreadPool.h"
+#include "utility/VoxelContourOptimizer.h"
+#include "utility/models/SphereSetModel.h"
+#include "utility/models/VoxelContourModel.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+using ivec3 = glm::ivec3;
+
+// Runs func(i) for all i in [0, count), on all worker threads and the calling thread, which all grab chunks of indices
+// until there are none left. (Must not be called from a worker thread, since it waits for the other workers.)
+template<typename Func>
+void parallelFor(size_t count, size_t chunkSize, Func&& func)
+{
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    std::atomic<size_t> nextChunk { 0 };
+
+    auto work = [&]() {
+        for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            size_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; ++i) {
+                func(i);
+            }
+        }
+    };
+
+    std::vector<std::future<void>> workers {};
+    for (uint32_t i = 0; i < ThreadPool::global().threadCount() && i + 1 < chunkCount; ++i) {
+        workers.push_back(ThreadPool::global().enqueue(work));
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+}
+
+// Small & fast random numbers which can be seeded per work item, so the results don't depend on the thread count
+class Random {
+public:
+    explicit Random(uint32_t seed, uint32_t stream)
+    {
+        uint32_t state = seed * 0x9e3779b9u + stream;
+        state = (state ^ 61u) ^ (state >> 16u);
+        state *= 9u;
+        state = state ^ (state >> 4u);
+        state *= 0x27d4eb2du;
+        state = state ^ (state >> 15u);
+        m_state = std::max(state, 1u);
+    }
+
+    float randomFloat()
+    {
+        m_state ^= (m_state << 13u);
+        m_state ^= (m_state >> 17u);
+        m_state ^= (m_state << 5u);
+        return float(m_state) * (1.0f / 4294967296.0f);
+    }
+
+private:
+    uint32_t m_state;
+};
+
+float maxComponent(vec3 v)
+{
+    return std::max(std::max(v.x, v.y), v.z);
+}
+
+// Exact squared distance transform along one line of the grid (see "Distance Transforms of Sampled Functions" by
+// Felzenszwalb & Huttenlocher), where the input is zero for the features and "infinity" everywhere else
+void distanceTransformLine(std::vector<double>& values)
+{
+    constexpr double infinity = 1e20;
+    int n = int(values.size());
+
+    std::vector<double> f = values;
+    std::vector<int> v(n);
+    std::vector<double> z(n + 1);
+
+    int k = 0;
+    v[0] = 0;
+    z[0] = -infinity;
+    z[1] = +infinity;
+    for (int q = 1; q < n; ++q) {
+        double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        while (s <= z[k]) {
+            k -= 1;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        }
+        k += 1;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = +infinity;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) {
+            k += 1;
+        }
+        values[q] = double(q - v[k]) * double(q - v[k]) + f[v[k]];
+    }
+}
+
+// (in the same order and with the same normalization as sampleSphericalHarmonic in common.glsl)
+std::array<float, 9> sphericalHarmonicsBasis(vec3 dir)
+{
+    return { +0.282095f,
+             -0.488603f * dir.y,
+             +0.488603f * dir.z,
+             -0.488603f * dir.x,
+             +1.092548f * dir.x * dir.y,
+             -1.092548f * dir.y * dir.z,
+             +0.315392f * (-dir.x * dir.x - dir.y * dir.y + 2.0f * dir.z * dir.z),
+             +1.092548f * dir.x * dir.z,
+             +0.546274f * (dir.x * dir.x - dir.y * dir.y) };
+}
+
+// Solves A x = b for the symmetric positive definite 9x9 matrix A, for all three columns of b (i.e. color channels)
+bool solveCholesky(std::array<double, 81> A, std::array<vec3, 9>& bx)
+{
+    for (int j = 0; j < 9; ++j) {
+        double diagonal = A[j * 9 + j];
+        for (int k = 0; k < j; ++k) {
+            diagonal -= A[j * 9 + k] * A[j * 9 + k];
+        }
+        if (diagonal <= 0.0) {
+            return false;
+        }
+        A[j * 9 + j] = std::sqrt(diagonal);
+
+        for (int i = j + 1; i < 9; ++i) {
+            double value = A[i * 9 + j];
+            for (int k = 0; k < j; ++k) {
+                value -= A[i * 9 + k] * A[j * 9 + k];
+            }
+            A[i * 9 + j] = value / A[j * 9 + j];
+        }
+    }
+
+    for (int channel = 0; channel < 3; ++channel) {
+        std::array<double, 9> y {};
+        for (int i = 0; i < 9; ++i) {
+            double value = bx[i][channel];
+            for (int k = 0; k < i; ++k) {
+                value -= A[i * 9 + k] * y[k];
+            }
+            y[i] = value / A[i * 9 + i];
+        }
+        for (int i = 8; i >= 0; --i) {
+            double value = y[i];
+            for (int k = i + 1; k < 9; ++k) {
+                value -= A[k * 9 + i] * bx[k][channel];
+            }
+            bx[i][channel] = float(value / A[i * 9 + i]);
+        }
+    }
+
+    return true;
+}
+
+// Weighted k-means (with k-means++ seeding) of the colors, returns the palette and writes the palette index per color
+std::vector<vec3> clusterColors(const std::vector<vec3>& colors, const std::vector<float>& weights, uint32_t maxClusterCount, uint32_t seed, std::vector<uint32_t>& clusterIndices)
+{
+    clusterIndices.assign(colors.size(), 0);
+    if (colors.empty()) {
+        return {};
+    }
+
+    auto distanceSquared = [](vec3 a, vec3 b) { return dot(a - b, a - b); };
+
+    Random random { seed, 0 };
+    std::vector<vec3> palette { colors[0] };
+    std::vector<float> closest(colors.size());
+    while (palette.size() < maxClusterCount) {
+        double total = 0.0;
+        for (size_t i = 0; i < colors.size(); ++i) {
+            closest[i] = std::numeric_limits<float>::max();
+            for (const vec3& color : palette) {
+                closest[i] = std::min(closest[i], distanceSquared(colors[i], color));
+            }
+            total += weights[i] * closest[i];
+        }
+        if (total <= 0.0) {
+            break; // (there aren't any more distinct colors)
+        }
+
+        double target = random.randomFloat() * total;
+        size_t chosen = 0;
+        for (double sum = 0.0; chosen + 1 < colors.size(); ++chosen) {
+            sum += weights[chosen] * closest[chosen];
+            if (sum >= target && closest[chosen] > 0.0f) {
+                break;
+            }
+        }
+        palette.push_back(colors[chosen]);
+    }
+
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        std::vector<vec3> sums(palette.size(), vec3(0.0f));
+        std::vector<float> sumWeights(palette.size(), 0.0f);
+        for (size_t i = 0; i < colors.size(); ++i) {
+            uint32_t best = 0;
+            for (uint32_t c = 1; c < palette.size(); ++c) {
+                if (distanceSquared(colors[i], palette[c]) < distanceSquared(colors[i], palette[best])) {
+                    best = c;
+                }
+            }
+            clusterIndices[i] = best;
+            sums[best] += weights[i] * colors[i];
+            sumWeights[best] += weights[i];
+        }
+        for (size_t c = 0; c < palette.size(); ++c) {
+            if (sumWeights[c] > 0.0f) {
+                palette[c] = sums[c] / sumWeights[c];
+            }
+        }
+    }
+
+    return palette;
+}
+
+}
+
+ProxyGenerator::ProxyGenerator(const Model& model, const Settings& settings)
+    : m_settings(settings)
+{
+    vec3 boundsMin { std::numeric_limits<float>::max() };
+    vec3 boundsMax { -std::numeric_limits<float>::max() };
+
+    model.forEachMesh([&](const Mesh& mesh) {
+        MeshData meshData {};
+
+        // (in the object space of the model, just like the triangles in CpuRayTracingScene)
+        mat4 localMatrix = mesh.transform().localMatrix();
+        mat3 localNormalMatrix = mesh.transform().localNormalMatrix();
+        for (const vec3& position : mesh.positionData()) {
+            meshData.positions.push_back(vec3(localMatrix * vec4(position, 1.0f)));
+            boundsMin = glm::min(boundsMin, meshData.positions.back());
+            boundsMax = glm::max(boundsMax, meshData.positions.back());
+        }
+        for (const vec3& normal : mesh.normalData()) {
+            meshData.normals.push_back(normalize(localNormalMatrix * normal));
+        }
+        meshData.texcoords = mesh.texcoordData();
+
+        meshData.indices = mesh.indexData();
+        if (!mesh.isIndexed()) {
+            meshData.indices.resize(mesh.vertexCount());
+            std::iota(meshData.indices.begin(), meshData.indices.end(), 0u);
+        }
+
+        // (same as for the RT & forward passes, i.e. the factor is only used if there is no texture)
+        Material material = mesh.material();
+        meshData.baseColor = material.baseColor.empty() || meshData.texcoords.empty() ? nullptr : loadTexture(material.baseColor);
+        meshData.baseColorFactor = vec3(material.baseColorFactor);
+
+        m_meshes.push_back(std::move(meshData));
+    });
+
+    if (m_meshes.empty() || boundsMin.x > boundsMax.x) {
+        LogErrorAndExit("ProxyGenerator: the model doesn't have any meshes to generate proxies for, exiting\n");
+    }
+    m_bounds = aabb3(boundsMin, boundsMax);
+
+    sampleSurface();
+    voxelizeVolume(model);
+    placeSpheres();
+}
+
+ProxyGenerator::~ProxyGenerator() = default;
+
+const CpuTexture* ProxyGenerator::loadTexture(const std::string& path)
+{
+    auto entry = m_textures.find(path);
+    if (entry != m_textures.end()) {
+        return entry->second.get();
+    }
+
+    std::optional<Image::Info> info = Image::probe(path);
+    if (!info.has_value() || info->blockFormat.has_value()) {
+        LogWarning("ProxyGenerator: can't sample image '%s', using the base color factor instead\n", path.c_str());
+        m_textures[path] = nullptr;
+        return nullptr;
+    }
+
+    auto texture = std::make_unique<CpuTexture>();
+    texture->image = Image::load(path, *info, 4);
+    texture->srgb = !info->isHdr;
+    if (!texture->image.isValid()) {
+        LogWarning("ProxyGenerator: could not load image '%s', using the base color factor instead\n", path.c_str());
+        texture = nullptr;
+    }
+
+    const CpuTexture* texturePtr = texture.get();
+    m_textures[path] = std::move(texture);
+    return texturePtr;
+}
+
+void ProxyGenerator::sampleSurface()
+{
+    struct Triangle {
+        uint32_t mesh;
+        uint32_t firstIndex;
+        float area;
+    };
+
+    std::vector<Triangle> triangles {};
+    double totalArea = 0.0;
+    for (uint32_t meshIndex = 0; meshIndex < m_meshes.size(); ++meshIndex) {
+        const MeshData& mesh = m_meshes[meshIndex];
+        for (uint32_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            vec3 p0 = mesh.positions[mesh.indices[i + 0]];
+            vec3 p1 = mesh.positions[mesh.indices[i + 1]];
+            vec3 p2 = mesh.positions[mesh.indices[i + 2]];
+            float area = 0.5f * length(cross(p1 - p0, p2 - p0));
+            triangles.push_back({ meshIndex, i, area });
+            totalArea += area;
+        }
+    }
+
+    // Every triangle gets its expected number of samples, randomly rounded up or down, so that the samples are uniform
+    // over the surface while each triangle still can be sampled independently of all others
+    std::vector<uint32_t> firstSample(triangles.size() + 1, 0);
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        Random random { m_settings.seed, uint32_t(i) };
+        float expected = float(triangles[i].area / totalArea * m_settings.surfaceSampleCount);
+        firstSample[i + 1] = firstSample[i] + uint32_t(expected + random.randomFloat());
+    }
+
+    m_samples.resize(firstSample.back());
+    parallelFor(triangles.size(), 1024, [&](size_t i) {
+        const Triangle& triangle = triangles[i];
+        const MeshData& mesh = m_meshes[triangle.mesh];
+        uint32_t i0 = mesh.indices[triangle.firstIndex + 0];
+        uint32_t i1 = mesh.indices[triangle.firstIndex + 1];
+        uint32_t i2 = mesh.indices[triangle.firstIndex + 2];
+
+        vec3 geometricNormal = cross(mesh.positions[i1] - mesh.positions[i0], mesh.positions[i2] - mesh.positions[i0]);
+        geometricNormal = triangle.area > 0.0f ? normalize(geometricNormal) : vec3(0, 1, 0);
+
+        // (skipping the first number, which was used for the sample count)
+        Random random { m_settings.seed, uint32_t(i) };
+        random.randomFloat();
+
+        for (uint32_t sampleIndex = firstSample[i]; sampleIndex < firstSample[i + 1]; ++sampleIndex) {
+            float u = std::sqrt(random.randomFloat());
+            float v = random.randomFloat();
+            vec3 b = vec3(1.0f - u, u * (1.0f - v), u * v);
+
+            SurfaceSample& sample = m_samples[sampleIndex];
+            sample.position = b.x * mesh.positions[i0] + b.y * mesh.positions[i1] + b.z * mesh.positions[i2];
+
+            sample.normal = geometricNormal;
+            if (!mesh.normals.empty()) {
+                vec3 normal = b.x * mesh.normals[i0] + b.y * mesh.normals[i1] + b.z * mesh.normals[i2];
+                if (length(normal) > 1e-6f) {
+                    sample.normal = normalize(normal);
+                }
+            }
+
+            sample.color = mesh.baseColorFactor;
+            if (mesh.baseColor) {
+                vec2 uv = b.x * mesh.texcoords[i0] + b.y * mesh.texcoords[i1] + b.z * mesh.texcoords[i2];
+                sample.color = mesh.baseColor->sample(uv);
+            }
+        }
+    });
+}
+
+void ProxyGenerator::voxelizeVolume(const Model& model)
+{
+    // (with one voxel of padding, so that the outermost voxels are always outside)
+    vec3 extent = m_bounds.max - m_bounds.min;
+    m_gridVoxelSize = maxComponent(extent) / float(std::max(m_settings.volumeResolution, 1u));
+    m_gridOrigin = m_bounds.min - m_gridVoxelSize;
+    m_gridSize = glm::uvec3(glm::ceil(extent / m_gridVoxelSize)) + 2u;
+
+    auto voxelIndex = [&](glm::uvec3 voxel) -> size_t {
+        return voxel.x + size_t(m_gridSize.x) * (voxel.y + size_t(m_gridSize.y) * voxel.z);
+    };
+    size_t voxelCount = size_t(m_gridSize.x) * m_gridSize.y * m_gridSize.z;
+
+    // A voxel is inside if it's between a front face and a back face along at least two of the three axes, which works
+    // well enough for meshes that aren't completely closed. Voxels with any surface in them always count as inside.
+    CpuRayTracingScene rtScene { { &model }, false };
+    mat4 worldFromObject = model.transform().worldMatrix();
+
+    std::vector<uint8_t> insideVotes(voxelCount, 0);
+    for (int axis = 0; axis < 3; ++axis) {
+        int uAxis = (axis + 1) % 3;
+        int vAxis = (axis + 2) % 3;
+
+        vec3 objectDirection { 0.0f };
+        objectDirection[axis] = 1.0f;
+        vec3 worldDirection = mat3(worldFromObject) * objectDirection;
+        float worldScale = length(worldDirection);
+        worldDirection /= worldScale;
+
+        parallelFor(size_t(m_gridSize[uAxis]) * m_gridSize[vAxis], 64, [&](size_t column) {
+            glm::uvec3 voxel {};
+            voxel[uAxis] = uint32_t(column % m_gridSize[uAxis]);
+            voxel[vAxis] = uint32_t(column / m_gridSize[uAxis]);
+
+            vec3 objectOrigin = m_gridOrigin + (vec3(voxel) + 0.5f) * m_gridVoxelSize;
+            objectOrigin[axis] = m_gridOrigin[axis] - m_gridVoxelSize;
+
+            // All hits along the column, and whether they are on front faces
+            std::vector<std::pair<float, bool>> hits {};
+            Ray ray { .origin = vec3(worldFromObject * vec4(objectOrigin, 1.0f)),
+                      .direction = worldDirection,
+                      .tMin = 0.0f,
+                      .tMax = std::numeric_limits<float>::max() };
+            while (hits.size() < 1024) {
+                std::optional<CpuRayTracingScene::Hit> hit = rtScene.traceRay(ray, 0xff, false);
+                if (!hit.has_value()) {
+                    break;
+                }
+                hits.emplace_back(hit->t, dot(hit->normal, worldDirection) < 0.0f);
+                ray.tMin = hit->t + 1e-5f * m_gridVoxelSize * worldScale;
+                ray.tMax = std::numeric_limits<float>::max();
+            }
+
+            size_t nextHit = 0;
+            for (uint32_t i = 0; i < m_gridSize[axis]; ++i) {
+                float t = (float(i) + 1.5f) * m_gridVoxelSize * worldScale;
+                while (nextHit < hits.size() && hits[nextHit].first < t) {
+                    nextHit += 1;
+                }
+                bool afterFrontFace = nextHit > 0 && hits[nextHit - 1].second;
+                bool beforeBackFace = nextHit < hits.size() && !hits[nextHit].second;
+                if (afterFrontFace && beforeBackFace) {
+                    voxel[axis] = i;
+                    insideVotes[voxelIndex(voxel)] += 1;
+                }
+            }
+        });
+    }
+
+    for (const SurfaceSample& sample : m_samples) {
+        glm::uvec3 voxel = glm::uvec3(glm::clamp(ivec3(glm::floor((sample.position - m_gridOrigin) / m_gridVoxelSize)), ivec3(1), ivec3(m_gridSize) - 2));
+        insideVotes[voxelIndex(voxel)] = 3;
+    }
+
+    // The distance from every inside voxel to the closest outside voxel, one axis at a time
+    std::vector<double> squaredDistances(voxelCount);
+    for (size_t i = 0; i < voxelCount; ++i) {
+        squaredDistances[i] = (insideVotes[i] >= 2) ? 1e20 : 0.0;
+    }
+
+    for (int axis = 0; axis < 3; ++axis) {
+        int uAxis = (axis + 1) % 3;
+        int vAxis = (axis + 2) % 3;
+        parallelFor(size_t(m_gridSize[uAxis]) * m_gridSize[vAxis], 64, [&](size_t line) {
+            glm::uvec3 voxel {};
+            voxel[uAxis] = uint32_t(line % m_gridSize[uAxis]);
+            voxel[vAxis] = uint32_t(line / m_gridSize[uAxis]);
+
+            std::vector<double> values(m_gridSize[axis]);
+            for (uint32_t i = 0; i < m_gridSize[axis]; ++i) {
+                voxel[axis] = i;
+                values[i] = squaredDistances[voxelIndex(voxel)];
+            }
+            distanceTransformLine(values);
+            for (uint32_t i = 0; i < m_gridSize[axis]; ++i) {
+                voxel[axis] = i;
+                squaredDistances[voxelIndex(voxel)] = values[i];
+            }
+        });
+    }
+
+    m_surfaceDistance.resize(voxelCount);
+    for (size_t i = 0; i < voxelCount; ++i) {
+        m_surfaceDistance[i] = float(std::sqrt(squaredDistances[i]));
+    }
+}
+
+void ProxyGenerator::placeSpheres()
+{
+    std::vector<uint32_t> insideVoxels {};
+    for (uint32_t i = 0; i < m_surfaceDistance.size(); ++i) {
+        if (m_surfaceDistance[i] > 0.0f) {
+            insideVoxels.push_back(i);
+        }
+    }
+    std::stable_sort(insideVoxels.begin(), insideVoxels.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return m_surfaceDistance[lhs] > m_surfaceDistance[rhs];
+    });
+
+    std::vector<bool> covered(m_surfaceDistance.size(), false);
+    for (uint32_t index : insideVoxels) {
+        if (covered[index]) {
+            continue;
+        }
+
+        ivec3 voxel { int(index % m_gridSize.x), int((index / m_gridSize.x) % m_gridSize.y), int(index / (size_t(m_gridSize.x) * m_gridSize.y)) };
+
+        // (the surface is somewhere between the center of the closest outside voxel and the center of its neighbour, so
+        // go halfway, but always far enough to cover the whole voxel)
+        float radius = std::max(m_surfaceDistance[index] - 0.5f, 0.5f * std::sqrt(3.0f));
+        vec3 center = m_gridOrigin + (vec3(voxel) + 0.5f) * m_gridVoxelSize;
+        m_spheres.emplace_back(center, radius * m_gridVoxelSize);
+
+        int reach = int(std::ceil(radius));
+        ivec3 lo = glm::max(voxel - reach, ivec3(0));
+        ivec3 hi = glm::min(voxel + reach, ivec3(m_gridSize) - 1);
+        for (int z = lo.z; z <= hi.z; ++z) {
+            for (int y = lo.y; y <= hi.y; ++y) {
+                for (int x = lo.x; x <= hi.x; ++x) {
+                    vec3 offset = vec3(x, y, z) - vec3(voxel);
+                    if (dot(offset, offset) <= radius * radius) {
+                        covered[x + size_t(m_gridSize.x) * (y + size_t(m_gridSize.y) * z)] = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::unique_ptr<SphereSetModel> ProxyGenerator::generateSphereSet(uint32_t sphereCount) const
+{
+    std::vector<SphereSetModel::Sphere> spheres(m_spheres.begin(), m_spheres.begin() + std::min(size_t(sphereCount), m_spheres.size()));
+
+    // Find the closest sphere of every surface sample, by the distance to the sphere's surface. The spheres are sorted
+    // into a coarse grid by their bounds plus a margin, so if the closest sphere in a cell is within the margin, it must
+    // be the closest of all spheres, and otherwise we have to look at all of them.
+    float cellSize = 4.0f * m_gridVoxelSize;
+    float margin = 2.0f * m_gridVoxelSize;
+    ivec3 cellCount = ivec3(glm::ceil((m_bounds.max - m_bounds.min) / cellSize)) + 1;
+    auto cellOf = [&](vec3 point) { return glm::clamp(ivec3(glm::floor((point - m_bounds.min) / cellSize)), ivec3(0), cellCount - 1); };
+    auto cellIndex = [&](ivec3 cell) { return size_t(cell.x) + size_t(cellCount.x) * (cell.y + size_t(cellCount.y) * cell.z); };
+
+    std::vector<std::vector<uint32_t>> spheresInCell(size_t(cellCount.x) * cellCount.y * cellCount.z);
+    for (uint32_t i = 0; i < spheres.size(); ++i) {
+        vec3 center = vec3(spheres[i]);
+        float reach = spheres[i].w + margin;
+        ivec3 lo = cellOf(center - reach);
+        ivec3 hi = cellOf(center + reach);
+        for (int z = lo.z; z <= hi.z; ++z) {
+            for (int y = lo.y; y <= hi.y; ++y) {
+                for (int x = lo.x; x <= hi.x; ++x) {
+                    spheresInCell[cellIndex(ivec3(x, y, z))].push_back(i);
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> closestSphere(m_samples.size(), 0);
+    parallelFor(m_samples.size(), 4096, [&](size_t sampleIndex) {
+        vec3 position = m_samples[sampleIndex].position;
+        auto surfaceDistance = [&](uint32_t sphere) { return distance(position, vec3(spheres[sphere])) - spheres[sphere].w; };
+
+        float closestDistance = std::numeric_limits<float>::max();
+        for (uint32_t sphere : spheresInCell[cellIndex(cellOf(position))]) {
+            float sphereDistance = surfaceDistance(sphere);
+            if (sphereDistance < closestDistance || (sphereDistance == closestDistance && sphere < closestSphere[sampleIndex])) {
+                closestDistance = sphereDistance;
+                closestSphere[sampleIndex] = sphere;
+            }
+        }
+        if (closestDistance > margin) {
+            for (uint32_t sphere = 0; sphere < spheres.size(); ++sphere) {
+                float sphereDistance = surfaceDistance(sphere);
+                if (sphereDistance < closestDistance) {
+                    closestDistance = sphereDistance;
+                    closestSphere[sampleIndex] = sphere;
+                }
+            }
+        }
+    });
+
+    std::vector<std::vector<uint32_t>> samplesOfSphere(spheres.size());
+    vec3 averageColor { 0.0f };
+    for (uint32_t sampleIndex = 0; sampleIndex < m_samples.size(); ++sampleIndex) {
+        samplesOfSphere[closestSphere[sampleIndex]].push_back(sampleIndex);
+        averageColor += m_samples[sampleIndex].color / float(m_samples.size());
+    }
+
+    // Least squares fit of the SH to the colors in the directions of the samples, as seen from the sphere center (which
+    // is also the direction of the normal that the SH are evaluated for). The bands above the constant one are slightly
+    // regularized, so that directions without any samples just get the average color.
+    std::vector<SphericalHarmonics> sphericalHarmonics(spheres.size());
+    parallelFor(spheres.size(), 1, [&](size_t sphereIndex) {
+        std::array<double, 81> A {};
+        std::array<vec3, 9> b {};
+        b[0] = averageColor / 0.282095f;
+
+        const std::vector<uint32_t>& samples = samplesOfSphere[sphereIndex];
+        if (!samples.empty()) {
+            b[0] = vec3(0.0f);
+            for (uint32_t sampleIndex : samples) {
+                const SurfaceSample& sample = m_samples[sampleIndex];
+                vec3 toSample = sample.position - vec3(spheres[sphereIndex]);
+                vec3 direction = length(toSample) > 1e-6f ? normalize(toSample) : sample.normal;
+
+                std::array<float, 9> basis = sphericalHarmonicsBasis(direction);
+                for (int i = 0; i < 9; ++i) {
+                    for (int j = 0; j < 9; ++j) {
+                        A[i * 9 + j] += double(basis[i]) * basis[j];
+                    }
+                    b[i] += basis[i] * sample.color;
+                }
+            }
+
+            // (for uniformly distributed directions A is the identity times this, since the basis is orthonormal)
+            double uniformScale = double(samples.size()) / (4.0 * mathkit::PI);
+            A[0] += 1e-4 * uniformScale;
+            for (int i = 1; i < 9; ++i) {
+                A[i * 9 + i] += 0.1 * uniformScale;
+            }
+
+            if (!solveCholesky(A, b)) {
+                b = {};
+                b[0] = averageColor / 0.282095f;
+            }
+        }
+
+        SphericalHarmonics& sh = sphericalHarmonics[sphereIndex];
+        sh.L00 = vec4(b[0], 0.0f);
+        sh.L1_1 = vec4(b[1], 0.0f);
+        sh.L10 = vec4(b[2], 0.0f);
+        sh.L11 = vec4(b[3], 0.0f);
+        sh.L2_2 = vec4(b[4], 0.0f);
+        sh.L2_1 = vec4(b[5], 0.0f);
+        sh.L20 = vec4(b[6], 0.0f);
+        sh.L21 = vec4(b[7], 0.0f);
+        sh.L22 = vec4(b[8], 0.0f);
+    });
+
+    return std::make_unique<SphereSetModel>(std::move(spheres), std::move(sphericalHarmonics));
+}
+
+float ProxyGenerator::contourVoxelSize(uint32_t resolution) const
+{
+    return maxComponent(m_bounds.max - m_bounds.min) / float(resolution);
+}
+
+std::unique_ptr<VoxelContourModel> ProxyGenerator::fitVoxelContours(uint32_t resolution, size_t* unmergedContours) const
+{
+    struct Cell {
+        vec3 normalSum { 0.0f };
+        vec3 positionSum { 0.0f };
+        vec3 colorSum { 0.0f };
+        uint32_t sampleCount { 0 };
+        vec3 firstNormal {};
+    };
+
+    float voxelSize = contourVoxelSize(resolution);
+    auto cellKey = [](glm::uvec3 cell) -> uint64_t {
+        return (uint64_t(cell.z) << 42) | (uint64_t(cell.y) << 21) | uint64_t(cell.x);
+    };
+
+    std::unordered_map<uint64_t, Cell> cells {};
+    for (const SurfaceSample& sample : m_samples) {
+        glm::uvec3 cell = glm::uvec3(glm::max(ivec3(glm::floor((sample.position - m_bounds.min) / voxelSize)), ivec3(0)));
+        Cell& cellData = cells[cellKey(cell)];
+        if (cellData.sampleCount == 0) {
+            cellData.firstNormal = sample.normal;
+        }
+        cellData.normalSum += sample.normal;
+        cellData.positionSum += sample.position;
+        cellData.colorSum += sample.color;
+        cellData.sampleCount += 1;
+    }
+
+    std::vector<uint64_t> keys {};
+    keys.reserve(cells.size());
+    for (const auto& [key, cell] : cells) {
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    // One contour per voxel, through the centroid of the samples and with their average normal
+    std::vector<VoxelContourModel::VoxelContour> contours {};
+    std::vector<vec3> colors {};
+    std::vector<float> weights {};
+    for (uint64_t key : keys) {
+        const Cell& cellData = cells[key];
+        glm::uvec3 cell { uint32_t(key & 0x1fffff), uint32_t((key >> 21) & 0x1fffff), uint32_t(key >> 42) };
+
+        // (surfaces facing opposite directions can cancel out, e.g. for thin walls, so then pick one of them)
+        vec3 normal = length(cellData.normalSum) > 0.1f * cellData.sampleCount ? normalize(cellData.normalSum) : cellData.firstNormal;
+        vec3 centroid = cellData.positionSum / float(cellData.sampleCount);
+
+        vec3 cellMin = m_bounds.min + vec3(cell) * voxelSize;
+        contours.push_back({ .aabb = aabb3(cellMin, cellMin + voxelSize),
+                             .normal = normal,
+                             .distance = dot(normal, centroid),
+                             .colorIndex = 0 });
+        colors.push_back(cellData.colorSum / float(cellData.sampleCount));
+        weights.push_back(float(cellData.sampleCount));
+    }
+
+    std::vector<uint32_t> colorIndices {};
+    std::vector<vec3> palette = clusterColors(colors, weights, m_settings.contourColorCount, m_settings.seed, colorIndices);
+    for (size_t i = 0; i < contours.size(); ++i) {
+        contours[i].colorIndex = colorIndices[i];
+    }
+
+    if (unmergedContours) {
+        *unmergedContours = contours.size();
+    }
+
+    VoxelContourModel unmerged { std::move(contours), std::move(palette) };
+    return VoxelContourOptimizer::optimize(unmerged, VoxelContourOptimizer::Settings());
+}
+
+std::unique_ptr<VoxelContourModel> ProxyGenerator::generateVoxelContours(uint32_t contourCount, ContourStatistics* statistics)
+{
+    // Fits the contours at all of the resolutions that we don't yet know the contour counts of, in parallel
+    auto evaluateResolutions = [&](const std::vector<uint32_t>& resolutions) {
+        std::vector<uint32_t> unknown {};
+        for (uint32_t resolution : resolutions) {
+            if (m_contourCounts.count(resolution) == 0) {
+                unknown.push_back(resolution);
+            }
+        }
+        std::vector<size_t> counts(unknown.size());
+        parallelFor(unknown.size(), 1, [&](size_t i) {
+            counts[i] = fitVoxelContours(unknown[i])->contours().size();
+        });
+        for (size_t i = 0; i < unknown.size(); ++i) {
+            m_contourCounts[unknown[i]] = counts[i];
+        }
+    };
+
+    // The contour count grows with the resolution (roughly quadratically), so first find the range of resolutions to
+    // look in, by stepping through the resolutions in steps of a quarter octave (a batch at a time, for all threads),
+    std::vector<uint32_t> steps {};
+    for (float resolution = 2.0f; resolution <= float(m_settings.maxContourResolution); resolution *= std::pow(2.0f, 0.25f)) {
+        if (steps.empty() || uint32_t(resolution) != steps.back()) {
+            steps.push_back(uint32_t(resolution));
+        }
+    }
+
+    uint32_t batchSize = ThreadPool::global().threadCount() + 1;
+    size_t firstTooLarge = steps.size();
+    for (size_t batchStart = 0; batchStart < steps.size() && firstTooLarge == steps.size(); batchStart += batchSize) {
+        std::vector<uint32_t> batch(steps.begin() + batchStart, steps.begin() + std::min(batchStart + batchSize, steps.size()));
+        evaluateResolutions(batch);
+        for (size_t i = batchStart; i < batchStart + batch.size(); ++i) {
+            if (m_contourCounts[steps[i]] > contourCount) {
+                firstTooLarge = i;
+                break;
+            }
+        }
+    }
+
+    // .. and then try every resolution in that range
+    uint32_t rangeMin = firstTooLarge > 0 ? steps[firstTooLarge - 1] : 1;
+    uint32_t rangeMax = firstTooLarge < steps.size() ? steps[firstTooLarge] : m_settings.maxContourResolution + 1;
+    std::vector<uint32_t> range(rangeMax - rangeMin);
+    std::iota(range.begin(), range.end(), rangeMin);
+    evaluateResolutions(range);
+
+    uint32_t bestResolution = 0;
+    for (uint32_t resolution : range) {
+        if (m_contourCounts[resolution] <= contourCount) {
+            bestResolution = resolution;
+        }
+    }
+    if (bestResolution == 0) {
+        LogWarning("ProxyGenerator: can't fit the voxel contours in %u contours, using the lowest resolution\n", contourCount);
+        bestResolution = 1;
+    }
+
+    ContourStatistics contourStatistics { .resolution = bestResolution, .voxelSize = contourVoxelSize(bestResolution) };
+    std::unique_ptr<VoxelContourModel> voxelContours = fitVoxelContours(bestResolution, &contourStatistics.unmergedContours);
+    if (statistics) {
+        *statistics = contourStatistics;
+    }
+
+    return voxelContours;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "rendering/cpu/CpuTexture.h"
+#include "utility/Model.h"
+#include "utility/mathkit.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+class SphereSetModel;
+class VoxelContourModel;
+
+// Generates sphere-set & voxel-contour proxies for any model with meshes, at a given primitive budget. The proxies are
+// in the object space of the model (i.e. with the mesh transforms applied), just like the ones loaded from files, and
+// their colors are fitted to the base color of the meshes, so meshes with a baked color texture work best.
+//
+// Everything that is shared between budgets is prepared once in the constructor (on all threads), so that sweeping
+// over budgets is cheap:
+//  - the surface is sampled uniformly, with a base color, normal, and position per sample
+//  - the volume is voxelized and every voxel inside the mesh gets its distance to the surface
+//  - spheres are placed greedily at the voxel furthest from the surface that isn't covered by any previous sphere, so
+//    the sphere set for any budget is simply the first N of them
+// The SH of the spheres are fitted (per budget) to the colors of the surface samples that are closest to each sphere,
+// and the voxel contours are fitted to the samples in each voxel, at the finest voxel resolution that still fits the
+// budget after merging (see VoxelContourOptimizer).
+class ProxyGenerator {
+public:
+    struct Settings {
+        uint32_t surfaceSampleCount { 500'000 };
+        uint32_t volumeResolution { 96 }; // voxels along the longest side of the bounds, for placing spheres
+        uint32_t maxContourResolution { 512 }; // (same, but for the voxel contours)
+        uint32_t contourColorCount { 40 }; // colors in the palette of the voxel contours (at most)
+        uint32_t seed { 0 };
+    };
+
+    struct ContourStatistics {
+        uint32_t resolution { 0 }; // voxels along the longest side of the bounds
+        float voxelSize { 0.0f };
+        size_t unmergedContours { 0 };
+    };
+
+    ProxyGenerator(const Model&, const Settings&);
+    ~ProxyGenerator();
+
+    [[nodiscard]] aabb3 bounds() const { return m_bounds; }
+    [[nodiscard]] size_t maxSphereCount() const { return m_spheres.size(); }
+
+    [[nodiscard]] std::unique_ptr<SphereSetModel> generateSphereSet(uint32_t sphereCount) const;
+
+    // (the contour counts of all resolutions that are tried are remembered, so sweeping over budgets gets cheaper)
+    [[nodiscard]] std::unique_ptr<VoxelContourModel> generateVoxelContours(uint32_t contourCount, ContourStatistics* = nullptr);
+
+private:
+    struct SurfaceSample {
+        vec3 position;
+        vec3 normal;
+        vec3 color;
+    };
+
+    struct MeshData {
+        std::vector<vec3> positions;
+        std::vector<vec3> normals;
+        std::vector<vec2> texcoords;
+        std::vector<uint32_t> indices;
+
+        const CpuTexture* baseColor;
+        vec3 baseColorFactor;
+    };
+
+    const CpuTexture* loadTexture(const std::string& path);
+
+    void sampleSurface();
+    void voxelizeVolume(const Model&);
+    void placeSpheres();
+
+    float contourVoxelSize(uint32_t resolution) const;
+    std::unique_ptr<VoxelContourModel> fitVoxelContours(uint32_t resolution, size_t* unmergedContours = nullptr) const;
+
+    Settings m_settings;
+    aabb3 m_bounds { vec3(0.0f), vec3(0.0f) };
+
+    std::vector<MeshData> m_meshes {};
+    std::map<std::string, std::unique_ptr<CpuTexture>> m_textures {};
+
+    std::vector<SurfaceSample> m_samples {};
+
+    vec3 m_gridOrigin {};
+    float m_gridVoxelSize {};
+    glm::uvec3 m_gridSize {};
+    std::vector<float> m_surfaceDistance {}; // (per voxel, in voxels, and zero for voxels outside of the mesh)
+
+    std::vector<vec4> m_spheres {}; // (center & radius, in the greedy order)
+
+    std::map<uint32_t, size_t> m_contourCounts {}; // (per resolution)
+};
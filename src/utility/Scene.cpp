@@ -2,9 +2,9 @@
 
 #include "utility/FileIO.h"
 #include "utility/Logging.h"
+#include "utility/ProxyFile.h"
+#include "utility/SceneFile.h"
 #include "utility/models/GltfModel.h"
-#include "utility/models/SphereSetModel.h"
-#include "utility/models/VoxelContourModel.h"
 #include <fstream>
 #include <imgui.h>
 #include <json.hpp>
@@ -34,112 +34,96 @@ void Scene::forEachLight(std::function<void(const Light&)> callback) const
 
 std::unique_ptr<Scene> Scene::loadFromFile(const std::string& path)
 {
-    using json = nlohmann::json;
-
     if (!FileIO::isFileReadable(path)) {
         LogErrorAndExit("Could not read scene file '%s', exiting\n", path.c_str());
     }
 
-    json jsonScene;
-    std::ifstream fileStream(path);
-    fileStream >> jsonScene;
+    std::optional<FileIO::MappedFile> sceneFile = FileIO::mapFile(path);
+    if (!sceneFile.has_value()) {
+        LogErrorAndExit("Could not read scene file '%s', exiting\n", path.c_str());
+    }
+
+    std::optional<SceneFile::Description> description = SceneFile::parse(sceneFile->begin(), sceneFile->end(), path);
+    if (!description.has_value()) {
+        LogErrorAndExit("Could not parse scene file '%s', exiting\n", path.c_str());
+    }
 
     auto scene = std::make_unique<Scene>(path);
 
-    auto jsonEnv = jsonScene.at("environment");
-    scene->m_environmentMap = jsonEnv.at("texture");
-    scene->m_environmentMultiplier = jsonEnv.at("multiplier");
+    scene->m_environmentMap = description->environmentMap;
+    scene->m_environmentMultiplier = description->environmentMultiplier;
+    scene->m_environmentMapMipmaps = description->environmentMapMipmaps;
+    if (description->environmentMapFormat.has_value()) {
+        scene->m_environmentMapFormat = description->environmentMapFormat.value();
+    }
+
+    if (description->textureStreamingBudgetMB.has_value()) {
+        scene->m_textureStreamingBudget = size_t(description->textureStreamingBudgetMB.value() * 1024.0f * 1024.0f);
+    }
+
+    if (description->shPacking.has_value()) {
+        scene->m_shPacking = description->shPacking.value();
+    }
 
-    for (auto& jsonModel : jsonScene.at("models")) {
-        std::string modelGltf = jsonModel.at("gltf");
+    if (description->sphereOrder.has_value()) {
+        scene->m_sphereOrder = description->sphereOrder.value();
+    }
 
-        auto model = GltfModel::load(modelGltf);
+    for (const SceneFile::ModelDescription& modelDescription : description->models) {
+        auto model = GltfModel::load(modelDescription.gltf, modelDescription.optimize);
         if (!model) {
             continue;
         }
 
-        std::string name = jsonModel.at("name");
-        model->setName(name);
+        model->setName(modelDescription.name);
 
-        if (jsonModel.find("proxy") != jsonModel.end()) {
-            std::string proxyPath = jsonModel.at("proxy");
-            auto proxy = loadProxy(proxyPath);
+        if (!modelDescription.proxy.empty()) {
+            auto proxy = loadProxy(modelDescription.proxy);
+            if (auto* sphereSetModel = dynamic_cast<SphereSetModel*>(proxy.get())) {
+                sphereSetModel->sortSpheres(scene->m_sphereOrder);
+            }
             if (proxy) {
                 model->setProxy(std::move(proxy));
             }
         }
 
-        auto transform = jsonModel.at("transform");
-
-        std::vector<float> translation = transform.at("translation");
-        std::vector<float> scale = transform.at("scale");
-
-        mat4 rotationMatrix;
-        auto jsonRotation = transform.at("rotation");
-        std::string rotType = jsonRotation.at("type");
-        if (rotType == "axis-angle") {
-            float angle = jsonRotation.at("angle");
-            std::vector<float> axis = jsonRotation.at("axis");
-            rotationMatrix = mathkit::axisAngleMatrix({ axis[0], axis[1], axis[2] }, angle);
-        } else {
-            ASSERT_NOT_REACHED();
-        }
+        const vec3& translation = modelDescription.translation;
+        const vec3& scale = modelDescription.scale;
+        mat4 rotationMatrix = mathkit::axisAngleMatrix(modelDescription.rotationAxis, modelDescription.rotationAngle);
 
-        mat4 localMatrix = mathkit::translate(translation[0], translation[1], translation[2])
-            * rotationMatrix * mathkit::scale(scale[0], scale[1], scale[2]);
+        mat4 localMatrix = mathkit::translate(translation.x, translation.y, translation.z)
+            * rotationMatrix * mathkit::scale(scale.x, scale.y, scale.z);
         model->transform().setLocalMatrix(localMatrix);
 
         scene->addModel(std::move(model));
     }
 
-    for (auto& jsonLight : jsonScene.at("lights")) {
-        ASSERT(jsonLight.at("type") == "directional");
+    if (description->sun.has_value()) {
+        const SceneFile::SunDescription& sunDescription = description->sun.value();
 
         SunLight sun {};
+        sun.color = sunDescription.color;
+        sun.intensity = sunDescription.intensity;
+        sun.direction = normalize(sunDescription.direction);
+        sun.worldExtent = sunDescription.worldExtent;
 
-        float color[3];
-        jsonLight.at("color").get_to(color);
-        sun.color = { color[0], color[1], color[2] };
-
-        sun.intensity = jsonLight.at("intensity");
-
-        float dir[3];
-        jsonLight.at("direction").get_to(dir);
-        sun.direction = normalize(vec3(dir[0], dir[1], dir[2]));
-
-        sun.worldExtent = jsonLight.at("worldExtent");
-
-        int mapSize[2];
-        jsonLight.at("shadowMapSize").get_to(mapSize);
-        ShadowMapSpec shadowMap { { mapSize[0], mapSize[1] }, "directional" };
+        ShadowMapSpec shadowMap { { sunDescription.shadowMapSize[0], sunDescription.shadowMapSize[1] }, "directional" };
         sun.shadowMap = shadowMap;
 
-        // TODO!
         scene->m_sunLight = sun;
     }
 
-    for (auto& jsonCamera : jsonScene.at("cameras")) {
-
+    for (const SceneFile::CameraDescription& cameraDescription : description->cameras) {
         FpsCamera camera;
-
-        std::string name = jsonCamera.at("name");
-
-        float origin[3];
-        jsonCamera.at("origin").get_to(origin);
-
-        float target[3];
-        jsonCamera.at("target").get_to(target);
-
-        camera.lookAt({ origin[0], origin[1], origin[2] }, { target[0], target[1], target[2] }, mathkit::globalUp);
-        scene->m_allCameras[name] = camera;
+        camera.lookAt(cameraDescription.origin, cameraDescription.target, mathkit::globalUp);
+        scene->m_allCameras[cameraDescription.name] = camera;
     }
 
     scene->loadAdditionalCameras();
 
-    std::string mainCamera = jsonScene.at("camera");
-    auto entry = scene->m_allCameras.find(mainCamera);
+    auto entry = scene->m_allCameras.find(description->mainCamera);
     if (entry != scene->m_allCameras.end()) {
-        scene->m_currentMainCamera = scene->m_allCameras[mainCamera];
+        scene->m_currentMainCamera = entry->second;
     }
 
     return scene;
@@ -278,109 +262,18 @@ void Scene::loadAdditionalCameras()
 
 std::unique_ptr<Model> Scene::loadProxy(const std::string& path)
 {
-    using json = nlohmann::json;
+    if (ProxyFile::isBinaryProxyPath(path)) {
+        return ProxyFile::loadBinary(path);
+    }
 
-    std::string extension = path.substr(path.length() - 4);
-    if (extension == "json") {
-        std::ifstream proxyStream(path);
-        json jsonProxy;
-        proxyStream >> jsonProxy;
-
-        std::string type = jsonProxy.at("proxy");
-        if (type == "sphere-set") {
-            return loadSphereSetProxy(jsonProxy);
-        } else if (type == "voxel-contours") {
-            return loadVoxelContourProxy(jsonProxy);
-        } else {
-            ASSERT_NOT_REACHED();
+    if (ProxyFile::isJsonProxyPath(path)) {
+        // (prefer the converted binary version if there is one, it's both smaller and much faster to load)
+        if (auto binaryPath = ProxyFile::findConvertedProxy(path)) {
+            return ProxyFile::loadBinary(binaryPath.value());
         }
+        return ProxyFile::loadJson(path);
     }
 
     // Else, assume it's a gltf and simply fail if it isn't..
     return GltfModel::load(path);
 }
-
-std::unique_ptr<Model> Scene::loadSphereSetProxy(const nlohmann::json& proxy)
-{
-    using json = nlohmann::json;
-
-    std::vector<SphereSetModel::Sphere> spheres;
-    std::vector<SphericalHarmonics> sphereSH;
-
-    for (auto& jsonSphere : proxy.at("spheres")) {
-        std::vector<float> center = jsonSphere.at("center");
-        float radius = jsonSphere.at("radius");
-
-        SphereSetModel::Sphere sphere { center[0], center[1], center[2], radius };
-        spheres.push_back(sphere);
-
-        auto jsonSh = jsonSphere.at("sh");
-        SphericalHarmonics sh;
-
-        std::vector<float> L00 = jsonSh.at("L00");
-        sh.L00 = { L00[0], L00[1], L00[2], 0 };
-
-        std::vector<float> L1_1 = jsonSh.at("L1_1");
-        sh.L1_1 = { L1_1[0], L1_1[1], L1_1[2], 0 };
-
-        std::vector<float> L10 = jsonSh.at("L10");
-        sh.L10 = { L10[0], L10[1], L10[2], 0 };
-
-        std::vector<float> L11 = jsonSh.at("L11");
-        sh.L11 = { L11[0], L11[1], L11[2], 0 };
-
-        std::vector<float> L2_2 = jsonSh.at("L2_2");
-        sh.L2_2 = { L2_2[0], L2_2[1], L2_2[2], 0 };
-
-        std::vector<float> L2_1 = jsonSh.at("L2_1");
-        sh.L2_1 = { L2_1[0], L2_1[1], L2_1[2], 0 };
-
-        std::vector<float> L20 = jsonSh.at("L20");
-        sh.L20 = { L20[0], L20[1], L20[2], 0 };
-
-        std::vector<float> L21 = jsonSh.at("L21");
-        sh.L21 = { L21[0], L21[1], L21[2], 0 };
-
-        std::vector<float> L22 = jsonSh.at("L22");
-        sh.L22 = { L22[0], L22[1], L22[2], 0 };
-
-        sphereSH.push_back(sh);
-    }
-
-    return std::make_unique<SphereSetModel>(spheres, sphereSH);
-}
-
-std::unique_ptr<Model> Scene::loadVoxelContourProxy(const nlohmann::json& proxy)
-{
-    using json = nlohmann::json;
-
-    std::vector<VoxelContourModel::VoxelContour> contours;
-    for (auto& jsonContour : proxy.at("contours")) {
-
-        std::vector<float> minC = jsonContour.at("aabbMin");
-        std::vector<float> maxC = jsonContour.at("aabbMax");
-
-        vec3 min = { minC[0], minC[1], minC[2] };
-        vec3 max = { maxC[0], maxC[1], maxC[2] };
-        aabb3 aabb { min, max };
-
-        std::vector<float> norm = jsonContour.at("normal");
-        vec3 normal = { norm[0], norm[1], norm[2] };
-
-        float distance = jsonContour.at("distance");
-
-        uint32_t colorIndex = jsonContour.at("colorIndex");
-
-        VoxelContourModel::VoxelContour contour { aabb, normal, distance, colorIndex };
-        contours.push_back(contour);
-    }
-
-    std::vector<vec3> colors;
-    for (auto& jsonColor : proxy.at("colors")) {
-
-        vec3 color = { jsonColor[0], jsonColor[1], jsonColor[2] };
-        colors.push_back(color);
-    }
-
-    return std::make_unique<VoxelContourModel>(contours, colors);
-}
@@ -1,8 +1,9 @@
 #pragma once
 
 #include "Model.h"
+#include "utility/Image.h"
 #include "utility/mathkit.h"
-#include <json.hpp>
+#include "utility/models/SphereSetModel.h"
 #include <memory>
 #include <optional>
 #include <string>
@@ -97,12 +98,28 @@ public:
     float environmentMultiplier() const { return m_environmentMultiplier; }
     float& environmentMultiplier() { return m_environmentMultiplier; }
 
+    // HDR environment maps are packed to this format on load, optionally with (prefiltered) mipmaps
+    void setEnvironmentMapFormat(Image::HdrFormat format) { m_environmentMapFormat = format; }
+    Image::HdrFormat environmentMapFormat() const { return m_environmentMapFormat; }
+    void setEnvironmentMapMipmaps(bool mipmaps) { m_environmentMapMipmaps = mipmaps; }
+    bool environmentMapMipmaps() const { return m_environmentMapMipmaps; }
+
+    // If set, textures are streamed in within this VRAM budget (in bytes) instead of being fully resident from the start
+    void setTextureStreamingBudget(std::optional<size_t> budget) { m_textureStreamingBudget = budget; }
+    std::optional<size_t> textureStreamingBudget() const { return m_textureStreamingBudget; }
+
+    // How the SH of sphere-set proxies are packed on the GPU
+    void setSphericalHarmonicsPacking(SphericalHarmonicsPacking packing) { m_shPacking = packing; }
+    SphericalHarmonicsPacking sphericalHarmonicsPacking() const { return m_shPacking; }
+
+    // How the spheres of sphere-set proxies are ordered (only applies to proxies loaded after it's set)
+    void setSphereOrder(SphereOrder order) { m_sphereOrder = order; }
+    SphereOrder sphereOrder() const { return m_sphereOrder; }
+
 private:
     void loadAdditionalCameras();
 
     static std::unique_ptr<Model> loadProxy(const std::string&);
-    static std::unique_ptr<Model> loadSphereSetProxy(const nlohmann::json&);
-    static std::unique_ptr<Model> loadVoxelContourProxy(const nlohmann::json&);
 
 private:
     std::string m_loadedPath {};
@@ -117,4 +134,11 @@ private:
 
     std::string m_environmentMap {};
     float m_environmentMultiplier { 1.0f };
+    Image::HdrFormat m_environmentMapFormat { Image::HdrFormat::RGB9E5 };
+    bool m_environmentMapMipmaps { false };
+
+    std::optional<size_t> m_textureStreamingBudget {};
+
+    SphericalHarmonicsPacking m_shPacking { SphericalHarmonicsPacking::Half };
+    SphereOrder m_sphereOrder { SphereOrder::None };
 };
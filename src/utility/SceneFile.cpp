@@ -0,0 +1,257 @@
+#include "SceneFile.h"
+
+#include "utility/Logging.h"
+#include <json.hpp>
+
+namespace {
+
+using json = nlohmann::json;
+using SceneFile::Description;
+
+std::optional<Image::HdrFormat> hdrFormatFromName(const std::string& format)
+{
+    if (format == "rgba32f") {
+        return Image::HdrFormat::Float32;
+    } else if (format == "rgba16f") {
+        return Image::HdrFormat::Float16;
+    } else if (format == "rgb9e5") {
+        return Image::HdrFormat::RGB9E5;
+    }
+
+    LogError("Scene: unknown environment map format '%s', using the default.\n", format.c_str());
+    return {};
+}
+
+std::optional<SphericalHarmonicsPacking> shPackingFromName(const std::string& packing)
+{
+    if (packing == "float") {
+        return SphericalHarmonicsPacking::Float;
+    } else if (packing == "half") {
+        return SphericalHarmonicsPacking::Half;
+    } else if (packing == "l1-half") {
+        return SphericalHarmonicsPacking::L1Half;
+    }
+
+    LogError("Scene: unknown spherical harmonics packing '%s', using the default.\n", packing.c_str());
+    return {};
+}
+
+std::optional<SphereOrder> sphereOrderFromName(const std::string& order)
+{
+    if (order == "none") {
+        return SphereOrder::None;
+    } else if (order == "morton") {
+        return SphereOrder::Morton;
+    } else if (order == "hilbert") {
+        return SphereOrder::Hilbert;
+    }
+
+    LogError("Scene: unknown sphere order '%s', using the default.\n", order.c_str());
+    return {};
+}
+
+class SceneStreamingParser final : public JsonStreamingParser {
+public:
+    explicit SceneStreamingParser(Description& description)
+        : m_description(description)
+    {
+    }
+
+private:
+    void onBeginObject() override
+    {
+        if (pathIs({ "models", "[]" })) {
+            m_description.models.emplace_back();
+        } else if (pathIs({ "lights", "[]" })) {
+            // (only a single directional light is supported, so the last one wins)
+            m_description.sun = SceneFile::SunDescription {};
+        } else if (pathIs({ "cameras", "[]" })) {
+            m_description.cameras.emplace_back();
+        }
+    }
+
+    void onString(const std::string& value) override
+    {
+        if (pathIs({ "environment", "texture" })) {
+            m_description.environmentMap = value;
+        } else if (pathIs({ "environment", "format" })) {
+            m_description.environmentMapFormat = hdrFormatFromName(value);
+        } else if (pathIs({ "shPacking" })) {
+            m_description.shPacking = shPackingFromName(value);
+        } else if (pathIs({ "sphereOrder" })) {
+            m_description.sphereOrder = sphereOrderFromName(value);
+        } else if (pathIs({ "models", "[]", "name" })) {
+            m_description.models.back().name = value;
+        } else if (pathIs({ "models", "[]", "gltf" })) {
+            m_description.models.back().gltf = value;
+        } else if (pathIs({ "models", "[]", "proxy" })) {
+            m_description.models.back().proxy = value;
+        } else if (pathIs({ "models", "[]", "transform", "rotation", "type" })) {
+            ASSERT(value == "axis-angle");
+        } else if (pathIs({ "lights", "[]", "type" })) {
+            ASSERT(value == "directional");
+        } else if (pathIs({ "cameras", "[]", "name" })) {
+            m_description.cameras.back().name = value;
+        } else if (pathIs({ "camera" })) {
+            m_description.mainCamera = value;
+        }
+    }
+
+    void onBool(bool value) override
+    {
+        if (pathIs({ "environment", "mipmaps" })) {
+            m_description.environmentMapMipmaps = value;
+        } else if (pathIs({ "models", "[]", "optimize" })) {
+            m_description.models.back().optimize = value;
+        }
+    }
+
+    void onNumber(float value) override
+    {
+        if (pathIs({ "environment", "multiplier" })) {
+            m_description.environmentMultiplier = value;
+        } else if (pathIs({ "textureStreaming", "budgetMB" })) {
+            m_description.textureStreamingBudgetMB = value;
+        } else if (pathIs({ "models", "[]", "transform", "*", "[]" })) {
+            SceneFile::ModelDescription& model = m_description.models.back();
+            const std::string& key = keyAt(3);
+            if (key == "translation") {
+                setComponent(model.translation, 4, value);
+            } else if (key == "scale") {
+                setComponent(model.scale, 4, value);
+            }
+        } else if (pathIs({ "models", "[]", "transform", "rotation", "axis", "[]" })) {
+            setComponent(m_description.models.back().rotationAxis, 5, value);
+        } else if (pathIs({ "models", "[]", "transform", "rotation", "angle" })) {
+            m_description.models.back().rotationAngle = value;
+        } else if (pathIs({ "lights", "[]", "color", "[]" })) {
+            setComponent(m_description.sun->color, 3, value);
+        } else if (pathIs({ "lights", "[]", "intensity" })) {
+            m_description.sun->intensity = value;
+        } else if (pathIs({ "lights", "[]", "direction", "[]" })) {
+            setComponent(m_description.sun->direction, 3, value);
+        } else if (pathIs({ "lights", "[]", "worldExtent" })) {
+            m_description.sun->worldExtent = value;
+        } else if (pathIs({ "lights", "[]", "shadowMapSize", "[]" })) {
+            size_t component = indexAt(3);
+            if (component < 2) {
+                m_description.sun->shadowMapSize[component] = int(value);
+            }
+        } else if (pathIs({ "cameras", "[]", "origin", "[]" })) {
+            setComponent(m_description.cameras.back().origin, 3, value);
+        } else if (pathIs({ "cameras", "[]", "target", "[]" })) {
+            setComponent(m_description.cameras.back().target, 3, value);
+        }
+    }
+
+    void setComponent(vec3& vector, size_t level, float value) const
+    {
+        size_t component = indexAt(level);
+        if (component < 3) {
+            vector[int(component)] = value;
+        }
+    }
+
+    Description& m_description;
+};
+
+vec3 readVec3(const json& jsonArray)
+{
+    return { jsonArray[0].get<float>(), jsonArray[1].get<float>(), jsonArray[2].get<float>() };
+}
+
+Description parseDom(const json& jsonScene)
+{
+    Description description {};
+
+    auto& jsonEnv = jsonScene.at("environment");
+    description.environmentMap = jsonEnv.at("texture");
+    description.environmentMultiplier = jsonEnv.at("multiplier");
+    description.environmentMapMipmaps = jsonEnv.value("mipmaps", false);
+    if (jsonEnv.find("format") != jsonEnv.end()) {
+        description.environmentMapFormat = hdrFormatFromName(jsonEnv.at("format"));
+    }
+
+    if (jsonScene.find("textureStreaming") != jsonScene.end()) {
+        description.textureStreamingBudgetMB = jsonScene.at("textureStreaming").at("budgetMB").get<float>();
+    }
+
+    if (jsonScene.find("shPacking") != jsonScene.end()) {
+        description.shPacking = shPackingFromName(jsonScene.at("shPacking"));
+    }
+
+    if (jsonScene.find("sphereOrder") != jsonScene.end()) {
+        description.sphereOrder = sphereOrderFromName(jsonScene.at("sphereOrder"));
+    }
+
+    for (auto& jsonModel : jsonScene.at("models")) {
+        SceneFile::ModelDescription model {};
+        model.name = jsonModel.at("name");
+        model.gltf = jsonModel.at("gltf");
+        model.proxy = jsonModel.value("proxy", "");
+        model.optimize = jsonModel.value("optimize", false);
+
+        auto& transform = jsonModel.at("transform");
+        model.translation = readVec3(transform.at("translation"));
+        model.scale = readVec3(transform.at("scale"));
+
+        auto& jsonRotation = transform.at("rotation");
+        ASSERT(jsonRotation.at("type") == "axis-angle");
+        model.rotationAxis = readVec3(jsonRotation.at("axis"));
+        model.rotationAngle = jsonRotation.at("angle");
+
+        description.models.push_back(std::move(model));
+    }
+
+    for (auto& jsonLight : jsonScene.at("lights")) {
+        ASSERT(jsonLight.at("type") == "directional");
+
+        SceneFile::SunDescription sun {};
+        sun.color = readVec3(jsonLight.at("color"));
+        sun.intensity = jsonLight.at("intensity");
+        sun.direction = readVec3(jsonLight.at("direction"));
+        sun.worldExtent = jsonLight.at("worldExtent");
+        jsonLight.at("shadowMapSize").get_to(sun.shadowMapSize);
+
+        description.sun = sun;
+    }
+
+    for (auto& jsonCamera : jsonScene.at("cameras")) {
+        SceneFile::CameraDescription camera {};
+        camera.name = jsonCamera.at("name");
+        camera.origin = readVec3(jsonCamera.at("origin"));
+        camera.target = readVec3(jsonCamera.at("target"));
+        description.cameras.push_back(std::move(camera));
+    }
+
+    description.mainCamera = jsonScene.at("camera");
+
+    return description;
+}
+
+}
+
+namespace SceneFile {
+
+std::optional<Description> parse(const char* begin, const char* end, const std::string& nameForErrors, JsonParser parser)
+{
+    if (parser == JsonParser::Dom) {
+        return parseDom(json::parse(begin, end));
+    }
+
+    Description description {};
+    SceneStreamingParser streamingParser { description };
+    if (!streamingParser.parse(begin, end, nameForErrors)) {
+        return {};
+    }
+
+    // (the DOM parser requires these, so make sure it's not just silently ignored here)
+    if (description.environmentMap.empty() || description.mainCamera.empty()) {
+        LogError("Scene: '%s' is missing the environment map or main camera.\n", nameForErrors.c_str());
+        return {};
+    }
+
+    return description;
+}
+
+}
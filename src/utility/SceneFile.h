@@ -0,0 +1,59 @@
+#pragma once
+
+#include "utility/Image.h"
+#include "utility/JsonStreaming.h"
+#include "utility/mathkit.h"
+#include "utility/models/SphereSetModel.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+// Parsing of the scene JSON files into plain descriptions, which Scene::loadFromFile then builds the scene from. This
+// keeps the parsing separate from the (much slower) model loading, so that it can be benchmarked on its own.
+namespace SceneFile {
+
+struct ModelDescription {
+    std::string name {};
+    std::string gltf {};
+    std::string proxy {};
+    bool optimize { false };
+
+    vec3 translation { 0.0f };
+    vec3 rotationAxis { 0.0f, 1.0f, 0.0f };
+    float rotationAngle { 0.0f };
+    vec3 scale { 1.0f };
+};
+
+struct SunDescription {
+    vec3 color { 1.0f };
+    float intensity { 1.0f };
+    vec3 direction { 0.0f, 0.0f, -1.0f };
+    float worldExtent { 30.0f };
+    int shadowMapSize[2] { 0, 0 };
+};
+
+struct CameraDescription {
+    std::string name {};
+    vec3 origin { 0.0f };
+    vec3 target { 0.0f };
+};
+
+struct Description {
+    std::string environmentMap {};
+    float environmentMultiplier { 1.0f };
+    std::optional<Image::HdrFormat> environmentMapFormat {};
+    bool environmentMapMipmaps { false };
+
+    std::optional<float> textureStreamingBudgetMB {};
+    std::optional<SphericalHarmonicsPacking> shPacking {};
+    std::optional<SphereOrder> sphereOrder {};
+
+    std::vector<ModelDescription> models {};
+    std::optional<SunDescription> sun {};
+    std::vector<CameraDescription> cameras {};
+    std::string mainCamera {};
+};
+
+std::optional<Description> parse(const char* begin, const char* end, const std::string& nameForErrors, JsonParser = JsonParser::Streaming);
+
+}
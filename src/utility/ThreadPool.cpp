@@ -0,0 +1,50 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock<std::mutex> lock { m_jobMutex };
+        m_stopping = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::global()
+{
+    static ThreadPool pool { std::max(std::thread::hardware_concurrency(), 2u) - 1u };
+    return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock { m_jobMutex };
+            m_jobCondition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+            // Finish all queued jobs before stopping, since someone might be waiting for them
+            if (m_jobs.empty()) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        job();
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed size pool of worker threads for CPU heavy jobs (e.g. image decoding) that shouldn't block the main thread
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    // Shared pool with one thread per hardware thread, except for one which is left for the main thread
+    static ThreadPool& global();
+
+    template<typename Func>
+    auto enqueue(Func&& func) -> std::future<std::invoke_result_t<Func>>;
+
+    [[nodiscard]] uint32_t threadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_threads {};
+
+    std::mutex m_jobMutex {};
+    std::condition_variable m_jobCondition {};
+    std::queue<std::function<void()>> m_jobs {};
+    bool m_stopping { false };
+};
+
+template<typename Func>
+auto ThreadPool::enqueue(Func&& func) -> std::future<std::invoke_result_t<Func>>
+{
+    using ResultType = std::invoke_result_t<Func>;
+
+    // (std::function requires a copyable callable, so we can't move the packaged task into it directly)
+    auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+    std::future<ResultType> future = task->get_future();
+
+    {
+        std::scoped_lock<std::mutex> lock { m_jobMutex };
+        m_jobs.emplace([task]() { (*task)(); });
+    }
+    m_jobCondition.notify_one();
+
+    return future;
+}
@@ -0,0 +1,351 @@
+#include "VoxelContourOptimizer.h"
+
+#include "utility/Logging.h"
+#include <algorithm>
+#include <array>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
+namespace {
+
+using VoxelContour = VoxelContourModel::VoxelContour;
+using ivec3 = glm::ivec3;
+
+struct Grid {
+    vec3 origin;
+    vec3 voxelSize;
+
+    vec3 toGrid(vec3 point) const { return (point - origin) / voxelSize; }
+    vec3 toWorld(vec3 gridPoint) const { return origin + gridPoint * voxelSize; }
+};
+
+// The contours are generated per voxel, so the most common AABB size is the voxel size
+Grid inferGrid(const std::vector<VoxelContour>& contours)
+{
+    Grid grid { .origin = vec3(std::numeric_limits<float>::max()), .voxelSize = vec3(1.0f) };
+    for (const VoxelContour& contour : contours) {
+        grid.origin = glm::min(grid.origin, contour.aabb.min);
+    }
+
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<float> extents {};
+        extents.reserve(contours.size());
+        for (const VoxelContour& contour : contours) {
+            extents.push_back(contour.aabb.max[axis] - contour.aabb.min[axis]);
+        }
+
+        auto median = extents.begin() + extents.size() / 2;
+        std::nth_element(extents.begin(), median, extents.end());
+        if (*median > 0.0f) {
+            grid.voxelSize[axis] = *median;
+        }
+    }
+
+    return grid;
+}
+
+// (the plane equation is dot(normal, p) = distance, see contour.rint)
+bool planeIntersectsBox(const VoxelContour& plane, vec3 boxMin, vec3 boxMax)
+{
+    vec3 center = 0.5f * (boxMin + boxMax);
+    vec3 halfExtent = 0.5f * (boxMax - boxMin);
+    return std::abs(dot(plane.normal, center) - plane.distance) <= dot(glm::abs(plane.normal), halfExtent);
+}
+
+// Bounds of the polygon where the plane cuts through the box, if it does at all
+std::optional<aabb3> planeBoxIntersectionBounds(const VoxelContour& plane, vec3 boxMin, vec3 boxMax)
+{
+    std::array<vec3, 8> corners {};
+    std::array<float, 8> distances {};
+    for (int corner = 0; corner < 8; ++corner) {
+        corners[corner] = vec3((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y, (corner & 4) ? boxMax.z : boxMin.z);
+        distances[corner] = dot(plane.normal, corners[corner]) - plane.distance;
+    }
+
+    vec3 boundsMin { std::numeric_limits<float>::max() };
+    vec3 boundsMax { -std::numeric_limits<float>::max() };
+    bool didIntersect = false;
+
+    auto include = [&](vec3 point) {
+        boundsMin = glm::min(boundsMin, point);
+        boundsMax = glm::max(boundsMax, point);
+        didIntersect = true;
+    };
+
+    for (int a = 0; a < 8; ++a) {
+        if (distances[a] == 0.0f) {
+            include(corners[a]);
+        }
+        for (int axisBit : { 1, 2, 4 }) {
+            int b = a | axisBit;
+            if (b == a || (distances[a] < 0.0f) == (distances[b] < 0.0f) || distances[b] == 0.0f) {
+                continue;
+            }
+            float t = distances[a] / (distances[a] - distances[b]);
+            include(glm::mix(corners[a], corners[b], t));
+        }
+    }
+
+    if (!didIntersect) {
+        return {};
+    }
+    return aabb3(glm::clamp(boundsMin, boxMin, boxMax), glm::clamp(boundsMax, boxMin, boxMax));
+}
+
+// Rounds to a value that can be stored exactly as a half (which the AABBs are on the GPU), rounding outwards
+float roundToHalf(float value, bool roundUp)
+{
+    using half_float::half;
+    half rounded { value };
+    if (roundUp && float(rounded) < value) {
+        rounded = half_float::nextafter(rounded, std::numeric_limits<half>::infinity());
+    } else if (!roundUp && float(rounded) > value) {
+        rounded = half_float::nextafter(rounded, -std::numeric_limits<half>::infinity());
+    }
+    return float(rounded);
+}
+
+// Maps the old color indices to a new dictionary of only the used colors, where colors that are (almost) the same share
+// an entry, and where the most used colors come first
+std::vector<vec3> buildColorDictionary(const std::vector<VoxelContour>& contours, const std::vector<vec3>& colors, float tolerance, std::vector<uint32_t>& colorRemap)
+{
+    std::vector<size_t> usage(colors.size(), 0);
+    for (const VoxelContour& contour : contours) {
+        ASSERT(contour.colorIndex < colors.size());
+        usage[contour.colorIndex] += 1;
+    }
+
+    struct Entry {
+        vec3 color;
+        size_t usage;
+        uint32_t firstColorIndex;
+    };
+    std::vector<Entry> entries {};
+    std::vector<uint32_t> entryForColor(colors.size(), UINT32_MAX);
+    std::map<std::array<int, 3>, uint32_t> entryForKey {};
+
+    for (uint32_t colorIndex = 0; colorIndex < colors.size(); ++colorIndex) {
+        if (usage[colorIndex] == 0) {
+            continue;
+        }
+
+        ivec3 quantized = ivec3(glm::round(colors[colorIndex] / std::max(tolerance, 1e-9f)));
+        std::array<int, 3> key { quantized.x, quantized.y, quantized.z };
+
+        auto [it, didInsert] = entryForKey.try_emplace(key, uint32_t(entries.size()));
+        if (didInsert) {
+            entries.push_back({ .color = colors[colorIndex], .usage = 0, .firstColorIndex = colorIndex });
+        }
+        entries[it->second].usage += usage[colorIndex];
+        entryForColor[colorIndex] = it->second;
+    }
+
+    std::vector<uint32_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+        if (entries[lhs].usage != entries[rhs].usage) {
+            return entries[lhs].usage > entries[rhs].usage;
+        }
+        return entries[lhs].firstColorIndex < entries[rhs].firstColorIndex;
+    });
+
+    std::vector<uint32_t> dictionaryIndexForEntry(entries.size());
+    std::vector<vec3> dictionary {};
+    for (uint32_t entry : order) {
+        dictionaryIndexForEntry[entry] = uint32_t(dictionary.size());
+        dictionary.push_back(entries[entry].color);
+    }
+
+    colorRemap.assign(colors.size(), UINT32_MAX);
+    for (uint32_t colorIndex = 0; colorIndex < colors.size(); ++colorIndex) {
+        if (entryForColor[colorIndex] != UINT32_MAX) {
+            colorRemap[colorIndex] = dictionaryIndexForEntry[entryForColor[colorIndex]];
+        }
+    }
+
+    return dictionary;
+}
+
+}
+
+namespace VoxelContourOptimizer {
+
+std::unique_ptr<VoxelContourModel> optimize(const VoxelContourModel& input, const Settings& settings, Statistics* statistics)
+{
+    const std::vector<VoxelContour>& inputContours = input.contours();
+    if (inputContours.empty()) {
+        return std::make_unique<VoxelContourModel>(inputContours, input.colors());
+    }
+
+    Grid grid = inferGrid(inputContours);
+
+    std::vector<uint32_t> colorRemap {};
+    std::vector<vec3> dictionary = buildColorDictionary(inputContours, input.colors(), settings.colorTolerance, colorRemap);
+
+    // Find the voxel of every contour (contours that don't cover exactly one voxel are passed through as they are)
+    auto cellKey = [](ivec3 cell) -> uint64_t {
+        return (uint64_t(uint32_t(cell.x) & 0x1fffff) << 42) | (uint64_t(uint32_t(cell.y) & 0x1fffff) << 21) | uint64_t(uint32_t(cell.z) & 0x1fffff);
+    };
+
+    std::vector<std::optional<ivec3>> contourCells(inputContours.size());
+    std::unordered_map<uint64_t, std::vector<uint32_t>> contoursInCell {};
+    for (uint32_t i = 0; i < inputContours.size(); ++i) {
+        ivec3 cellMin = ivec3(glm::round(grid.toGrid(inputContours[i].aabb.min)));
+        ivec3 cellMax = ivec3(glm::round(grid.toGrid(inputContours[i].aabb.max)));
+        if (cellMax - cellMin == ivec3(1)) {
+            contourCells[i] = cellMin;
+            contoursInCell[cellKey(cellMin)].push_back(i);
+        }
+    }
+
+    float minVoxelSize = std::min(std::min(grid.voxelSize.x, grid.voxelSize.y), grid.voxelSize.z);
+    float maxPlaneDistance = settings.maxMergeDistance * minVoxelSize;
+    float minNormalDot = std::cos(settings.maxMergeAngle);
+
+    std::vector<bool> consumed(inputContours.size(), false);
+    std::vector<uint32_t> outputIndexForInput(inputContours.size(), UINT32_MAX);
+    std::vector<VoxelContour> outputContours {};
+
+    for (uint32_t seed = 0; seed < inputContours.size(); ++seed) {
+        if (consumed[seed]) {
+            continue;
+        }
+        consumed[seed] = true;
+        outputIndexForInput[seed] = uint32_t(outputContours.size());
+
+        VoxelContour merged = inputContours[seed];
+        merged.colorIndex = colorRemap[merged.colorIndex];
+
+        if (contourCells[seed].has_value()) {
+            // Grow the box of voxels one layer at a time in any direction, for as long as every voxel of the new layer
+            // that the plane passes through has a contour that can be replaced by this one.
+            ivec3 lo = contourCells[seed].value();
+            ivec3 hi = lo + 1;
+
+            auto findReplaceable = [&](ivec3 cell) -> std::optional<uint32_t> {
+                auto entry = contoursInCell.find(cellKey(cell));
+                if (entry == contoursInCell.end()) {
+                    return {};
+                }
+                vec3 cellCenter = grid.toWorld(vec3(cell) + 0.5f);
+                for (uint32_t candidate : entry->second) {
+                    const VoxelContour& contour = inputContours[candidate];
+                    if (consumed[candidate] || colorRemap[contour.colorIndex] != merged.colorIndex || dot(contour.normal, merged.normal) < minNormalDot) {
+                        continue;
+                    }
+                    float planeDistance = (dot(contour.normal, cellCenter) - contour.distance) - (dot(merged.normal, cellCenter) - merged.distance);
+                    if (std::abs(planeDistance) <= maxPlaneDistance) {
+                        return candidate;
+                    }
+                }
+                return {};
+            };
+
+            bool didGrow = true;
+            while (didGrow) {
+                didGrow = false;
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (int side : { -1, +1 }) {
+                        int layer = (side < 0) ? lo[axis] - 1 : hi[axis];
+                        int u = (axis + 1) % 3;
+                        int v = (axis + 2) % 3;
+
+                        std::vector<uint32_t> layerContours {};
+                        bool canGrow = true;
+                        for (int cu = lo[u]; cu < hi[u] && canGrow; ++cu) {
+                            for (int cv = lo[v]; cv < hi[v] && canGrow; ++cv) {
+                                ivec3 cell {};
+                                cell[axis] = layer;
+                                cell[u] = cu;
+                                cell[v] = cv;
+
+                                vec3 cellMin = grid.toWorld(vec3(cell));
+                                vec3 cellMax = grid.toWorld(vec3(cell + 1));
+                                if (!planeIntersectsBox(merged, cellMin, cellMax)) {
+                                    continue;
+                                }
+
+                                // (voxels that the plane only grazes don't have to be replaceable, but are merged if they are)
+                                std::optional<uint32_t> replaceable = findReplaceable(cell);
+                                if (replaceable.has_value()) {
+                                    layerContours.push_back(replaceable.value());
+                                } else {
+                                    vec3 margin = 0.01f * grid.voxelSize;
+                                    canGrow = !planeIntersectsBox(merged, cellMin + margin, cellMax - margin);
+                                }
+                            }
+                        }
+
+                        if (canGrow && !layerContours.empty()) {
+                            for (uint32_t contour : layerContours) {
+                                consumed[contour] = true;
+                                outputIndexForInput[contour] = uint32_t(outputContours.size());
+                            }
+                            if (side < 0) {
+                                lo[axis] -= 1;
+                            } else {
+                                hi[axis] += 1;
+                            }
+                            didGrow = true;
+                        }
+                    }
+                }
+            }
+
+            merged.aabb = aabb3(grid.toWorld(vec3(lo)), grid.toWorld(vec3(hi)));
+        }
+
+        // Shrink the box to where the plane is (which doesn't change what the contour covers), quantized to the subvoxel
+        // grid with a margin of one step, since the plane is only stored with half precision on the GPU
+        if (auto bounds = planeBoxIntersectionBounds(merged, merged.aabb.min, merged.aabb.max)) {
+            vec3 step = grid.voxelSize / float(std::max(settings.subvoxels, 1u));
+            vec3 quantizedMin = grid.origin + (glm::floor((bounds->min - grid.origin) / step) - 1.0f) * step;
+            vec3 quantizedMax = grid.origin + (glm::ceil((bounds->max - grid.origin) / step) + 1.0f) * step;
+            merged.aabb = aabb3(glm::max(quantizedMin, merged.aabb.min), glm::min(quantizedMax, merged.aabb.max));
+        }
+
+        for (int axis = 0; axis < 3; ++axis) {
+            merged.aabb.min[axis] = roundToHalf(merged.aabb.min[axis], false);
+            merged.aabb.max[axis] = roundToHalf(merged.aabb.max[axis], true);
+        }
+
+        outputContours.push_back(merged);
+    }
+
+    // Make sure that every input contour is replaced by one with (almost) the same color, since a mistake in the color
+    // remapping wouldn't show up in the coverage or depth errors
+    size_t colorMismatches = 0;
+    for (uint32_t i = 0; i < inputContours.size(); ++i) {
+        ASSERT(outputIndexForInput[i] < outputContours.size());
+        vec3 inputColor = input.colors()[inputContours[i].colorIndex];
+        vec3 outputColor = dictionary[outputContours[outputIndexForInput[i]].colorIndex];
+        if (glm::any(glm::greaterThan(glm::abs(outputColor - inputColor), vec3(settings.colorTolerance + 1e-6f)))) {
+            if (colorMismatches++ == 0) {
+                LogError("VoxelContourOptimizer: contour %u has color (%.4f, %.4f, %.4f) but was replaced by one with (%.4f, %.4f, %.4f)\n", i,
+                         inputColor.r, inputColor.g, inputColor.b, outputColor.r, outputColor.g, outputColor.b);
+            }
+        }
+    }
+
+    if (statistics) {
+        float totalVolume = 0.0f;
+        for (const VoxelContour& contour : outputContours) {
+            vec3 extent = (contour.aabb.max - contour.aabb.min) / grid.voxelSize;
+            totalVolume += extent.x * extent.y * extent.z;
+        }
+
+        *statistics = { .voxelSize = grid.voxelSize,
+                        .inputContours = inputContours.size(),
+                        .outputContours = outputContours.size(),
+                        .inputColors = input.colors().size(),
+                        .outputColors = dictionary.size(),
+                        .averageAabbVolume = totalVolume / float(outputContours.size()),
+                        .colorMismatches = colorMismatches };
+    }
+
+    return std::make_unique<VoxelContourModel>(std::move(outputContours), std::move(dictionary));
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "utility/mathkit.h"
+#include "utility/models/VoxelContourModel.h"
+#include <memory>
+
+// Optimization of voxel-contour proxies, which are generated with one contour (a plane clipped to an AABB) per voxel.
+// Neighbouring voxels on flat surfaces tend to have the same plane and color, so they can share a single contour, which
+// means fewer primitives in the BLAS and fewer intersection shader invocations per ray.
+namespace VoxelContourOptimizer {
+
+struct Settings {
+    float maxMergeAngle { mathkit::radians(4.0f) }; // between the normals of contours that are merged
+    float maxMergeDistance { 0.1f }; // between the planes of contours that are merged, in voxels
+    float colorTolerance { 1.0f / 255.0f }; // colors within this of each other (per component) share a dictionary entry
+    uint32_t subvoxels { 8 }; // AABBs are quantized to this many steps per voxel
+};
+
+struct Statistics {
+    vec3 voxelSize { 0.0f };
+    size_t inputContours { 0 };
+    size_t outputContours { 0 };
+    size_t inputColors { 0 };
+    size_t outputColors { 0 };
+    float averageAabbVolume { 0.0f }; // (of the output contours, in voxels)
+    size_t colorMismatches { 0 }; // input contours replaced by a contour with a color further away than the tolerance
+};
+
+// Runs all passes on the contours:
+//  1. infer the voxel grid from the AABBs
+//  2. build a color dictionary of only the used & unique colors, with the most used ones first
+//  3. merge adjacent contours with the same color and (almost) the same plane into contours spanning several voxels
+//  4. shrink the AABBs to the part of the box that the plane actually passes through, quantized to the voxel grid
+[[nodiscard]] std::unique_ptr<VoxelContourModel> optimize(const VoxelContourModel&, const Settings&, Statistics* = nullptr);
+
+}
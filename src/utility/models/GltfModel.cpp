@@ -2,12 +2,93 @@
 
 #include "utility/FileIO.h"
 #include "utility/Logging.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <json.hpp>
 #include <string>
 #include <unordered_map>
 
 static std::unordered_map<std::string, tinygltf::Model> s_loadedModels {};
 
-std::unique_ptr<Model> GltfModel::load(const std::string& path)
+// (primitives are owned by the models in s_loadedModels so they are stable keys for the lifetime of the program)
+static std::unordered_map<const tinygltf::Primitive*, MeshOptimizer::MeshData> s_optimizedMeshes {};
+
+namespace {
+
+// tinygltf reads the external buffers & images of a model one by one while parsing, so instead all of them are read at
+// once on the thread pool before parsing, and tinygltf is handed the data through its file system callbacks.
+class PrefetchedFiles {
+public:
+    PrefetchedFiles(std::string_view gltfJson, const std::string& baseDirectory)
+    {
+        nlohmann::json json = nlohmann::json::parse(gltfJson, nullptr, false);
+        if (json.is_discarded()) {
+            return; // (tinygltf will report the error)
+        }
+
+        std::vector<std::string> paths {};
+        for (const char* type : { "buffers", "images" }) {
+            if (!json.contains(type)) {
+                continue;
+            }
+            for (const nlohmann::json& entry : json[type]) {
+                if (!entry.contains("uri") || !entry["uri"].is_string()) {
+                    continue;
+                }
+                std::string uri = entry["uri"].get<std::string>();
+                std::string path = normalizedPath(std::filesystem::path(baseDirectory) / uri);
+                if (uri.rfind("data:", 0) != 0 && std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                    paths.push_back(path);
+                }
+            }
+        }
+
+        std::vector<std::future<std::optional<FileIO::BinaryData>>> files = FileIO::readFilesAsync(paths);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            m_files.try_emplace(paths[i], std::move(files[i]));
+        }
+    }
+
+    tinygltf::FsCallbacks fsCallbacks()
+    {
+        return { .FileExists = &tinygltf::FileExists,
+                 .ExpandFilePath = &tinygltf::ExpandFilePath,
+                 .ReadWholeFile = &PrefetchedFiles::readWholeFile,
+                 .WriteWholeFile = &tinygltf::WriteWholeFile,
+                 .user_data = this };
+    }
+
+private:
+    static std::string normalizedPath(const std::filesystem::path& path)
+    {
+        return path.lexically_normal().string();
+    }
+
+    static bool readWholeFile(std::vector<unsigned char>* out, std::string* err, const std::string& path, void* userData)
+    {
+        auto& self = *static_cast<PrefetchedFiles*>(userData);
+
+        auto entry = self.m_files.find(normalizedPath(path));
+        if (entry == self.m_files.end() || !entry->second.valid()) {
+            return tinygltf::ReadWholeFile(out, err, path, nullptr);
+        }
+
+        std::optional<FileIO::BinaryData> data = entry->second.get();
+        if (!data.has_value()) {
+            return tinygltf::ReadWholeFile(out, err, path, nullptr);
+        }
+
+        out->assign(data->begin(), data->end());
+        return true;
+    }
+
+    std::unordered_map<std::string, std::future<std::optional<FileIO::BinaryData>>> m_files {};
+};
+
+}
+
+std::unique_ptr<Model> GltfModel::load(const std::string& path, bool optimizeMeshes)
 {
     if (!FileIO::isFileReadable(path)) {
         LogError("Could not find glTF model file at path '%s'\n", path.c_str());
@@ -17,7 +98,7 @@ std::unique_ptr<Model> GltfModel::load(const std::string& path)
     auto entry = s_loadedModels.find(path);
     if (entry != s_loadedModels.end()) {
         tinygltf::Model& internal = s_loadedModels[path];
-        return std::make_unique<GltfModel>(path, internal);
+        return std::make_unique<GltfModel>(path, internal, optimizeMeshes);
     }
 
     tinygltf::TinyGLTF loader {};
@@ -26,8 +107,25 @@ std::unique_ptr<Model> GltfModel::load(const std::string& path)
     std::string error;
     std::string warning;
 
-    // TODO: Check if ASCII or binary!
-    bool result = loader.LoadASCIIFromFile(&internal, &error, &warning, path);
+    std::optional<FileIO::MappedFile> file = FileIO::mapFile(path);
+    if (!file.has_value()) {
+        LogError("glTF loader: could not read file '%s'\n", path.c_str());
+        return nullptr;
+    }
+
+    // (buffers & images referenced by the glTF are relative to its directory)
+    std::string baseDirectory = std::filesystem::path(path).parent_path().string();
+
+    bool result;
+    bool isBinary = file->size() >= 4 && std::memcmp(file->data(), "glTF", 4) == 0;
+    if (isBinary) {
+        auto* bytes = reinterpret_cast<const unsigned char*>(file->data());
+        result = loader.LoadBinaryFromMemory(&internal, &error, &warning, bytes, unsigned(file->size()), baseDirectory);
+    } else {
+        PrefetchedFiles prefetchedFiles { file->text(), baseDirectory };
+        loader.SetFsCallbacks(prefetchedFiles.fsCallbacks());
+        result = loader.LoadASCIIFromString(&internal, &error, &warning, file->data(), unsigned(file->size()), baseDirectory);
+    }
 
     if (!warning.empty()) {
         LogWarning("glTF loader warning: %s\n", warning.c_str());
@@ -46,12 +144,13 @@ std::unique_ptr<Model> GltfModel::load(const std::string& path)
         LogWarning("glTF loader: scene ambiguity in model '%s'\n", path.c_str());
     }
 
-    return std::make_unique<GltfModel>(path, internal);
+    return std::make_unique<GltfModel>(path, internal, optimizeMeshes);
 }
 
-GltfModel::GltfModel(std::string path, const tinygltf::Model& model)
+GltfModel::GltfModel(std::string path, const tinygltf::Model& model, bool optimizeMeshes)
     : m_path(std::move(path))
     , m_model(&model)
+    , m_optimizeMeshes(optimizeMeshes)
 {
     const tinygltf::Scene& scene = (m_model->defaultScene != -1)
         ? m_model->scenes[m_model->defaultScene]
@@ -186,6 +285,80 @@ const tinygltf::Accessor* GltfMesh::getAccessor(const char* name) const
 }
 
 std::vector<vec3> GltfMesh::positionData() const
+{
+    if (shouldUseOptimizedData()) {
+        return optimizedMeshData().positions;
+    }
+    return rawPositionData();
+}
+
+std::vector<vec2> GltfMesh::texcoordData() const
+{
+    if (shouldUseOptimizedData()) {
+        return optimizedMeshData().texcoords;
+    }
+    return rawTexcoordData();
+}
+
+std::vector<vec3> GltfMesh::normalData() const
+{
+    if (shouldUseOptimizedData()) {
+        return optimizedMeshData().normals;
+    }
+    return rawNormalData();
+}
+
+std::vector<vec4> GltfMesh::tangentData() const
+{
+    if (shouldUseOptimizedData()) {
+        return optimizedMeshData().tangents;
+    }
+    return rawTangentData();
+}
+
+std::vector<uint32_t> GltfMesh::indexData() const
+{
+    if (shouldUseOptimizedData()) {
+        return optimizedMeshData().indices;
+    }
+    return rawIndexData();
+}
+
+const void* GltfMesh::geometrySource() const
+{
+    // (both the primitives and their optimized data live for the lifetime of the program, see s_loadedModels)
+    if (shouldUseOptimizedData()) {
+        return &optimizedMeshData();
+    }
+    return m_primitive;
+}
+
+bool GltfMesh::shouldUseOptimizedData() const
+{
+    // (we need indices to optimize anything, so non-indexed meshes are simply passed through)
+    return m_parentModel->optimizeMeshes() && isIndexed();
+}
+
+const MeshOptimizer::MeshData& GltfMesh::optimizedMeshData() const
+{
+    auto entry = s_optimizedMeshes.find(m_primitive);
+    if (entry != s_optimizedMeshes.end()) {
+        return entry->second;
+    }
+
+    MeshOptimizer::MeshData& meshData = s_optimizedMeshes[m_primitive];
+    meshData.positions = rawPositionData();
+    meshData.texcoords = rawTexcoordData();
+    meshData.normals = rawNormalData();
+    meshData.tangents = rawTangentData();
+    meshData.indices = rawIndexData();
+
+    MeshOptimizer::optimize(meshData, m_name);
+
+    return meshData;
+}
+
+std::vector<vec3> GltfMesh::rawPositionData() const
 {
     const tinygltf::Accessor& accessor = *getAccessor("POSITION");
     ASSERT(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
@@ -204,7 +377,7 @@ std::vector<vec3> GltfMesh::positionData() const
     return vec;
 }
 
-std::vector<vec2> GltfMesh::texcoordData() const
+std::vector<vec2> GltfMesh::rawTexcoordData() const
 {
     const tinygltf::Accessor* accessor = getAccessor("TEXCOORD_0");
     if (accessor == nullptr) {
@@ -227,7 +400,7 @@ std::vector<vec2> GltfMesh::texcoordData() const
     return vec;
 }
 
-std::vector<vec3> GltfMesh::normalData() const
+std::vector<vec3> GltfMesh::rawNormalData() const
 {
     const tinygltf::Accessor* accessor = getAccessor("NORMAL");
     if (accessor == nullptr) {
@@ -250,7 +423,7 @@ std::vector<vec3> GltfMesh::normalData() const
     return vec;
 }
 
-std::vector<vec4> GltfMesh::tangentData() const
+std::vector<vec4> GltfMesh::rawTangentData() const
 {
     const tinygltf::Accessor* accessor = getAccessor("TANGENT");
     if (accessor == nullptr) {
@@ -273,7 +446,7 @@ std::vector<vec4> GltfMesh::tangentData() const
     return vec;
 }
 
-std::vector<uint32_t> GltfMesh::indexData() const
+std::vector<uint32_t> GltfMesh::rawIndexData() const
 {
     ASSERT(isIndexed());
     const tinygltf::Accessor& accessor = m_model->accessors[m_primitive->indices];
@@ -320,6 +493,14 @@ std::vector<uint32_t> GltfMesh::indexData() const
     return vec;
 }
 
+size_t GltfMesh::vertexCount() const
+{
+    if (shouldUseOptimizedData()) {
+        return optimizedMeshData().vertexCount();
+    }
+    return getAccessor("POSITION")->count;
+}
+
 size_t GltfMesh::indexCount() const
 {
     ASSERT(isIndexed());
@@ -341,5 +522,9 @@ VertexFormat GltfMesh::vertexFormat() const
 
 IndexType GltfMesh::indexType() const
 {
+    // (note: index 0xFFFF is only special with primitive restart, which we don't use)
+    if (vertexCount() <= UINT16_MAX + 1) {
+        return IndexType::UInt16;
+    }
     return IndexType::UInt32;
 }
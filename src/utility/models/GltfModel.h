@@ -1,5 +1,6 @@
 #pragma once
 
+#include "utility/MeshOptimizer.h"
 #include "utility/Model.h"
 #include <memory>
 #include <string>
@@ -12,6 +13,8 @@ public:
     explicit GltfMesh(std::string name, const GltfModel* parent, const tinygltf::Model&, const tinygltf::Primitive&, mat4 matrix);
     ~GltfMesh() = default;
 
+    [[nodiscard]] const void* geometrySource() const override;
+
     [[nodiscard]] Material material() const override;
 
     [[nodiscard]] std::vector<vec3> positionData() const override;
@@ -19,6 +22,8 @@ public:
     [[nodiscard]] std::vector<vec3> normalData() const override;
     [[nodiscard]] std::vector<vec4> tangentData() const override;
 
+    [[nodiscard]] size_t vertexCount() const override;
+
     [[nodiscard]] std::vector<uint32_t> indexData() const override;
     [[nodiscard]] size_t indexCount() const override;
     [[nodiscard]] bool isIndexed() const override;
@@ -29,6 +34,15 @@ public:
 private:
     const tinygltf::Accessor* getAccessor(const char* name) const;
 
+    std::vector<vec3> rawPositionData() const;
+    std::vector<vec2> rawTexcoordData() const;
+    std::vector<vec3> rawNormalData() const;
+    std::vector<vec4> rawTangentData() const;
+    std::vector<uint32_t> rawIndexData() const;
+
+    bool shouldUseOptimizedData() const;
+    const MeshOptimizer::MeshData& optimizedMeshData() const;
+
 private:
     std::string m_name;
     const GltfModel* m_parentModel;
@@ -38,19 +52,23 @@ private:
 
 class GltfModel : public Model {
 public:
-    explicit GltfModel(std::string path, const tinygltf::Model&);
+    explicit GltfModel(std::string path, const tinygltf::Model&, bool optimizeMeshes = false);
     GltfModel() = default;
     ~GltfModel() = default;
 
-    [[nodiscard]] static std::unique_ptr<Model> load(const std::string& path);
+    [[nodiscard]] static std::unique_ptr<Model> load(const std::string& path, bool optimizeMeshes = false);
 
     bool hasMeshes() const override;
     void forEachMesh(std::function<void(const Mesh&)>) const override;
 
     [[nodiscard]] std::string directory() const;
 
+    // If true, meshes will go through the MeshOptimizer before their data is handed out
+    [[nodiscard]] bool optimizeMeshes() const { return m_optimizeMeshes; }
+
 private:
     std::string m_path {};
     const tinygltf::Model* m_model {};
+    bool m_optimizeMeshes { false };
     std::vector<GltfMesh> m_meshes {};
 };
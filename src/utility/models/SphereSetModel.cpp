@@ -1,10 +1,190 @@
 #include "SphereSetModel.h"
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// (10 bits per axis, so all indices fit in 30 bits)
+constexpr uint32_t curveBitsPerAxis = 10;
+
+uint32_t mortonIndex(glm::uvec3 p)
+{
+    auto spreadBits = [](uint32_t x) -> uint32_t {
+        x = (x | (x << 16)) & 0x030000FF;
+        x = (x | (x << 8)) & 0x0300F00F;
+        x = (x | (x << 4)) & 0x030C30C3;
+        x = (x | (x << 2)) & 0x09249249;
+        return x;
+    };
+    return (spreadBits(p.x) << 2) | (spreadBits(p.y) << 1) | spreadBits(p.z);
+}
+
+// See John Skilling, "Programming the Hilbert curve", AIP Conference Proceedings 707 (2004)
+uint32_t hilbertIndex(glm::uvec3 p)
+{
+    uint32_t X[3] = { p.x, p.y, p.z };
+    constexpr uint32_t M = 1u << (curveBitsPerAxis - 1);
+
+    // Inverse undo excess work
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (int i = 0; i < 3; ++i) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (X[2] & Q) {
+            t ^= Q - 1;
+        }
+    }
+    for (uint32_t& x : X) {
+        x ^= t;
+    }
+
+    // (the result is "transposed", i.e. the bits of the index are interleaved over the three axes)
+    uint32_t index = 0;
+    for (int bit = curveBitsPerAxis - 1; bit >= 0; --bit) {
+        for (uint32_t x : X) {
+            index = (index << 1) | ((x >> bit) & 1u);
+        }
+    }
+    return index;
+}
+
+}
+
 SphereSetModel::SphereSetModel(std::vector<Sphere> spheres, std::vector<SphericalHarmonics> sphericalHarmonics)
     : m_spheres(std::move(spheres))
     , m_sphericalHarmonics(std::move(sphericalHarmonics))
 {
     ASSERT(m_spheres.size() == m_sphericalHarmonics.size());
+
+    using namespace half_float;
+    m_packedSpheres.reserve(4 * m_spheres.size());
+    for (const Sphere& sphere : m_spheres) {
+        m_packedSpheres.push_back(half(sphere.x));
+        m_packedSpheres.push_back(half(sphere.y));
+        m_packedSpheres.push_back(half(sphere.z));
+        m_packedSpheres.push_back(half(sphere.w));
+    }
+}
+
+SphereSetModel::SphereSetModel(std::vector<Sphere> spheres, std::vector<SphericalHarmonics> sphericalHarmonics, std::vector<half_float::half> packedSpheres)
+    : m_spheres(std::move(spheres))
+    , m_sphericalHarmonics(std::move(sphericalHarmonics))
+    , m_packedSpheres(std::move(packedSpheres))
+{
+    ASSERT(m_spheres.size() == m_sphericalHarmonics.size());
+    ASSERT(m_packedSpheres.size() == 4 * m_spheres.size());
+}
+
+size_t SphereSetModel::packedSphericalHarmonicsWords(SphericalHarmonicsPacking packing)
+{
+    switch (packing) {
+    case SphericalHarmonicsPacking::Float:
+        return SH_PACKED_WORDS_FLOAT;
+    case SphericalHarmonicsPacking::Half:
+        return SH_PACKED_WORDS_HALF;
+    case SphericalHarmonicsPacking::L1Half:
+        return SH_PACKED_WORDS_L1_HALF;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+std::vector<uint32_t> SphereSetModel::packedSphericalHarmonics(SphericalHarmonicsPacking packing) const
+{
+    size_t wordsPerSphere = packedSphericalHarmonicsWords(packing);
+    std::vector<uint32_t> words(1 + wordsPerSphere * m_sphericalHarmonics.size(), 0u);
+    words[0] = static_cast<uint32_t>(packing);
+
+    for (size_t sphereIdx = 0; sphereIdx < m_sphericalHarmonics.size(); ++sphereIdx) {
+        const SphericalHarmonics& sh = m_sphericalHarmonics[sphereIdx];
+        const vec4 coefficients[] = { sh.L00, sh.L1_1, sh.L10, sh.L11, sh.L2_2, sh.L2_1, sh.L20, sh.L21, sh.L22 };
+
+        uint32_t* sphereWords = &words[1 + sphereIdx * wordsPerSphere];
+        if (packing == SphericalHarmonicsPacking::Float) {
+            for (size_t c = 0; c < 9; ++c) {
+                std::memcpy(&sphereWords[3 * c], &coefficients[c], 3 * sizeof(float));
+            }
+        } else {
+            // (two halfs per word, with the first one in the low bits)
+            size_t coefficientCount = (packing == SphericalHarmonicsPacking::L1Half) ? 4 : 9;
+            auto* sphereHalfs = reinterpret_cast<uint16_t*>(sphereWords);
+            for (size_t c = 0; c < coefficientCount; ++c) {
+                for (int i = 0; i < 3; ++i) {
+                    half_float::half value { coefficients[c][i] };
+                    std::memcpy(&sphereHalfs[3 * c + i], &value, sizeof(uint16_t));
+                }
+            }
+        }
+    }
+
+    return words;
+}
+
+void SphereSetModel::sortSpheres(SphereOrder order)
+{
+    if (order == SphereOrder::None || m_spheres.size() < 2) {
+        return;
+    }
+
+    // Quantize the centers to a grid over their bounds (with the same scale on all axes, so the curve isn't stretched)
+    vec3 minCenter { std::numeric_limits<float>::max() };
+    vec3 maxCenter { -std::numeric_limits<float>::max() };
+    for (const Sphere& sphere : m_spheres) {
+        minCenter = glm::min(minCenter, vec3(sphere));
+        maxCenter = glm::max(maxCenter, vec3(sphere));
+    }
+
+    float maxExtent = std::max(std::max(maxCenter.x - minCenter.x, maxCenter.y - minCenter.y), maxCenter.z - minCenter.z);
+    float gridScale = (maxExtent > 0.0f) ? float((1u << curveBitsPerAxis) - 1) / maxExtent : 0.0f;
+
+    std::vector<uint32_t> curveIndices {};
+    curveIndices.reserve(m_spheres.size());
+    for (const Sphere& sphere : m_spheres) {
+        glm::uvec3 gridPoint = glm::uvec3(glm::clamp((vec3(sphere) - minCenter) * gridScale + 0.5f, vec3(0.0f), vec3((1u << curveBitsPerAxis) - 1)));
+        curveIndices.push_back(order == SphereOrder::Morton ? mortonIndex(gridPoint) : hilbertIndex(gridPoint));
+    }
+
+    // (stable, so that the result is deterministic even if several spheres share a grid cell)
+    std::vector<uint32_t> permutation(m_spheres.size());
+    std::iota(permutation.begin(), permutation.end(), 0u);
+    std::stable_sort(permutation.begin(), permutation.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return curveIndices[lhs] < curveIndices[rhs];
+    });
+
+    std::vector<Sphere> sortedSpheres {};
+    std::vector<SphericalHarmonics> sortedSphericalHarmonics {};
+    std::vector<half_float::half> sortedPackedSpheres {};
+    sortedSpheres.reserve(m_spheres.size());
+    sortedSphericalHarmonics.reserve(m_sphericalHarmonics.size());
+    sortedPackedSpheres.reserve(m_packedSpheres.size());
+
+    for (uint32_t index : permutation) {
+        sortedSpheres.push_back(m_spheres[index]);
+        sortedSphericalHarmonics.push_back(m_sphericalHarmonics[index]);
+        for (int i = 0; i < 4; ++i) {
+            sortedPackedSpheres.push_back(m_packedSpheres[4 * index + i]);
+        }
+    }
+
+    m_spheres = std::move(sortedSpheres);
+    m_sphericalHarmonics = std::move(sortedSphericalHarmonics);
+    m_packedSpheres = std::move(sortedPackedSpheres);
 }
 
 bool SphereSetModel::hasMeshes() const
@@ -2,15 +2,32 @@
 
 #include "utility/Model.h"
 #include "utility/mathkit.h"
+#include <half.hpp>
 #include <vector>
 
 #include "SphericalHarmonics.h"
 
+// How the SH of each sphere is packed on the GPU (see shared/SphericalHarmonics.h)
+enum class SphericalHarmonicsPacking : uint32_t {
+    Float = SH_PACKING_FLOAT,
+    Half = SH_PACKING_HALF,
+    L1Half = SH_PACKING_L1_HALF,
+};
+
+// Optional spatial sorting of the spheres along a space filling curve, so that spheres close to each other in space (and
+// thereby likely hit by coherent rays) also are close in the sphere & SH buffers and in the BLAS build input
+enum class SphereOrder {
+    None, // (the order of the proxy file)
+    Morton,
+    Hilbert,
+};
+
 class SphereSetModel final : public Model {
 public:
     using Sphere = vec4;
 
     SphereSetModel(std::vector<Sphere>, std::vector<SphericalHarmonics>);
+    SphereSetModel(std::vector<Sphere>, std::vector<SphericalHarmonics>, std::vector<half_float::half> packedSpheres);
     SphereSetModel() = default;
     ~SphereSetModel() = default;
 
@@ -20,7 +37,18 @@ public:
     const std::vector<Sphere>& spheres() const { return m_spheres; }
     const std::vector<SphericalHarmonics>& sphericalHarmonics() const { return m_sphericalHarmonics; }
 
+    // The spheres as they are stored on the GPU, i.e. four halfs (center & radius) per sphere
+    const std::vector<half_float::half>& packedSpheres() const { return m_packedSpheres; }
+
+    // The contents of the SH buffer for the GPU, i.e. the packing followed by the packed SHs of all spheres
+    std::vector<uint32_t> packedSphericalHarmonics(SphericalHarmonicsPacking) const;
+    static size_t packedSphericalHarmonicsWords(SphericalHarmonicsPacking);
+
+    // Reorders the spheres, their SH, and their packed versions, by the curve index of the sphere centers
+    void sortSpheres(SphereOrder);
+
 private:
     std::vector<Sphere> m_spheres;
     std::vector<SphericalHarmonics> m_sphericalHarmonics;
+    std::vector<half_float::half> m_packedSpheres;
 };
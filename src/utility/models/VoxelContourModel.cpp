@@ -4,6 +4,36 @@ VoxelContourModel::VoxelContourModel(std::vector<VoxelContour> contours, std::ve
     : m_contours(std::move(contours))
     , m_colors(std::move(colors))
 {
+    using namespace half_float;
+    m_packedContours.planes.reserve(4 * m_contours.size());
+    m_packedContours.aabbs.reserve(6 * m_contours.size());
+    m_packedContours.colorIndices.reserve(m_contours.size());
+
+    for (const VoxelContour& contour : m_contours) {
+        m_packedContours.planes.push_back(half(contour.normal.x));
+        m_packedContours.planes.push_back(half(contour.normal.y));
+        m_packedContours.planes.push_back(half(contour.normal.z));
+        m_packedContours.planes.push_back(half(contour.distance));
+
+        m_packedContours.aabbs.push_back(half(contour.aabb.min.x));
+        m_packedContours.aabbs.push_back(half(contour.aabb.min.y));
+        m_packedContours.aabbs.push_back(half(contour.aabb.min.z));
+        m_packedContours.aabbs.push_back(half(contour.aabb.max.x));
+        m_packedContours.aabbs.push_back(half(contour.aabb.max.y));
+        m_packedContours.aabbs.push_back(half(contour.aabb.max.z));
+
+        m_packedContours.colorIndices.push_back(contour.colorIndex);
+    }
+}
+
+VoxelContourModel::VoxelContourModel(std::vector<VoxelContour> contours, std::vector<vec3> colors, PackedContours packedContours)
+    : m_contours(std::move(contours))
+    , m_colors(std::move(colors))
+    , m_packedContours(std::move(packedContours))
+{
+    ASSERT(m_packedContours.planes.size() == 4 * m_contours.size());
+    ASSERT(m_packedContours.aabbs.size() == 6 * m_contours.size());
+    ASSERT(m_packedContours.colorIndices.size() == m_contours.size());
 }
 
 bool VoxelContourModel::hasMeshes() const
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "utility/Model.h"
+#include <half.hpp>
 #include <vector>
 
 class VoxelContourModel final : public Model {
@@ -12,7 +13,16 @@ public:
         uint32_t colorIndex;
     };
 
+    // The contours as they are stored on the GPU, as separate arrays of planes (normal & distance, four halfs each),
+    // AABBs (min & max, six halfs each), and color indices.
+    struct PackedContours {
+        std::vector<half_float::half> planes;
+        std::vector<half_float::half> aabbs;
+        std::vector<uint32_t> colorIndices;
+    };
+
     VoxelContourModel(std::vector<VoxelContour>, std::vector<vec3> colors);
+    VoxelContourModel(std::vector<VoxelContour>, std::vector<vec3> colors, PackedContours);
     VoxelContourModel() = default;
     ~VoxelContourModel() = default;
 
@@ -22,7 +32,10 @@ public:
     const std::vector<VoxelContour>& contours() const { return m_contours; }
     const std::vector<vec3>& colors() const { return m_colors; }
 
+    const PackedContours& packedContours() const { return m_packedContours; }
+
 private:
     std::vector<VoxelContour> m_contours;
     std::vector<vec3> m_colors;
+    PackedContours m_packedContours;
 };